@@ -0,0 +1,100 @@
+// OPT3001_ReadLux基准：固件驱动源码在主机上对接虚拟GPIOB上的逐位OPT3001从机，
+// 统计每次读取的SCL边沿数、仿真总线时间与主机指令数（perf_event不可用时改报主机纳秒）
+//   opt3001_bench [次数，缺省1000]
+#include "sim_core.h"
+#include "sim_i2c_trace.h"
+#include "sim_opt3001.h"
+
+#include "delay.h"
+#include "opt3001.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace {
+
+// 用户态指令计数器，打开失败（容器/权限）返回-1
+int open_instruction_counter()
+{
+    struct perf_event_attr attr;
+
+    std::memset(&attr, 0, sizeof attr);
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.size = sizeof attr;
+    attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    return (int)syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
+}
+
+int main(int argc, char **argv)
+{
+    int n = argc > 1 ? std::atoi(argv[1]) : 1000;
+    sim::Opt3001 dev(OPT3001_ADDR);
+    OPT3001_IIC_StatsTypeDef stats;
+    uint64_t bus_start, instructions = 0;
+    int counter;
+    float lux = 0;
+
+    if (n <= 0)
+        n = 1000;
+    dev.lux = [](double) { return 321.0; };
+    dev.attach_wire(OPT3001_IIC_PORT, OPT3001_IIC_SCL_PIN, OPT3001_IIC_SDA_PIN);
+    sim::I2cTimingTrace trace(OPT3001_IIC_PORT, OPT3001_IIC_SCL_PIN, OPT3001_IIC_SDA_PIN);
+
+    SysTick_Init();
+    DWT_Init();
+    if (OPT3001_Init() != 0) {
+        std::fprintf(stderr, "OPT3001_Init失败\n");
+        return 1;
+    }
+    sim::advance(sim::ms_to_cycles(900));       // 等第一次800ms转换完成
+
+    OPT3001_IIC_ResetStats();
+    trace.reset();
+    counter = open_instruction_counter();
+    bus_start = sim::now();
+    auto host_start = std::chrono::steady_clock::now();
+    if (counter >= 0) {
+        ioctl(counter, PERF_EVENT_IOC_RESET, 0);
+        ioctl(counter, PERF_EVENT_IOC_ENABLE, 0);
+    }
+    for (int i = 0; i < n; i++)
+        lux = OPT3001_ReadLux();
+    if (counter >= 0) {
+        ioctl(counter, PERF_EVENT_IOC_DISABLE, 0);
+        if (read(counter, &instructions, sizeof instructions) != (ssize_t)sizeof instructions)
+            instructions = 0;
+        close(counter);
+    }
+    auto host_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - host_start).count();
+    OPT3001_IIC_GetStats(&stats);
+
+    std::printf("OPT3001_ReadLux x%d  lux=%.2f  IIC=%dHz\n", n, lux, OPT3001_IIC_SPEED);
+    std::printf("  SCL边沿/次        %.1f（驱动统计SCL脉冲 %.1f）\n",
+                (double)trace.scl_edges() / n, (double)stats.scl_pulses / n);
+    std::printf("  总线字节/次       %.1f  START/次 %.1f\n", (double)stats.bytes / n, (double)stats.starts / n);
+    std::printf("  仿真总线时间/次   %.1f us\n", sim::cycles_to_us(sim::now() - bus_start) / n);
+    if (counter >= 0 && instructions > 0)
+        std::printf("  主机指令/次       %.0f\n", (double)instructions / n);
+    else
+        std::printf("  主机指令/次       n/a（perf_event不可用）\n");
+    std::printf("  主机时间/次       %.0f ns\n", (double)host_ns / n);
+
+    if (lux < 320.0f || lux > 322.0f) {
+        std::fprintf(stderr, "读数不符：%.2f\n", lux);
+        return 1;
+    }
+    return 0;
+}
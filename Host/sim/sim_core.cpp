@@ -0,0 +1,565 @@
+// 仿真核心：时钟与设备事件、寄存器分派、NVIC派发、WFI睡眠、固件协程与printf重定向
+#include "sim_internal.h"
+
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ucontext.h>
+#include <vector>
+
+uint32_t SystemCoreClock = sim::kCoreClockHz;
+
+void SystemInit(void)
+{
+}
+
+// 中断服务函数用弱引用：只有链接了定义它的固件模块时才会被派发
+void SysTick_Handler(void) __attribute__((weak));
+void EXTI0_IRQHandler(void) __attribute__((weak));
+void EXTI1_IRQHandler(void) __attribute__((weak));
+void EXTI2_IRQHandler(void) __attribute__((weak));
+void EXTI3_IRQHandler(void) __attribute__((weak));
+void EXTI4_IRQHandler(void) __attribute__((weak));
+void DMA1_Channel1_IRQHandler(void) __attribute__((weak));
+void DMA1_Channel2_IRQHandler(void) __attribute__((weak));
+void DMA1_Channel3_IRQHandler(void) __attribute__((weak));
+void DMA1_Channel4_IRQHandler(void) __attribute__((weak));
+void DMA1_Channel5_IRQHandler(void) __attribute__((weak));
+void DMA1_Channel6_IRQHandler(void) __attribute__((weak));
+void DMA1_Channel7_IRQHandler(void) __attribute__((weak));
+void EXTI9_5_IRQHandler(void) __attribute__((weak));
+void TIM2_IRQHandler(void) __attribute__((weak));
+void I2C1_EV_IRQHandler(void) __attribute__((weak));
+void I2C1_ER_IRQHandler(void) __attribute__((weak));
+void USART1_IRQHandler(void) __attribute__((weak));
+void EXTI15_10_IRQHandler(void) __attribute__((weak));
+
+namespace sim {
+namespace {
+
+const int kIrqOffset = 16;              // 表下标 = IRQn + 16（SysTick为15）
+const int kIrqCount = 16 + 64;
+const uint32_t kIrqEntryCycles = 12;    // 压栈+取向量
+const uint32_t kIrqExitCycles = 10;
+
+struct IrqSlot {
+    bool enabled;
+    uint8_t priority;
+    bool pending;
+    bool (*line)();
+    void (*handler)();
+    uint32_t count;
+};
+
+uint64_t g_now = 0;
+uint64_t g_sleep = 0;
+IrqSlot g_irq[kIrqCount];
+bool g_irq_ready = false;
+bool g_in_isr = false;
+uint32_t g_primask = 0;
+uint32_t g_priority_group = 0;
+
+// 固件协程
+ucontext_t g_host_ctx;
+ucontext_t g_fw_ctx;
+int (*g_fw_entry)(void) = 0;
+bool g_fw_started = false;
+bool g_fw_running = false;
+bool g_fw_returned = false;
+uint64_t g_fw_limit = 0;
+
+detail::PeriphOps *g_last_periph = 0;   // 最近一次命中的外设（注册新外设时作废）
+
+std::vector<Device *> &devices()
+{
+    static std::vector<Device *> list;
+    return list;
+}
+
+std::vector<detail::PeriphOps> &periphs()
+{
+    static std::vector<detail::PeriphOps> list;
+    return list;
+}
+
+// 单次定时回调按时间排序存放，作为一个设备参与调度
+class TimedEvents : public Device {
+public:
+    struct Event {
+        uint64_t when;
+        std::function<void()> fn;
+    };
+
+    void add(uint64_t when, std::function<void()> fn)
+    {
+        size_t i = events_.size();
+        events_.push_back(Event());
+        while (i > 0 && events_[i - 1].when > when) {
+            events_[i] = events_[i - 1];
+            i--;
+        }
+        events_[i].when = when;
+        events_[i].fn = fn;
+    }
+
+    uint64_t next_event() const override
+    {
+        return events_.empty() ? UINT64_MAX : events_.front().when;
+    }
+
+    void run_until(uint64_t t) override
+    {
+        while (!events_.empty() && events_.front().when <= t) {
+            std::function<void()> fn = events_.front().fn;
+            events_.erase(events_.begin());
+            fn();
+        }
+    }
+
+private:
+    std::vector<Event> events_;
+};
+
+TimedEvents &timed_events()
+{
+    static TimedEvents ev;
+    static bool added = false;
+    if (!added) {
+        added = true;
+        add_device(&ev);
+    }
+    return ev;
+}
+
+void init_irq_table()
+{
+    if (g_irq_ready)
+        return;
+    g_irq_ready = true;
+    std::memset(g_irq, 0, sizeof g_irq);
+    g_irq[SysTick_IRQn + kIrqOffset].handler = SysTick_Handler;
+    g_irq[SysTick_IRQn + kIrqOffset].enabled = true;
+    g_irq[EXTI0_IRQn + kIrqOffset].handler = EXTI0_IRQHandler;
+    g_irq[EXTI1_IRQn + kIrqOffset].handler = EXTI1_IRQHandler;
+    g_irq[EXTI2_IRQn + kIrqOffset].handler = EXTI2_IRQHandler;
+    g_irq[EXTI3_IRQn + kIrqOffset].handler = EXTI3_IRQHandler;
+    g_irq[EXTI4_IRQn + kIrqOffset].handler = EXTI4_IRQHandler;
+    g_irq[DMA1_Channel1_IRQn + kIrqOffset].handler = DMA1_Channel1_IRQHandler;
+    g_irq[DMA1_Channel2_IRQn + kIrqOffset].handler = DMA1_Channel2_IRQHandler;
+    g_irq[DMA1_Channel3_IRQn + kIrqOffset].handler = DMA1_Channel3_IRQHandler;
+    g_irq[DMA1_Channel4_IRQn + kIrqOffset].handler = DMA1_Channel4_IRQHandler;
+    g_irq[DMA1_Channel5_IRQn + kIrqOffset].handler = DMA1_Channel5_IRQHandler;
+    g_irq[DMA1_Channel6_IRQn + kIrqOffset].handler = DMA1_Channel6_IRQHandler;
+    g_irq[DMA1_Channel7_IRQn + kIrqOffset].handler = DMA1_Channel7_IRQHandler;
+    g_irq[EXTI9_5_IRQn + kIrqOffset].handler = EXTI9_5_IRQHandler;
+    g_irq[TIM2_IRQn + kIrqOffset].handler = TIM2_IRQHandler;
+    g_irq[I2C1_EV_IRQn + kIrqOffset].handler = I2C1_EV_IRQHandler;
+    g_irq[I2C1_ER_IRQn + kIrqOffset].handler = I2C1_ER_IRQHandler;
+    g_irq[USART1_IRQn + kIrqOffset].handler = USART1_IRQHandler;
+    g_irq[EXTI15_10_IRQn + kIrqOffset].handler = EXTI15_10_IRQHandler;
+}
+
+IrqSlot &irq(int irqn)
+{
+    init_irq_table();
+    return g_irq[irqn + kIrqOffset];
+}
+
+// 最早的设备事件
+Device *earliest_device(uint64_t *when)
+{
+    Device *best = 0;
+    uint64_t best_t = UINT64_MAX;
+    std::vector<Device *> &list = devices();
+    for (size_t i = 0; i < list.size(); i++) {
+        uint64_t t = list[i]->next_event();
+        if (t < best_t) {
+            best_t = t;
+            best = list[i];
+        }
+    }
+    *when = best_t;
+    return best;
+}
+
+// 时钟推进到target，途中按时间先后执行设备事件（事件执行时now()即事件时刻）
+void run_to(uint64_t target)
+{
+    for (;;) {
+        uint64_t when;
+        Device *dev = earliest_device(&when);
+        if (!dev || when > target)
+            break;
+        if (when > g_now)
+            g_now = when;
+        dev->run_until(g_now);
+    }
+    if (target > g_now)
+        g_now = target;
+}
+
+// 可被派发的中断（使能且挂起或中断线有效），返回表下标，无则-1
+int ready_irq()
+{
+    int best = -1;
+    init_irq_table();
+    for (int i = 0; i < kIrqCount; i++) {
+        IrqSlot &s = g_irq[i];
+        if (!s.enabled || !s.handler)
+            continue;
+        if (!s.pending && !(s.line && s.line()))
+            continue;
+        if (best < 0 || s.priority < g_irq[best].priority)
+            best = i;
+    }
+    return best;
+}
+
+// 固件协程到时切回调用者（只在主循环上下文）
+void maybe_yield()
+{
+    if (g_fw_running && !g_in_isr && g_now >= g_fw_limit)
+        swapcontext(&g_fw_ctx, &g_host_ctx);
+}
+
+// 主循环上下文且未关中断时依次执行就绪的中断（不模拟抢占嵌套）
+void dispatch()
+{
+    int guard = 0;
+
+    if (g_in_isr || g_primask)
+        return;
+    for (;;) {
+        int i = ready_irq();
+        if (i < 0)
+            return;
+        if (++guard > 100000) {
+            std::fprintf(stderr, "sim: 中断 %d 持续有效（服务函数未清除标志）\n", i - kIrqOffset);
+            std::abort();
+        }
+        IrqSlot &s = g_irq[i];
+        s.pending = false;
+        if (i == SysTick_IRQn + kIrqOffset)
+            sim_scb.ICSR.v &= ~SCB_ICSR_PENDSTSET_Msk;
+        g_in_isr = true;
+        run_to(g_now + kIrqEntryCycles);
+        s.count++;
+        s.handler();
+        run_to(g_now + kIrqExitCycles);
+        g_in_isr = false;
+    }
+}
+
+detail::PeriphOps *find_periph(void *reg)
+{
+    detail::PeriphOps *last = g_last_periph;
+    uintptr_t a = (uintptr_t)reg;
+    std::vector<detail::PeriphOps> &list = periphs();
+
+    if (last && a >= (uintptr_t)last->base && a < (uintptr_t)last->base + last->size)
+        return last;
+    for (size_t i = 0; i < list.size(); i++) {
+        if (a >= (uintptr_t)list[i].base && a < (uintptr_t)list[i].base + list[i].size) {
+            g_last_periph = &list[i];
+            return g_last_periph;
+        }
+    }
+    std::fprintf(stderr, "sim: 未注册的外设寄存器 %p\n", reg);
+    std::abort();
+}
+
+void fw_trampoline()
+{
+    g_fw_entry();
+    g_fw_returned = true;
+}
+
+}
+
+/********************* 时间 *********************/
+uint64_t now()
+{
+    return g_now;
+}
+
+uint64_t sleep_cycles()
+{
+    return g_sleep;
+}
+
+double now_us()
+{
+    return cycles_to_us(g_now);
+}
+
+void advance(uint64_t cycles)
+{
+    uint64_t target = g_now + cycles;
+
+    dispatch();
+    while (g_now < target) {
+        uint64_t when;
+        earliest_device(&when);
+        if (when > target)
+            when = target;
+        run_to(when);
+        dispatch();
+    }
+}
+
+int advance_until(const std::function<bool()> &done, uint64_t max_cycles)
+{
+    uint64_t deadline = g_now + max_cycles;
+
+    dispatch();
+    while (!done()) {
+        uint64_t when;
+        if (g_now >= deadline)
+            return 1;
+        earliest_device(&when);
+        if (when > deadline)
+            when = deadline;
+        run_to(when);
+        dispatch();
+    }
+    return 0;
+}
+
+/********************* 设备与定时事件 *********************/
+void add_device(Device *dev)
+{
+    devices().push_back(dev);
+}
+
+void remove_device(Device *dev)
+{
+    std::vector<Device *> &list = devices();
+    for (size_t i = 0; i < list.size(); i++) {
+        if (list[i] == dev) {
+            list.erase(list.begin() + i);
+            return;
+        }
+    }
+}
+
+void at(uint64_t when, std::function<void()> fn)
+{
+    timed_events().add(when, fn);
+}
+
+/********************* 中断 *********************/
+bool in_isr()
+{
+    return g_in_isr;
+}
+
+uint32_t irq_count(int irqn)
+{
+    return irq(irqn).count;
+}
+
+/********************* 固件整体运行 *********************/
+void run_firmware(int (*entry)(void), uint64_t cycles)
+{
+    static const size_t kStackSize = 1 << 20;
+
+    if (g_fw_returned)
+        return;
+    g_fw_limit = g_now + cycles;
+    if (!g_fw_started) {
+        g_fw_started = true;
+        g_fw_entry = entry;
+        getcontext(&g_fw_ctx);
+        g_fw_ctx.uc_stack.ss_sp = std::malloc(kStackSize);
+        g_fw_ctx.uc_stack.ss_size = kStackSize;
+        g_fw_ctx.uc_link = &g_host_ctx;
+        makecontext(&g_fw_ctx, fw_trampoline, 0);
+    }
+    g_fw_running = true;
+    swapcontext(&g_host_ctx, &g_fw_ctx);
+    g_fw_running = false;
+}
+
+namespace detail {
+
+void register_periph(const PeriphOps &ops)
+{
+    periphs().push_back(ops);
+    g_last_periph = 0;
+}
+
+void busy(uint64_t cycles)
+{
+    run_to(g_now + cycles);
+}
+
+uint64_t active_cycles()
+{
+    return g_now - g_sleep;
+}
+
+void register_irq_line(int irqn, bool (*line)())
+{
+    irq(irqn).line = line;
+}
+
+void pend_irq(int irqn)
+{
+    irq(irqn).pending = true;
+    if (irqn == SysTick_IRQn)
+        sim_scb.ICSR.v |= SCB_ICSR_PENDSTSET_Msk;
+}
+
+bool systick_pending()
+{
+    return irq(SysTick_IRQn).pending;
+}
+
+// 固件把指针截成u32写入DMA地址寄存器：在当前栈帧与静态区附近找高32位，取距离最近的候选
+uintptr_t recover_pointer(uint32_t low)
+{
+    const uintptr_t refs[2] = { (uintptr_t)__builtin_frame_address(0), (uintptr_t)&g_now };
+    uintptr_t best = 0, best_dist = UINTPTR_MAX;
+
+    for (int r = 0; r < 2; r++) {
+        uintptr_t base = refs[r] & ~(uintptr_t)0xFFFFFFFFu;
+        for (int k = -1; k <= 1; k++) {
+            uintptr_t cand = (base + (uintptr_t)((intptr_t)k << 32)) | low;
+            uintptr_t dist = cand > refs[r] ? cand - refs[r] : refs[r] - cand;
+            if (dist < best_dist) {
+                best_dist = dist;
+                best = cand;
+            }
+        }
+    }
+    return best;
+}
+
+}
+}
+
+/********************* 寄存器代理入口 *********************/
+uint32_t sim_reg_read(void *reg)
+{
+    sim::detail::PeriphOps *ops = sim::find_periph(reg);
+    uint32_t value;
+
+    sim::run_to(sim::g_now + sim::kAccessCycles);
+    if (ops->read)
+        ops->read((uintptr_t)reg - (uintptr_t)ops->base);
+    value = ops->width == 2 ? *(uint16_t *)reg : *(uint32_t *)reg;
+    if (ops->after_read)
+        ops->after_read((uintptr_t)reg - (uintptr_t)ops->base);
+    sim::dispatch();
+    sim::maybe_yield();
+    return value;
+}
+
+void sim_reg_write(void *reg, uint32_t old_value)
+{
+    sim::detail::PeriphOps *ops = sim::find_periph(reg);
+
+    sim::run_to(sim::g_now + sim::kAccessCycles);
+    if (ops->write)
+        ops->write((uintptr_t)reg - (uintptr_t)ops->base, old_value);
+    sim::dispatch();
+    sim::maybe_yield();
+}
+
+/********************* NVIC *********************/
+void NVIC_PriorityGroupConfig(u32 NVIC_PriorityGroup)
+{
+    sim::g_priority_group = NVIC_PriorityGroup;
+}
+
+void NVIC_Init(NVIC_InitTypeDef *NVIC_InitStruct)
+{
+    // SPL的NVIC_PriorityGroup_n为(7-n)<<8，抢占优先级占n位；未配置时按复位值（4位全为抢占）
+    u32 group = sim::g_priority_group;
+    u32 pre_bits = (group >= 0x300 && group <= 0x700) ? (0x700 - group) >> 8 : 4;
+    u32 sub_bits = 4 - pre_bits;
+    sim::IrqSlot &s = sim::irq(NVIC_InitStruct->NVIC_IRQChannel);
+
+    s.priority = (u8)((NVIC_InitStruct->NVIC_IRQChannelPreemptionPriority << sub_bits) |
+                      (NVIC_InitStruct->NVIC_IRQChannelSubPriority & ((1u << sub_bits) - 1)));
+    s.enabled = NVIC_InitStruct->NVIC_IRQChannelCmd != DISABLE;
+}
+
+void NVIC_SetPriority(IRQn_Type IRQn, u32 priority)
+{
+    sim::irq(IRQn).priority = (u8)priority;
+}
+
+void NVIC_EnableIRQ(IRQn_Type IRQn)
+{
+    sim::irq(IRQn).enabled = true;
+}
+
+void NVIC_DisableIRQ(IRQn_Type IRQn)
+{
+    sim::irq(IRQn).enabled = false;
+}
+
+/********************* 内核指令 *********************/
+void __disable_irq(void)
+{
+    sim::g_primask = 1;
+}
+
+void __enable_irq(void)
+{
+    sim::g_primask = 0;
+    sim::dispatch();
+}
+
+u32 __get_PRIMASK(void)
+{
+    return sim::g_primask;
+}
+
+void __set_PRIMASK(u32 priMask)
+{
+    sim::g_primask = priMask & 1;
+    sim::dispatch();
+}
+
+// 有中断挂起（不论PRIMASK）立即返回，否则睡到下一个设备事件；睡眠期间DWT计数停止
+void __WFI(void)
+{
+    sim::run_to(sim::g_now + sim::kAccessCycles);
+    while (sim::ready_irq() < 0) {
+        uint64_t when;
+        sim::earliest_device(&when);
+        if (when == UINT64_MAX) {
+            std::fprintf(stderr, "sim: WFI没有任何唤醒源\n");
+            std::abort();
+        }
+        if (when > sim::g_now) {
+            sim::g_sleep += when - sim::g_now;
+            sim::g_now = when;
+        }
+        sim::run_to(sim::g_now);
+        sim::maybe_yield();
+    }
+    sim::dispatch();
+    sim::maybe_yield();
+}
+
+/********************* printf重定向 *********************/
+// 与Keil的MicroLIB一样逐字符调用fputc（main.c重定向到串口DMA）
+int sim_printf(const char *fmt, ...)
+{
+    char buf[512];
+    va_list ap;
+    int n;
+
+    va_start(ap, fmt);
+    n = std::vsnprintf(buf, sizeof buf, fmt, ap);
+    va_end(ap);
+    if (n > (int)sizeof buf - 1)
+        n = (int)sizeof buf - 1;
+    for (int i = 0; i < n; i++)
+        fputc((unsigned char)buf[i], stdout);
+    return n;
+}
@@ -0,0 +1,93 @@
+// 主机仿真核心：虚拟72MHz时钟、外设寄存器行为、NVIC派发与WFI睡眠
+// 固件源码通过stub/stm32f10x.h访问寄存器，测试与基准程序通过本头文件驱动仿真
+#ifndef SIM_CORE_H
+#define SIM_CORE_H
+
+#include "stm32f10x.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+
+namespace sim {
+
+const uint32_t kCoreClockHz = 72000000;
+const uint32_t kAccessCycles = 2;       // 每次外设寄存器访问计入的内核周期
+
+/********************* 时间 *********************/
+uint64_t now();                         // 仿真时钟（内核周期，含睡眠）
+uint64_t sleep_cycles();                // 其中WFI睡眠的周期
+double now_us();
+
+inline uint64_t us_to_cycles(double us) { return (uint64_t)(us * (kCoreClockHz / 1e6) + 0.5); }
+inline uint64_t ms_to_cycles(double ms) { return us_to_cycles(ms * 1000.0); }
+inline double cycles_to_us(uint64_t cycles) { return cycles / (kCoreClockHz / 1e6); }
+
+// 主循环空闲：时钟前进cycles，途中按时间执行设备事件并派发中断（测试驱动代替主循环时使用）
+void advance(uint64_t cycles);
+// 空闲推进直到done()成立，返回0：成立，1：超过max_cycles
+int advance_until(const std::function<bool()> &done, uint64_t max_cycles);
+
+/********************* 设备与定时事件 *********************/
+// 有时间行为的外设/外部器件：next_event()返回下一事件时刻（无则UINT64_MAX）
+class Device {
+public:
+    virtual ~Device() {}
+    virtual uint64_t next_event() const = 0;
+    virtual void run_until(uint64_t t) = 0;
+};
+void add_device(Device *dev);
+void remove_device(Device *dev);
+// 单次定时回调，在设备事件上下文执行：只能操作仿真模型，不能调用固件
+void at(uint64_t when, std::function<void()> fn);
+
+/********************* GPIO *********************/
+// 引脚电平 = MCU输出（仅GPIO输出模式的ODR，其余视为释放）与各外部器件下拉的线与，全部引脚有上拉
+class PinListener {
+public:
+    virtual ~PinListener() {}
+    virtual void on_pins(GPIO_TypeDef *port, uint16_t old_level, uint16_t new_level) = 0;
+};
+void add_pin_listener(GPIO_TypeDef *port, PinListener *listener);
+void remove_pin_listener(GPIO_TypeDef *port, PinListener *listener);
+// owner对pins的下拉（low=true拉低，false释放），电平变化即通知监听者并做EXTI边沿检测
+void set_pull_low(GPIO_TypeDef *port, uint16_t pins, bool low, const void *owner);
+uint16_t pin_level(GPIO_TypeDef *port);
+
+/********************* 中断 *********************/
+bool in_isr();
+uint32_t irq_count(int irqn);           // 各中断累计执行次数（SysTick为-1）
+
+/********************* I2C1（硬件I2C+DMA寄存器模型） *********************/
+// 字节级从机接口：START后第一个写入字节为地址；返回值为是否应答
+class I2cTarget {
+public:
+    virtual ~I2cTarget() {}
+    virtual void i2c_start() = 0;
+    virtual bool i2c_write(uint8_t byte) = 0;
+    virtual uint8_t i2c_read() = 0;
+    virtual void i2c_master_ack(bool ack) = 0;
+    virtual void i2c_stop() = 0;
+};
+void i2c1_attach(I2cTarget *target);
+uint32_t i2c1_bytes();                  // I2C1上传输的字节数（含地址）
+
+/********************* USART1 *********************/
+const std::string &uart_output();       // DMA发出的全部字节
+void uart_clear_output();
+void uart_inject(const std::string &bytes);  // 从当前时刻起按波特率逐字节送入接收端
+uint32_t uart_baud();
+
+/********************* Flash / IWDG *********************/
+void flash_erase_all();                 // 整片恢复为0xFF（模拟新芯片）
+uint32_t iwdg_expired();                // 看门狗超时次数（仿真不复位，只计数）
+
+/********************* 固件整体运行 *********************/
+// 固件main（main.c以-Dmain=firmware_main编译）在独立的协程栈上运行：每次调用从上次停下的位置
+// 继续，仿真时钟再前进cycles后于主循环上下文的寄存器访问处切回调用者，期间可检查状态或注入串口命令
+void run_firmware(int (*entry)(void), uint64_t cycles);
+
+}
+
+#endif
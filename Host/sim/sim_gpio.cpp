@@ -0,0 +1,226 @@
+// GPIO模型：开漏线与电平、外部器件下拉、电平变化通知（I2C从机解码/时序记录）与EXTI边沿
+#include "sim_internal.h"
+
+#include <vector>
+
+GPIO_TypeDef sim_gpioa;
+GPIO_TypeDef sim_gpiob;
+GPIO_TypeDef sim_gpioc;
+
+namespace sim {
+namespace {
+
+struct Pull {
+    const void *owner;
+    uint16_t pins;
+};
+
+struct PortState {
+    GPIO_TypeDef *regs;
+    uint16_t level;
+    std::vector<Pull> pulls;
+    std::vector<PinListener *> listeners;
+    bool updating;
+    bool dirty;
+};
+
+PortState g_ports[3] = {
+    { &sim_gpioa, 0xFFFF, {}, {}, false, false },
+    { &sim_gpiob, 0xFFFF, {}, {}, false, false },
+    { &sim_gpioc, 0xFFFF, {}, {}, false, false },
+};
+
+PortState &port_state(GPIO_TypeDef *port)
+{
+    if (port == &sim_gpioa)
+        return g_ports[0];
+    if (port == &sim_gpiob)
+        return g_ports[1];
+    return g_ports[2];
+}
+
+// GPIO输出模式（MODE!=0且CNF1=0）的引脚由ODR驱动，输入与复用功能视为释放
+uint16_t mcu_drive(const GPIO_TypeDef *regs)
+{
+    uint16_t released = 0xFFFF;
+    for (int pin = 0; pin < 16; pin++) {
+        uint32_t cr = pin < 8 ? regs->CRL.v : regs->CRH.v;
+        uint32_t cfg = (cr >> (4 * (pin % 8))) & 0xF;
+        if ((cfg & 0x3) != 0 && !(cfg & 0x8) && !(regs->ODR.v & (1u << pin)))
+            released &= ~(1u << pin);
+    }
+    return released;
+}
+
+uint16_t compute(const PortState &ps)
+{
+    uint16_t level = mcu_drive(ps.regs);
+    for (size_t i = 0; i < ps.pulls.size(); i++)
+        level &= ~ps.pulls[i].pins;
+    return level;
+}
+
+// 电平变化时通知监听者；监听者在回调中改变下拉（如从机在SCL下降沿后改变SDA）时再次计算，直到稳定
+void update(PortState &ps)
+{
+    if (ps.updating) {
+        ps.dirty = true;
+        return;
+    }
+    ps.updating = true;
+    for (int guard = 0; guard < 64; guard++) {
+        uint16_t old = ps.level;
+        uint16_t level = compute(ps);
+        ps.dirty = false;
+        if (level == old)
+            break;
+        ps.level = level;
+        for (size_t i = 0; i < ps.listeners.size(); i++)
+            ps.listeners[i]->on_pins(ps.regs, old, level);
+        detail::exti_edges(ps.regs, (uint16_t)(old & ~level), (uint16_t)(~old & level));
+        if (!ps.dirty && compute(ps) == ps.level)
+            break;
+    }
+    ps.updating = false;
+}
+
+void gpio_read(GPIO_TypeDef *regs, size_t offset)
+{
+    if (offset == (size_t)((char *)&regs->IDR - (char *)regs))
+        regs->IDR.v = port_state(regs).level;
+}
+
+void gpio_write(GPIO_TypeDef *regs, size_t offset, uint32_t old)
+{
+    size_t bsrr = (size_t)((char *)&regs->BSRR - (char *)regs);
+    size_t brr = (size_t)((char *)&regs->BRR - (char *)regs);
+    size_t idr = (size_t)((char *)&regs->IDR - (char *)regs);
+
+    if (offset == bsrr) {
+        uint32_t v = regs->BSRR.v;
+        regs->ODR.v = (regs->ODR.v & ~(v >> 16)) | (v & 0xFFFF);   // 同一位置位优先
+        regs->BSRR.v = 0;
+    } else if (offset == brr) {
+        regs->ODR.v &= ~(regs->BRR.v & 0xFFFF);
+        regs->BRR.v = 0;
+    } else if (offset == idr) {
+        regs->IDR.v = old;                                          // 只读
+        return;
+    }
+    regs->ODR.v &= 0xFFFF;
+    update(port_state(regs));
+}
+
+void gpioa_read(size_t offset) { gpio_read(&sim_gpioa, offset); }
+void gpiob_read(size_t offset) { gpio_read(&sim_gpiob, offset); }
+void gpioc_read(size_t offset) { gpio_read(&sim_gpioc, offset); }
+void gpioa_write(size_t offset, uint32_t old) { gpio_write(&sim_gpioa, offset, old); }
+void gpiob_write(size_t offset, uint32_t old) { gpio_write(&sim_gpiob, offset, old); }
+void gpioc_write(size_t offset, uint32_t old) { gpio_write(&sim_gpioc, offset, old); }
+
+struct Registrar {
+    Registrar()
+    {
+        // 复位值：全部引脚浮空输入
+        for (int i = 0; i < 3; i++) {
+            g_ports[i].regs->CRL.v = 0x44444444;
+            g_ports[i].regs->CRH.v = 0x44444444;
+        }
+        detail::PeriphOps a = { &sim_gpioa, sizeof sim_gpioa, 4, gpioa_read, gpioa_write, 0 };
+        detail::PeriphOps b = { &sim_gpiob, sizeof sim_gpiob, 4, gpiob_read, gpiob_write, 0 };
+        detail::PeriphOps c = { &sim_gpioc, sizeof sim_gpioc, 4, gpioc_read, gpioc_write, 0 };
+        detail::register_periph(a);
+        detail::register_periph(b);
+        detail::register_periph(c);
+    }
+} g_registrar;
+
+}
+
+void add_pin_listener(GPIO_TypeDef *port, PinListener *listener)
+{
+    port_state(port).listeners.push_back(listener);
+}
+
+void remove_pin_listener(GPIO_TypeDef *port, PinListener *listener)
+{
+    std::vector<PinListener *> &list = port_state(port).listeners;
+    for (size_t i = 0; i < list.size(); i++) {
+        if (list[i] == listener) {
+            list.erase(list.begin() + i);
+            return;
+        }
+    }
+}
+
+void set_pull_low(GPIO_TypeDef *port, uint16_t pins, bool low, const void *owner)
+{
+    PortState &ps = port_state(port);
+    size_t i;
+
+    for (i = 0; i < ps.pulls.size(); i++) {
+        if (ps.pulls[i].owner == owner)
+            break;
+    }
+    if (i == ps.pulls.size()) {
+        Pull p = { owner, 0 };
+        ps.pulls.push_back(p);
+    }
+    if (low)
+        ps.pulls[i].pins |= pins;
+    else
+        ps.pulls[i].pins &= ~pins;
+    update(ps);
+}
+
+uint16_t pin_level(GPIO_TypeDef *port)
+{
+    return port_state(port).level;
+}
+
+}
+
+/********************* SPL：GPIO *********************/
+void GPIO_Init(GPIO_TypeDef *GPIOx, GPIO_InitTypeDef *GPIO_InitStruct)
+{
+    u32 mode = (u32)GPIO_InitStruct->GPIO_Mode & 0x0F;
+    u32 crl, crh;
+
+    if ((u32)GPIO_InitStruct->GPIO_Mode & 0x10)
+        mode |= (u32)GPIO_InitStruct->GPIO_Speed;
+    crl = GPIOx->CRL;
+    crh = GPIOx->CRH;
+    for (u32 pin = 0; pin < 16; pin++) {
+        if (!(GPIO_InitStruct->GPIO_Pin & (1u << pin)))
+            continue;
+        if (pin < 8) {
+            crl &= ~(0xFu << (4 * pin));
+            crl |= mode << (4 * pin);
+        } else {
+            crh &= ~(0xFu << (4 * (pin - 8)));
+            crh |= mode << (4 * (pin - 8));
+        }
+        // 上拉/下拉输入由ODR选择
+        if (GPIO_InitStruct->GPIO_Mode == GPIO_Mode_IPU)
+            GPIOx->BSRR = 1u << pin;
+        else if (GPIO_InitStruct->GPIO_Mode == GPIO_Mode_IPD)
+            GPIOx->BRR = 1u << pin;
+    }
+    GPIOx->CRL = crl;
+    GPIOx->CRH = crh;
+}
+
+void GPIO_SetBits(GPIO_TypeDef *GPIOx, u16 GPIO_Pin)
+{
+    GPIOx->BSRR = GPIO_Pin;
+}
+
+void GPIO_ResetBits(GPIO_TypeDef *GPIOx, u16 GPIO_Pin)
+{
+    GPIOx->BRR = GPIO_Pin;
+}
+
+u8 GPIO_ReadInputDataBit(GPIO_TypeDef *GPIOx, u16 GPIO_Pin)
+{
+    return (GPIOx->IDR & GPIO_Pin) ? 1 : 0;
+}
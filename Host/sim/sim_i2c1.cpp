@@ -0,0 +1,289 @@
+// I2C1 + DMA1通道6/7寄存器模型（主模式）：字节级事务在写寄存器的时刻立即完成并按字节时间推进时钟，
+// 因为I2C1_DMA_Wait只自旋软件状态变量、不访问寄存器，事件链必须在触发它的那次写入里跑完
+#include "sim_internal.h"
+
+#include <vector>
+
+I2C_TypeDef sim_i2c1;
+
+namespace sim {
+namespace {
+
+const uint32_t kPclk1Hz = 36000000;
+const uint16_t kSr1EvFlags = I2C_SR1_SB | I2C_SR1_ADDR | I2C_SR1_BTF | I2C_SR1_STOPF | 0x0008;
+const uint16_t kSr1ErrFlags = 0xDF00;
+const uint16_t kSda = GPIO_Pin_7;       // PB7（I2C1_SDA）
+const uint16_t kScl = GPIO_Pin_6;       // PB6（I2C1_SCL）
+
+std::vector<I2cTarget *> g_targets;
+I2cTarget *g_addressed = 0;             // 应答了地址的从机
+bool g_active = false;                  // 已发出START、尚未STOP
+bool g_transmitter = false;
+uint32_t g_bytes = 0;
+
+template <typename T>
+size_t off(const T &reg)
+{
+    return (size_t)((const char *)&reg - (const char *)&sim_i2c1);
+}
+
+// 一位时间（内核周期）：标准模式Thigh=Tlow=CCR，快速模式Tlow:Thigh=2:1（DUTY=0）
+uint64_t bit_cycles()
+{
+    uint32_t ccr = sim_i2c1.CCR.v & 0x0FFF;
+    uint32_t pclk_per_bit;
+
+    if (ccr == 0)
+        ccr = 180;
+    pclk_per_bit = (sim_i2c1.CCR.v & 0x8000) ? 3 * ccr : 2 * ccr;
+    return (uint64_t)pclk_per_bit * kCoreClockHz / kPclk1Hz;
+}
+
+uint64_t byte_cycles()
+{
+    return 9 * bit_cycles();
+}
+
+void reset_state()
+{
+    if (g_active) {
+        for (size_t i = 0; i < g_targets.size(); i++)
+            g_targets[i]->i2c_stop();
+    }
+    g_active = false;
+    g_addressed = 0;
+    g_transmitter = false;
+}
+
+bool line_held()
+{
+    uint16_t level = pin_level(&sim_gpiob);
+    return !(level & kSda) || !(level & kScl);
+}
+
+// 地址字节：所有从机都看到，地址匹配的应答
+void send_address(uint8_t byte)
+{
+    bool ack = false;
+
+    detail::busy(byte_cycles());
+    g_bytes++;
+    g_addressed = 0;
+    for (size_t i = 0; i < g_targets.size(); i++) {
+        if (g_targets[i]->i2c_write(byte) && !g_addressed) {
+            g_addressed = g_targets[i];
+            ack = true;
+        }
+    }
+    g_transmitter = !(byte & 1);
+    if (ack) {
+        sim_i2c1.SR1.v |= I2C_SR1_ADDR;
+        sim_i2c1.SR2.v = (uint16_t)(I2C_SR2_MSL | I2C_SR2_BUSY | (g_transmitter ? I2C_SR2_TRA : 0));
+    } else {
+        sim_i2c1.SR1.v |= I2C_SR1_AF;
+    }
+}
+
+bool send_data(uint8_t byte)
+{
+    bool ack = g_addressed && g_addressed->i2c_write(byte);
+
+    detail::busy(byte_cycles());
+    g_bytes++;
+    if (ack)
+        sim_i2c1.SR1.v |= I2C_SR1_BTF | I2C_SR1_TXE;
+    else
+        sim_i2c1.SR1.v |= I2C_SR1_AF;
+    return ack;
+}
+
+// ADDR清除后DMA接管：发送方向推送CNDTR字节后置BTF；接收方向读CNDTR字节写入内存，
+// LAST置位时最后一个字节回NACK，完成后置TCIF7
+void run_dma()
+{
+    DMA_Channel_TypeDef &tx = sim_dma1_ch[5];
+    DMA_Channel_TypeDef &rx = sim_dma1_ch[6];
+
+    if (!(sim_i2c1.CR2.v & I2C_CR2_DMAEN) || !g_addressed)
+        return;
+    if (g_transmitter && (tx.CCR.v & DMA_CCR1_EN)) {
+        uint8_t *mem = (uint8_t *)detail::dma_memory(6);
+        while (tx.CNDTR.v > 0) {
+            uint8_t byte = *mem++;
+            tx.CNDTR.v--;
+            if (!send_data(byte))
+                return;
+            sim_i2c1.SR1.v &= ~I2C_SR1_BTF;
+        }
+        detail::dma_set_flags(6, 0x2);
+        sim_i2c1.SR1.v |= I2C_SR1_BTF | I2C_SR1_TXE;
+    } else if (!g_transmitter && (rx.CCR.v & DMA_CCR1_EN)) {
+        uint8_t *mem = (uint8_t *)detail::dma_memory(7);
+        while (rx.CNDTR.v > 0) {
+            bool last = rx.CNDTR.v == 1;
+            bool ack = (sim_i2c1.CR1.v & I2C_CR1_ACK) && !(last && (sim_i2c1.CR2.v & I2C_CR2_LAST));
+            *mem++ = g_addressed->i2c_read();
+            g_addressed->i2c_master_ack(ack);
+            detail::busy(byte_cycles());
+            g_bytes++;
+            rx.CNDTR.v--;
+        }
+        detail::dma_set_flags(7, 0x2);
+    }
+}
+
+void i2c1_read(size_t offset)
+{
+    if (offset == off(sim_i2c1.SR2) && !g_active) {
+        if (line_held())
+            sim_i2c1.SR2.v |= I2C_SR2_BUSY;
+        else
+            sim_i2c1.SR2.v &= ~I2C_SR2_BUSY;
+    }
+}
+
+// 固件以“读SR1再读SR2”清除ADDR；(void)I2C1->SR2不经过代理，这里在看到ADDR的那次SR1读之后清除
+void i2c1_after_read(size_t offset)
+{
+    if (offset == off(sim_i2c1.SR1) && (sim_i2c1.SR1.v & I2C_SR1_ADDR)) {
+        sim_i2c1.SR1.v &= ~I2C_SR1_ADDR;
+        run_dma();
+    }
+}
+
+void i2c1_write(size_t offset, uint32_t old)
+{
+    I2C_TypeDef &r = sim_i2c1;
+
+    if (offset == off(r.CR1)) {
+        if (r.CR1.v & I2C_CR1_SWRST) {
+            reset_state();
+            r.CR2.v = r.OAR1.v = r.OAR2.v = r.DR.v = r.SR1.v = r.SR2.v = r.CCR.v = 0;
+            r.TRISE.v = 0x0002;
+            return;
+        }
+        if (!(r.CR1.v & I2C_CR1_PE)) {
+            reset_state();
+            r.SR1.v = 0;
+            r.SR2.v = 0;
+            r.CR1.v &= ~(I2C_CR1_START | I2C_CR1_STOP);
+            return;
+        }
+        if ((r.CR1.v & I2C_CR1_START) && !(old & I2C_CR1_START)) {
+            // 空闲时线路被拉住：START发不出去，只报BUSY
+            if (!g_active && line_held()) {
+                r.SR2.v |= I2C_SR2_BUSY;
+                return;
+            }
+            detail::busy(bit_cycles());
+            for (size_t i = 0; i < g_targets.size(); i++)
+                g_targets[i]->i2c_start();
+            g_active = true;
+            g_addressed = 0;
+            r.CR1.v &= ~I2C_CR1_START;
+            r.SR1.v = (uint16_t)((r.SR1.v & ~(I2C_SR1_BTF | I2C_SR1_TXE)) | I2C_SR1_SB);
+            r.SR2.v = I2C_SR2_MSL | I2C_SR2_BUSY;
+        }
+        if ((r.CR1.v & I2C_CR1_STOP) && !(old & I2C_CR1_STOP)) {
+            detail::busy(bit_cycles());
+            reset_state();
+            r.CR1.v &= ~I2C_CR1_STOP;
+            r.SR1.v &= ~(I2C_SR1_BTF | I2C_SR1_TXE | I2C_SR1_SB | I2C_SR1_ADDR);
+            r.SR2.v = 0;
+        }
+    } else if (offset == off(r.DR)) {
+        if (!g_active)
+            return;
+        if (r.SR1.v & I2C_SR1_SB) {
+            r.SR1.v &= ~I2C_SR1_SB;
+            send_address((uint8_t)r.DR.v);
+        } else if (g_transmitter && g_addressed) {
+            r.SR1.v &= ~(I2C_SR1_BTF | I2C_SR1_TXE);
+            send_data((uint8_t)r.DR.v);
+        }
+    } else if (offset == off(r.SR1)) {
+        // 错误标志rc_w0，其余位只读
+        r.SR1.v = (uint16_t)((old & ~kSr1ErrFlags) | (old & r.SR1.v & kSr1ErrFlags));
+    } else if (offset == off(r.SR2)) {
+        r.SR2.v = (uint16_t)old;
+    }
+}
+
+bool ev_line()
+{
+    return (sim_i2c1.CR2.v & I2C_CR2_ITEVTEN) && (sim_i2c1.SR1.v & kSr1EvFlags);
+}
+
+bool er_line()
+{
+    return (sim_i2c1.CR2.v & I2C_CR2_ITERREN) && (sim_i2c1.SR1.v & kSr1ErrFlags);
+}
+
+struct Registrar {
+    Registrar()
+    {
+        detail::PeriphOps ops = { &sim_i2c1, sizeof sim_i2c1, 2, i2c1_read, i2c1_write, i2c1_after_read };
+        sim_i2c1.TRISE.v = 0x0002;
+        detail::register_periph(ops);
+        detail::register_irq_line(I2C1_EV_IRQn, ev_line);
+        detail::register_irq_line(I2C1_ER_IRQn, er_line);
+    }
+} g_registrar;
+
+}
+
+void i2c1_attach(I2cTarget *target)
+{
+    g_targets.push_back(target);
+}
+
+uint32_t i2c1_bytes()
+{
+    return g_bytes;
+}
+
+}
+
+/********************* SPL：I2C *********************/
+void I2C_DeInit(I2C_TypeDef *I2Cx)
+{
+    RCC_APB1PeriphResetCmd(RCC_APB1Periph_I2C1, ENABLE);
+    I2Cx->CR1 = I2C_CR1_SWRST;
+    I2Cx->CR1 = 0;
+    RCC_APB1PeriphResetCmd(RCC_APB1Periph_I2C1, DISABLE);
+}
+
+void I2C_Init(I2C_TypeDef *I2Cx, I2C_InitTypeDef *I2C_InitStruct)
+{
+    u32 pclk = 36000000;
+    u16 ccr;
+
+    I2Cx->CR2 = (u16)((I2Cx->CR2 & ~I2C_CR2_FREQ) | (pclk / 1000000));
+    I2Cx->CR1 = (u16)(I2Cx->CR1 & ~I2C_CR1_PE);
+    if (I2C_InitStruct->I2C_ClockSpeed <= 100000) {
+        ccr = (u16)(pclk / (I2C_InitStruct->I2C_ClockSpeed << 1));
+        if (ccr < 4)
+            ccr = 4;
+        I2Cx->TRISE = (u16)(pclk / 1000000 + 1);
+    } else {
+        if (I2C_InitStruct->I2C_DutyCycle == I2C_DutyCycle_2)
+            ccr = (u16)(pclk / (I2C_InitStruct->I2C_ClockSpeed * 3));
+        else
+            ccr = (u16)((pclk / (I2C_InitStruct->I2C_ClockSpeed * 25)) | I2C_DutyCycle_16_9);
+        if ((ccr & 0x0FFF) == 0)
+            ccr |= 1;
+        ccr |= 0x8000;
+        I2Cx->TRISE = (u16)((pclk / 1000000) * 300 / 1000 + 1);
+    }
+    I2Cx->CCR = ccr;
+    I2Cx->CR1 = (u16)((I2Cx->CR1 & ~(I2C_CR1_ACK | 0x001A)) | I2C_InitStruct->I2C_Mode | I2C_InitStruct->I2C_Ack | I2C_CR1_PE);
+    I2Cx->OAR1 = (u16)(I2C_InitStruct->I2C_AcknowledgedAddress | I2C_InitStruct->I2C_OwnAddress1);
+}
+
+void I2C_Cmd(I2C_TypeDef *I2Cx, FunctionalState NewState)
+{
+    if (NewState != DISABLE)
+        I2Cx->CR1 |= I2C_CR1_PE;
+    else
+        I2Cx->CR1 &= (u16)~I2C_CR1_PE;
+}
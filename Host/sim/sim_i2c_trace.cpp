@@ -0,0 +1,155 @@
+// GPIO I2C线上时序记录
+#include "sim_i2c_trace.h"
+
+#include <cstdio>
+
+namespace sim {
+
+I2cTiming i2c_spec(uint32_t speed_hz)
+{
+    I2cTiming s;
+
+    if (speed_hz > 100000) {
+        s.t_low = 1.3;  s.t_high = 0.6;  s.period = 2.5;
+        s.hd_sta = 0.6; s.su_sta = 0.6;  s.su_sto = 0.6;
+        s.buf = 1.3;    s.su_dat = 0.1;  s.hd_dat = 0.0;
+    } else {
+        s.t_low = 4.7;  s.t_high = 4.0;  s.period = 10.0;
+        s.hd_sta = 4.0; s.su_sta = 4.7;  s.su_sto = 4.0;
+        s.buf = 4.7;    s.su_dat = 0.25; s.hd_dat = 0.0;
+    }
+    return s;
+}
+
+I2cTimingTrace::I2cTimingTrace(GPIO_TypeDef *port, uint16_t scl_pin, uint16_t sda_pin)
+    : port_(port), scl_(scl_pin), sda_(sda_pin)
+{
+    reset();
+    add_pin_listener(port_, this);
+}
+
+I2cTimingTrace::~I2cTimingTrace()
+{
+    remove_pin_listener(port_, this);
+}
+
+void I2cTimingTrace::reset()
+{
+    I2cTiming none = { -1, -1, -1, -1, -1, -1, -1, -1, -1 };
+
+    min_ = none;
+    scl_edges_ = starts_ = stops_ = 0;
+    period_sum_ = 0;
+    period_n_ = 0;
+    in_transfer_ = high_has_cond_ = sda_changed_low_ = false;
+    have_rise_ = have_stop_ = pending_start_ = false;
+}
+
+void I2cTimingTrace::note(double *slot, uint64_t from, uint64_t to)
+{
+    double us = cycles_to_us(to - from);
+
+    if (*slot < 0 || us < *slot)
+        *slot = us;
+}
+
+void I2cTimingTrace::on_pins(GPIO_TypeDef *port, uint16_t old_level, uint16_t new_level)
+{
+    bool scl_old = (old_level & scl_) != 0;
+    bool scl_new = (new_level & scl_) != 0;
+    bool sda_old = (old_level & sda_) != 0;
+    bool sda_new = (new_level & sda_) != 0;
+    uint64_t t = now();
+
+    (void)port;
+    if (scl_old != scl_new)
+        scl_edges_++;
+
+    // SDA先于SCL处理：同一时刻两者都变化时按SCL高电平期间的SDA变化算
+    if (sda_old != sda_new) {
+        if (scl_old && scl_new) {
+            high_has_cond_ = true;
+            if (!sda_new) {
+                // START / 重复START
+                starts_++;
+                if (in_transfer_ && have_rise_)
+                    note(&min_.su_sta, scl_rise_, t);
+                else if (have_stop_)
+                    note(&min_.buf, stop_at_, t);
+                start_at_ = t;
+                pending_start_ = true;
+                in_transfer_ = true;
+            } else {
+                stops_++;
+                if (have_rise_)
+                    note(&min_.su_sto, scl_rise_, t);
+                stop_at_ = t;
+                have_stop_ = true;
+                in_transfer_ = false;
+                have_rise_ = false;
+            }
+        } else if (!scl_old && !scl_new) {
+            if (in_transfer_)
+                note(&min_.hd_dat, scl_fall_, t);
+            sda_change_ = t;
+            sda_changed_low_ = true;
+        }
+    }
+
+    if (!scl_old && scl_new) {
+        if (in_transfer_) {
+            note(&min_.t_low, scl_fall_, t);
+            if (sda_changed_low_)
+                note(&min_.su_dat, sda_change_, t);
+            if (have_rise_) {
+                note(&min_.period, prev_rise_, t);
+                period_sum_ += cycles_to_us(t - prev_rise_);
+                period_n_++;
+            }
+            prev_rise_ = t;
+        }
+        scl_rise_ = t;
+        have_rise_ = in_transfer_;
+        high_has_cond_ = false;
+        sda_changed_low_ = false;
+    } else if (scl_old && !scl_new) {
+        if (pending_start_) {
+            note(&min_.hd_sta, start_at_, t);
+            pending_start_ = false;
+            // START之后的第一个时钟周期与前面的高电平不相邻
+            have_rise_ = false;
+        } else if (in_transfer_ && have_rise_ && !high_has_cond_) {
+            note(&min_.t_high, scl_rise_, t);
+        }
+        scl_fall_ = t;
+        sda_changed_low_ = false;
+    }
+}
+
+std::string I2cTimingTrace::violations(const I2cTiming &spec) const
+{
+    struct Item { const char *name; double got; double want; };
+    const Item items[] = {
+        { "tLOW", min_.t_low, spec.t_low },
+        { "tHIGH", min_.t_high, spec.t_high },
+        { "tSCL", min_.period, spec.period },
+        { "tHD;STA", min_.hd_sta, spec.hd_sta },
+        { "tSU;STA", min_.su_sta, spec.su_sta },
+        { "tSU;STO", min_.su_sto, spec.su_sto },
+        { "tBUF", min_.buf, spec.buf },
+        { "tSU;DAT", min_.su_dat, spec.su_dat },
+        { "tHD;DAT", min_.hd_dat, spec.hd_dat },
+    };
+    std::string out;
+    char text[64];
+
+    for (size_t i = 0; i < sizeof items / sizeof items[0]; i++) {
+        if (items[i].got >= 0 && items[i].got + 1e-9 < items[i].want) {
+            std::snprintf(text, sizeof text, "%s=%.2fus<%.2fus; ", items[i].name, items[i].got, items[i].want);
+            out += text;
+        }
+    }
+    return out;
+}
+
+}
@@ -0,0 +1,74 @@
+// GPIO I2C线上时序记录：按仿真时钟给SCL/SDA的每个边沿打时间戳，统计各时序参数的最小值并对照I2C规范
+#ifndef SIM_I2C_TRACE_H
+#define SIM_I2C_TRACE_H
+
+#include "sim_core.h"
+
+#include <string>
+
+namespace sim {
+
+// 各参数单位us；规范值取I2C-bus specification（UM10204）表10的最小值
+struct I2cTiming {
+    double t_low;       // SCL低电平
+    double t_high;      // SCL高电平（不含START/STOP所在的高电平段）
+    double period;      // 相邻SCL上升沿（同一事务内）
+    double hd_sta;      // START(SDA下降) -> SCL下降
+    double su_sta;      // 重复START：SCL上升 -> SDA下降
+    double su_sto;      // SCL上升 -> STOP(SDA上升)
+    double buf;         // STOP -> 下一个START
+    double su_dat;      // SCL低电平期间SDA变化 -> SCL上升
+    double hd_dat;      // SCL下降 -> SDA变化
+};
+
+I2cTiming i2c_spec(uint32_t speed_hz);
+
+class I2cTimingTrace : public PinListener {
+public:
+    I2cTimingTrace(GPIO_TypeDef *port, uint16_t scl_pin, uint16_t sda_pin);
+    ~I2cTimingTrace();
+
+    void on_pins(GPIO_TypeDef *port, uint16_t old_level, uint16_t new_level) override;
+    void reset();
+
+    // 最小值（没有样本的参数为-1）
+    const I2cTiming &min() const { return min_; }
+    uint32_t scl_edges() const { return scl_edges_; }
+    uint32_t starts() const { return starts_; }
+    uint32_t stops() const { return stops_; }
+    // 事务内相邻SCL上升沿的平均间隔（us，没有样本为-1），即实际总线速率
+    double mean_period() const { return period_n_ ? period_sum_ / period_n_ : -1; }
+
+    // 与规范比较，返回不满足的参数列表（"tLOW=4.52us<4.70us; ..."），全部满足为空串
+    std::string violations(const I2cTiming &spec) const;
+
+private:
+    void note(double *slot, uint64_t from, uint64_t to);
+
+    GPIO_TypeDef *port_;
+    uint16_t scl_;
+    uint16_t sda_;
+    I2cTiming min_;
+    uint32_t scl_edges_ = 0;
+    uint32_t starts_ = 0;
+    uint32_t stops_ = 0;
+    double period_sum_ = 0;
+    uint32_t period_n_ = 0;
+
+    bool in_transfer_ = false;
+    bool high_has_cond_ = false;        // 本次SCL高电平内出现过START/STOP
+    bool sda_changed_low_ = false;      // 本次SCL低电平内SDA变化过
+    uint64_t scl_rise_ = 0;
+    uint64_t scl_fall_ = 0;
+    uint64_t prev_rise_ = 0;
+    uint64_t sda_change_ = 0;
+    uint64_t start_at_ = 0;
+    uint64_t stop_at_ = 0;
+    bool have_rise_ = false;
+    bool have_stop_ = false;
+    bool pending_start_ = false;
+};
+
+}
+
+#endif
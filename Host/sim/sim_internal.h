@@ -0,0 +1,43 @@
+// 仿真库内部接口：外设模型向寄存器分派表注册，共享时钟推进、中断线与DMA通道
+// 模型内部一律通过寄存器的 .v 成员直接读写，不经代理（代理只属于固件侧的访问）
+#ifndef SIM_INTERNAL_H
+#define SIM_INTERNAL_H
+
+#include "sim_core.h"
+
+namespace sim {
+namespace detail {
+
+// 寄存器访问：read在值被锁存前刷新寄存器，write在新值存入后执行写入语义（old为写前的值）
+struct PeriphOps {
+    void *base;
+    size_t size;
+    unsigned width;                     // 寄存器宽度（字节）：I2C/USART/TIM为2，其余为4
+    void (*read)(size_t offset);
+    void (*write)(size_t offset, uint32_t old);
+    void (*after_read)(size_t offset);  // 值已锁存之后（读清零等“读序列”副作用），可为空
+};
+void register_periph(const PeriphOps &ops);
+
+// 外设事务占用的时间（如I2C1按字节时间推进），计入运行周期并执行到期的设备事件
+void busy(uint64_t cycles);
+uint64_t active_cycles();               // 非睡眠周期（DWT计数来源）
+
+// 中断线：电平有效，派发前查询；SysTick等无外设标志的用挂起锁存
+void register_irq_line(int irqn, bool (*line)());
+void pend_irq(int irqn);
+bool systick_pending();
+
+// DMA1：通道号1~7；CMAR写入时按低32位还原出主机指针
+uintptr_t dma_memory(int channel);
+void dma_set_flags(int channel, uint32_t flags);    // 通道内的 GIF/TCIF/HTIF/TEIF（低4位）
+void dma_on_enable(int channel, void (*hook)(int channel));
+uintptr_t recover_pointer(uint32_t low);
+
+// GPIO电平变化时的EXTI边沿检测
+void exti_edges(GPIO_TypeDef *port, uint16_t falling, uint16_t rising);
+
+}
+}
+
+#endif
@@ -0,0 +1,484 @@
+// 虚拟OPT3001与GPIO按位I2C从机前端
+#include "sim_opt3001.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+namespace sim {
+
+namespace {
+
+const uint16_t kCfgWritable = 0xFE1F;   // RN/CT/M/L/POL/ME/FC
+const uint16_t kCfgOvf = 0x0100;
+const uint16_t kCfgCrf = 0x0080;
+const uint16_t kCfgFh = 0x0040;
+const uint16_t kCfgFl = 0x0020;
+const uint16_t kCfgL = 0x0010;
+const uint16_t kCfgPol = 0x0008;
+const uint16_t kCfgCt = 0x0800;
+const double kIntPulseUs = 1.0;         // 非锁存转换完成指示的INT脉宽
+
+}
+
+/********************* I2cWire *********************/
+I2cWire::I2cWire(I2cTarget *target, GPIO_TypeDef *port, uint16_t scl_pin, uint16_t sda_pin)
+    : target_(target), port_(port), scl_(scl_pin), sda_(sda_pin)
+{
+    add_pin_listener(port_, this);
+}
+
+I2cWire::~I2cWire()
+{
+    remove_pin_listener(port_, this);
+    set_pull_low(port_, sda_, false, this);
+}
+
+void I2cWire::set_sda(bool low)
+{
+    if (low == pull_)
+        return;
+    pull_ = low;
+    set_pull_low(port_, sda_, low, this);
+}
+
+void I2cWire::log_bit(bool sda)
+{
+    char text[8];
+
+    if (!trace_enabled)
+        return;
+    log_shift_ = (log_shift_ << 1) | (sda ? 1u : 0u);
+    if (++log_bits_ == 9) {
+        std::snprintf(text, sizeof text, "%02X%c ", (log_shift_ >> 1) & 0xFF, (log_shift_ & 1) ? 'N' : 'A');
+        trace += text;
+        log_bits_ = 0;
+        log_shift_ = 0;
+    }
+}
+
+void I2cWire::hold_sda(unsigned bits)
+{
+    if (bits == 0 || bits > 8)
+        bits = 8;
+    phase_ = kTransmit;
+    tx_ = 0;
+    bit_ = 8 - (int)bits;
+    set_sda(true);
+}
+
+void I2cWire::on_pins(GPIO_TypeDef *port, uint16_t old_level, uint16_t new_level)
+{
+    bool scl_old = (old_level & scl_) != 0;
+    bool scl_new = (new_level & scl_) != 0;
+    bool sda_old = (old_level & sda_) != 0;
+    bool sda_new = (new_level & sda_) != 0;
+
+    (void)port;
+    // SCL高电平期间SDA变化：START/STOP
+    if (scl_old && scl_new && sda_old != sda_new) {
+        if (!sda_new) {
+            if (trace_enabled)
+                trace += "S ";
+            log_bits_ = 0;
+            log_shift_ = 0;
+            target_->i2c_start();
+            phase_ = kReceive;
+            first_byte_ = true;
+            bit_ = 0;
+            shift_ = 0;
+        } else {
+            if (trace_enabled)
+                trace += "P ";
+            // STOP前的SCL上升沿不是数据位
+            log_bits_ = 0;
+            log_shift_ = 0;
+            target_->i2c_stop();
+            phase_ = kIdle;
+        }
+        set_sda(false);
+        return;
+    }
+    // 上升沿采样
+    if (!scl_old && scl_new) {
+        log_bit(sda_new);
+        if (phase_ == kReceive) {
+            shift_ = (uint8_t)((shift_ << 1) | (sda_new ? 1 : 0));
+            bit_++;
+        } else if (phase_ == kMasterAck) {
+            master_ack_ = !sda_new;
+        }
+        return;
+    }
+    // 下降沿之后改变SDA
+    if (scl_old && !scl_new) {
+        switch (phase_) {
+        case kReceive:
+            if (bit_ < 8)
+                break;
+            if (!target_->i2c_write(shift_)) {
+                phase_ = kIdle;
+                set_sda(false);
+                break;
+            }
+            if (first_byte_)
+                read_ = (shift_ & 1) != 0;
+            first_byte_ = false;
+            phase_ = kAckOut;
+            set_sda(true);
+            break;
+        case kAckOut:
+            if (read_) {
+                tx_ = target_->i2c_read();
+                bit_ = 0;
+                phase_ = kTransmit;
+                set_sda(!(tx_ & 0x80));
+            } else {
+                phase_ = kReceive;
+                bit_ = 0;
+                shift_ = 0;
+                set_sda(false);
+            }
+            break;
+        case kTransmit:
+            if (++bit_ == 8) {
+                phase_ = kMasterAck;
+                set_sda(false);
+            } else {
+                set_sda(!(tx_ & (0x80 >> bit_)));
+            }
+            break;
+        case kMasterAck:
+            target_->i2c_master_ack(master_ack_);
+            if (master_ack_) {
+                tx_ = target_->i2c_read();
+                bit_ = 0;
+                phase_ = kTransmit;
+                set_sda(!(tx_ & 0x80));
+            } else {
+                phase_ = kIdle;
+                set_sda(false);
+            }
+            break;
+        default:
+            break;
+        }
+    }
+}
+
+/********************* Opt3001 *********************/
+Opt3001::Opt3001(uint8_t addr)
+    : addr_(addr)
+{
+    lux = [](double) { return 100.0; };
+    reset_stats();
+    power_on_reset();
+    add_device(this);
+}
+
+Opt3001::~Opt3001()
+{
+    remove_device(this);
+    delete wire_;
+    if (sda_port_)
+        set_pull_low(sda_port_, sda_pin_, false, &short_owner_);
+    if (int_port_)
+        set_pull_low(int_port_, int_pin_, false, this);
+}
+
+I2cWire &Opt3001::attach_wire(GPIO_TypeDef *port, uint16_t scl_pin, uint16_t sda_pin)
+{
+    delete wire_;
+    wire_ = new I2cWire(this, port, scl_pin, sda_pin);
+    sda_port_ = port;
+    sda_pin_ = sda_pin;
+    return *wire_;
+}
+
+void Opt3001::attach_i2c1()
+{
+    i2c1_attach(this);
+}
+
+void Opt3001::attach_int(GPIO_TypeDef *port, uint16_t pin)
+{
+    int_port_ = port;
+    int_pin_ = pin;
+    apply_int_pin();
+}
+
+void Opt3001::reset_stats()
+{
+    std::memset(&stats_, 0, sizeof stats_);
+}
+
+void Opt3001::hold_sda(unsigned bits)
+{
+    if (wire_)
+        wire_->hold_sda(bits);
+}
+
+void Opt3001::short_sda(bool on)
+{
+    if (sda_port_)
+        set_pull_low(sda_port_, sda_pin_, on, &short_owner_);
+}
+
+void Opt3001::power_on_reset()
+{
+    std::memset(regs_, 0, sizeof regs_);
+    regs_[0x01] = 0xC810;
+    regs_[0x02] = 0xC000;
+    regs_[0x03] = 0xBFFF;
+    regs_[0x7E] = 0x5449;
+    regs_[0x7F] = 0x3001;
+    ptr_ = 0;
+    phase_ = kIdle;
+    conv_end_ = UINT64_MAX;
+    int_pulse_end_ = UINT64_MAX;
+    fault_count_ = 0;
+    set_int(false);
+}
+
+/********************* 字节级从机 *********************/
+void Opt3001::i2c_start()
+{
+    phase_ = present ? kAddress : kIdle;
+}
+
+bool Opt3001::i2c_write(uint8_t byte)
+{
+    if (phase_ == kIdle || phase_ == kReadHigh || phase_ == kReadLow)
+        return false;
+    if (nack_skip_ > 0) {
+        nack_skip_--;
+    } else if (nack_next_ > 0) {
+        nack_next_--;
+        phase_ = kIdle;
+        return false;
+    }
+    switch (phase_) {
+    case kAddress:
+        if ((byte >> 1) != addr_) {
+            phase_ = kIdle;
+            return false;
+        }
+        stats_.starts++;
+        phase_ = (byte & 1) ? kReadHigh : kPointer;
+        break;
+    case kPointer:
+        ptr_ = byte;
+        stats_.ptr_writes++;
+        phase_ = kDataHigh;
+        break;
+    case kDataHigh:
+        data_high_ = byte;
+        phase_ = kDataLow;
+        break;
+    case kDataLow:
+        stats_.reg_writes++;
+        write_register(ptr_, (uint16_t)((data_high_ << 8) | byte));
+        phase_ = kDone;
+        break;
+    default:
+        break;
+    }
+    stats_.bytes++;
+    return true;
+}
+
+uint8_t Opt3001::i2c_read()
+{
+    if (phase_ == kReadHigh) {
+        read_word_ = read_register(ptr_);
+        phase_ = kReadLow;
+        stats_.bytes++;
+        return (uint8_t)(read_word_ >> 8);
+    }
+    if (phase_ == kReadLow) {
+        phase_ = kReadHigh;
+        stats_.bytes++;
+        return (uint8_t)read_word_;
+    }
+    return 0xFF;
+}
+
+void Opt3001::i2c_master_ack(bool ack)
+{
+    if (!ack)
+        phase_ = kIdle;
+}
+
+void Opt3001::i2c_stop()
+{
+    phase_ = kIdle;
+}
+
+/********************* 寄存器 *********************/
+uint16_t Opt3001::read_register(uint8_t r)
+{
+    uint16_t value = regs_[r];
+
+    if (r == 0x00) {
+        stats_.result_reads++;
+    } else if (r == 0x01) {
+        // 读配置寄存器清除CRF；锁存模式下同时清除FH/FL并释放INT
+        stats_.config_reads++;
+        regs_[0x01] &= ~kCfgCrf;
+        if (regs_[0x01] & kCfgL) {
+            regs_[0x01] &= ~(kCfgFh | kCfgFl);
+            set_int(false);
+        }
+    }
+    return value;
+}
+
+void Opt3001::write_register(uint8_t r, uint16_t v)
+{
+    if (r == 0x01) {
+        regs_[0x01] = (uint16_t)((regs_[0x01] & ~kCfgWritable) | (v & kCfgWritable));
+        fault_count_ = 0;
+        // M=00关断；其余模式从写入时刻重新开始一次转换
+        if (((regs_[0x01] >> 9) & 3) == 0)
+            conv_end_ = UINT64_MAX;
+        else
+            start_conversion(now());
+        apply_int_pin();
+    } else if (r == 0x02 || r == 0x03) {
+        regs_[r] = v;
+    }
+}
+
+void Opt3001::start_conversion(uint64_t t)
+{
+    double ms = (regs_[0x01] & kCfgCt) ? 800.0 : 100.0;
+    conv_start_ = t;
+    conv_end_ = t + ms_to_cycles(ms * conv_scale);
+}
+
+uint32_t Opt3001::to_centilux(uint16_t raw)
+{
+    return (uint32_t)(raw & 0x0FFF) << (raw >> 12);
+}
+
+uint16_t Opt3001::encode(double centilux, int range, bool *overflow)
+{
+    *overflow = false;
+    if (centilux < 0)
+        centilux = 0;
+    if (range >= 12) {
+        for (int e = 0; e < 12; e++) {
+            double r = std::floor(centilux / (double)(1u << e));
+            if (r <= 4095)
+                return (uint16_t)((e << 12) | (int)r);
+        }
+        *overflow = true;
+        return 0xBFFF;
+    }
+    double r = std::floor(centilux / (double)(1u << range));
+    if (r > 4095) {
+        r = 4095;
+        *overflow = true;
+    }
+    return (uint16_t)((range << 12) | (int)r);
+}
+
+// 转换完成：结果取积分窗口平均照度，更新CRF/OVF/FH/FL与INT；单次模式回到关断
+void Opt3001::complete_conversion()
+{
+    const int kSamples = 8;
+    uint64_t end = conv_end_;
+    double t0 = cycles_to_us(conv_start_) / 1e6;
+    double t1 = cycles_to_us(end) / 1e6;
+    double sum = 0;
+    bool overflow;
+    uint16_t cfg = regs_[0x01];
+    int mode = (cfg >> 9) & 3;
+    int need = 1 << (cfg & 3);
+    bool eoc = (regs_[0x02] & 0xF000) == 0xC000;
+
+    for (int i = 0; i < kSamples; i++)
+        sum += lux(t0 + (t1 - t0) * (i + 0.5) / kSamples);
+    regs_[0x00] = encode(sum / kSamples * 100.0, cfg >> 12, &overflow);
+    stats_.conversions++;
+
+    cfg |= kCfgCrf;
+    if (overflow)
+        cfg |= kCfgOvf;
+    else
+        cfg &= ~kCfgOvf;
+
+    uint32_t value = to_centilux(regs_[0x00]);
+    bool above = value > to_centilux(regs_[0x03]);
+    bool below = !eoc && value < to_centilux(regs_[0x02]);
+    if (above || below)
+        fault_count_++;
+    else
+        fault_count_ = 0;
+
+    if (cfg & kCfgL) {
+        if (above && fault_count_ >= need)
+            cfg |= kCfgFh;
+        if (below && fault_count_ >= need)
+            cfg |= kCfgFl;
+    } else {
+        if (above && fault_count_ >= need)
+            cfg = (uint16_t)((cfg | kCfgFh) & ~kCfgFl);
+        if (below && fault_count_ >= need)
+            cfg = (uint16_t)((cfg | kCfgFl) & ~kCfgFh);
+    }
+    if (mode == 1)
+        cfg &= ~0x0600;
+    regs_[0x01] = cfg;
+
+    if (eoc) {
+        set_int(true);
+        if (!(cfg & kCfgL))
+            int_pulse_end_ = end + us_to_cycles(kIntPulseUs);
+    } else if (cfg & kCfgL) {
+        if (cfg & (kCfgFh | kCfgFl))
+            set_int(true);
+    } else {
+        set_int((cfg & kCfgFh) != 0);
+    }
+
+    if (mode >= 2)
+        start_conversion(end);
+    else
+        conv_end_ = UINT64_MAX;
+}
+
+void Opt3001::set_int(bool active)
+{
+    int_active_ = active;
+    apply_int_pin();
+}
+
+// INT开漏：POL=0低有效，POL=1高有效
+void Opt3001::apply_int_pin()
+{
+    bool pol = (regs_[0x01] & kCfgPol) != 0;
+    if (int_port_)
+        set_pull_low(int_port_, int_pin_, int_active_ != pol, this);
+}
+
+uint64_t Opt3001::next_event() const
+{
+    return conv_end_ < int_pulse_end_ ? conv_end_ : int_pulse_end_;
+}
+
+void Opt3001::run_until(uint64_t t)
+{
+    for (;;) {
+        if (conv_end_ <= t && conv_end_ <= int_pulse_end_) {
+            complete_conversion();
+        } else if (int_pulse_end_ <= t) {
+            int_pulse_end_ = UINT64_MAX;
+            set_int(false);
+        } else {
+            break;
+        }
+    }
+}
+
+}
@@ -0,0 +1,149 @@
+// 虚拟OPT3001：寄存器0x00~0x03/0x7E/0x7F、按CT计时的转换引擎、INT输出与故障注入；
+// 总线前端有两种：按位解码GPIO引脚的I2cWire（软件IIC/多通道）与I2C1寄存器模型
+#ifndef SIM_OPT3001_H
+#define SIM_OPT3001_H
+
+#include "sim_core.h"
+
+#include <string>
+
+namespace sim {
+
+/********************* GPIO线上的I2C从机前端 *********************/
+// 监听SCL/SDA的电平变化，按位驱动一个I2cTarget：SCL上升沿采样，下降沿后才改变SDA
+class I2cWire : public PinListener {
+public:
+    I2cWire(I2cTarget *target, GPIO_TypeDef *port, uint16_t scl_pin, uint16_t sda_pin);
+    ~I2cWire();
+
+    void on_pins(GPIO_TypeDef *port, uint16_t old_level, uint16_t new_level) override;
+
+    // 从机卡在发送字节中途：立即拉住SDA（发送0），再被时钟移出bits位后释放
+    void hold_sda(unsigned bits);
+
+    // 线上解码记录（"S 88A 00A S 89A 12A 34N P "），trace_enabled为true时追加
+    bool trace_enabled = false;
+    std::string trace;
+
+private:
+    enum Phase { kIdle, kReceive, kAckOut, kTransmit, kMasterAck };
+
+    void set_sda(bool low);
+    void log_bit(bool sda);
+
+    I2cTarget *target_;
+    GPIO_TypeDef *port_;
+    uint16_t scl_;
+    uint16_t sda_;
+    Phase phase_ = kIdle;
+    bool first_byte_ = false;
+    bool read_ = false;
+    bool master_ack_ = false;
+    int bit_ = 0;
+    uint8_t shift_ = 0;
+    uint8_t tx_ = 0;
+    bool pull_ = false;
+    int log_bits_ = 0;
+    unsigned log_shift_ = 0;
+};
+
+/********************* OPT3001器件 *********************/
+class Opt3001 : public Device, public I2cTarget {
+public:
+    struct Stats {
+        uint32_t starts;            // 寻址到本器件的START
+        uint32_t bytes;             // 本器件应答/发出的字节（含地址）
+        uint32_t ptr_writes;        // 指针写入
+        uint32_t reg_writes;        // 寄存器写入
+        uint32_t result_reads;      // 结果寄存器读（按高字节计）
+        uint32_t config_reads;      // 配置寄存器读
+        uint32_t conversions;       // 完成的转换
+    };
+
+    explicit Opt3001(uint8_t addr = 0x44);
+    ~Opt3001();
+
+    // 接线：软件IIC引脚（GPIO按位前端）、I2C1外设、INT引脚（开漏）
+    I2cWire &attach_wire(GPIO_TypeDef *port, uint16_t scl_pin, uint16_t sda_pin);
+    void attach_i2c1();
+    void attach_int(GPIO_TypeDef *port, uint16_t pin);
+    I2cWire *wire() { return wire_; }
+
+    // 光照来源（lux，参数为仿真时间秒），转换结果取积分窗口内的平均值
+    std::function<double(double)> lux;
+    double conv_scale = 1.0;        // 转换时间系数（器件CT偏差，手册±10%）
+
+    uint8_t address() const { return addr_; }
+    uint16_t reg(uint8_t r) const { return regs_[r]; }
+    void set_reg(uint8_t r, uint16_t v) { regs_[r] = v; }
+    uint8_t pointer() const { return ptr_; }
+    bool int_active() const { return int_active_; }
+    bool converting() const { return conv_end_ != UINT64_MAX; }
+    uint64_t conversion_end() const { return conv_end_; }
+    const Stats &stats() const { return stats_; }
+    void reset_stats();
+
+    // 故障注入
+    bool present = true;            // false：地址无应答
+    // 跳过skip个写入字节后，接下来的bytes个写入字节无应答（指针不更新）
+    void nack_next(unsigned bytes, unsigned skip = 0)
+    {
+        nack_next_ = bytes;
+        nack_skip_ = skip;
+    }
+    void hold_sda(unsigned bits);   // 字节中途卡住SDA（需GPIO前端）
+    void short_sda(bool on);        // SDA对地短路（永久拉低，需GPIO前端）
+    void power_on_reset();          // 掉电复位：寄存器回到上电值，指针归零，停止转换
+
+    // I2cTarget
+    void i2c_start() override;
+    bool i2c_write(uint8_t byte) override;
+    uint8_t i2c_read() override;
+    void i2c_master_ack(bool ack) override;
+    void i2c_stop() override;
+
+    // Device：转换完成与INT脉冲
+    uint64_t next_event() const override;
+    void run_until(uint64_t t) override;
+
+    // 换算工具：结果/限值寄存器 <-> 0.01lux
+    static uint32_t to_centilux(uint16_t raw);
+    static uint16_t encode(double centilux, int range, bool *overflow);
+
+private:
+    enum Phase { kIdle, kAddress, kPointer, kDataHigh, kDataLow, kDone, kReadHigh, kReadLow };
+
+    uint16_t read_register(uint8_t r);
+    void write_register(uint8_t r, uint16_t v);
+    void start_conversion(uint64_t t);
+    void complete_conversion();
+    void set_int(bool active);
+    void apply_int_pin();
+
+    uint8_t addr_;
+    uint16_t regs_[256];
+    uint8_t ptr_ = 0;
+    Phase phase_ = kIdle;
+    uint8_t data_high_ = 0;
+    uint16_t read_word_ = 0;
+    unsigned nack_next_ = 0;
+    unsigned nack_skip_ = 0;
+    Stats stats_;
+
+    uint64_t conv_start_ = 0;
+    uint64_t conv_end_ = UINT64_MAX;
+    uint64_t int_pulse_end_ = UINT64_MAX;
+    bool int_active_ = false;
+    int fault_count_ = 0;
+
+    I2cWire *wire_ = nullptr;
+    GPIO_TypeDef *sda_port_ = nullptr;
+    uint16_t sda_pin_ = 0;
+    GPIO_TypeDef *int_port_ = nullptr;
+    uint16_t int_pin_ = 0;
+    int short_owner_ = 0;
+};
+
+}
+
+#endif
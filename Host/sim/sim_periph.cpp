@@ -0,0 +1,555 @@
+// 内核与片上外设模型：SysTick、SCB、DWT、TIM2、EXTI/AFIO、DMA1、RCC、Flash、IWDG及其余纯存储寄存器
+#include "sim_internal.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <sys/mman.h>
+
+#ifndef MAP_FIXED_NOREPLACE
+#define MAP_FIXED_NOREPLACE 0x100000
+#endif
+
+SysTick_Type        sim_systick;
+SCB_Type            sim_scb;
+DWT_Type            sim_dwt;
+CoreDebug_Type      sim_coredebug;
+TIM_TypeDef         sim_tim2;
+EXTI_TypeDef        sim_exti;
+AFIO_TypeDef        sim_afio;
+DMA_TypeDef         sim_dma1;
+DMA_Channel_TypeDef sim_dma1_ch[7];
+RCC_TypeDef         sim_rcc;
+FLASH_TypeDef       sim_flash;
+IWDG_TypeDef        sim_iwdg;
+PWR_TypeDef         sim_pwr;
+DBGMCU_TypeDef      sim_dbgmcu;
+
+namespace sim {
+namespace {
+
+const uint32_t kLsiHz = 40000;
+const uint32_t kFlashPage = 1024;
+const double kFlashEraseMs = 20.0;      // 页擦除时间（手册典型值）
+
+template <typename T>
+size_t off(const T &reg, const void *base)
+{
+    return (size_t)((const char *)&reg - (const char *)base);
+}
+
+/********************* SysTick *********************/
+// CLKSOURCE=0时按HCLK/8计数；VAL由时间推算，每(LOAD+1)个计数挂起一次SysTick
+class SysTickDevice : public Device {
+public:
+    uint64_t epoch = 0;
+    uint64_t next_fire = UINT64_MAX;
+
+    uint64_t divider() const
+    {
+        return (sim_systick.CTRL.v & SysTick_CTRL_CLKSOURCE_Msk) ? 1 : 8;
+    }
+
+    uint64_t period() const
+    {
+        return ((uint64_t)(sim_systick.LOAD.v & SysTick_LOAD_RELOAD_Msk) + 1) * divider();
+    }
+
+    void restart()
+    {
+        epoch = now();
+        next_fire = (sim_systick.CTRL.v & SysTick_CTRL_ENABLE_Msk) ? epoch + period() : UINT64_MAX;
+    }
+
+    uint32_t value() const
+    {
+        uint64_t ticks;
+        uint32_t load = sim_systick.LOAD.v & SysTick_LOAD_RELOAD_Msk;
+        if (!(sim_systick.CTRL.v & SysTick_CTRL_ENABLE_Msk))
+            return sim_systick.VAL.v;
+        ticks = (now() - epoch) / divider();
+        return load - (uint32_t)(ticks % ((uint64_t)load + 1));
+    }
+
+    uint64_t next_event() const override
+    {
+        return next_fire;
+    }
+
+    void run_until(uint64_t t) override
+    {
+        while (next_fire <= t) {
+            if (sim_systick.CTRL.v & SysTick_CTRL_TICKINT_Msk)
+                detail::pend_irq(SysTick_IRQn);
+            next_fire += period();
+        }
+    }
+} g_systick;
+
+void systick_read(size_t offset)
+{
+    if (offset == off(sim_systick.VAL, &sim_systick))
+        sim_systick.VAL.v = g_systick.value();
+}
+
+void systick_write(size_t offset, uint32_t old)
+{
+    if (offset == off(sim_systick.CTRL, &sim_systick)) {
+        if ((sim_systick.CTRL.v ^ old) & (SysTick_CTRL_ENABLE_Msk | SysTick_CTRL_CLKSOURCE_Msk))
+            g_systick.restart();
+    } else if (offset == off(sim_systick.VAL, &sim_systick)) {
+        sim_systick.VAL.v = 0;
+        g_systick.restart();
+    } else if (offset == off(sim_systick.LOAD, &sim_systick)) {
+        if (sim_systick.CTRL.v & SysTick_CTRL_ENABLE_Msk)
+            g_systick.next_fire = g_systick.epoch + g_systick.period();
+    }
+}
+
+/********************* SCB *********************/
+void scb_read(size_t offset)
+{
+    if (offset == off(sim_scb.ICSR, &sim_scb)) {
+        if (detail::systick_pending())
+            sim_scb.ICSR.v |= SCB_ICSR_PENDSTSET_Msk;
+        else
+            sim_scb.ICSR.v &= ~SCB_ICSR_PENDSTSET_Msk;
+    }
+}
+
+void scb_write(size_t offset, uint32_t old)
+{
+    (void)old;
+    if (offset == off(sim_scb.ICSR, &sim_scb)) {
+        if (sim_scb.ICSR.v & SCB_ICSR_PENDSTSET_Msk)
+            detail::pend_irq(SysTick_IRQn);
+        sim_scb.ICSR.v &= SCB_ICSR_PENDSTSET_Msk;
+    }
+}
+
+/********************* DWT *********************/
+// CYCCNT只计非睡眠周期（WFI期间内核时钟停止）
+uint64_t g_cyccnt_base = 0;
+
+void dwt_read(size_t offset)
+{
+    if (offset == off(sim_dwt.CYCCNT, &sim_dwt) && (sim_dwt.CTRL.v & DWT_CTRL_CYCCNTENA_Msk))
+        sim_dwt.CYCCNT.v = (uint32_t)(detail::active_cycles() - g_cyccnt_base);
+}
+
+void dwt_write(size_t offset, uint32_t old)
+{
+    if (offset == off(sim_dwt.CYCCNT, &sim_dwt)) {
+        g_cyccnt_base = detail::active_cycles() - sim_dwt.CYCCNT.v;
+    } else if (offset == off(sim_dwt.CTRL, &sim_dwt)) {
+        if ((sim_dwt.CTRL.v & DWT_CTRL_CYCCNTENA_Msk) && !(old & DWT_CTRL_CYCCNTENA_Msk))
+            g_cyccnt_base = detail::active_cycles() - sim_dwt.CYCCNT.v;
+        if (!(sim_dwt.CTRL.v & DWT_CTRL_CYCCNTENA_Msk) && (old & DWT_CTRL_CYCCNTENA_Msk))
+            sim_dwt.CYCCNT.v = (uint32_t)(detail::active_cycles() - g_cyccnt_base);
+    }
+}
+
+/********************* TIM2 *********************/
+// 计数时钟72MHz（APB1分频2，定时器时钟倍频），周期(PSC+1)*(ARR+1)，更新时置UIF
+class Tim2Device : public Device {
+public:
+    uint64_t epoch = 0;
+    uint64_t next_update = UINT64_MAX;
+
+    uint64_t period() const
+    {
+        return ((uint64_t)sim_tim2.PSC.v + 1) * ((uint64_t)sim_tim2.ARR.v + 1);
+    }
+
+    void restart()
+    {
+        epoch = now();
+        next_update = (sim_tim2.CR1.v & TIM_CR1_CEN) ? epoch + period() : UINT64_MAX;
+    }
+
+    uint64_t next_event() const override
+    {
+        return next_update;
+    }
+
+    void run_until(uint64_t t) override
+    {
+        while (next_update <= t) {
+            sim_tim2.SR.v |= TIM_SR_UIF;
+            if (sim_tim2.CR1.v & TIM_CR1_OPM) {
+                sim_tim2.CR1.v &= ~TIM_CR1_CEN;
+                next_update = UINT64_MAX;
+                break;
+            }
+            epoch = next_update;
+            next_update += period();
+        }
+    }
+} g_tim2;
+
+void tim2_read(size_t offset)
+{
+    if (offset == off(sim_tim2.CNT, &sim_tim2) && (sim_tim2.CR1.v & TIM_CR1_CEN))
+        sim_tim2.CNT.v = (uint16_t)((now() - g_tim2.epoch) / ((uint64_t)sim_tim2.PSC.v + 1));
+}
+
+void tim2_write(size_t offset, uint32_t old)
+{
+    if (offset == off(sim_tim2.CR1, &sim_tim2)) {
+        if ((sim_tim2.CR1.v ^ old) & TIM_CR1_CEN)
+            g_tim2.restart();
+    } else if (offset == off(sim_tim2.SR, &sim_tim2)) {
+        sim_tim2.SR.v = (uint16_t)(old & sim_tim2.SR.v);        // rc_w0
+    } else if (offset == off(sim_tim2.EGR, &sim_tim2)) {
+        if (sim_tim2.EGR.v & TIM_EGR_UG) {
+            sim_tim2.SR.v |= TIM_SR_UIF;
+            g_tim2.restart();
+        }
+        sim_tim2.EGR.v = 0;
+    }
+}
+
+bool tim2_line()
+{
+    return (sim_tim2.SR.v & TIM_SR_UIF) && (sim_tim2.DIER.v & TIM_DIER_UIE);
+}
+
+/********************* EXTI *********************/
+void exti_write(size_t offset, uint32_t old)
+{
+    if (offset == off(sim_exti.PR, &sim_exti)) {
+        sim_exti.PR.v = old & ~sim_exti.PR.v;                    // rc_w1
+    } else if (offset == off(sim_exti.SWIER, &sim_exti)) {
+        sim_exti.PR.v |= sim_exti.SWIER.v & ~old;
+    }
+}
+
+bool exti_lines(uint32_t mask)
+{
+    return (sim_exti.PR.v & sim_exti.IMR.v & mask) != 0;
+}
+
+bool exti0_line() { return exti_lines(1u << 0); }
+bool exti1_line() { return exti_lines(1u << 1); }
+bool exti2_line() { return exti_lines(1u << 2); }
+bool exti3_line() { return exti_lines(1u << 3); }
+bool exti4_line() { return exti_lines(1u << 4); }
+bool exti9_5_line() { return exti_lines(0x03E0); }
+bool exti15_10_line() { return exti_lines(0xFC00); }
+
+/********************* DMA1 *********************/
+uintptr_t g_dma_mem[7];
+void (*g_dma_hook[7])(int channel);
+
+void dma_write(size_t offset, uint32_t old)
+{
+    (void)old;
+    if (offset == off(sim_dma1.IFCR, &sim_dma1)) {
+        uint32_t clear = sim_dma1.IFCR.v;
+        // CGIFx同时清除该通道的四个标志
+        for (int ch = 0; ch < 7; ch++) {
+            if (clear & (1u << (4 * ch)))
+                clear |= 0xFu << (4 * ch);
+        }
+        sim_dma1.ISR.v &= ~clear;
+        sim_dma1.IFCR.v = 0;
+    } else if (offset == off(sim_dma1.ISR, &sim_dma1)) {
+        sim_dma1.ISR.v = old;                                   // 只读
+    }
+}
+
+void dma_ch_write(size_t offset, uint32_t old)
+{
+    int ch = (int)(offset / sizeof(DMA_Channel_TypeDef));
+    size_t reg = offset % sizeof(DMA_Channel_TypeDef);
+    DMA_Channel_TypeDef &c = sim_dma1_ch[ch];
+
+    if (reg == off(c.CMAR, &c)) {
+        g_dma_mem[ch] = detail::recover_pointer(c.CMAR.v);
+    } else if (reg == off(c.CCR, &c)) {
+        if ((c.CCR.v & DMA_CCR1_EN) && !(old & DMA_CCR1_EN) && g_dma_hook[ch])
+            g_dma_hook[ch](ch + 1);
+    }
+}
+
+bool dma_line(int ch)
+{
+    uint32_t flags = (sim_dma1.ISR.v >> (4 * (ch - 1))) & 0xF;
+    uint32_t ccr = sim_dma1_ch[ch - 1].CCR.v;
+    return ((flags & 0x2) && (ccr & DMA_CCR1_TCIE)) ||
+           ((flags & 0x4) && (ccr & DMA_CCR1_HTIE)) ||
+           ((flags & 0x8) && (ccr & DMA_CCR1_TEIE));
+}
+
+bool dma1_line() { return dma_line(1); }
+bool dma2_line() { return dma_line(2); }
+bool dma3_line() { return dma_line(3); }
+bool dma4_line() { return dma_line(4); }
+bool dma5_line() { return dma_line(5); }
+bool dma6_line() { return dma_line(6); }
+bool dma7_line() { return dma_line(7); }
+
+/********************* RCC *********************/
+void rcc_write(size_t offset, uint32_t old)
+{
+    (void)old;
+    if (offset == off(sim_rcc.CSR, &sim_rcc) && (sim_rcc.CSR.v & RCC_CSR_RMVF))
+        sim_rcc.CSR.v &= 0x00FFFFFF;                            // 清除全部复位标志
+}
+
+/********************* Flash *********************/
+// 主存储器映射到与芯片相同的地址，固件可直接按地址读取；页擦除期间BSY置位
+uint64_t g_flash_busy_until = 0;
+int g_flash_unlock_step = 0;
+
+void flash_map()
+{
+    void *p = mmap((void *)FLASH_BASE, FLASH_SIZE, PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED_NOREPLACE, -1, 0);
+    if (p != (void *)FLASH_BASE) {
+        std::fprintf(stderr, "sim: 无法在0x%08lX映射Flash\n", (unsigned long)FLASH_BASE);
+        std::abort();
+    }
+    std::memset(p, 0xFF, FLASH_SIZE);
+}
+
+void flash_read(size_t offset)
+{
+    if (offset == off(sim_flash.SR, &sim_flash)) {
+        if (now() < g_flash_busy_until)
+            sim_flash.SR.v |= FLASH_SR_BSY;
+        else
+            sim_flash.SR.v &= ~FLASH_SR_BSY;
+    }
+}
+
+void flash_write(size_t offset, uint32_t old)
+{
+    if (offset == off(sim_flash.KEYR, &sim_flash)) {
+        if (sim_flash.KEYR.v == 0x45670123)
+            g_flash_unlock_step = 1;
+        else if (sim_flash.KEYR.v == 0xCDEF89AB && g_flash_unlock_step == 1)
+            sim_flash.CR.v &= ~FLASH_CR_LOCK;
+        else
+            g_flash_unlock_step = 0;
+    } else if (offset == off(sim_flash.CR, &sim_flash)) {
+        if (old & FLASH_CR_LOCK)
+            sim_flash.CR.v = old | (sim_flash.CR.v & FLASH_CR_LOCK);   // 锁定时只能再置LOCK
+        if ((sim_flash.CR.v & FLASH_CR_STRT) && (sim_flash.CR.v & FLASH_CR_PER)) {
+            uint32_t addr = sim_flash.AR.v & ~(kFlashPage - 1);
+            if (addr >= FLASH_BASE && addr < FLASH_BASE + FLASH_SIZE)
+                std::memset((void *)(uintptr_t)addr, 0xFF, kFlashPage);
+            g_flash_busy_until = now() + ms_to_cycles(kFlashEraseMs);
+            sim_flash.SR.v |= FLASH_SR_EOP;
+        }
+        sim_flash.CR.v &= ~FLASH_CR_STRT;
+        if (sim_flash.CR.v & FLASH_CR_LOCK)
+            g_flash_unlock_step = 0;
+    } else if (offset == off(sim_flash.SR, &sim_flash)) {
+        sim_flash.SR.v = old & ~(sim_flash.SR.v & (FLASH_SR_EOP | FLASH_SR_PGERR | FLASH_SR_WRPRTERR));
+    }
+}
+
+/********************* IWDG *********************/
+// LSI 40kHz，超时(RLR+1)*(4<<PR)/40kHz；超时只计数并重新开始计时
+class IwdgDevice : public Device {
+public:
+    bool started = false;
+    bool unlocked = false;
+    uint64_t deadline = UINT64_MAX;
+    uint32_t expired = 0;
+
+    uint64_t timeout() const
+    {
+        uint64_t lsi_ticks = ((uint64_t)(sim_iwdg.RLR.v & 0x0FFF) + 1) * (4u << (sim_iwdg.PR.v & 7));
+        return lsi_ticks * kCoreClockHz / kLsiHz;
+    }
+
+    void reload()
+    {
+        deadline = started ? now() + timeout() : UINT64_MAX;
+    }
+
+    uint64_t next_event() const override
+    {
+        return deadline;
+    }
+
+    void run_until(uint64_t t) override
+    {
+        while (deadline <= t) {
+            expired++;
+            sim_rcc.CSR.v |= RCC_CSR_IWDGRSTF;
+            deadline += timeout();
+        }
+    }
+} g_iwdg;
+
+void iwdg_write(size_t offset, uint32_t old)
+{
+    if (offset == off(sim_iwdg.KR, &sim_iwdg)) {
+        switch (sim_iwdg.KR.v & 0xFFFF) {
+        case 0x5555:
+            g_iwdg.unlocked = true;
+            break;
+        case 0xAAAA:
+            g_iwdg.unlocked = false;
+            g_iwdg.reload();
+            break;
+        case 0xCCCC:
+            g_iwdg.started = true;
+            g_iwdg.reload();
+            break;
+        default:
+            break;
+        }
+    } else if (offset == off(sim_iwdg.PR, &sim_iwdg) || offset == off(sim_iwdg.RLR, &sim_iwdg)) {
+        if (!g_iwdg.unlocked)
+            *(uint32_t *)((char *)&sim_iwdg + offset) = old;
+    } else if (offset == off(sim_iwdg.SR, &sim_iwdg)) {
+        sim_iwdg.SR.v = old;
+    }
+}
+
+/********************* 注册 *********************/
+void periph(void *base, size_t size, unsigned width, void (*read)(size_t), void (*write)(size_t, uint32_t))
+{
+    detail::PeriphOps ops = { base, size, width, read, write, 0 };
+    detail::register_periph(ops);
+}
+
+struct Registrar {
+    Registrar()
+    {
+        flash_map();
+        sim_flash.CR.v = FLASH_CR_LOCK;
+        sim_rcc.CSR.v = 0x0C000000;                             // 上电复位：PORRSTF|PINRSTF
+
+        periph(&sim_systick, sizeof sim_systick, 4, systick_read, systick_write);
+        periph(&sim_scb, sizeof sim_scb, 4, scb_read, scb_write);
+        periph(&sim_dwt, sizeof sim_dwt, 4, dwt_read, dwt_write);
+        periph(&sim_coredebug, sizeof sim_coredebug, 4, 0, 0);
+        periph(&sim_tim2, sizeof sim_tim2, 2, tim2_read, tim2_write);
+        periph(&sim_exti, sizeof sim_exti, 4, 0, exti_write);
+        periph(&sim_afio, sizeof sim_afio, 4, 0, 0);
+        periph(&sim_dma1, sizeof sim_dma1, 4, 0, dma_write);
+        periph(sim_dma1_ch, sizeof sim_dma1_ch, 4, 0, dma_ch_write);
+        periph(&sim_rcc, sizeof sim_rcc, 4, 0, rcc_write);
+        periph(&sim_flash, sizeof sim_flash, 4, flash_read, flash_write);
+        periph(&sim_iwdg, sizeof sim_iwdg, 4, 0, iwdg_write);
+        periph(&sim_pwr, sizeof sim_pwr, 4, 0, 0);
+        periph(&sim_dbgmcu, sizeof sim_dbgmcu, 4, 0, 0);
+
+        add_device(&g_systick);
+        add_device(&g_tim2);
+        add_device(&g_iwdg);
+
+        detail::register_irq_line(TIM2_IRQn, tim2_line);
+        detail::register_irq_line(EXTI0_IRQn, exti0_line);
+        detail::register_irq_line(EXTI1_IRQn, exti1_line);
+        detail::register_irq_line(EXTI2_IRQn, exti2_line);
+        detail::register_irq_line(EXTI3_IRQn, exti3_line);
+        detail::register_irq_line(EXTI4_IRQn, exti4_line);
+        detail::register_irq_line(EXTI9_5_IRQn, exti9_5_line);
+        detail::register_irq_line(EXTI15_10_IRQn, exti15_10_line);
+        detail::register_irq_line(DMA1_Channel1_IRQn, dma1_line);
+        detail::register_irq_line(DMA1_Channel2_IRQn, dma2_line);
+        detail::register_irq_line(DMA1_Channel3_IRQn, dma3_line);
+        detail::register_irq_line(DMA1_Channel4_IRQn, dma4_line);
+        detail::register_irq_line(DMA1_Channel5_IRQn, dma5_line);
+        detail::register_irq_line(DMA1_Channel6_IRQn, dma6_line);
+        detail::register_irq_line(DMA1_Channel7_IRQn, dma7_line);
+    }
+} g_registrar;
+
+}
+
+void flash_erase_all()
+{
+    std::memset((void *)(uintptr_t)FLASH_BASE, 0xFF, FLASH_SIZE);
+}
+
+uint32_t iwdg_expired()
+{
+    return g_iwdg.expired;
+}
+
+namespace detail {
+
+uintptr_t dma_memory(int channel)
+{
+    return g_dma_mem[channel - 1];
+}
+
+void dma_set_flags(int channel, uint32_t flags)
+{
+    sim_dma1.ISR.v |= ((flags & 0xF) | 0x1) << (4 * (channel - 1));
+}
+
+void dma_on_enable(int channel, void (*hook)(int channel))
+{
+    g_dma_hook[channel - 1] = hook;
+}
+
+void exti_edges(GPIO_TypeDef *port, uint16_t falling, uint16_t rising)
+{
+    uint32_t port_index;
+
+    if (port == &sim_gpioa)
+        port_index = 0;
+    else if (port == &sim_gpiob)
+        port_index = 1;
+    else
+        port_index = 2;
+    for (int line = 0; line < 16; line++) {
+        uint32_t bit = 1u << line;
+        uint32_t src = (sim_afio.EXTICR[line / 4].v >> (4 * (line % 4))) & 0xF;
+        if (src != port_index)
+            continue;
+        if (((falling & bit) && (sim_exti.FTSR.v & bit)) || ((rising & bit) && (sim_exti.RTSR.v & bit)))
+            sim_exti.PR.v |= bit;
+    }
+}
+
+}
+}
+
+/********************* SPL：RCC / AFIO *********************/
+void RCC_APB2PeriphClockCmd(u32 RCC_APB2Periph, FunctionalState NewState)
+{
+    if (NewState != DISABLE)
+        RCC->APB2ENR |= RCC_APB2Periph;
+    else
+        RCC->APB2ENR &= ~RCC_APB2Periph;
+}
+
+void RCC_APB1PeriphClockCmd(u32 RCC_APB1Periph, FunctionalState NewState)
+{
+    if (NewState != DISABLE)
+        RCC->APB1ENR |= RCC_APB1Periph;
+    else
+        RCC->APB1ENR &= ~RCC_APB1Periph;
+}
+
+void RCC_AHBPeriphClockCmd(u32 RCC_AHBPeriph, FunctionalState NewState)
+{
+    if (NewState != DISABLE)
+        RCC->AHBENR |= RCC_AHBPeriph;
+    else
+        RCC->AHBENR &= ~RCC_AHBPeriph;
+}
+
+void RCC_APB1PeriphResetCmd(u32 RCC_APB1Periph, FunctionalState NewState)
+{
+    if (NewState != DISABLE)
+        RCC->APB1RSTR |= RCC_APB1Periph;
+    else
+        RCC->APB1RSTR &= ~RCC_APB1Periph;
+}
+
+void GPIO_EXTILineConfig(u8 GPIO_PortSource, u8 GPIO_PinSource)
+{
+    u32 shift = 4 * (GPIO_PinSource & 0x03);
+    AFIO->EXTICR[GPIO_PinSource >> 2] &= ~(0xFu << shift);
+    AFIO->EXTICR[GPIO_PinSource >> 2] |= (u32)GPIO_PortSource << shift;
+}
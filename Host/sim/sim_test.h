@@ -0,0 +1,63 @@
+// 仿真测试的断言：失败时打印位置与表达式并计数，main以sim_test_result()返回；
+// 以及各测试共用的传感器句柄建立
+#ifndef SIM_TEST_H
+#define SIM_TEST_H
+
+#include "opt3001.h"
+#include "sim_opt3001.h"
+
+#include <cstdio>
+
+namespace sim {
+namespace test {
+
+inline int &failures()
+{
+    static int count = 0;
+    return count;
+}
+
+}
+}
+
+#define CHECK(cond)                                                                  \
+    do {                                                                             \
+        if (!(cond)) {                                                               \
+            std::fprintf(stderr, "%s:%d: CHECK(%s) 失败\n", __FILE__, __LINE__, #cond); \
+            sim::test::failures()++;                                                 \
+        }                                                                            \
+    } while (0)
+
+#define CHECK_MSG(cond, ...)                                                         \
+    do {                                                                             \
+        if (!(cond)) {                                                               \
+            std::fprintf(stderr, "%s:%d: CHECK(%s) 失败：", __FILE__, __LINE__, #cond); \
+            std::fprintf(stderr, __VA_ARGS__);                                       \
+            std::fprintf(stderr, "\n");                                              \
+            sim::test::failures()++;                                                 \
+        }                                                                            \
+    } while (0)
+
+// 虚拟器件回到上电状态（dev为空则不动器件），按总线/地址/编号建立句柄并执行OPT3001_Sensor_Init，
+// 返回Sensor_Init的结果（0：成功）
+inline u8 sim_sensor_init(OPT3001_HandleTypeDef *h, sim::Opt3001 *dev, const OPT3001_BusTypeDef *bus, u8 addr, u8 id)
+{
+    OPT3001_HandleTypeDef init = OPT3001_HANDLE_INIT(bus, addr, id);
+
+    if (dev != nullptr)
+        dev->power_on_reset();
+    *h = init;
+    return OPT3001_Sensor_Init(h);
+}
+
+inline int sim_test_result(const char *name)
+{
+    if (sim::test::failures() == 0) {
+        std::printf("%s: 通过\n", name);
+        return 0;
+    }
+    std::printf("%s: %d项失败\n", name, sim::test::failures());
+    return 1;
+}
+
+#endif
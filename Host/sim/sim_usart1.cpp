@@ -0,0 +1,255 @@
+// USART1模型：DMA1通道4逐字节发送（按波特率计时，发出的字节收集到输出串），接收端按字节时间注入，
+// RXNE未读时再来字节置ORE；TC在最后一个字节移出后置位。直接写DR时按发送数据寄存器+移位寄存器计时：
+// 移位寄存器忙时写入的字节留在数据寄存器中，TXE清零，直到上一个字节移出
+#include "sim_internal.h"
+
+#include <deque>
+
+USART_TypeDef sim_usart1;
+
+namespace sim {
+namespace {
+
+template <typename T>
+size_t off(const T &reg)
+{
+    return (size_t)((const char *)&reg - (const char *)&sim_usart1);
+}
+
+uint64_t byte_cycles()
+{
+    uint32_t brr = sim_usart1.BRR.v ? sim_usart1.BRR.v : 7500;
+    return 10ull * brr;                 // 起始位+8数据位+停止位，BRR即每位的PCLK2周期数
+}
+
+struct RxByte {
+    uint64_t when;
+    uint8_t byte;
+};
+
+class Usart1 : public Device {
+public:
+    std::string output;
+    std::deque<RxByte> rx;
+    bool tx_active = false;
+    uint64_t tx_next = UINT64_MAX;      // 下一个字节被DMA取走并移出完成的时刻
+    uint64_t tc_at = UINT64_MAX;
+    uintptr_t tx_mem = 0;
+    uint64_t shift_end = UINT64_MAX;    // 直接写DR：移位寄存器中的字节移出完成的时刻
+    bool holding = false;               // 数据寄存器中有等待移位的字节（TXE=0）
+
+    uint64_t next_event() const override
+    {
+        uint64_t t = tx_active ? tx_next : tc_at;
+        if (shift_end < t)
+            t = shift_end;
+        if (!rx.empty() && rx.front().when < t)
+            t = rx.front().when;
+        return t;
+    }
+
+    void run_until(uint64_t t) override
+    {
+        for (;;) {
+            uint64_t ev = next_event();
+            if (ev > t)
+                break;
+            if (!rx.empty() && rx.front().when == ev) {
+                receive(rx.front().byte);
+                rx.pop_front();
+            } else if (tx_active && tx_next == ev) {
+                send_one();
+            } else if (shift_end == ev) {
+                shift_done();
+            } else if (tc_at == ev) {
+                sim_usart1.SR.v |= USART_SR_TC;
+                tc_at = UINT64_MAX;
+            }
+        }
+    }
+
+    // 直接写DR：移位寄存器空闲时字节立即进入移位寄存器，TXE保持置位
+    void write_dr()
+    {
+        sim_usart1.SR.v &= ~USART_SR_TC;
+        tc_at = UINT64_MAX;
+        if (shift_end == UINT64_MAX) {
+            shift_end = now() + byte_cycles();
+        } else {
+            holding = true;
+            sim_usart1.SR.v &= ~USART_SR_TXE;
+        }
+    }
+
+    void start_tx()
+    {
+        tx_mem = detail::dma_memory(4);
+        sim_usart1.SR.v &= ~USART_SR_TC;
+        tc_at = UINT64_MAX;
+        tx_active = sim_dma1_ch[3].CNDTR.v > 0;
+        tx_next = now() + byte_cycles();
+    }
+
+private:
+    void shift_done()
+    {
+        if (holding) {
+            holding = false;
+            sim_usart1.SR.v |= USART_SR_TXE;
+            shift_end += byte_cycles();
+        } else {
+            shift_end = UINT64_MAX;
+            sim_usart1.SR.v |= USART_SR_TC;
+        }
+    }
+
+    void send_one()
+    {
+        DMA_Channel_TypeDef &ch = sim_dma1_ch[3];
+
+        if (!(ch.CCR.v & DMA_CCR1_EN) || ch.CNDTR.v == 0) {
+            tx_active = false;
+            return;
+        }
+        output.push_back((char)*(const uint8_t *)tx_mem);
+        tx_mem++;
+        ch.CNDTR.v--;
+        if (ch.CNDTR.v == 0) {
+            tx_active = false;
+            detail::dma_set_flags(4, 0x2);
+            sim_usart1.SR.v |= USART_SR_TC;     // tx_next即最后一个字节移出完成的时刻
+        } else {
+            tx_next += byte_cycles();
+        }
+    }
+
+    void receive(uint8_t byte)
+    {
+        if (!(sim_usart1.CR1.v & USART_CR1_UE) || !(sim_usart1.CR1.v & USART_CR1_RE))
+            return;
+        if (sim_usart1.SR.v & USART_SR_RXNE) {
+            sim_usart1.SR.v |= USART_SR_ORE;        // 未读的字节保留，新字节丢失
+            return;
+        }
+        sim_usart1.DR.v = byte;
+        sim_usart1.SR.v |= USART_SR_RXNE;
+    }
+};
+
+Usart1 g_usart;
+
+void dma4_enabled(int channel)
+{
+    (void)channel;
+    if (sim_usart1.CR3.v & USART_CR3_DMAT)
+        g_usart.start_tx();
+}
+
+void usart1_read(size_t offset)
+{
+    (void)offset;
+}
+
+// 读DR清除RXNE；ORE由“读SR再读DR”清除
+void usart1_after_read(size_t offset)
+{
+    if (offset == off(sim_usart1.DR))
+        sim_usart1.SR.v &= ~(USART_SR_RXNE | USART_SR_ORE);
+}
+
+void usart1_write(size_t offset, uint32_t old)
+{
+    if (offset == off(sim_usart1.SR)) {
+        // RXNE与TC可写0清除，其余只读
+        uint16_t clearable = USART_SR_RXNE | USART_SR_TC;
+        sim_usart1.SR.v = (uint16_t)((old & ~clearable) | (old & sim_usart1.SR.v & clearable));
+    } else if (offset == off(sim_usart1.DR)) {
+        // 直接写DR（不经DMA）：立即计入输出，TXE/TC按移位寄存器计时
+        g_usart.output.push_back((char)sim_usart1.DR.v);
+        g_usart.write_dr();
+    }
+}
+
+bool usart1_line()
+{
+    uint16_t sr = sim_usart1.SR.v;
+    uint16_t cr1 = sim_usart1.CR1.v;
+    return ((cr1 & USART_CR1_RXNEIE) && (sr & (USART_SR_RXNE | USART_SR_ORE))) ||
+           ((cr1 & USART_CR1_TCIE) && (sr & USART_SR_TC));
+}
+
+struct Registrar {
+    Registrar()
+    {
+        detail::PeriphOps ops = { &sim_usart1, sizeof sim_usart1, 2, usart1_read, usart1_write, usart1_after_read };
+        sim_usart1.SR.v = USART_SR_TXE | USART_SR_TC;
+        detail::register_periph(ops);
+        detail::dma_on_enable(4, dma4_enabled);
+        detail::register_irq_line(USART1_IRQn, usart1_line);
+        add_device(&g_usart);
+    }
+} g_registrar;
+
+}
+
+const std::string &uart_output()
+{
+    return g_usart.output;
+}
+
+void uart_clear_output()
+{
+    g_usart.output.clear();
+}
+
+void uart_inject(const std::string &bytes)
+{
+    uint64_t t = now();
+
+    if (!g_usart.rx.empty() && g_usart.rx.back().when > t)
+        t = g_usart.rx.back().when;
+    for (size_t i = 0; i < bytes.size(); i++) {
+        RxByte b;
+        t += byte_cycles();
+        b.when = t;
+        b.byte = (uint8_t)bytes[i];
+        g_usart.rx.push_back(b);
+    }
+}
+
+uint32_t uart_baud()
+{
+    return sim_usart1.BRR.v ? kCoreClockHz / sim_usart1.BRR.v : 0;
+}
+
+}
+
+/********************* SPL：USART *********************/
+void USART_Init(USART_TypeDef *USARTx, USART_InitTypeDef *USART_InitStruct)
+{
+    USARTx->BRR = (u16)((72000000 + USART_InitStruct->USART_BaudRate / 2) / USART_InitStruct->USART_BaudRate);
+    USARTx->CR1 = (u16)((USARTx->CR1 & ~(USART_CR1_TE | USART_CR1_RE)) | USART_InitStruct->USART_Mode);
+}
+
+void USART_Cmd(USART_TypeDef *USARTx, FunctionalState NewState)
+{
+    if (NewState != DISABLE)
+        USARTx->CR1 |= USART_CR1_UE;
+    else
+        USARTx->CR1 &= (u16)~USART_CR1_UE;
+}
+
+FlagStatus USART_GetFlagStatus(USART_TypeDef *USARTx, u16 USART_FLAG)
+{
+    return (USARTx->SR & USART_FLAG) ? SET : RESET;
+}
+
+void USART_SendData(USART_TypeDef *USARTx, u16 Data)
+{
+    USARTx->DR = (u16)(Data & 0x01FF);
+}
+
+u16 USART_ReceiveData(USART_TypeDef *USARTx)
+{
+    return (u16)(USARTx->DR & 0x01FF);
+}
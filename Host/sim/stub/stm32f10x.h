@@ -0,0 +1,421 @@
+// 主机仿真用的 stm32f10x.h 替身：固件源码（按 C++ 编译）原样包含本头文件。
+// 外设寄存器是 SimReg 代理，每次读写都进入 sim_core.cpp：推进仿真时钟、执行外设行为、
+// 在主循环上下文派发挂起的中断；类型、常量与 SPL 函数名与官方库一致
+#ifndef __STM32F10x_H
+#define __STM32F10x_H
+
+#ifndef __cplusplus
+#error "仿真替身头文件只支持按 C++ 编译固件源码"
+#endif
+
+#include <stdint.h>
+#include <stdio.h>
+
+/********************* 基本类型 *********************/
+typedef int32_t  s32;
+typedef int16_t  s16;
+typedef int8_t   s8;
+typedef uint32_t u32;
+typedef uint16_t u16;
+typedef uint8_t  u8;
+typedef volatile uint32_t vu32;
+typedef volatile uint16_t vu16;
+typedef volatile uint8_t  vu8;
+
+typedef enum {RESET = 0, SET = !RESET} FlagStatus, ITStatus;
+typedef enum {DISABLE = 0, ENABLE = !DISABLE} FunctionalState;
+typedef enum {ERROR = 0, SUCCESS = !ERROR} ErrorStatus;
+
+#define __IO volatile
+#define __I  volatile const
+
+typedef enum {
+    SysTick_IRQn       = -1,
+    EXTI0_IRQn         = 6,
+    EXTI1_IRQn         = 7,
+    EXTI2_IRQn         = 8,
+    EXTI3_IRQn         = 9,
+    EXTI4_IRQn         = 10,
+    DMA1_Channel1_IRQn = 11,
+    DMA1_Channel2_IRQn = 12,
+    DMA1_Channel3_IRQn = 13,
+    DMA1_Channel4_IRQn = 14,
+    DMA1_Channel5_IRQn = 15,
+    DMA1_Channel6_IRQn = 16,
+    DMA1_Channel7_IRQn = 17,
+    EXTI9_5_IRQn       = 23,
+    TIM2_IRQn          = 28,
+    TIM3_IRQn          = 29,
+    TIM4_IRQn          = 30,
+    I2C1_EV_IRQn       = 31,
+    I2C1_ER_IRQn       = 32,
+    USART1_IRQn        = 37,
+    EXTI15_10_IRQn     = 40
+} IRQn_Type;
+
+/********************* 寄存器代理 *********************/
+// 读：外设先刷新寄存器值，锁存后再派发中断（等效于中断发生在读指令之后）
+// 写：先存入新值，外设按写入语义处理（置位/清零/触发动作）后再派发中断
+uint32_t sim_reg_read(void *reg);
+void     sim_reg_write(void *reg, uint32_t old_value);
+
+template <typename T>
+struct SimReg {
+    T v;
+
+    operator T() const { return (T)sim_reg_read(const_cast<SimReg *>(this)); }
+    SimReg &operator=(uint32_t x) { T old = v; v = (T)x; sim_reg_write(this, old); return *this; }
+    SimReg &operator=(const SimReg &r) { return *this = (uint32_t)(T)r; }
+    SimReg &operator|=(uint32_t x) { return *this = (uint32_t)(T)*this | x; }
+    SimReg &operator&=(uint32_t x) { return *this = (uint32_t)(T)*this & x; }
+    SimReg &operator^=(uint32_t x) { return *this = (uint32_t)(T)*this ^ x; }
+};
+typedef SimReg<uint32_t> SimReg32;
+typedef SimReg<uint16_t> SimReg16;
+
+/********************* 外设寄存器布局 *********************/
+typedef struct { SimReg32 CRL, CRH, IDR, ODR, BSRR, BRR, LCKR; } GPIO_TypeDef;
+typedef struct { SimReg32 EVCR, MAPR, EXTICR[4], RESERVED0, MAPR2; } AFIO_TypeDef;
+typedef struct { SimReg32 IMR, EMR, RTSR, FTSR, SWIER, PR; } EXTI_TypeDef;
+typedef struct {
+    SimReg16 CR1;   u16 RESERVED0;
+    SimReg16 CR2;   u16 RESERVED1;
+    SimReg16 OAR1;  u16 RESERVED2;
+    SimReg16 OAR2;  u16 RESERVED3;
+    SimReg16 DR;    u16 RESERVED4;
+    SimReg16 SR1;   u16 RESERVED5;
+    SimReg16 SR2;   u16 RESERVED6;
+    SimReg16 CCR;   u16 RESERVED7;
+    SimReg16 TRISE; u16 RESERVED8;
+} I2C_TypeDef;
+typedef struct { SimReg32 CCR, CNDTR, CPAR, CMAR; } DMA_Channel_TypeDef;
+typedef struct { SimReg32 ISR, IFCR; } DMA_TypeDef;
+typedef struct {
+    SimReg16 SR;   u16 RESERVED0;
+    SimReg16 DR;   u16 RESERVED1;
+    SimReg16 BRR;  u16 RESERVED2;
+    SimReg16 CR1;  u16 RESERVED3;
+    SimReg16 CR2;  u16 RESERVED4;
+    SimReg16 CR3;  u16 RESERVED5;
+    SimReg16 GTPR; u16 RESERVED6;
+} USART_TypeDef;
+typedef struct {
+    SimReg16 CR1;   u16 RESERVED0;
+    SimReg16 CR2;   u16 RESERVED1;
+    SimReg16 SMCR;  u16 RESERVED2;
+    SimReg16 DIER;  u16 RESERVED3;
+    SimReg16 SR;    u16 RESERVED4;
+    SimReg16 EGR;   u16 RESERVED5;
+    SimReg16 CCMR1; u16 RESERVED6;
+    SimReg16 CCMR2; u16 RESERVED7;
+    SimReg16 CCER;  u16 RESERVED8;
+    SimReg16 CNT;   u16 RESERVED9;
+    SimReg16 PSC;   u16 RESERVED10;
+    SimReg16 ARR;   u16 RESERVED11;
+} TIM_TypeDef;
+typedef struct { SimReg32 CR, CFGR, CIR, APB2RSTR, APB1RSTR, AHBENR, APB2ENR, APB1ENR, BDCR, CSR; } RCC_TypeDef;
+typedef struct { SimReg32 ACR, KEYR, OPTKEYR, SR, CR, AR, RESERVED, OBR, WRPR; } FLASH_TypeDef;
+typedef struct { SimReg32 KR, PR, RLR, SR; } IWDG_TypeDef;
+typedef struct { SimReg32 CR, CSR; } PWR_TypeDef;
+typedef struct { SimReg32 IDCODE, CR; } DBGMCU_TypeDef;
+typedef struct { SimReg32 CTRL, LOAD, VAL, CALIB; } SysTick_Type;
+typedef struct { SimReg32 CPUID, ICSR, VTOR, AIRCR, SCR, CCR; } SCB_Type;
+typedef struct { SimReg32 CTRL, CYCCNT, CPICNT, EXCCNT, SLEEPCNT, LSUCNT, FOLDCNT, PCSR; } DWT_Type;
+typedef struct { SimReg32 DHCSR, DCRSR, DCRDR, DEMCR; } CoreDebug_Type;
+
+/********************* 外设实例（仿真对象） *********************/
+extern GPIO_TypeDef        sim_gpioa, sim_gpiob, sim_gpioc;
+extern AFIO_TypeDef        sim_afio;
+extern EXTI_TypeDef        sim_exti;
+extern I2C_TypeDef         sim_i2c1;
+extern DMA_TypeDef         sim_dma1;
+extern DMA_Channel_TypeDef sim_dma1_ch[7];
+extern USART_TypeDef       sim_usart1;
+extern TIM_TypeDef         sim_tim2;
+extern RCC_TypeDef         sim_rcc;
+extern FLASH_TypeDef       sim_flash;
+extern IWDG_TypeDef        sim_iwdg;
+extern PWR_TypeDef         sim_pwr;
+extern DBGMCU_TypeDef      sim_dbgmcu;
+extern SysTick_Type        sim_systick;
+extern SCB_Type            sim_scb;
+extern DWT_Type            sim_dwt;
+extern CoreDebug_Type      sim_coredebug;
+
+#define GPIOA          (&sim_gpioa)
+#define GPIOB          (&sim_gpiob)
+#define GPIOC          (&sim_gpioc)
+#define AFIO           (&sim_afio)
+#define EXTI           (&sim_exti)
+#define I2C1           (&sim_i2c1)
+#define DMA1           (&sim_dma1)
+#define DMA1_Channel1  (&sim_dma1_ch[0])
+#define DMA1_Channel2  (&sim_dma1_ch[1])
+#define DMA1_Channel3  (&sim_dma1_ch[2])
+#define DMA1_Channel4  (&sim_dma1_ch[3])
+#define DMA1_Channel5  (&sim_dma1_ch[4])
+#define DMA1_Channel6  (&sim_dma1_ch[5])
+#define DMA1_Channel7  (&sim_dma1_ch[6])
+#define USART1         (&sim_usart1)
+#define TIM2           (&sim_tim2)
+#define RCC            (&sim_rcc)
+#define FLASH          (&sim_flash)
+#define IWDG           (&sim_iwdg)
+#define PWR            (&sim_pwr)
+#define DBGMCU         (&sim_dbgmcu)
+#define SysTick        (&sim_systick)
+#define SCB            (&sim_scb)
+#define DWT            (&sim_dwt)
+#define CoreDebug      (&sim_coredebug)
+
+// Flash在主机上映射到与芯片相同的地址（见sim_core.cpp），64KB
+#define FLASH_BASE     0x08000000UL
+#define FLASH_SIZE     0x00010000UL
+
+extern uint32_t SystemCoreClock;
+void SystemInit(void);
+
+/********************* 寄存器位定义（固件用到的部分） *********************/
+#define I2C_CR1_PE              0x0001
+#define I2C_CR1_START           0x0100
+#define I2C_CR1_STOP            0x0200
+#define I2C_CR1_ACK             0x0400
+#define I2C_CR1_POS             0x0800
+#define I2C_CR1_SWRST           0x8000
+#define I2C_CR2_FREQ            0x003F
+#define I2C_CR2_ITERREN         0x0100
+#define I2C_CR2_ITEVTEN         0x0200
+#define I2C_CR2_ITBUFEN         0x0400
+#define I2C_CR2_DMAEN           0x0800
+#define I2C_CR2_LAST            0x1000
+#define I2C_SR1_SB              0x0001
+#define I2C_SR1_ADDR            0x0002
+#define I2C_SR1_BTF             0x0004
+#define I2C_SR1_STOPF           0x0010
+#define I2C_SR1_RXNE            0x0040
+#define I2C_SR1_TXE             0x0080
+#define I2C_SR1_BERR            0x0100
+#define I2C_SR1_ARLO            0x0200
+#define I2C_SR1_AF              0x0400
+#define I2C_SR1_OVR             0x0800
+#define I2C_SR1_TIMEOUT         0x4000
+#define I2C_SR2_MSL             0x0001
+#define I2C_SR2_BUSY            0x0002
+#define I2C_SR2_TRA             0x0004
+
+#define DMA_CCR1_EN             0x0001
+#define DMA_CCR1_TCIE           0x0002
+#define DMA_CCR1_HTIE           0x0004
+#define DMA_CCR1_TEIE           0x0008
+#define DMA_CCR1_DIR            0x0010
+#define DMA_CCR1_CIRC           0x0020
+#define DMA_CCR1_PINC           0x0040
+#define DMA_CCR1_MINC           0x0080
+#define DMA_CCR1_PSIZE_0        0x0100
+#define DMA_CCR1_MSIZE_0        0x0400
+#define DMA_CCR1_PL_0           0x1000
+#define DMA_CCR1_PL_1           0x2000
+#define DMA_CCR1_PL             0x3000
+// 通道n的标志位为 (GIF,TCIF,HTIF,TEIF) << 4*(n-1)
+#define DMA_ISR_GIF4            0x00001000
+#define DMA_ISR_TCIF4           0x00002000
+#define DMA_ISR_TEIF4           0x00008000
+#define DMA_ISR_GIF6            0x00100000
+#define DMA_ISR_TCIF6           0x00200000
+#define DMA_ISR_TEIF6           0x00800000
+#define DMA_ISR_GIF7            0x01000000
+#define DMA_ISR_TCIF7           0x02000000
+#define DMA_ISR_TEIF7           0x08000000
+#define DMA_IFCR_CGIF4          0x00001000
+#define DMA_IFCR_CGIF6          0x00100000
+#define DMA_IFCR_CGIF7          0x01000000
+
+#define USART_SR_FE             0x0002
+#define USART_SR_NE             0x0004
+#define USART_SR_ORE            0x0008
+#define USART_SR_RXNE           0x0020
+#define USART_SR_TC             0x0040
+#define USART_SR_TXE            0x0080
+#define USART_CR1_RE            0x0004
+#define USART_CR1_TE            0x0008
+#define USART_CR1_RXNEIE        0x0020
+#define USART_CR1_TCIE          0x0040
+#define USART_CR1_UE            0x2000
+#define USART_CR3_DMAR          0x0040
+#define USART_CR3_DMAT          0x0080
+
+#define TIM_CR1_CEN             0x0001
+#define TIM_CR1_OPM             0x0008
+#define TIM_DIER_UIE            0x0001
+#define TIM_SR_UIF              0x0001
+#define TIM_EGR_UG              0x0001
+
+#define FLASH_SR_BSY            0x01
+#define FLASH_SR_PGERR          0x04
+#define FLASH_SR_WRPRTERR       0x10
+#define FLASH_SR_EOP            0x20
+#define FLASH_CR_PG             0x01
+#define FLASH_CR_PER            0x02
+#define FLASH_CR_STRT           0x40
+#define FLASH_CR_LOCK           0x80
+
+#define RCC_CSR_LSION           0x00000001
+#define RCC_CSR_LSIRDY          0x00000002
+#define RCC_CSR_RMVF            0x01000000
+#define RCC_CSR_IWDGRSTF        0x20000000
+
+#define DBGMCU_CR_DBG_IWDG_STOP 0x00000100
+
+#define SysTick_CTRL_ENABLE_Msk     (1UL << 0)
+#define SysTick_CTRL_TICKINT_Msk    (1UL << 1)
+#define SysTick_CTRL_CLKSOURCE_Msk  (1UL << 2)
+#define SysTick_CTRL_COUNTFLAG_Msk  (1UL << 16)
+#define SysTick_LOAD_RELOAD_Msk     0x00FFFFFFUL
+#define SCB_ICSR_PENDSTSET_Msk      (1UL << 26)
+#define SCB_SCR_SLEEPONEXIT_Msk     (1UL << 1)
+#define SCB_SCR_SLEEPDEEP_Msk       (1UL << 2)
+#define DWT_CTRL_CYCCNTENA_Msk      (1UL << 0)
+#define CoreDebug_DEMCR_TRCENA_Msk  (1UL << 24)
+#define __NVIC_PRIO_BITS            4
+
+/********************* SPL：GPIO / AFIO *********************/
+#define GPIO_Pin_0    ((u16)0x0001)
+#define GPIO_Pin_1    ((u16)0x0002)
+#define GPIO_Pin_2    ((u16)0x0004)
+#define GPIO_Pin_3    ((u16)0x0008)
+#define GPIO_Pin_4    ((u16)0x0010)
+#define GPIO_Pin_5    ((u16)0x0020)
+#define GPIO_Pin_6    ((u16)0x0040)
+#define GPIO_Pin_7    ((u16)0x0080)
+#define GPIO_Pin_8    ((u16)0x0100)
+#define GPIO_Pin_9    ((u16)0x0200)
+#define GPIO_Pin_10   ((u16)0x0400)
+#define GPIO_Pin_11   ((u16)0x0800)
+#define GPIO_Pin_12   ((u16)0x1000)
+#define GPIO_Pin_13   ((u16)0x2000)
+#define GPIO_Pin_14   ((u16)0x4000)
+#define GPIO_Pin_15   ((u16)0x8000)
+#define GPIO_Pin_All  ((u16)0xFFFF)
+
+typedef enum { GPIO_Speed_10MHz = 1, GPIO_Speed_2MHz, GPIO_Speed_50MHz } GPIOSpeed_TypeDef;
+typedef enum {
+    GPIO_Mode_AIN = 0x0, GPIO_Mode_IN_FLOATING = 0x04, GPIO_Mode_IPD = 0x28, GPIO_Mode_IPU = 0x48,
+    GPIO_Mode_Out_OD = 0x14, GPIO_Mode_Out_PP = 0x10, GPIO_Mode_AF_OD = 0x1C, GPIO_Mode_AF_PP = 0x18
+} GPIOMode_TypeDef;
+typedef struct {
+    u16 GPIO_Pin;
+    GPIOSpeed_TypeDef GPIO_Speed;
+    GPIOMode_TypeDef GPIO_Mode;
+} GPIO_InitTypeDef;
+
+#define GPIO_PortSourceGPIOA  ((u8)0x00)
+#define GPIO_PortSourceGPIOB  ((u8)0x01)
+#define GPIO_PortSourceGPIOC  ((u8)0x02)
+#define GPIO_PinSource0       ((u8)0x00)
+#define GPIO_PinSource5       ((u8)0x05)
+
+void GPIO_Init(GPIO_TypeDef *GPIOx, GPIO_InitTypeDef *GPIO_InitStruct);
+void GPIO_SetBits(GPIO_TypeDef *GPIOx, u16 GPIO_Pin);
+void GPIO_ResetBits(GPIO_TypeDef *GPIOx, u16 GPIO_Pin);
+u8   GPIO_ReadInputDataBit(GPIO_TypeDef *GPIOx, u16 GPIO_Pin);
+void GPIO_EXTILineConfig(u8 GPIO_PortSource, u8 GPIO_PinSource);
+
+/********************* SPL：RCC *********************/
+#define RCC_APB2Periph_AFIO    ((u32)0x00000001)
+#define RCC_APB2Periph_GPIOA   ((u32)0x00000004)
+#define RCC_APB2Periph_GPIOB   ((u32)0x00000008)
+#define RCC_APB2Periph_GPIOC   ((u32)0x00000010)
+#define RCC_APB2Periph_USART1  ((u32)0x00004000)
+#define RCC_APB1Periph_TIM2    ((u32)0x00000001)
+#define RCC_APB1Periph_I2C1    ((u32)0x00200000)
+#define RCC_APB1Periph_PWR     ((u32)0x10000000)
+#define RCC_AHBPeriph_DMA1     ((u32)0x00000001)
+
+void RCC_APB2PeriphClockCmd(u32 RCC_APB2Periph, FunctionalState NewState);
+void RCC_APB1PeriphClockCmd(u32 RCC_APB1Periph, FunctionalState NewState);
+void RCC_AHBPeriphClockCmd(u32 RCC_AHBPeriph, FunctionalState NewState);
+void RCC_APB1PeriphResetCmd(u32 RCC_APB1Periph, FunctionalState NewState);
+
+/********************* SPL：I2C *********************/
+#define I2C_Mode_I2C                  ((u16)0x0000)
+#define I2C_DutyCycle_16_9            ((u16)0x4000)
+#define I2C_DutyCycle_2               ((u16)0xBFFF)
+#define I2C_Ack_Enable                ((u16)0x0400)
+#define I2C_Ack_Disable               ((u16)0x0000)
+#define I2C_AcknowledgedAddress_7bit  ((u16)0x4000)
+
+typedef struct {
+    u32 I2C_ClockSpeed;
+    u16 I2C_Mode;
+    u16 I2C_DutyCycle;
+    u16 I2C_OwnAddress1;
+    u16 I2C_Ack;
+    u16 I2C_AcknowledgedAddress;
+} I2C_InitTypeDef;
+
+void I2C_DeInit(I2C_TypeDef *I2Cx);
+void I2C_Init(I2C_TypeDef *I2Cx, I2C_InitTypeDef *I2C_InitStruct);
+void I2C_Cmd(I2C_TypeDef *I2Cx, FunctionalState NewState);
+
+/********************* SPL：USART *********************/
+#define USART_WordLength_8b             ((u16)0x0000)
+#define USART_StopBits_1                ((u16)0x0000)
+#define USART_Parity_No                 ((u16)0x0000)
+#define USART_Mode_Rx                   ((u16)0x0004)
+#define USART_Mode_Tx                   ((u16)0x0008)
+#define USART_HardwareFlowControl_None  ((u16)0x0000)
+#define USART_FLAG_ORE                  ((u16)0x0008)
+#define USART_FLAG_RXNE                 ((u16)0x0020)
+#define USART_FLAG_TC                   ((u16)0x0040)
+#define USART_FLAG_TXE                  ((u16)0x0080)
+
+typedef struct {
+    u32 USART_BaudRate;
+    u16 USART_WordLength;
+    u16 USART_StopBits;
+    u16 USART_Parity;
+    u16 USART_Mode;
+    u16 USART_HardwareFlowControl;
+} USART_InitTypeDef;
+
+void USART_Init(USART_TypeDef *USARTx, USART_InitTypeDef *USART_InitStruct);
+void USART_Cmd(USART_TypeDef *USARTx, FunctionalState NewState);
+FlagStatus USART_GetFlagStatus(USART_TypeDef *USARTx, u16 USART_FLAG);
+void USART_SendData(USART_TypeDef *USARTx, u16 Data);
+u16  USART_ReceiveData(USART_TypeDef *USARTx);
+
+/********************* SPL：NVIC / SysTick *********************/
+#define NVIC_PriorityGroup_2  ((u32)0x500)
+
+typedef struct {
+    u8 NVIC_IRQChannel;
+    u8 NVIC_IRQChannelPreemptionPriority;
+    u8 NVIC_IRQChannelSubPriority;
+    FunctionalState NVIC_IRQChannelCmd;
+} NVIC_InitTypeDef;
+
+void NVIC_PriorityGroupConfig(u32 NVIC_PriorityGroup);
+void NVIC_Init(NVIC_InitTypeDef *NVIC_InitStruct);
+void NVIC_SetPriority(IRQn_Type IRQn, u32 priority);
+void NVIC_EnableIRQ(IRQn_Type IRQn);
+void NVIC_DisableIRQ(IRQn_Type IRQn);
+
+/********************* 内核指令 *********************/
+void __WFI(void);
+void __disable_irq(void);
+void __enable_irq(void);
+u32  __get_PRIMASK(void);
+void __set_PRIMASK(u32 priMask);
+static inline void __DMB(void) { __atomic_thread_fence(__ATOMIC_SEQ_CST); }
+static inline void __DSB(void) { __atomic_thread_fence(__ATOMIC_SEQ_CST); }
+static inline void __ISB(void) { __atomic_thread_fence(__ATOMIC_SEQ_CST); }
+static inline void __NOP(void) {}
+static inline u32  __CLZ(u32 value) { return value ? (u32)__builtin_clz(value) : 32; }
+
+// 固件的 printf 经由 fputc 走串口DMA（main.c 重定向），主机上同样由 sim_printf 逐字符调用 fputc
+#ifdef SIM_FIRMWARE_PRINTF
+int sim_printf(const char *fmt, ...) __attribute__((format(printf, 1, 2)));
+#define printf sim_printf
+#endif
+
+#endif
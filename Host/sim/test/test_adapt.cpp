@@ -0,0 +1,174 @@
+// 自适应转换时间/量程：一个虚拟OPT3001按主循环方式运行调度器，光照依次为稳定300lux、
+// 跳到3000lux、在快速转换期间降到1000lux并保持、再跳到超出固定量程的5000lux。核对：
+// 稳态保持800ms；变化后切到100ms且快速转换下200ms内看到新值；持续稳定3s后回到800ms并按2倍余量固定RN；
+// 超出固定量程立即恢复自动量程，在新等级上稳定后再次固定；每次重配置后跨越它的那次转换被丢弃，
+// 其余转换一个不少
+#include "sim_core.h"
+#include "sim_opt3001.h"
+#include "sim_test.h"
+
+#include "delay.h"
+#include "opt3001.h"
+#include "opt3001_adapt.h"
+#include "opt3001_health.h"
+#include "opt3001_sched.h"
+
+#include <cmath>
+#include <vector>
+
+namespace {
+
+const double kStep1 = 5.0;      // 300 -> 3000lux（稳态800ms下发生）
+const double kStep2 = 6.53;     // 3000 -> 1000lux（快速转换期间发生）
+const double kStep3 = 14.0;     // 1000 -> 5000lux（超出固定量程）
+const double kEnd = 20.0;
+
+double lux_at(double t)
+{
+    if (t < kStep1)
+        return 300;
+    if (t < kStep2)
+        return 3000;
+    if (t < kStep3)
+        return 1000;
+    return 5000;
+}
+
+struct Sample {
+    double t;                   // 回调时刻（s，自t0起）
+    u32 raw_clux;               // 结果寄存器换算的光照（未经滤波）
+};
+
+std::vector<Sample> g_samples;
+double g_t0;
+
+void on_sample(OPT3001_HandleTypeDef *h, u16 raw, u32 clux, u32 stamp_us)
+{
+    Sample s;
+
+    (void)h;
+    (void)clux;
+    (void)stamp_us;
+    if (raw == 0)
+        return;
+    s.t = sim::now_us() / 1e6 - g_t0;
+    s.raw_clux = OPT3001_RawToCentiLux(raw);
+    g_samples.push_back(s);
+}
+
+// 阶跃之后第一个与旧值相差超过控制器动态阈值（约7%）的样本，及第一个进入新值±10%的样本
+void step_latency(double step, double from, double to, double *detect_ms, double *settle_ms)
+{
+    *detect_ms = *settle_ms = -1;
+    for (const Sample &s : g_samples) {
+        double lux = s.raw_clux / 100.0;
+
+        if (s.t < step)
+            continue;
+        if (*detect_ms < 0 && std::fabs(lux - from) > from * 0.07)
+            *detect_ms = (s.t - step) * 1000;
+        if (*settle_ms < 0 && std::fabs(lux - to) <= to * 0.1) {
+            *settle_ms = (s.t - step) * 1000;
+            return;
+        }
+    }
+}
+
+}
+
+int main()
+{
+    sim::Opt3001 dev(OPT3001_ADDR);
+    OPT3001_HandleTypeDef h;
+    OPT3001_AdaptStatsTypeDef as;
+    double fast_at = -1, slow_at = -1, auto_at = -1, d1, s1, d2, s2, d3, s3;
+    u16 cfg, prev_cfg, pinned_cfg = 0;
+    uint32_t conv0;
+    uint64_t end;
+
+    dev.attach_wire(OPT3001_IIC_PORT, OPT3001_IIC_SCL_PIN, OPT3001_IIC_SDA_PIN);
+    dev.attach_int(OPT3001_INT_PORT, OPT3001_INT_PIN);
+    SysTick_Init();
+    DWT_Init();
+    OPT3001_Bus_Init(&OPT3001_DefaultBus);
+
+    // 与main.c相同的上电顺序：常规配置 + 转换完成指示，再交给调度器与控制器
+    g_t0 = sim::now_us() / 1e6;
+    dev.lux = [](double t) { return lux_at(t - g_t0); };
+    CHECK(sim_sensor_init(&h, &dev, &OPT3001_DefaultBus, OPT3001_ADDR, 0) == 0);
+    CHECK(OPT3001_Sensor_Configure(&h, OPT3001_CONFIG_DEFAULT) == 0);
+    CHECK(OPT3001_Sensor_EnableEoc(&h) == 0);
+    OPT3001_Async_Init();
+    OPT3001_Sched_Init(&h, 1, on_sample);
+    OPT3001_Health_Init(&h, 1);
+    OPT3001_Adapt_Init(&h, 1);
+    conv0 = dev.stats().conversions;
+
+    // 按器件上实际生效的配置记录切换时刻
+    prev_cfg = dev.reg(OPT3001_CONFIG_REG) & 0xFE00;
+    end = sim::now() + sim::ms_to_cycles(kEnd * 1000);
+    while (sim::now() < end) {
+        double t = sim::now_us() / 1e6 - g_t0;
+
+        OPT3001_Sched_Poll();
+        sim::advance(sim::us_to_cycles(100));
+        cfg = dev.reg(OPT3001_CONFIG_REG) & 0xFE00;
+        if (cfg != prev_cfg) {
+            if (t < kStep2 && !(cfg & OPT3001_CFG_CT) && fast_at < 0)
+                fast_at = t;
+            if (t > kStep2 && t < kStep3 && (cfg & OPT3001_CFG_CT) && slow_at < 0) {
+                slow_at = t;
+                pinned_cfg = cfg;
+            }
+            if (t > kStep3 && (cfg >> 12) == OPT3001_CFG_RN_AUTO && auto_at < 0)
+                auto_at = t;
+            prev_cfg = cfg;
+        }
+        // 稳态300lux：始终是上电的800ms自动量程配置
+        if (t < kStep1)
+            CHECK(cfg == (OPT3001_CONFIG_DEFAULT & 0xFE00));
+    }
+    // 收尾：进行中的一轮读完
+    end = sim::now() + sim::ms_to_cycles(50);
+    while ((OPT3001_Sched_IsBusy() || OPT3001_Async_Pending() != 0) && sim::now() < end) {
+        OPT3001_Sched_Poll();
+        sim::advance(sim::us_to_cycles(100));
+    }
+
+    step_latency(kStep1, 300, 3000, &d1, &s1);
+    step_latency(kStep2, 3000, 1000, &d2, &s2);
+    step_latency(kStep3, 1000, 5000, &d3, &s3);
+    OPT3001_Adapt_GetStats(0, &as);
+    std::printf("  阶跃               发现变化(ms)  到达新值(ms)\n");
+    std::printf("  300->3000（800ms）  %10.0f  %12.0f\n", d1, s1);
+    std::printf("  3000->1000（100ms） %10.0f  %12.0f\n", d2, s2);
+    std::printf("  1000->5000（固定RN）%10.0f  %12.0f\n", d3, s3);
+    std::printf("  切到100ms %.2fs，回到800ms %.2fs（配置0x%04X），恢复自动量程 %.2fs\n",
+                fast_at, slow_at, (unsigned)pinned_cfg, auto_at);
+    std::printf("  重配置 %u 次，丢弃 %u 个样本，转换 %u 次，上报 %u 个样本\n", (unsigned)as.switches,
+                (unsigned)as.discarded, (unsigned)(dev.stats().conversions - conv0), (unsigned)g_samples.size());
+
+    // 稳态的800ms转换下，变化在跨越它的那次转换结束时被发现，随即切到100ms
+    CHECK_MSG(d1 > 0 && d1 <= 810, "step1 detect %.0fms", d1);
+    CHECK_MSG(fast_at >= kStep1 && fast_at - kStep1 <= d1 / 1000 + 0.01, "fast_at %.2f", fast_at);
+    // 快速转换期间：200ms内发现并到达新值
+    CHECK_MSG(d2 > 0 && d2 < 200, "step2 detect %.0fms", d2);
+    CHECK_MSG(s2 > 0 && s2 < 200, "step2 settle %.0fms", s2);
+    // 持续稳定3s后回到800ms，量程固定为满量程不低于当前值2倍的最小RN（1000lux -> RN=6，2620lux）
+    CHECK_MSG(slow_at > 0 && slow_at - kStep2 >= 3.0 && slow_at - kStep2 <= 3.5, "slow_at %.2f", slow_at);
+    CHECK_MSG((pinned_cfg >> 12) == 6, "pinned 0x%04X", (unsigned)pinned_cfg);
+    // 超出固定量程：读数饱和即按动态处理，恢复自动量程并读到真实值
+    CHECK_MSG(auto_at > kStep3 && auto_at - kStep3 <= 1.0, "auto_at %.2f", auto_at);
+    CHECK_MSG(s3 > 0 && s3 <= 1200, "step3 settle %.0fms", s3);
+    // 5000lux上再次稳定：回到800ms并固定在RN=8（10483lux）
+    CHECK_MSG((dev.reg(OPT3001_CONFIG_REG) & 0xF800) == (0x8000 | OPT3001_CFG_CT),
+              "final 0x%04X", (unsigned)dev.reg(OPT3001_CONFIG_REG));
+    // 每次重配置丢弃一个转换；其余转换都上报（最后一次转换可能刚完成尚未读出）
+    CHECK(as.switches >= 3 && as.discarded == as.switches);
+    CHECK_MSG(g_samples.size() + as.discarded + 1 >= dev.stats().conversions - conv0 &&
+              g_samples.size() + as.discarded <= dev.stats().conversions - conv0,
+              "samples %u + discarded %u vs conversions %u", (unsigned)g_samples.size(),
+              (unsigned)as.discarded, (unsigned)(dev.stats().conversions - conv0));
+
+    return sim_test_result("adapt");
+}
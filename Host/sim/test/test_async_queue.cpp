@@ -0,0 +1,150 @@
+// 异步事务队列：TIM2节拍中断推进软件IIC状态机，核对FIFO顺序、回调在中断上下文执行、
+// 队列满、指针缓存省去的字节、NACK重试间隔与重试耗尽，以及回调内再提交
+#include "sim_core.h"
+#include "sim_opt3001.h"
+#include "sim_test.h"
+
+#include "delay.h"
+#include "opt3001.h"
+#include "opt3001_async.h"
+
+namespace {
+
+struct Log {
+    int calls;
+    int order[16];
+    u16 data[16];
+    OPT3001_XferResultTypeDef result[16];
+    bool all_in_isr;
+    uint64_t done_at;
+};
+
+Log g_log;
+
+void record(const OPT3001_XferTypeDef *xfer)
+{
+    int n = g_log.calls++;
+
+    if (n < 16) {
+        g_log.order[n] = (int)(intptr_t)xfer->ctx;
+        g_log.data[n] = xfer->data;
+        g_log.result[n] = xfer->result;
+    }
+    if (!sim::in_isr())
+        g_log.all_in_isr = false;
+    g_log.done_at = sim::now();
+}
+
+void clear_log()
+{
+    g_log = Log();
+    g_log.all_in_isr = true;
+}
+
+bool drained()
+{
+    return OPT3001_Async_Pending() == 0;
+}
+
+// 回调内提交下一个读，验证中断上下文中的Submit
+OPT3001_HandleTypeDef *g_chain_handle;
+
+void chain(const OPT3001_XferTypeDef *xfer)
+{
+    record(xfer);
+    if ((intptr_t)xfer->ctx == 100)
+        OPT3001_Async_ReadReg(g_chain_handle, OPT3001_MANUF_ID_REG, record, (void *)101);
+}
+
+}
+
+int main()
+{
+    sim::Opt3001 dev(OPT3001_ADDR);
+    OPT3001_HandleTypeDef h = OPT3001_HANDLE_INIT(&OPT3001_DefaultBus, OPT3001_ADDR, 0);
+    uint64_t t0;
+    int i;
+
+    dev.lux = [](double) { return 250.0; };
+    dev.attach_wire(OPT3001_IIC_PORT, OPT3001_IIC_SCL_PIN, OPT3001_IIC_SDA_PIN);
+    SysTick_Init();
+    DWT_Init();
+    OPT3001_Bus_Init(&OPT3001_DefaultBus);
+    OPT3001_Async_Init();
+
+    // 提交立即返回，事务按提交顺序在TIM2中断中完成，队列空后节拍停止
+    clear_log();
+    t0 = sim::now();
+    CHECK(OPT3001_Async_WriteReg(&h, OPT3001_CONFIG_REG, OPT3001_CONFIG_FASTBOOT, record, (void *)0) == 0);
+    CHECK(OPT3001_Async_ReadReg(&h, OPT3001_DEVICE_ID_REG, record, (void *)1) == 0);
+    CHECK(OPT3001_Async_ReadReg(&h, OPT3001_MANUF_ID_REG, record, (void *)2) == 0);
+    CHECK(OPT3001_Async_ReadReg(&h, OPT3001_CONFIG_REG, record, (void *)3) == 0);
+    CHECK_MSG(sim::cycles_to_us(sim::now() - t0) < 20, "submit=%.1fus", sim::cycles_to_us(sim::now() - t0));
+    CHECK(OPT3001_Async_Pending() == 4);
+    CHECK(g_log.calls == 0);
+    CHECK(sim::advance_until(drained, sim::ms_to_cycles(20)) == 0);
+    CHECK(g_log.calls == 4);
+    for (i = 0; i < 4; i++)
+        CHECK(g_log.order[i] == i && g_log.result[i] == OPT3001_XFER_OK);
+    CHECK(g_log.data[1] == OPT3001_DEVICE_ID);
+    CHECK(g_log.data[2] == OPT3001_MANUF_ID);
+    CHECK((g_log.data[3] & 0xFE1F) == OPT3001_CONFIG_FASTBOOT);
+    CHECK(g_log.all_in_isr);
+    CHECK(sim::irq_count(TIM2_IRQn) > 0);
+    CHECK(!(TIM2->CR1.v & TIM_CR1_CEN));
+    CHECK(OPT3001_Async_GetXferCount() == 4);
+
+    // 队列满：第9个提交被拒绝，已排队的照常完成
+    clear_log();
+    for (i = 0; i < OPT3001_ASYNC_QUEUE_SIZE; i++)
+        CHECK(OPT3001_Async_ReadReg(&h, OPT3001_DEVICE_ID_REG, record, (void *)(intptr_t)i) == 0);
+    CHECK(OPT3001_Async_ReadReg(&h, OPT3001_DEVICE_ID_REG, record, (void *)99) == 1);
+    CHECK(sim::advance_until(drained, sim::ms_to_cycles(50)) == 0);
+    CHECK(g_log.calls == OPT3001_ASYNC_QUEUE_SIZE);
+
+    // 指针缓存：连续读结果寄存器，第一次5字节，之后只有addr+R与2个数据字节
+    sim::advance(sim::ms_to_cycles(110));
+    dev.reset_stats();
+    CHECK(OPT3001_Async_ReadReg(&h, OPT3001_RESULT_REG, record, 0) == 0);
+    CHECK(sim::advance_until(drained, sim::ms_to_cycles(10)) == 0);
+    CHECK(dev.stats().bytes == 5);
+    CHECK(OPT3001_Async_ReadReg(&h, OPT3001_RESULT_REG, record, 0) == 0);
+    CHECK(sim::advance_until(drained, sim::ms_to_cycles(10)) == 0);
+    CHECK(dev.stats().bytes == 8);
+    CHECK(dev.stats().ptr_writes == 1);
+    CHECK(h.reg_ptr == OPT3001_RESULT_REG);
+
+    // 一次NACK：隔OPT3001_ASYNC_RETRY_MS重试后成功，回调只来一次
+    clear_log();
+    dev.nack_next(1);
+    t0 = sim::now();
+    CHECK(OPT3001_Async_WriteReg(&h, OPT3001_LOW_LIMIT_REG, 0x1234, record, (void *)7) == 0);
+    CHECK(sim::advance_until(drained, sim::ms_to_cycles(50)) == 0);
+    CHECK(g_log.calls == 1 && g_log.result[0] == OPT3001_XFER_OK);
+    CHECK(dev.reg(OPT3001_LOW_LIMIT_REG) == 0x1234);
+    CHECK(sim::cycles_to_us(g_log.done_at - t0) >= OPT3001_ASYNC_RETRY_MS * 1000);
+
+    // 器件不在线：共尝试OPT3001_MAX_RETRY次后以NACK完成，指针缓存作废
+    clear_log();
+    dev.present = false;
+    t0 = sim::now();
+    CHECK(OPT3001_Async_ReadReg(&h, OPT3001_RESULT_REG, record, (void *)8) == 0);
+    CHECK(sim::advance_until(drained, sim::ms_to_cycles(100)) == 0);
+    CHECK(g_log.calls == 1 && g_log.result[0] == OPT3001_XFER_NACK);
+    CHECK(sim::cycles_to_us(g_log.done_at - t0) >= (OPT3001_MAX_RETRY - 1) * OPT3001_ASYNC_RETRY_MS * 1000);
+    CHECK(h.reg_ptr == OPT3001_PTR_UNKNOWN);
+    dev.present = true;
+
+    // 回调内提交：队列排满时也能用上刚完成事务释放的槽位，后续事务排在队尾接着执行
+    clear_log();
+    g_chain_handle = &h;
+    CHECK(OPT3001_Async_ReadReg(&h, OPT3001_DEVICE_ID_REG, chain, (void *)100) == 0);
+    for (i = 1; i < OPT3001_ASYNC_QUEUE_SIZE; i++)
+        CHECK(OPT3001_Async_ReadReg(&h, OPT3001_DEVICE_ID_REG, record, (void *)(intptr_t)i) == 0);
+    CHECK(sim::advance_until(drained, sim::ms_to_cycles(50)) == 0);
+    CHECK(g_log.calls == OPT3001_ASYNC_QUEUE_SIZE + 1);
+    CHECK(g_log.order[0] == 100 && g_log.order[OPT3001_ASYNC_QUEUE_SIZE] == 101);
+    CHECK(g_log.data[OPT3001_ASYNC_QUEUE_SIZE] == OPT3001_MANUF_ID);
+
+    return sim_test_result("async_queue");
+}
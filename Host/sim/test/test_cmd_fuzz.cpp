@@ -0,0 +1,321 @@
+// 串口命令解析的模糊测试：按固定种子生成混合的命令行（合法命令、随机词、任意字节、恰好/超过
+// CMD_LINE_MAX的行、空行、\r\n/\n/\r结尾），逐字节送入Cmd_Feed，与一个按字符串实现的参照解析逐行比较结果；
+// 处理函数检查argv都落在行缓冲内、非空且不含分隔符，参数个数符合命令表。Cmd_ParseU32与参照转换比较。
+// 最后经虚拟USART1按9600bps送入同一批字节，RXNE中断环形缓冲取出后的解析结果与直接输入一致，
+// 主循环停顿时缓冲满的字节被丢弃并计数
+#include "sim_core.h"
+#include "sim_test.h"
+
+#include "cmd_parser.h"
+#include "delay.h"
+#include "usart1_rx.h"
+
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+const int kLines = 200000;
+const int kRxLines = 150;
+
+Cmd_ParserTypeDef g_parser;
+u32 g_calls, g_bad_argv;
+
+// 返回1（参数值非法）当且仅当最后一个参数以'!'开头，参照解析据此预测CMD_BAD_VALUE
+u8 on_cmd(u8 argc, char **argv)
+{
+    const char *lo = g_parser.line, *hi = g_parser.line + sizeof g_parser.line;
+
+    g_calls++;
+    for (u8 i = 0; i < argc; i++) {
+        size_t n = std::strlen(argv[i]);
+        if (argv[i] < lo || argv[i] + n >= hi || n == 0 || std::strpbrk(argv[i], " \t") != nullptr)
+            g_bad_argv++;
+    }
+    return argv[argc - 1][0] == '!';
+}
+
+// 与main.c的命令表同形：各种参数个数范围
+const Cmd_EntryTypeDef kTable[] = {
+    { "get", 0, 1, on_cmd, "" },
+    { "set", 2, 2, on_cmd, "" },
+    { "mode", 1, 1, on_cmd, "" },
+    { "scan", 0, 0, on_cmd, "" },
+    { "s", 0, 0, on_cmd, "" },
+    { "stats", 0, 0, on_cmd, "" },
+    { "baud", 1, 1, on_cmd, "" },
+    { "confirm", 0, 0, on_cmd, "" },
+};
+const u8 kTableSize = sizeof kTable / sizeof kTable[0];
+
+// 参照解析：整行（不含结束符）的预期结果
+Cmd_ResultTypeDef reference(const std::string &content)
+{
+    std::vector<std::string> tok;
+    std::string cur;
+
+    if (content.size() > CMD_LINE_MAX)
+        return CMD_TOO_LONG;
+    for (unsigned char c : content) {
+        if (c < 0x20 || c >= 0x7F)
+            c = ' ';
+        if (c == ' ') {
+            if (!cur.empty())
+                tok.push_back(cur);
+            cur.clear();
+        } else {
+            cur += (char)c;
+        }
+    }
+    if (!cur.empty())
+        tok.push_back(cur);
+    if (tok.empty())
+        return CMD_NONE;
+    if (tok.size() > CMD_ARGS_MAX)
+        return CMD_BAD_ARGS;
+    for (const Cmd_EntryTypeDef &e : kTable) {
+        if (tok[0] != e.name)
+            continue;
+        if (tok.size() - 1 < e.min_args || tok.size() - 1 > e.max_args)
+            return CMD_BAD_ARGS;
+        return tok.back()[0] == '!' ? CMD_BAD_VALUE : CMD_OK;
+    }
+    return CMD_UNKNOWN;
+}
+
+// 一行内容（不含\r\n）：各类输入按比例混合
+std::string make_line(std::mt19937 &rng)
+{
+    static const char *const words[] = { "get", "set", "mode", "scan", "s", "stats", "baud", "confirm",
+                                         "jump", "median", "bin", "text", "115200", "0x1F", "!bad", "Set",
+                                         "get2", "" };
+    const int nwords = sizeof words / sizeof words[0];
+    std::string s;
+    int kind = rng() % 10, n;
+
+    switch (kind) {
+    case 0: case 1: case 2: case 3:             // 由词表拼成，分隔符为空格/制表符/控制字符
+        n = rng() % 7;
+        for (int i = 0; i < n; i++) {
+            if (i > 0 || rng() % 4 == 0)
+                s += " \t\x01\x7F\xFF"[rng() % 5];
+            if (rng() % 8 == 0)
+                s += ' ';
+            s += words[rng() % nwords];
+        }
+        break;
+    case 4: case 5:                             // 任意字节（除行结束符）
+        n = rng() % 60;
+        for (int i = 0; i < n; i++) {
+            char c;
+            do {
+                c = (char)(rng() & 0xFF);
+            } while (c == '\r' || c == '\n');
+            s += c;
+        }
+        break;
+    case 6:                                     // 长度落在CMD_LINE_MAX附近
+        n = CMD_LINE_MAX - 1 + rng() % 3;
+        s = "set jump ";
+        while ((int)s.size() < n)
+            s += (char)('0' + rng() % 10);
+        s.resize(n);
+        break;
+    case 7:                                     // 远超单行上限
+        n = CMD_LINE_MAX + 1 + rng() % 200;
+        for (int i = 0; i < n; i++)
+            s += (char)('a' + rng() % 26);
+        break;
+    case 8:                                     // 空行或只有分隔符
+        s.assign(rng() % 5, ' ');
+        break;
+    default:                                    // 合法命令
+        s = "set median ";
+        s += std::to_string(rng() % 16);
+        break;
+    }
+    return s;
+}
+
+std::string make_terminator(std::mt19937 &rng)
+{
+    static const char *const ends[] = { "\r\n", "\n", "\r", "\n\n" };
+    return ends[rng() % 4];
+}
+
+// 参照转换：十进制或0x十六进制，空串/非法字符/超出32位返回1
+u8 reference_u32(const std::string &s, u32 *out)
+{
+    size_t i = 0;
+    uint64_t v = 0, base = 10;
+
+    if (s.size() >= 2 && s[0] == '0' && (s[1] == 'x' || s[1] == 'X')) {
+        base = 16;
+        i = 2;
+    }
+    if (i == s.size())
+        return 1;
+    for (; i < s.size(); i++) {
+        char c = s[i];
+        int d;
+
+        if (c >= '0' && c <= '9')
+            d = c - '0';
+        else if (base == 16 && c >= 'a' && c <= 'f')
+            d = c - 'a' + 10;
+        else if (base == 16 && c >= 'A' && c <= 'F')
+            d = c - 'A' + 10;
+        else
+            return 1;
+        v = v * base + d;
+        if (v > 0xFFFFFFFFull)
+            return 1;
+    }
+    *out = (u32)v;
+    return 0;
+}
+
+void usart1_init()
+{
+    USART_InitTypeDef init;
+
+    RCC_APB2PeriphClockCmd(RCC_APB2Periph_USART1 | RCC_APB2Periph_GPIOA, ENABLE);
+    init.USART_BaudRate = 9600;
+    init.USART_WordLength = USART_WordLength_8b;
+    init.USART_StopBits = USART_StopBits_1;
+    init.USART_Parity = USART_Parity_No;
+    init.USART_HardwareFlowControl = USART_HardwareFlowControl_None;
+    init.USART_Mode = USART_Mode_Tx | USART_Mode_Rx;
+    USART_Init(USART1, &init);
+    USART_Cmd(USART1, ENABLE);
+}
+
+}
+
+int main()
+{
+    std::mt19937 rng(20261017);
+    u32 counts[CMD_TOO_LONG + 1] = { 0 }, mismatches = 0, bad_len = 0, expect_calls = 0;
+    uint64_t bytes = 0;
+
+    // 逐字节比较：行内字节一律返回CMD_NONE，结束符返回整行结果，紧跟的第二个结束符是空行
+    Cmd_Init(&g_parser, kTable, kTableSize);
+    for (int n = 0; n < kLines; n++) {
+        std::string content = make_line(rng), end = make_terminator(rng);
+        Cmd_ResultTypeDef expect = reference(content), got;
+
+        for (unsigned char c : content) {
+            if (Cmd_Feed(&g_parser, c) != CMD_NONE)
+                mismatches++;
+            if (g_parser.len > CMD_LINE_MAX)
+                bad_len++;
+        }
+        got = Cmd_Feed(&g_parser, (u8)end[0]);
+        if (got != expect && mismatches++ < 5)
+            std::fprintf(stderr, "  行%d：期望%d，得到%d\n", n, (int)expect, (int)got);
+        if (end.size() > 1 && Cmd_Feed(&g_parser, (u8)end[1]) != CMD_NONE)
+            mismatches++;
+        if (expect == CMD_OK || expect == CMD_BAD_VALUE)
+            expect_calls++;
+        counts[expect]++;
+        bytes += content.size() + end.size();
+    }
+    std::printf("  %d行 %llu字节：执行 %u，未知 %u，参数个数错 %u，值非法 %u，超长 %u，空行 %u\n", kLines,
+                (unsigned long long)bytes, (unsigned)counts[CMD_OK], (unsigned)counts[CMD_UNKNOWN],
+                (unsigned)counts[CMD_BAD_ARGS], (unsigned)counts[CMD_BAD_VALUE], (unsigned)counts[CMD_TOO_LONG],
+                (unsigned)counts[CMD_NONE]);
+    CHECK_MSG(mismatches == 0, "%u mismatches", (unsigned)mismatches);
+    CHECK(bad_len == 0);
+    CHECK_MSG(g_calls == expect_calls && g_bad_argv == 0, "calls %u/%u, bad argv %u", (unsigned)g_calls,
+              (unsigned)expect_calls, (unsigned)g_bad_argv);
+    // 每类结果都实际出现过
+    for (int r = CMD_NONE; r <= CMD_TOO_LONG; r++)
+        CHECK_MSG(counts[r] > 100, "result %d seen %u times", r, (unsigned)counts[r]);
+
+    // 整数转换：随机串与边界值
+    {
+        static const char alphabet[] = "0123456789abcdefABCDEFxX+- g";
+        const char *const edges[] = { "0", "4294967295", "4294967296", "0xFFFFFFFF", "0x100000000", "0x",
+                                      "0X0", "", "00000000000004294967295", "0x0000000000001F", "99999999999" };
+        u32 diff = 0;
+
+        for (const char *e : edges) {
+            u32 a = 0xDEAD, b = 0xDEAD;
+            u8 ra = Cmd_ParseU32(e, &a), rb = reference_u32(e, &b);
+            if (ra != rb || (ra == 0 && a != b))
+                diff++;
+        }
+        for (int n = 0; n < 500000; n++) {
+            std::string s;
+            int len = rng() % 13;
+            u32 a = 0, b = 0;
+            u8 ra, rb;
+
+            if (rng() % 3 == 0)
+                s = "0x";
+            for (int i = 0; i < len; i++)
+                s += alphabet[rng() % (sizeof alphabet - 1)];
+            ra = Cmd_ParseU32(s.c_str(), &a);
+            rb = reference_u32(s, &b);
+            if (ra != rb || (ra == 0 && a != b))
+                diff++;
+        }
+        CHECK_MSG(diff == 0, "ParseU32 differs on %u inputs", (unsigned)diff);
+    }
+
+    // 经虚拟USART1接收：主循环每100us取空环形缓冲，结果序列与直接输入相同，不丢字节
+    {
+        Cmd_ParserTypeDef direct;
+        std::vector<int> want, got;
+        std::string stream;
+        uint64_t end;
+        u8 ch;
+        u32 received = 0;
+
+        SysTick_Init();
+        DWT_Init();
+        usart1_init();
+        USART1_RX_Init();
+
+        for (int n = 0; n < kRxLines; n++)
+            stream += make_line(rng) + make_terminator(rng);
+        Cmd_Init(&direct, kTable, kTableSize);
+        for (unsigned char c : stream) {
+            Cmd_ResultTypeDef r = Cmd_Feed(&direct, c);
+            if (r != CMD_NONE)
+                want.push_back(r);
+        }
+
+        Cmd_Init(&g_parser, kTable, kTableSize);
+        sim::uart_inject(stream);
+        end = sim::now() + sim::ms_to_cycles(stream.size() * 10000.0 / 9600 + 20);
+        while (sim::now() < end) {
+            while (USART1_RX_Read(&ch)) {
+                Cmd_ResultTypeDef r = Cmd_Feed(&g_parser, ch);
+                if (r != CMD_NONE)
+                    got.push_back(r);
+                received++;
+            }
+            sim::advance(sim::us_to_cycles(100));
+        }
+        std::printf("  串口接收 %u 字节（%.1f s），解析出 %u 个结果\n", (unsigned)received,
+                    stream.size() * 10.0 / 9600, (unsigned)got.size());
+        CHECK(received == stream.size());
+        CHECK(got == want);
+        CHECK(USART1_RX_GetDropped() == 0 && USART1_RX_GetOverrun() == 0);
+
+        // 主循环停顿：200字节到达期间不读，缓冲只留前USART1_RX_BUF_SIZE个，其余计入丢弃
+        sim::uart_inject(std::string(200, 'z'));
+        sim::advance(sim::ms_to_cycles(250));
+        received = 0;
+        while (USART1_RX_Read(&ch))
+            received++;
+        CHECK(received == USART1_RX_BUF_SIZE);
+        CHECK(USART1_RX_GetDropped() == 200 - USART1_RX_BUF_SIZE);
+        CHECK(USART1_RX_GetOverrun() == 0);
+    }
+
+    return sim_test_result("cmd_fuzz");
+}
@@ -0,0 +1,165 @@
+// 阈值窗口事件模式：两个虚拟OPT3001（800ms转换），一个光照基本不变，一个在10s和15s各跳变一次。
+// 同样的光照（共60s）分别按每次转换采集与事件模式运行，比较总线事务数与上报样本数；
+// 事件模式下光照留在窗口内时总线上没有任何事务，越限后上报新值并重新居中窗口
+#include "sim_core.h"
+#include "sim_opt3001.h"
+#include "sim_test.h"
+
+#include "delay.h"
+#include "opt3001.h"
+#include "opt3001_adapt.h"
+#include "opt3001_health.h"
+#include "opt3001_sched.h"
+
+#include <memory>
+
+namespace {
+
+const int kRunMs = 60000;
+const int kSensors = 2;
+
+struct Result {
+    uint32_t starts;            // 两个器件上的START（事务）总数
+    int samples;                // 上报样本数（串口每个样本一行）
+    uint32_t quiet_starts;      // 2s~10s光照不变期间的事务数
+    u32 step_clux;              // 10s跳变后传感器0上报的第一个接近新值的样本
+    double step_latency_ms;     // 跳变到上报该样本的时间
+};
+
+sim::Opt3001 *g_dev[kSensors];
+OPT3001_HandleTypeDef g_h[kSensors];
+Result g_r;
+
+// 传感器0：300lux，10s~15s跳到600lux；传感器1：500lux附近±1%缓慢起伏
+double lux0(double t)
+{
+    return (t >= 10.0 && t < 15.0) ? 600.0 : 300.0;
+}
+
+double lux1(double t)
+{
+    return 500.0 + 5.0 * (t - (int)t);
+}
+
+double g_t0;
+
+void on_sample(OPT3001_HandleTypeDef *h, u16 raw, u32 clux, u32 stamp_us)
+{
+    (void)stamp_us;
+    if (raw == 0)
+        return;
+    g_r.samples++;
+    if (h->id == 0 && g_r.step_clux == 0 && sim::now_us() > g_t0 + 10e6 && clux > 55000) {
+        g_r.step_clux = clux;
+        g_r.step_latency_ms = (sim::now_us() - g_t0 - 10e6) / 1000;
+    }
+}
+
+uint32_t total_starts()
+{
+    uint32_t n = 0;
+
+    for (int i = 0; i < kSensors; i++)
+        n += g_dev[i]->stats().starts;
+    return n;
+}
+
+Result run(bool event_mode)
+{
+    uint64_t t0, end;
+    uint32_t s2 = 0;
+    bool at2 = false, at10 = false;
+    int i;
+
+    // 上一种模式的读取全部结束后再重新初始化
+    end = sim::now() + sim::ms_to_cycles(100);
+    while ((OPT3001_Sched_IsBusy() || OPT3001_Async_Pending() != 0) && sim::now() < end) {
+        OPT3001_Sched_Poll();
+        sim::advance(sim::us_to_cycles(100));
+    }
+    for (i = 0; i < kSensors; i++) {
+        CHECK(sim_sensor_init(&g_h[i], g_dev[i], &OPT3001_DefaultBus, (u8)(OPT3001_ADDR_MIN + i), (u8)i) == 0);
+        CHECK(OPT3001_Sensor_Configure(&g_h[i], OPT3001_CONFIG_DEFAULT) == 0);
+        CHECK(OPT3001_Sensor_EnableEoc(&g_h[i]) == 0);
+    }
+    OPT3001_Async_Init();
+    OPT3001_Sched_Init(g_h, kSensors, on_sample);
+    OPT3001_Health_Init(g_h, kSensors);
+    OPT3001_Adapt_Init(g_h, kSensors);
+    CHECK(OPT3001_Sched_SetEventMode(event_mode) == 0);
+
+    // 光照时间轴从这里开始
+    t0 = sim::now();
+    g_t0 = sim::cycles_to_us(t0);
+    g_dev[0]->lux = [](double t) { return lux0(t - g_t0 / 1e6); };
+    g_dev[1]->lux = [](double t) { return lux1(t - g_t0 / 1e6); };
+    for (i = 0; i < kSensors; i++)
+        g_dev[i]->reset_stats();
+    g_r = Result();
+
+    end = t0 + sim::ms_to_cycles(kRunMs);
+    while (sim::now() < end) {
+        OPT3001_Sched_Poll();
+        sim::advance(sim::us_to_cycles(100));
+        if (!at2 && sim::now() - t0 >= sim::ms_to_cycles(2000)) {
+            s2 = total_starts();
+            at2 = true;
+        }
+        if (!at10 && sim::now() - t0 >= sim::ms_to_cycles(10000)) {
+            g_r.quiet_starts = total_starts() - s2;
+            at10 = true;
+        }
+    }
+    g_r.starts = total_starts();
+    return g_r;
+}
+
+}
+
+int main()
+{
+    std::unique_ptr<sim::Opt3001> dev[kSensors];
+    Result conv, event;
+    uint32_t low, high, now_clux;
+    int i;
+
+    for (i = 0; i < kSensors; i++) {
+        dev[i].reset(new sim::Opt3001((uint8_t)(OPT3001_ADDR_MIN + i)));
+        g_dev[i] = dev[i].get();
+        g_dev[i]->conv_scale = 1.0 + 0.03 * i;
+        g_dev[i]->attach_wire(OPT3001_IIC_PORT, OPT3001_IIC_SCL_PIN, OPT3001_IIC_SDA_PIN);
+        g_dev[i]->attach_int(OPT3001_INT_PORT, OPT3001_INT_PIN);
+    }
+    SysTick_Init();
+    DWT_Init();
+    OPT3001_Bus_Init(&OPT3001_DefaultBus);
+
+    conv = run(false);
+    event = run(true);
+
+    std::printf("  模式          总线事务  上报样本  2~10s事务  跳变后上报(ms)\n");
+    std::printf("  每次转换采集  %8u  %8d  %9u  %8.0f\n", (unsigned)conv.starts, conv.samples,
+                (unsigned)conv.quiet_starts, conv.step_latency_ms);
+    std::printf("  事件模式      %8u  %8d  %9u  %8.0f\n", (unsigned)event.starts, event.samples,
+                (unsigned)event.quiet_starts, event.step_latency_ms);
+
+    // 光照留在窗口内：没有INT，总线完全静默
+    CHECK_MSG(event.quiet_starts == 0, "quiet_starts=%u", (unsigned)event.quiet_starts);
+    CHECK(conv.quiet_starts > 0);
+    // 事务与上报样本都减少一个数量级以上
+    CHECK_MSG(event.starts * 10 < conv.starts, "event=%u conv=%u", (unsigned)event.starts, (unsigned)conv.starts);
+    CHECK_MSG(event.samples * 10 < conv.samples, "event=%d conv=%d", event.samples, conv.samples);
+    // 越限照常上报，不比逐次采集慢过一个转换周期
+    CHECK_MSG(event.step_clux > 0 && event.step_latency_ms <= conv.step_latency_ms + 800,
+              "event %u@%.0fms conv %u@%.0fms", (unsigned)event.step_clux, event.step_latency_ms,
+              (unsigned)conv.step_clux, conv.step_latency_ms);
+
+    // 窗口已按最后一次上报的光照（回到300lux）重新居中
+    now_clux = sim::Opt3001::to_centilux(g_dev[0]->reg(OPT3001_RESULT_REG));
+    low = sim::Opt3001::to_centilux(g_dev[0]->reg(OPT3001_LOW_LIMIT_REG));
+    high = sim::Opt3001::to_centilux(g_dev[0]->reg(OPT3001_HIGH_LIMIT_REG));
+    CHECK_MSG(low < now_clux && now_clux < high && high < 40000,
+              "window %u..%u, now %u", (unsigned)low, (unsigned)high, (unsigned)now_clux);
+
+    return sim_test_result("event_mode");
+}
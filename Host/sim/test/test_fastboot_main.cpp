@@ -0,0 +1,98 @@
+// 整机上电：从复位运行main.c，串口报告的上电到首个样本不超过150ms；
+// 上电只访问0x44~0x47候选地址，配置寄存器只写一次短转换配置；全地址扫描只在scan命令后发生
+#include "sim_core.h"
+#include "sim_opt3001.h"
+#include "sim_test.h"
+
+#include "opt3001.h"
+
+#include <cstdlib>
+#include <regex>
+#include <set>
+#include <string>
+
+int firmware_main(void);
+
+namespace {
+
+// 线上记录中每个START后的地址字节（"S 88A ..." -> 0x44）
+std::set<int> addressed(const std::string &trace)
+{
+    std::set<int> out;
+    size_t pos = 0;
+
+    while ((pos = trace.find("S ", pos)) != std::string::npos) {
+        pos += 2;
+        if (pos + 3 <= trace.size() && (trace[pos + 2] == 'A' || trace[pos + 2] == 'N'))
+            out.insert(std::strtol(trace.substr(pos, 2).c_str(), 0, 16) >> 1);
+    }
+    return out;
+}
+
+// 写配置寄存器的事务："S 88A 01A xxA xxA P"（读配置在01A之后是重复START）
+int config_writes(const std::string &trace)
+{
+    const std::string prefix = "S 88A 01A ";
+    size_t pos = 0;
+    int n = 0;
+
+    while ((pos = trace.find(prefix, pos)) != std::string::npos) {
+        pos += prefix.size();
+        if (trace.compare(pos, 1, "S") != 0)
+            n++;
+    }
+    return n;
+}
+
+}
+
+int main()
+{
+    sim::Opt3001 dev(OPT3001_ADDR);
+    std::string boot, trace;
+    std::smatch m;
+    int boot_ms = -1;
+    double first_ms;
+
+    dev.lux = [](double) { return 420.0; };
+    dev.attach_wire(OPT3001_IIC_PORT, OPT3001_IIC_SCL_PIN, OPT3001_IIC_SDA_PIN).trace_enabled = true;
+    dev.attach_int(OPT3001_INT_PORT, OPT3001_INT_PIN);
+    sim::flash_erase_all();
+
+    // 新芯片首次上电：缓存为空，按候选地址重新发现。按1ms步进运行，
+    // 以仿真时钟记下第一次读结果寄存器的时刻，与固件自己报告的耗时对照
+    while (dev.stats().result_reads == 0 && sim::now() < sim::ms_to_cycles(300))
+        sim::run_firmware(firmware_main, sim::ms_to_cycles(1));
+    first_ms = sim::cycles_to_us(sim::now()) / 1000;
+    sim::run_firmware(firmware_main, sim::ms_to_cycles(1500));
+    boot = sim::uart_output();
+    CHECK_MSG(boot.find("发现1个OPT3001（重新发现）") != std::string::npos, "%s", boot.c_str());
+    CHECK(boot.find("初始化成功，首个样本：") != std::string::npos);
+    if (std::regex_search(boot, m, std::regex("上电到首个样本：([0-9]+) ms")))
+        boot_ms = std::atoi(m[1].str().c_str());
+    CHECK_MSG(boot_ms > 0 && boot_ms <= 150, "boot_ms=%d", boot_ms);
+    CHECK_MSG(first_ms <= 150 && boot_ms >= first_ms - 2 && boot_ms <= first_ms + 2,
+              "reported %d ms, bus shows %.1f ms", boot_ms, first_ms);
+    std::printf("上电到首个样本：固件报告 %d ms，仿真时钟 %.1f ms\n", boot_ms, first_ms);
+
+    // 上电期间只寻址候选地址；首个样本之前配置寄存器只写了一次（100ms快速启动配置）
+    trace = dev.wire()->trace;
+    for (int a : addressed(trace))
+        CHECK_MSG(a >= OPT3001_ADDR_MIN && a <= OPT3001_ADDR_MAX, "addressed 0x%02X", a);
+    {
+        std::string head = trace.substr(0, trace.find("S 88A 00A"));
+        CHECK_MSG(config_writes(head) == 1, "%s", head.c_str());
+        CHECK(head.find("S 88A 01A C6A 10A P") != std::string::npos);
+    }
+
+    // scan命令：全地址扫描在命令之后按2ms一步进行
+    dev.wire()->trace.clear();
+    sim::uart_clear_output();
+    sim::uart_inject("scan\r\n");
+    sim::run_firmware(firmware_main, sim::ms_to_cycles(1500));
+    CHECK_MSG(sim::uart_output().find("真实地址为: 0x44") != std::string::npos, "%s", sim::uart_output().c_str());
+    CHECK(sim::uart_output().find("--- 扫描结束 ---") != std::string::npos);
+    CHECK(addressed(dev.wire()->trace).size() == 127);
+
+    return sim_test_result("fastboot_main");
+}
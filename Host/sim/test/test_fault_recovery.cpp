@@ -0,0 +1,187 @@
+// 总线故障恢复的故障注入：一个软件IIC上的虚拟OPT3001按main.c的主循环运行调度器、健康监测与喂狗，
+// 依次注入字节中途卡住SDA、SDA对地短路5s、单次无应答、静默复位、掉电2.5s、拔出30s，
+// 测量每种故障从注入到恢复后第一个有效读数的时间（及故障解除后的部分）。核对：
+// 每次都恢复且读数正确；故障解除后的恢复时间不超过离线判定（兜底查询连续失败）、当时的退避间隔与两次转换之和；
+// 字节中途卡住与单次无应答在下一次传输内恢复、不进入离线；其余故障由健康监测按线路状态归类（卡死/无应答）
+// 并记录同样的恢复耗时；整个过程看门狗从未超时，
+// 主循环停住不喂狗时看门狗超时
+#include "sim_core.h"
+#include "sim_opt3001.h"
+#include "sim_test.h"
+
+#include "delay.h"
+#include "opt3001.h"
+#include "opt3001_adapt.h"
+#include "opt3001_health.h"
+#include "opt3001_sched.h"
+#include "watchdog.h"
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+
+namespace {
+
+const double kLux = 300;
+const u32 kConvMs = 800;
+
+const u32 kFallbackMs = 1000;           // main.c接INT时的兜底查询间隔（CYCLE_INTERVAL_MS）
+
+sim::Opt3001 *g_dev;
+double g_last_good_ms = -1;
+uint64_t g_next_cycle;
+
+void on_sample(OPT3001_HandleTypeDef *h, u16 raw, u32 clux, u32 stamp_us)
+{
+    (void)stamp_us;
+    // 读数正确：状态正常且结果寄存器与光照一致（±2%）
+    if (h->status == OPT3001_STATUS_NORMAL && raw != 0 &&
+        std::fabs(OPT3001_RawToCentiLux(raw) / 100.0 - kLux) <= kLux * 0.02 &&
+        std::fabs(clux / 100.0 - kLux) <= kLux * 0.02)
+        g_last_good_ms = sim::now_us() / 1000;
+}
+
+// main.c主循环的一次迭代：调度（INT触发，每轮结束后1s兜底查询）、两轮之间的恢复、采集未停滞才喂狗
+void loop_once()
+{
+    if (OPT3001_Sched_Poll())
+        g_next_cycle = sim::now() + sim::ms_to_cycles(kFallbackMs);
+    if (sim::now() >= g_next_cycle)
+        g_next_cycle = OPT3001_Sched_StartCycle() != 0 ? sim::now() + sim::ms_to_cycles(kFallbackMs) : UINT64_MAX;
+    OPT3001_Health_Poll();
+    if (OPT3001_Sched_GetBusyMs() < OPT3001_HEALTH_STALL_MS)
+        Watchdog_Kick();
+    sim::advance(sim::us_to_cycles(100));
+}
+
+void run_ms(double ms)
+{
+    uint64_t end = sim::now() + sim::ms_to_cycles(ms);
+
+    while (sim::now() < end)
+        loop_once();
+}
+
+u32 faults_total()
+{
+    OPT3001_RecoveryStatsTypeDef s;
+    u32 total = 0;
+
+    for (int k = 0; k < OPT3001_FAULT_TYPES; k++) {
+        OPT3001_Health_GetStats((OPT3001_FaultTypeDef)k, &s);
+        total += s.faults;
+    }
+    return total;
+}
+
+struct Fault {
+    const char *name;
+    int type;                           // 预期的健康监测归类（-1：不应离线）
+    u32 duration_ms;                    // 故障持续时间（0：注入后自行消失或无需解除）
+    std::function<void()> inject, clear;
+};
+
+}
+
+int main()
+{
+    sim::Opt3001 dev(OPT3001_ADDR);
+    OPT3001_HandleTypeDef h;
+    const Fault faults[] = {
+        { "字节中途卡住SDA", -1, 0, [] { g_dev->hold_sda(3); }, [] {} },
+        { "SDA对地短路5s", OPT3001_FAULT_BUS_STUCK, 5000, [] { g_dev->short_sda(true); },
+          [] { g_dev->short_sda(false); } },
+        { "单次无应答", -1, 0, [] { g_dev->nack_next(1); }, [] {} },
+        { "静默复位", OPT3001_FAULT_NO_ACK, 0, [] { g_dev->power_on_reset(); }, [] {} },
+        { "掉电2.5s", OPT3001_FAULT_NO_ACK, 2500, [] { g_dev->present = false; },
+          [] { g_dev->present = true; g_dev->power_on_reset(); } },
+        { "拔出30s", OPT3001_FAULT_NO_ACK, 30000, [] { g_dev->present = false; },
+          [] { g_dev->present = true; g_dev->power_on_reset(); } },
+    };
+
+    g_dev = &dev;
+    dev.attach_wire(OPT3001_IIC_PORT, OPT3001_IIC_SCL_PIN, OPT3001_IIC_SDA_PIN);
+    dev.attach_int(OPT3001_INT_PORT, OPT3001_INT_PIN);
+    dev.lux = [](double) { return kLux; };
+    SysTick_Init();
+    DWT_Init();
+    OPT3001_Bus_Init(&OPT3001_DefaultBus);
+
+    CHECK(sim_sensor_init(&h, &dev, &OPT3001_DefaultBus, OPT3001_ADDR, 0) == 0);
+    CHECK(OPT3001_Sensor_Configure(&h, OPT3001_CONFIG_DEFAULT) == 0);
+    CHECK(OPT3001_Sensor_EnableEoc(&h) == 0);
+    OPT3001_Async_Init();
+    OPT3001_Sched_Init(&h, 1, on_sample);
+    OPT3001_Health_Init(&h, 1);
+    OPT3001_Adapt_Init(&h, 1);
+    Watchdog_Init(WATCHDOG_TIMEOUT_MS);
+    g_next_cycle = sim::now() + sim::ms_to_cycles(kFallbackMs);
+    run_ms(3000);
+    CHECK(g_last_good_ms > 0);
+
+    std::printf("  故障              持续(ms)  注入到恢复(ms)  解除后(ms)  健康统计(ms)  恢复尝试\n");
+    for (const Fault &f : faults) {
+        OPT3001_RecoveryStatsTypeDef before = {}, after = {};
+        double t0, cleared, recovered, ttr, after_clear, bound;
+        u32 backoff_at_clear, detect_ms;
+
+        u32 faults_before = faults_total();
+
+        if (f.type >= 0)
+            OPT3001_Health_GetStats((OPT3001_FaultTypeDef)f.type, &before);
+        // 故障落在转换中途（上一个有效读数后约一半转换时间）
+        run_ms(kConvMs / 2);
+        t0 = sim::now_us() / 1000;
+        f.inject();
+        run_ms(f.duration_ms);
+        f.clear();
+        cleared = sim::now_us() / 1000;
+        g_last_good_ms = -1;
+        {
+            uint64_t end = sim::now() + sim::ms_to_cycles(OPT3001_HEALTH_BACKOFF_MAX + 5000);
+            while (g_last_good_ms < 0 && sim::now() < end)
+                loop_once();
+        }
+        recovered = g_last_good_ms;
+        ttr = recovered - t0;
+        after_clear = recovered - cleared;
+        if (f.type >= 0)
+            OPT3001_Health_GetStats((OPT3001_FaultTypeDef)f.type, &after);
+
+        std::printf("  %-16s %8u  %14.0f  %10.0f  %12u  %8u\n", f.name, (unsigned)f.duration_ms, ttr, after_clear,
+                    (unsigned)(after.recovered > before.recovered ? after.last_ms : 0),
+                    (unsigned)(after.attempts - before.attempts));
+        CHECK_MSG(recovered > 0, "%s: not recovered", f.name);
+        // 器件停在关断模式时不再产生INT，靠兜底查询连续失败FAIL_LIMIT轮才判离线，故障短于此时解除后仍要补足；
+        // 故障期间退避间隔翻倍，解除时的间隔不超过max(最小间隔, 持续时间)与上限中的较小者；
+        // 之后一次恢复尝试、一次转换丢弃（重配置）与一次完整转换
+        detect_ms = OPT3001_HEALTH_FAIL_LIMIT * kFallbackMs;
+        detect_ms = f.duration_ms < detect_ms ? detect_ms - f.duration_ms : 0;
+        backoff_at_clear = std::min<u32>(std::max<u32>(OPT3001_HEALTH_BACKOFF_MIN, f.duration_ms),
+                                         OPT3001_HEALTH_BACKOFF_MAX);
+        bound = detect_ms + backoff_at_clear + 3 * kConvMs;
+        CHECK_MSG(after_clear <= bound, "%s: %.0fms after clear (bound %.0f)", f.name, after_clear, bound);
+        if (f.type >= 0) {
+            CHECK_MSG(after.faults == before.faults + 1 && after.recovered == before.recovered + 1,
+                      "%s: not classified as type %d", f.name, f.type);
+            // 健康统计从首次失败算起，不早于注入、不晚于有效读数
+            CHECK_MSG(after.last_ms <= ttr + 1 && after.last_ms + kConvMs + 100 >= ttr, "%s: stat %u vs %.0f",
+                      f.name, (unsigned)after.last_ms, ttr);
+        } else {
+            // 短暂卡住/单次无应答：下一次传输或重试即恢复，不进入离线
+            CHECK_MSG(ttr <= 2 * kConvMs + 100, "%s: %.0fms", f.name, ttr);
+            CHECK_MSG(faults_total() == faults_before, "%s: went offline", f.name);
+        }
+        run_ms(3000);
+    }
+    std::printf("  总线恢复序列执行 %u 次，看门狗超时 %u 次\n", (unsigned)OPT3001_Health_GetBusRecoveries(),
+                (unsigned)sim::iwdg_expired());
+    CHECK(OPT3001_Health_GetBusRecoveries() >= 2);
+    CHECK(sim::iwdg_expired() == 0);
+
+    // 主循环停住（不再喂狗）：看门狗在超时后复位
+    sim::advance(sim::ms_to_cycles(WATCHDOG_TIMEOUT_MS * 2));
+    CHECK(sim::iwdg_expired() >= 1);
+
+    return sim_test_result("fault_recovery");
+}
@@ -0,0 +1,396 @@
+// 滤波链各级与参考实现比较：EMA（浮点一阶低通）、Hampel（排序求中值/MAD）、卡尔曼（双精度标量滤波）
+// 与抽取（分组平均）逐样本对照同一输入序列（噪声、尖峰与台阶）；
+// 另验证运行时FilterChain_Select/SetParams（越界拒绝且不改动、合法修改立即生效）、
+// 各级DWT统计（只计链上实际执行的级，抽取吸收的样本不进入后级），
+// 以及调度器路径上被抽取吸收的样本不触发采样回调
+#include "sim_core.h"
+#include "sim_opt3001.h"
+#include "sim_test.h"
+
+#include "delay.h"
+#include "filter_chain.h"
+#include "opt3001.h"
+#include "opt3001_async.h"
+#include "opt3001_sched.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <memory>
+#include <vector>
+
+namespace {
+
+const int kSamples = 2000;
+
+// 30000±500（0.01lux）噪声，每53个样本一个5倍尖峰，1000处台阶到8000
+std::vector<u32> make_input()
+{
+    std::vector<u32> v(kSamples);
+
+    std::srand(4242);
+    for (int i = 0; i < kSamples; i++) {
+        v[i] = (i < kSamples / 2 ? 30000 : 8000) - 500 + std::rand() % 1001;
+        if (i % 53 == 17)
+            v[i] *= 5;
+    }
+    return v;
+}
+
+void select(u8 id)
+{
+    CHECK(FilterChain_Select(&id, 1) == 0);
+}
+
+void set_params(const Filter_ParamsTypeDef &p)
+{
+    CHECK(FilterChain_SetParams(&p) == 0);
+}
+
+Filter_ParamsTypeDef defaults()
+{
+    Filter_ParamsTypeDef p;
+
+    FilterChain_GetParams(&p);
+    p.jump_log_q8 = FILTER_JUMP_LOG_Q8;
+    p.jump_floor = FILTER_JUMP_FLOOR;
+    p.jump_confirm = FILTER_JUMP_CONFIRM;
+    p.ema_shift = FILTER_EMA_SHIFT;
+    p.median_window = MEDIAN_WINDOW_SIZE;
+    p.decim_factor = FILTER_DECIM_FACTOR;
+    p.hampel_k_q8 = FILTER_HAMPEL_K_Q8;
+    p.kalman_q = FILTER_KALMAN_Q;
+    p.kalman_r = FILTER_KALMAN_R;
+    return p;
+}
+
+// y += alpha*(x-y)；定点实现每步截断1/16，稳态偏差不超过2^shift/16，再加输出舍入
+void check_ema(const std::vector<u32> &in, u8 shift)
+{
+    Filter_StateTypeDef st = FILTER_STATE_INIT;
+    Filter_ParamsTypeDef p = defaults();
+    double y = 0, alpha = 1.0 / (1 << shift), tol = 1.0 + (1 << shift) / 16.0, worst = 0;
+    u32 v;
+
+    p.ema_shift = shift;
+    set_params(p);
+    select(FILTER_STAGE_EMA);
+    for (size_t i = 0; i < in.size(); i++) {
+        v = in[i];
+        CHECK(FilterChain_Run(&st, &v) == FILTER_OK);
+        y = i == 0 ? in[i] : y + alpha * (in[i] - y);
+        worst = std::max(worst, std::fabs(v - y));
+    }
+    CHECK_MSG(worst <= tol, "ema shift=%u worst=%.2f tol=%.2f", shift, worst, tol);
+    std::printf("  ema     shift=%u  最大偏差 %.2f（容限 %.2f）\n", shift, worst, tol);
+}
+
+// 窗口取最近min(n,7)个样本，偶数个取下中值；偏离中值超过floor(MAD*k_q8/256)则替换为中值
+void check_hampel(const std::vector<u32> &in)
+{
+    Filter_StateTypeDef st = FILTER_STATE_INIT;
+    std::vector<u32> win, tmp;
+    u32 v, med, mad, ref;
+    int replaced = 0, mismatch = 0;
+
+    set_params(defaults());
+    select(FILTER_STAGE_HAMPEL);
+    for (size_t i = 0; i < in.size(); i++) {
+        win.push_back(in[i]);
+        if (win.size() > FILTER_HAMPEL_WINDOW)
+            win.erase(win.begin());
+        ref = in[i];
+        if (win.size() >= 3) {
+            tmp = win;
+            std::sort(tmp.begin(), tmp.end());
+            med = tmp[(tmp.size() - 1) / 2];
+            for (size_t j = 0; j < win.size(); j++)
+                tmp[j] = win[j] > med ? win[j] - med : med - win[j];
+            std::sort(tmp.begin(), tmp.end());
+            mad = tmp[(tmp.size() - 1) / 2];
+            if ((in[i] > med ? in[i] - med : med - in[i]) > (u32)((uint64_t)mad * FILTER_HAMPEL_K_Q8 >> 8))
+                ref = med;
+        }
+        v = in[i];
+        CHECK(FilterChain_Run(&st, &v) == FILTER_OK);
+        if (v != ref)
+            mismatch++;
+        if (ref != in[i])
+            replaced++;
+    }
+    CHECK_MSG(mismatch == 0, "hampel mismatch=%d", mismatch);
+    // 每个尖峰都被替换
+    CHECK_MSG(replaced >= kSamples / 53, "hampel replaced=%d", replaced);
+    std::printf("  hampel  替换 %d 个样本，与参考不一致 %d\n", replaced, mismatch);
+}
+
+// 常值模型：x0=z0、P0=R；P+=Q，K=P/(P+R)，x+=K(z-x)，P-=KP。
+// 定点实现的P按整数截断、增益为Q16，设增益误差不超过0.001、每步舍入不超过1，
+// 则偏差上界按 b = (1-K)*b + 0.001*|z-x| + 1 递推（尖峰处新息大，偏差随之放大后衰减）
+void check_kalman(const std::vector<u32> &in, u16 q, u16 r)
+{
+    Filter_StateTypeDef st = FILTER_STATE_INIT;
+    Filter_ParamsTypeDef p = defaults();
+    double x = 0, pv = 0, k = 0, bound = 0, innov, err, worst = 0;
+    int over = 0;
+    u32 v;
+
+    p.kalman_q = q;
+    p.kalman_r = r;
+    set_params(p);
+    select(FILTER_STAGE_KALMAN);
+    for (size_t i = 0; i < in.size(); i++) {
+        if (i == 0) {
+            x = in[i];
+            pv = r;
+        } else {
+            pv += q;
+            k = pv / (pv + r);
+            innov = (double)in[i] - x;
+            x += k * innov;
+            pv -= k * pv;
+            bound = (1 - k) * bound + 0.001 * std::fabs(innov) + 1;
+        }
+        v = in[i];
+        CHECK(FilterChain_Run(&st, &v) == FILTER_OK);
+        err = std::fabs(v - x);
+        worst = std::max(worst, err);
+        if (err > bound + 1)
+            over++;
+    }
+    CHECK_MSG(over == 0, "kalman q=%u r=%u over=%d worst=%.2f", q, r, over, worst);
+    std::printf("  kalman  Q=%u R=%u  稳态增益 %.4f  最大偏差 %.2f\n", q, r, k, worst);
+}
+
+// 每factor个样本输出一次四舍五入的平均，其余返回HOLD
+void check_decim(const std::vector<u32> &in, u8 factor)
+{
+    Filter_StateTypeDef st = FILTER_STATE_INIT;
+    Filter_ParamsTypeDef p = defaults();
+    Filter_ResultTypeDef res;
+    uint64_t sum = 0;
+    int outputs = 0, mismatch = 0;
+    u32 v;
+
+    p.decim_factor = factor;
+    set_params(p);
+    select(FILTER_STAGE_DECIM);
+    for (size_t i = 0; i < in.size(); i++) {
+        sum += in[i];
+        v = in[i];
+        res = FilterChain_Run(&st, &v);
+        if ((i + 1) % factor != 0) {
+            CHECK(res == FILTER_HOLD);
+            continue;
+        }
+        CHECK(res == FILTER_OK);
+        if (v != (u32)((sum + factor / 2) / factor))
+            mismatch++;
+        sum = 0;
+        outputs++;
+    }
+    CHECK(outputs == kSamples / factor);
+    CHECK_MSG(mismatch == 0, "decim factor=%u mismatch=%d", factor, mismatch);
+    std::printf("  decim   factor=%u  输出 %d 个，与参考不一致 %d\n", factor, outputs, mismatch);
+}
+
+// 越界的链与参数被拒绝且不改动当前配置；合法修改立即生效
+void check_runtime_config()
+{
+    const u8 ema_decim[] = { FILTER_STAGE_EMA, FILTER_STAGE_DECIM };
+    const u8 bad_id[] = { FILTER_STAGE_RANGE, FILTER_STAGE_COUNT };
+    u8 all[FILTER_CHAIN_MAX + 1];
+    Filter_ParamsTypeDef p, bad, now;
+    Filter_StateTypeDef st = FILTER_STATE_INIT;
+    u32 v;
+    int i;
+
+    CHECK(FilterChain_Select(ema_decim, 2) == 0);
+    CHECK(FilterChain_Length() == 2);
+    CHECK(FilterChain_StageAt(0) == FILTER_STAGE_EMA && FilterChain_StageAt(1) == FILTER_STAGE_DECIM);
+    CHECK(FilterChain_StageAt(2) == FILTER_STAGE_COUNT);
+
+    for (i = 0; i <= FILTER_CHAIN_MAX; i++)
+        all[i] = (u8)(i % FILTER_STAGE_COUNT);
+    CHECK(FilterChain_Select(all, 0) == 1);
+    CHECK(FilterChain_Select(all, FILTER_CHAIN_MAX + 1) == 1);
+    CHECK(FilterChain_Select(bad_id, 2) == 1);
+    CHECK(FilterChain_Length() == 2 && FilterChain_StageAt(1) == FILTER_STAGE_DECIM);
+    CHECK(FilterChain_Select(all, FILTER_CHAIN_MAX) == 0);
+    CHECK(FilterChain_Length() == FILTER_CHAIN_MAX);
+
+    p = defaults();
+    set_params(p);
+    const struct {
+        const char *what;
+        void (*apply)(Filter_ParamsTypeDef *);
+    } cases[] = {
+        { "jump_log_q8=0", [](Filter_ParamsTypeDef *q) { q->jump_log_q8 = 0; } },
+        { "jump_confirm=0", [](Filter_ParamsTypeDef *q) { q->jump_confirm = 0; } },
+        { "ema_shift=9", [](Filter_ParamsTypeDef *q) { q->ema_shift = 9; } },
+        { "decim_factor=0", [](Filter_ParamsTypeDef *q) { q->decim_factor = 0; } },
+        { "kalman_r=0", [](Filter_ParamsTypeDef *q) { q->kalman_r = 0; } },
+        { "Q+R=65536", [](Filter_ParamsTypeDef *q) { q->kalman_q = 1; q->kalman_r = 65535; } },
+        { "median_window=4", [](Filter_ParamsTypeDef *q) { q->median_window = 4; } },
+    };
+    for (const auto &c : cases) {
+        bad = p;
+        c.apply(&bad);
+        CHECK_MSG(FilterChain_SetParams(&bad) == 1, "%s 未被拒绝", c.what);
+        FilterChain_GetParams(&now);
+        CHECK_MSG(now.ema_shift == p.ema_shift && now.decim_factor == p.decim_factor &&
+                  now.kalman_r == p.kalman_r && now.median_window == p.median_window,
+                  "%s 改动了参数", c.what);
+    }
+
+    // 运行中把抽取因子从4改为2：下一个输出在第2个样本到达
+    CHECK(FilterChain_Select(ema_decim, 2) == 0);
+    for (i = 0; i < 4; i++) {
+        v = 1000;
+        CHECK(FilterChain_Run(&st, &v) == (i == 3 ? FILTER_OK : FILTER_HOLD));
+    }
+    p.decim_factor = 2;
+    set_params(p);
+    v = 1000;
+    CHECK(FilterChain_Run(&st, &v) == FILTER_HOLD);
+    v = 1000;
+    CHECK(FilterChain_Run(&st, &v) == FILTER_OK && v == 1000);
+    set_params(defaults());
+}
+
+// 只有链上实际执行的级计数：抽取在前时被吸收的样本不进入EMA；每级耗时为两次CYCCNT读之间的周期
+void check_stats()
+{
+    const u8 decim_first[] = { FILTER_STAGE_RANGE, FILTER_STAGE_DECIM, FILTER_STAGE_EMA };
+    Filter_StateTypeDef st = FILTER_STATE_INIT;
+    Filter_StageStatsTypeDef s[FILTER_STAGE_COUNT];
+    u32 v;
+    int i;
+
+    set_params(defaults());
+    CHECK(FilterChain_Select(decim_first, 3) == 0);
+    FilterChain_ResetStats();
+    for (i = 0; i < 100; i++) {
+        v = 30000;
+        FilterChain_Run(&st, &v);
+    }
+    v = 0;
+    CHECK(FilterChain_Run(&st, &v) == FILTER_RANGE_ERR);
+    for (i = 0; i < FILTER_STAGE_COUNT; i++)
+        FilterChain_GetStats((u8)i, &s[i]);
+
+    std::printf("  级      调用  周期  最大\n");
+    for (i = 0; i < FILTER_STAGE_COUNT; i++)
+        std::printf("  %-6s  %4u  %4u  %4u\n", s[i].name, (unsigned)s[i].calls, (unsigned)s[i].cycles,
+                    (unsigned)s[i].max);
+
+    CHECK(s[FILTER_STAGE_RANGE].calls == 101);
+    CHECK(s[FILTER_STAGE_DECIM].calls == 100);
+    CHECK(s[FILTER_STAGE_EMA].calls == 100 / FILTER_DECIM_FACTOR);
+    CHECK(s[FILTER_STAGE_JUMP].calls == 0 && s[FILTER_STAGE_MEDIAN].calls == 0 &&
+          s[FILTER_STAGE_HAMPEL].calls == 0 && s[FILTER_STAGE_KALMAN].calls == 0);
+    for (i = 0; i < FILTER_STAGE_COUNT; i++) {
+        if (s[i].calls == 0) {
+            CHECK(s[i].cycles == 0 && s[i].max == 0);
+            continue;
+        }
+        CHECK_MSG(s[i].max > 0 && s[i].max <= s[i].cycles && s[i].cycles <= s[i].calls * s[i].max,
+                  "%s cycles=%u max=%u", s[i].name, (unsigned)s[i].cycles, (unsigned)s[i].max);
+    }
+
+    FilterChain_ResetStats();
+    for (i = 0; i < FILTER_STAGE_COUNT; i++) {
+        FilterChain_GetStats((u8)i, &s[i]);
+        CHECK(s[i].calls == 0 && s[i].cycles == 0 && s[i].max == 0);
+    }
+}
+
+/********************* 调度器路径：抽取吸收的样本不回调 *********************/
+sim::Opt3001 *g_dev;
+OPT3001_HandleTypeDef g_h;
+int g_callbacks;
+u32 g_last_clux;
+
+void on_sample(OPT3001_HandleTypeDef *h, u16 raw, u32 clux, u32 stamp_us)
+{
+    (void)stamp_us;
+    CHECK(h->status == OPT3001_STATUS_NORMAL && raw != 0);
+    g_callbacks++;
+    g_last_clux = clux;
+}
+
+// 按转换完成采集10s，返回回调次数与器件上的结果寄存器读次数
+void run_sched(const u8 *ids, u8 count, int *callbacks, uint32_t *reads)
+{
+    uint64_t end;
+
+    end = sim::now() + sim::ms_to_cycles(100);
+    while ((OPT3001_Sched_IsBusy() || OPT3001_Async_Pending() != 0) && sim::now() < end) {
+        OPT3001_Sched_Poll();
+        sim::advance(sim::us_to_cycles(100));
+    }
+    CHECK(FilterChain_Select(ids, count) == 0);
+    CHECK(sim_sensor_init(&g_h, g_dev, &OPT3001_DefaultBus, OPT3001_ADDR, 0) == 0);
+    CHECK(OPT3001_Sensor_Configure(&g_h, OPT3001_CONFIG_DEFAULT) == 0);
+    CHECK(OPT3001_Sensor_EnableEoc(&g_h) == 0);
+    OPT3001_Async_Init();
+    OPT3001_Sched_Init(&g_h, 1, on_sample);
+    g_dev->reset_stats();
+    g_callbacks = 0;
+
+    end = sim::now() + sim::ms_to_cycles(10000);
+    while (sim::now() < end) {
+        OPT3001_Sched_Poll();
+        sim::advance(sim::us_to_cycles(100));
+    }
+    *callbacks = g_callbacks;
+    *reads = g_dev->stats().result_reads;
+}
+
+void check_sched_decim()
+{
+    const u8 plain[] = { FILTER_STAGE_RANGE };
+    const u8 decim[] = { FILTER_STAGE_RANGE, FILTER_STAGE_DECIM };
+    int cb_plain, cb_decim;
+    uint32_t rd_plain, rd_decim;
+
+    set_params(defaults());
+    run_sched(plain, 1, &cb_plain, &rd_plain);
+    run_sched(decim, 2, &cb_decim, &rd_decim);
+    std::printf("  调度器  不抽取：读 %u 回调 %d；抽取%d：读 %u 回调 %d\n", (unsigned)rd_plain, cb_plain,
+                FILTER_DECIM_FACTOR, (unsigned)rd_decim, cb_decim);
+
+    CHECK(rd_plain > 0 && cb_plain == (int)rd_plain);
+    CHECK_MSG(cb_decim == (int)(rd_decim / FILTER_DECIM_FACTOR), "reads=%u callbacks=%d", (unsigned)rd_decim,
+              cb_decim);
+    CHECK_MSG(std::abs((int)g_last_clux - 30000) <= 300, "last=%u", (unsigned)g_last_clux);
+}
+
+}
+
+int main()
+{
+    std::vector<u32> in = make_input();
+    std::unique_ptr<sim::Opt3001> dev(new sim::Opt3001(OPT3001_ADDR));
+
+    g_dev = dev.get();
+    g_dev->lux = [](double) { return 300.0; };
+    g_dev->attach_wire(OPT3001_IIC_PORT, OPT3001_IIC_SCL_PIN, OPT3001_IIC_SDA_PIN);
+    g_dev->attach_int(OPT3001_INT_PORT, OPT3001_INT_PIN);
+    SysTick_Init();
+    DWT_Init();
+    OPT3001_Bus_Init(&OPT3001_DefaultBus);
+
+    check_ema(in, 2);
+    check_ema(in, 5);
+    check_hampel(in);
+    check_kalman(in, FILTER_KALMAN_Q, FILTER_KALMAN_R);
+    check_kalman(in, 4000, 400);
+    check_decim(in, FILTER_DECIM_FACTOR);
+    check_decim(in, 7);
+    check_runtime_config();
+    check_stats();
+    check_sched_decim();
+
+    return sim_test_result("filter_chain");
+}
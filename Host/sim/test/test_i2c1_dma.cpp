@@ -0,0 +1,109 @@
+// 硬件I2C1+DMA后端：在I2C1/DMA1寄存器模型上跑i2c1_dma.c的状态机，
+// 核对事务字节数、DMA接收长度与NACK/忙/总线卡死的结果码，以及异步完成回调
+#include "sim_core.h"
+#include "sim_opt3001.h"
+#include "sim_test.h"
+
+#include "delay.h"
+#include "i2c1_dma.h"
+#include "opt3001.h"
+
+namespace {
+
+struct Done {
+    int calls;
+    I2C1_DMA_ResultTypeDef result;
+};
+
+void on_done(I2C1_DMA_ResultTypeDef result, void *ctx)
+{
+    Done *d = (Done *)ctx;
+    d->calls++;
+    d->result = result;
+}
+
+}
+
+int main()
+{
+    sim::Opt3001 dev(0x44);
+    sim::Opt3001 other(0x45);
+    u16 v = 0;
+    uint32_t bytes;
+    uint64_t t0;
+
+    dev.lux = [](double) { return 1234.0; };
+    dev.attach_i2c1();
+    other.attach_i2c1();
+    SysTick_Init();
+    DWT_Init();
+    I2C1_DMA_Init();
+
+    // 读寄存器：addr+W、指针、addr+R、2个数据字节
+    bytes = sim::i2c1_bytes();
+    CHECK(I2C1_DMA_ReadReg(0x44, OPT3001_MANUF_ID_REG, &v) == I2C1_DMA_OK);
+    CHECK(v == OPT3001_MANUF_ID);
+    CHECK(sim::i2c1_bytes() - bytes == 5);
+    CHECK(I2C1_DMA_ReadReg(0x45, OPT3001_DEVICE_ID_REG, &v) == I2C1_DMA_OK);
+    CHECK(v == OPT3001_DEVICE_ID);
+    CHECK(sim::irq_count(I2C1_EV_IRQn) > 0);
+    CHECK(sim::irq_count(DMA1_Channel7_IRQn) > 0);
+
+    // 写寄存器：DMA发送指针+2字节，器件收到完整配置
+    CHECK(I2C1_DMA_WriteReg(0x44, OPT3001_CONFIG_REG, OPT3001_CONFIG_FASTBOOT) == I2C1_DMA_OK);
+    CHECK((dev.reg(OPT3001_CONFIG_REG) & 0xFE1F) == OPT3001_CONFIG_FASTBOOT);
+    CHECK(other.reg(OPT3001_CONFIG_REG) == 0xC810);
+
+    // 读当前指针：只有addr+R与数据字节；总线时间不少于3字节×9位@400kHz
+    sim::advance(sim::ms_to_cycles(120));
+    CHECK(I2C1_DMA_ReadReg(0x44, OPT3001_RESULT_REG, &v) == I2C1_DMA_OK);
+    bytes = sim::i2c1_bytes();
+    t0 = sim::now();
+    CHECK(I2C1_DMA_ReadCurrent(0x44, &v) == I2C1_DMA_OK);
+    CHECK(sim::i2c1_bytes() - bytes == 3);
+    CHECK(sim::cycles_to_us(sim::now() - t0) >= 3 * 9 / 0.4);
+    CHECK(dev.pointer() == OPT3001_RESULT_REG);
+    {
+        u32 clux = OPT3001_RawToCentiLux(v);
+        CHECK_MSG(clux > 122000 && clux < 124500, "clux=%u", (unsigned)clux);
+    }
+
+    // 地址无应答：返回NACK，之后的事务不受影响
+    CHECK(I2C1_DMA_Probe(0x46) != 0);
+    CHECK(I2C1_DMA_GetResult() == I2C1_DMA_NACK);
+    CHECK(I2C1_DMA_Probe(0x44) == 0);
+    CHECK(I2C1_DMA_ReadReg(0x46, OPT3001_CONFIG_REG, &v) == I2C1_DMA_NACK);
+    CHECK(I2C1_DMA_ReadReg(0x44, OPT3001_DEVICE_ID_REG, &v) == I2C1_DMA_OK && v == OPT3001_DEVICE_ID);
+
+    // 数据字节无应答
+    dev.nack_next(1);
+    CHECK(I2C1_DMA_WriteReg(0x44, OPT3001_LOW_LIMIT_REG, 0x1234) == I2C1_DMA_NACK);
+    CHECK(dev.reg(OPT3001_LOW_LIMIT_REG) != 0x1234);
+    CHECK(I2C1_DMA_WriteReg(0x44, OPT3001_LOW_LIMIT_REG, 0x1234) == I2C1_DMA_OK);
+    CHECK(dev.reg(OPT3001_LOW_LIMIT_REG) == 0x1234);
+
+    // 异步读：回调在中断上下文中执行一次，结果写入调用者缓冲
+    {
+        Done d = { 0, I2C1_DMA_BUSY };
+        u8 buf[2] = { 0, 0 };
+        CHECK(I2C1_DMA_ReadAsync(0x45, OPT3001_MANUF_ID_REG, buf, 2, on_done, &d) == I2C1_DMA_OK);
+        CHECK(sim::advance_until([&d]() { return d.calls > 0; }, sim::ms_to_cycles(5)) == 0);
+        CHECK(d.calls == 1);
+        CHECK(d.result == I2C1_DMA_OK);
+        CHECK(((buf[0] << 8) | buf[1]) == OPT3001_MANUF_ID);
+        CHECK(!I2C1_DMA_IsBusy());
+    }
+
+    // SDA被从机拉住：线路状态报告SDA低，恢复后总线可用
+    {
+        int owner;
+        sim::set_pull_low(GPIOB, I2C1_DMA_SDA_PIN, true, &owner);
+        CHECK(I2C1_DMA_LineState() & I2C1_DMA_SDA_LOW);
+        CHECK(I2C1_DMA_ReadReg(0x44, OPT3001_CONFIG_REG, &v) != I2C1_DMA_OK);
+        sim::set_pull_low(GPIOB, I2C1_DMA_SDA_PIN, false, &owner);
+        CHECK(I2C1_DMA_Recover() == 0);
+        CHECK(I2C1_DMA_ReadReg(0x44, OPT3001_DEVICE_ID_REG, &v) == I2C1_DMA_OK && v == OPT3001_DEVICE_ID);
+    }
+
+    return sim_test_result("i2c1_dma");
+}
@@ -0,0 +1,56 @@
+// 软件IIC线上时序：在GPIOB引脚上记录SCL/SDA边沿，对照UM10204核对tLOW/tHIGH/建立保持时间，
+// 并检查实际SCL周期不偏离OPT3001_IIC_SPEED太多；同一源码分别按100k/400k编译
+#include "sim_core.h"
+#include "sim_i2c_trace.h"
+#include "sim_opt3001.h"
+#include "sim_test.h"
+
+#include "delay.h"
+#include "opt3001.h"
+
+int main()
+{
+    sim::Opt3001 dev(OPT3001_ADDR);
+    sim::I2cTimingTrace trace(OPT3001_IIC_PORT, OPT3001_IIC_SCL_PIN, OPT3001_IIC_SDA_PIN);
+    OPT3001_HandleTypeDef h = OPT3001_HANDLE_INIT(&OPT3001_DefaultBus, OPT3001_ADDR, 0);
+    const sim::I2cTiming spec = sim::i2c_spec(OPT3001_IIC_SPEED);
+    const double nominal = 1e6 / OPT3001_IIC_SPEED;
+    std::string bad;
+    int i;
+
+    dev.lux = [](double) { return 321.0; };
+    dev.attach_wire(OPT3001_IIC_PORT, OPT3001_IIC_SCL_PIN, OPT3001_IIC_SDA_PIN);
+    SysTick_Init();
+    DWT_Init();
+    OPT3001_Bus_Init(&OPT3001_DefaultBus);
+    trace.reset();
+
+    // 覆盖写寄存器、带重复START的读、只读当前指针、地址无应答
+    CHECK(OPT3001_Sensor_Identify(&h) == 0);
+    CHECK(OPT3001_Sensor_WriteReg(&h, OPT3001_CONFIG_REG, OPT3001_CONFIG_FASTBOOT) == 0);
+    sim::advance(sim::ms_to_cycles(110));
+    for (i = 0; i < 4; i++)
+        CHECK(OPT3001_Sensor_ReadCentiLux(&h) != OPT3001_CLUX_INVALID);
+    CHECK(OPT3001_Bus_Probe(&OPT3001_DefaultBus, 0x46) != 0);
+    CHECK(OPT3001_Bus_Probe(&OPT3001_DefaultBus, OPT3001_ADDR) == 0);
+
+    // 每个事务一对START/STOP（读寄存器另有一次重复START）
+    CHECK(trace.starts() >= trace.stops());
+    CHECK_MSG(trace.stops() >= 8, "stops=%u", (unsigned)trace.stops());
+
+    // 所有参数都有样本且不小于规范最小值
+    CHECK(trace.min().t_low >= 0 && trace.min().t_high >= 0 && trace.min().period >= 0);
+    CHECK(trace.min().hd_sta >= 0 && trace.min().su_sta >= 0 && trace.min().su_sto >= 0);
+    CHECK(trace.min().buf >= 0 && trace.min().su_dat >= 0);
+    bad = trace.violations(spec);
+    CHECK_MSG(bad.empty(), "%s", bad.c_str());
+
+    // 实际速率：平均周期不短于规范，也不超过标称的1.5倍（延时换算或GPIO开销过大）
+    CHECK_MSG(trace.mean_period() >= spec.period && trace.mean_period() <= nominal * 1.5,
+              "mean=%.2fus nominal=%.2fus", trace.mean_period(), nominal);
+
+    std::printf("iic_timing %uHz: tSCL mean %.2fus min %.2fus, tLOW %.2fus, tHIGH %.2fus, tBUF %.2fus\n",
+                (unsigned)OPT3001_IIC_SPEED, trace.mean_period(), trace.min().period,
+                trace.min().t_low, trace.min().t_high, trace.min().buf);
+    return sim_test_result(OPT3001_IIC_SPEED == 400000 ? "iic_timing_400k" : "iic_timing_100k");
+}
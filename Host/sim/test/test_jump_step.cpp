@@ -0,0 +1,134 @@
+// 跳变检测的阶跃响应：按800ms转换回放一段光照序列（50lux，单次2000lux尖峰，
+// 亮屏跳到600lux，再降到30lux）经OPT3001_Sensor_Process，测量从亮度真实变化到输出新值的延迟。
+// 确认次数N取1~4，阶跃时刻落在转换内不同相位：新等级在N次转换内被接受（跨越阶跃的转换最多再加一次），
+// N>=2时单次尖峰被拒绝；对照改造前的500lux绝对阈值，亮屏后输出永远停在旧值
+#include "sim_test.h"
+
+#include "opt3001.h"
+
+#include <cmath>
+
+namespace {
+
+const double kConvMs = 800;
+const int kConversions = 60;
+const int kSpike = 10;                  // 整个转换落在尖峰上
+const double kUp = 20, kDown = 40;
+
+// 光照随时间（以转换周期为单位）的变化，阶跃发生在kUp/kDown次转换开始后phase处
+double level(double pos, double phase)
+{
+    if (pos >= kSpike && pos < kSpike + 1)
+        return 2000;
+    if (pos < kUp + phase)
+        return 50;
+    if (pos < kDown + phase)
+        return 600;
+    return 30;
+}
+
+// 第k次转换的结果（0.01lux）：积分窗口内的平均光照，叠加±1%的确定性噪声
+u32 conversion(int k, double phase)
+{
+    double sum = 0;
+
+    for (int i = 0; i < 100; i++)
+        sum += level(k + (i + 0.5) / 100, phase);
+    return (u32)(sum / 100 * (1.0 + 0.01 * std::sin(k * 1.7)) * 100);
+}
+
+struct Response {
+    double up_ms, down_ms;              // 阶跃到输出进入新值±10%的时间（-1：未到达）
+    bool spike_rejected;
+    bool jump_err_seen;                 // 确认期间上报过JUMP_ERR
+    u8 accepted;                        // 接受时记录的确认次数
+};
+
+bool near(u32 out, double lux)
+{
+    return std::fabs(out / 100.0 - lux) <= lux * 0.1;
+}
+
+// 阶跃时刻（ms）：kUp/kDown次转换开始后phase个转换周期；转换k在(k+1)*800ms完成
+Response replay(double phase)
+{
+    OPT3001_HandleTypeDef h = OPT3001_HANDLE_INIT(&OPT3001_DefaultBus, OPT3001_ADDR, 0);
+    Response r = { -1, -1, true, false, 0 };
+    u32 out;
+
+    for (int k = 0; k < kConversions; k++) {
+        double done_ms = (k + 1) * kConvMs;
+
+        OPT3001_Sensor_Process(&h, conversion(k, phase), &out);
+        if (h.status == OPT3001_STATUS_JUMP_ERR)
+            r.jump_err_seen = true;
+        if (h.filter.jump.accepted)
+            r.accepted = h.filter.jump.accepted;
+        if ((k == kSpike || k == kSpike + 1) && !near(out, 50))
+            r.spike_rejected = false;
+        if (k >= kUp && k < kDown && r.up_ms < 0 && near(out, 600))
+            r.up_ms = done_ms - (kUp + phase) * kConvMs;
+        if (k >= kDown && r.down_ms < 0 && near(out, 30))
+            r.down_ms = done_ms - (kDown + phase) * kConvMs;
+    }
+    return r;
+}
+
+// 改造前：与上次有效值相差超过500lux即判为跳变并沿用上次有效值，上次有效值不再更新
+bool old_detector_reaches_600()
+{
+    u32 last = 0;
+
+    for (int k = 0; k < kDown; k++) {
+        u32 raw = conversion(k, 0);
+        if (last != 0 && (raw > last + 50000 || raw + 50000 < last))
+            continue;
+        last = raw;
+        if (k >= kUp && near(last, 600))
+            return true;
+    }
+    return false;
+}
+
+}
+
+int main()
+{
+    const double phases[] = { 0.0, 0.25, 0.5, 0.9 };
+    Filter_ParamsTypeDef params, saved;
+
+    FilterChain_GetParams(&saved);
+    std::printf("  N  阶跃相位  上跳延迟(ms)  下跳延迟(ms)  尖峰\n");
+    for (u8 n = 1; n <= 4; n++) {
+        params = saved;
+        params.jump_confirm = n;
+        CHECK(FilterChain_SetParams(&params) == 0);
+        for (double phase : phases) {
+            Response r = replay(phase);
+            double bound;
+
+            std::printf("  %u  %8.2f  %12.0f  %12.0f  %s\n", n, phase, r.up_ms, r.down_ms,
+                        r.spike_rejected ? "拒绝" : "通过");
+            // 阶跃落在转换边界：第N次完整的新等级转换完成时接受；
+            // 落在转换中间：跨越阶跃的转换可能自成候选，最多再晚一次转换。
+            // N=1不做确认，跨越阶跃的混合值被直接接受，之后由中值窗口逐步过渡到新值
+            if (phase == 0.0) {
+                CHECK_MSG(r.up_ms == n * kConvMs && r.down_ms == n * kConvMs,
+                          "N=%u: up %.0f down %.0f", n, r.up_ms, r.down_ms);
+                CHECK(r.accepted == n);
+            }
+            bound = (n >= 2 ? n + 1 : 1 + MEDIAN_WINDOW_SIZE) * kConvMs;
+            CHECK_MSG(r.up_ms > 0 && r.up_ms <= bound, "N=%u phase %.2f: up %.0f", n, phase, r.up_ms);
+            CHECK_MSG(r.down_ms > 0 && r.down_ms <= bound, "N=%u phase %.2f: down %.0f", n, phase, r.down_ms);
+            CHECK(r.spike_rejected == (n >= 2));
+            CHECK(r.jump_err_seen == (n >= 2));
+        }
+    }
+    CHECK(FilterChain_SetParams(&saved) == 0);
+
+    // 改造前：亮屏后每个样本都被判为跳变，输出永远停在旧值
+    CHECK(!old_detector_reaches_600());
+    std::printf("  改造前（500lux绝对阈值）：亮屏后输出停在50lux，不接受新等级\n");
+
+    return sim_test_result("jump_step");
+}
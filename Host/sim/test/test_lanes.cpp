@@ -0,0 +1,231 @@
+// 多通道锁步软件IIC：PA8为共用SCL，PA0~PA7各接一个地址同为0x44的虚拟OPT3001，
+// 每个通道的I2C前端逐位解码本通道的线上内容。核对各通道的位流与读写结果：
+// 8个通道数据各不相同、某通道不在线、某通道拒收指针字节、某通道数据全0/全1、某通道SDA对地短路、
+// 各通道写入不同数据、只选部分通道的探测与初始化。退出的通道此后SDA保持释放、没有重复START，
+// 其余通道不受影响；8通道并行读的SCL脉冲、字节、START与耗时和单通道读、单传感器驱动读一次相同，时序满足I2C规范
+#include "sim_core.h"
+#include "sim_i2c_trace.h"
+#include "sim_opt3001.h"
+#include "sim_test.h"
+
+#include "delay.h"
+#include "opt3001.h"
+#include "opt3001_lanes.h"
+
+#include <memory>
+#include <string>
+
+namespace {
+
+const int kLanes = 8;
+
+OPT3001_LaneBusTypeDef g_bus;
+sim::Opt3001 *g_dev[kLanes];
+
+// 各通道恢复到上电状态，结果寄存器各不相同，清空线上记录
+void reset_lanes()
+{
+    for (int i = 0; i < kLanes; i++) {
+        g_dev[i]->short_sda(false);
+        g_dev[i]->present = true;
+        g_dev[i]->nack_next(0);
+        g_dev[i]->power_on_reset();
+        g_dev[i]->set_reg(OPT3001_RESULT_REG, (uint16_t)(0x1000 + i * 0x111));
+        g_dev[i]->wire()->trace.clear();
+    }
+}
+
+const std::string &stream(int i)
+{
+    return g_dev[i]->wire()->trace;
+}
+
+// 未选中的通道只看到共用SCL上的时钟，没有START/STOP
+bool untouched(int i)
+{
+    return stream(i).find('S') == std::string::npos && stream(i).find('P') == std::string::npos;
+}
+
+std::string read_stream(u8 reg, u16 data)
+{
+    char buf[64];
+
+    std::snprintf(buf, sizeof buf, "S 88A %02XA S 89A %02XA %02XN P ", reg, data >> 8, data & 0xFF);
+    return buf;
+}
+
+void dump(const char *title)
+{
+    std::printf("  %s\n", title);
+    for (int i = 0; i < kLanes; i++)
+        std::printf("    通道%d：%s\n", i, stream(i).c_str());
+}
+
+}
+
+int main()
+{
+    std::unique_ptr<sim::Opt3001> dev[kLanes];
+    sim::Opt3001 single(OPT3001_ADDR);
+    OPT3001_HandleTypeDef h = OPT3001_HANDLE_INIT(&OPT3001_DefaultBus, OPT3001_ADDR, 0);
+    u16 data[kLanes], w[kLanes];
+    OPT3001_IIC_StatsTypeDef all, one, drv;
+    double all_us, one_us, serial_us, drv_us;
+    uint64_t t0;
+    u8 ok;
+    int i;
+
+    g_bus = OPT3001_DefaultLanes;
+    g_bus.count = kLanes;
+    for (i = 0; i < kLanes; i++) {
+        dev[i].reset(new sim::Opt3001(OPT3001_ADDR));
+        g_dev[i] = dev[i].get();
+        g_dev[i]->attach_wire(g_bus.port, g_bus.scl_pin, g_bus.sda_pin[i]).trace_enabled = true;
+    }
+    sim::I2cTimingTrace timing0(g_bus.port, g_bus.scl_pin, g_bus.sda_pin[0]);
+    sim::I2cTimingTrace timing7(g_bus.port, g_bus.scl_pin, g_bus.sda_pin[7]);
+    single.attach_wire(OPT3001_IIC_PORT, OPT3001_IIC_SCL_PIN, OPT3001_IIC_SDA_PIN);
+    SysTick_Init();
+    DWT_Init();
+    OPT3001_Bus_Init(&OPT3001_DefaultBus);
+    OPT3001_Lanes_Init(&g_bus);
+    // 引脚初始化时ODR的上电值会短暂拉低各线，不计入时序
+    timing0.reset();
+    timing7.reset();
+
+    // 8个通道同时读结果寄存器，各自得到自己的数据
+    reset_lanes();
+    OPT3001_Lanes_ResetStats();
+    t0 = sim::now();
+    ok = OPT3001_Lanes_ReadReg(&g_bus, OPT3001_ADDR, OPT3001_RESULT_REG, 0xFF, data);
+    all_us = sim::cycles_to_us(sim::now() - t0);
+    OPT3001_Lanes_GetStats(&all);
+    CHECK(ok == 0xFF);
+    for (i = 0; i < kLanes; i++) {
+        CHECK(data[i] == g_dev[i]->reg(OPT3001_RESULT_REG));
+        CHECK_MSG(stream(i) == read_stream(OPT3001_RESULT_REG, data[i]), "lane %d: %s", i, stream(i).c_str());
+    }
+
+    // 只读通道0：总线开销与8通道相同，也与单传感器驱动读一次相同；逐个读8次的耗时是并行读的8倍
+    reset_lanes();
+    OPT3001_Lanes_ResetStats();
+    t0 = sim::now();
+    ok = OPT3001_Lanes_ReadReg(&g_bus, OPT3001_ADDR, OPT3001_RESULT_REG, 0x01, data);
+    one_us = sim::cycles_to_us(sim::now() - t0);
+    OPT3001_Lanes_GetStats(&one);
+    CHECK(ok == 0x01 && data[0] == g_dev[0]->reg(OPT3001_RESULT_REG));
+    for (i = 1; i < kLanes; i++)
+        CHECK_MSG(untouched(i), "unselected lane %d: %s", i, stream(i).c_str());
+    t0 = sim::now();
+    for (i = 0; i < kLanes; i++)
+        OPT3001_Lanes_ReadReg(&g_bus, OPT3001_ADDR, OPT3001_RESULT_REG, (u8)(1 << i), data);
+    serial_us = sim::cycles_to_us(sim::now() - t0);
+    OPT3001_IIC_ResetStats();
+    t0 = sim::now();
+    CHECK(OPT3001_Sensor_ReadReg(&h, OPT3001_RESULT_REG) == single.reg(OPT3001_RESULT_REG));
+    drv_us = sim::cycles_to_us(sim::now() - t0);
+    OPT3001_IIC_GetStats(&drv);
+    std::printf("  读结果寄存器（SCL脉冲/字节/START）：8通道并行 %.0f us（%u/%u/%u），单通道 %.0f us（%u/%u/%u），\n"
+                "  单传感器驱动 %.0f us（%u/%u/%u），逐个读8个通道 %.0f us\n",
+                all_us, (unsigned)all.scl_pulses, (unsigned)all.bytes, (unsigned)all.starts, one_us,
+                (unsigned)one.scl_pulses, (unsigned)one.bytes, (unsigned)one.starts, drv_us,
+                (unsigned)drv.scl_pulses, (unsigned)drv.bytes, (unsigned)drv.starts, serial_us);
+    CHECK(all.scl_pulses == one.scl_pulses && all.bytes == one.bytes && all.starts == one.starts);
+    CHECK(all.scl_pulses == drv.scl_pulses && all.bytes == drv.bytes && all.starts == drv.starts);
+    CHECK(all_us <= one_us * 1.05 && all_us <= drv_us * 1.1 && serial_us >= all_us * 7.5);
+
+    // 通道3不在线：地址无应答后退出，SDA保持释放（此后每个字节都读作FF+N），没有重复START，STOP照发
+    reset_lanes();
+    g_dev[3]->present = false;
+    ok = OPT3001_Lanes_ReadReg(&g_bus, OPT3001_ADDR, OPT3001_RESULT_REG, 0xFF, data);
+    dump("通道3不在线");
+    CHECK(ok == 0xF7 && data[3] == 0xFFFF);
+    CHECK_MSG(stream(3) == "S 88N FFN FFN FFN FFN P ", "lane 3: %s", stream(3).c_str());
+    for (i = 0; i < kLanes; i++)
+        if (i != 3)
+            CHECK(data[i] == g_dev[i]->reg(OPT3001_RESULT_REG) &&
+                  stream(i) == read_stream(OPT3001_RESULT_REG, data[i]));
+
+    // 通道5拒收指针字节、通道6数据全0、通道7数据全1：通道5指针不变，其余通道照常
+    reset_lanes();
+    g_dev[5]->nack_next(1, 1);
+    g_dev[6]->set_reg(OPT3001_RESULT_REG, 0x0000);
+    g_dev[7]->set_reg(OPT3001_RESULT_REG, 0xFFFF);
+    ok = OPT3001_Lanes_ReadReg(&g_bus, OPT3001_ADDR, OPT3001_CONFIG_REG, 0xFF, data);
+    CHECK(ok == 0xDF && data[5] == 0xFFFF && g_dev[5]->pointer() == OPT3001_RESULT_REG);
+    CHECK_MSG(stream(5) == "S 88A 01N FFN FFN FFN P ", "lane 5: %s", stream(5).c_str());
+    ok = OPT3001_Lanes_ReadReg(&g_bus, OPT3001_ADDR, OPT3001_RESULT_REG, 0xC0, data);
+    CHECK(ok == 0xC0 && data[6] == 0x0000 && data[7] == 0xFFFF);
+    CHECK(stream(6) == read_stream(OPT3001_CONFIG_REG, 0xC810) + read_stream(OPT3001_RESULT_REG, 0x0000));
+    CHECK(stream(7) == read_stream(OPT3001_CONFIG_REG, 0xC810) + read_stream(OPT3001_RESULT_REG, 0xFFFF));
+
+    // 通道1的SDA对地短路：START时即剔除，其余通道读数正确，时序不受影响
+    reset_lanes();
+    g_dev[1]->short_sda(true);
+    ok = OPT3001_Lanes_ReadReg(&g_bus, OPT3001_ADDR, OPT3001_RESULT_REG, 0xFF, data);
+    CHECK(ok == 0xFD && data[1] == 0xFFFF);
+    for (i = 0; i < kLanes; i++)
+        if (i != 1)
+            CHECK(data[i] == g_dev[i]->reg(OPT3001_RESULT_REG) &&
+                  stream(i) == read_stream(OPT3001_RESULT_REG, data[i]));
+    g_dev[1]->short_sda(false);
+
+    // 各通道写入不同的上限，通道2不在线、通道4拒收第二个数据字节
+    reset_lanes();
+    g_dev[2]->present = false;
+    g_dev[4]->nack_next(1, 3);
+    for (i = 0; i < kLanes; i++)
+        w[i] = (u16)((0x0100 * i + 0x5A) ^ (i * 0x1357));
+    ok = OPT3001_Lanes_WriteReg(&g_bus, OPT3001_ADDR, OPT3001_HIGH_LIMIT_REG, 0xFF, w);
+    dump("各通道写入不同数据（通道2不在线，通道4拒收低字节）");
+    CHECK(ok == 0xEB);
+    for (i = 0; i < kLanes; i++) {
+        char expect[48];
+
+        if (i == 2 || i == 4) {
+            CHECK(g_dev[i]->reg(OPT3001_HIGH_LIMIT_REG) == 0xBFFF);
+            continue;
+        }
+        std::snprintf(expect, sizeof expect, "S 88A 03A %02XA %02XA P ", w[i] >> 8, w[i] & 0xFF);
+        CHECK(g_dev[i]->reg(OPT3001_HIGH_LIMIT_REG) == w[i]);
+        CHECK_MSG(stream(i) == expect, "lane %d: %s", i, stream(i).c_str());
+    }
+    CHECK_MSG(stream(2) == "S 88N FFN FFN FFN P ", "lane 2: %s", stream(2).c_str());
+    {
+        char expect[48];
+
+        std::snprintf(expect, sizeof expect, "S 88A 03A %02XA %02XN P ", w[4] >> 8, w[4] & 0xFF);
+        CHECK_MSG(stream(4) == expect, "lane 4: %s", stream(4).c_str());
+    }
+
+    // 只选通道0~3：探测只应答地址相符的通道，未选中的通道线上没有任何START/STOP
+    reset_lanes();
+    g_dev[0]->present = false;
+    ok = OPT3001_Lanes_Probe(&g_bus, OPT3001_ADDR, 0x0F);
+    CHECK(ok == 0x0E);
+    for (i = 4; i < kLanes; i++)
+        CHECK_MSG(untouched(i), "unselected lane %d: %s", i, stream(i).c_str());
+    g_dev[0]->present = true;
+    ok = OPT3001_Lanes_SensorInit(&g_bus, OPT3001_ADDR, 0x0F);
+    CHECK(ok == 0x0F);
+    for (i = 0; i < kLanes; i++) {
+        if (i < 4)
+            CHECK(g_dev[i]->reg(OPT3001_CONFIG_REG) == OPT3001_CONFIG_DEFAULT &&
+                  g_dev[i]->reg(OPT3001_LOW_LIMIT_REG) == OPT3001_LOW_LIMIT_EOC);
+        else
+            CHECK_MSG(untouched(i) && g_dev[i]->reg(OPT3001_CONFIG_REG) == 0xC810, "unselected lane %d: %s", i,
+                      stream(i).c_str());
+    }
+
+    // 两端通道上的时序都满足规范
+    {
+        std::string v0 = timing0.violations(sim::i2c_spec(OPT3001_IIC_SPEED));
+        std::string v7 = timing7.violations(sim::i2c_spec(OPT3001_IIC_SPEED));
+
+        CHECK_MSG(v0.empty(), "lane 0: %s", v0.c_str());
+        CHECK_MSG(v7.empty(), "lane 7: %s", v7.c_str());
+        std::printf("  SCL平均周期 %.2f us（%u Hz）\n", timing0.mean_period(), (unsigned)OPT3001_IIC_SPEED);
+    }
+
+    return sim_test_result("lanes");
+}
@@ -0,0 +1,130 @@
+// 流式中值滤波：在MEDIAN_WINDOW_MAX=63的构建上，窗口3~63逐一与原OPT3001_SlidingMedianFilter的
+// 复制+冒泡排序比较：每个样本的输出一致（含重复值与尖峰），并报告每样本主机耗时随窗口的变化。
+// 主机耗时只作相对比较（两者同一编译选项），冒泡O(n^2)与流式O(log n)比较+O(n)搬移的差距随窗口拉大
+#include "sim_test.h"
+
+#include "median_filter.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <vector>
+
+namespace {
+
+const int kSamples = 20000;
+const int kRepeats = 3;
+
+// 改造前的实现（窗口大小改为参数，浮点改为u32）：每个样本复制整个窗口后冒泡排序
+u32 g_window[MEDIAN_WINDOW_MAX];
+u8 g_index;
+
+u32 bubble_median(u32 new_val, u8 size)
+{
+    u32 temp[MEDIAN_WINDOW_MAX];
+    u8 i, j;
+
+    g_window[g_index] = new_val;
+    g_index = (g_index + 1) % size;
+    for (i = 0; i < size; i++)
+        temp[i] = g_window[i];
+    for (i = 0; i < size - 1; i++) {
+        for (j = 0; j < size - 1 - i; j++) {
+            if (temp[j] > temp[j + 1]) {
+                u32 t = temp[j];
+                temp[j] = temp[j + 1];
+                temp[j + 1] = t;
+            }
+        }
+    }
+    return temp[size / 2];
+}
+
+// 30000±1000（0.01lux）的噪声，夹杂重复值与10倍尖峰
+std::vector<u32> make_input()
+{
+    std::vector<u32> v(kSamples);
+
+    std::srand(12345);
+    for (int i = 0; i < kSamples; i++) {
+        v[i] = 29000 + std::rand() % 2000;
+        if (i % 17 == 0)
+            v[i] = 30000;
+        if (i % 97 == 0)
+            v[i] *= 10;
+    }
+    return v;
+}
+
+double ns_per_sample(std::chrono::steady_clock::duration d)
+{
+    return (double)std::chrono::duration_cast<std::chrono::nanoseconds>(d).count() / kSamples;
+}
+
+}
+
+int main()
+{
+    const u8 sizes[] = { 3, 7, 15, 31, 63 };
+    std::vector<u32> input = make_input();
+    std::vector<u32> expect(kSamples);
+    double bubble_ns[sizeof sizes], stream_ns[sizeof sizes];
+    volatile u32 sink = 0;
+
+    std::printf("  窗口  冒泡(ns/样本)  流式(ns/样本)  加速比\n");
+    for (size_t k = 0; k < sizeof sizes; k++) {
+        u8 n = sizes[k];
+        int mismatches = 0;
+
+        CHECK(Median_SetWindow(n) == 0);
+        bubble_ns[k] = stream_ns[k] = 1e30;
+        for (int r = 0; r < kRepeats; r++) {
+            Median_TypeDef m = MEDIAN_INIT;
+            std::chrono::steady_clock::time_point t;
+
+            // 冒泡参照从预填满的窗口开始，只比较窗口填满之后的输出
+            for (int i = 0; i < n; i++)
+                g_window[i] = input[i];
+            g_index = 0;
+            t = std::chrono::steady_clock::now();
+            for (int i = 0; i < kSamples; i++)
+                expect[i] = bubble_median(input[i], n);
+            bubble_ns[k] = std::min(bubble_ns[k], ns_per_sample(std::chrono::steady_clock::now() - t));
+
+            Median_Init(&m);
+            for (int i = 0; i < n; i++)
+                Median_Update(&m, input[i]);
+            t = std::chrono::steady_clock::now();
+            for (int i = 0; i < kSamples; i++) {
+                u32 out = Median_Update(&m, input[i]);
+                if (r == 0 && out != expect[i])
+                    mismatches++;
+                sink = sink + out;
+            }
+            stream_ns[k] = std::min(stream_ns[k], ns_per_sample(std::chrono::steady_clock::now() - t));
+        }
+        CHECK_MSG(mismatches == 0, "window %u: %d mismatches", n, mismatches);
+        std::printf("  %4u  %13.1f  %13.1f  %6.1fx\n", n, bubble_ns[k], stream_ns[k], bubble_ns[k] / stream_ns[k]);
+    }
+    (void)sink;
+
+    // 窗口未满：取已有样本的中值
+    {
+        Median_TypeDef m = MEDIAN_INIT;
+
+        CHECK(Median_SetWindow(63) == 0);
+        Median_Init(&m);
+        CHECK(Median_Update(&m, 500) == 500);
+        CHECK(Median_Update(&m, 100) == 100);
+        CHECK(Median_Update(&m, 300) == 300);
+    }
+    // 编译上限之外的窗口被拒绝
+    CHECK(Median_SetWindow(65) != 0 && Median_SetWindow(16) != 0 && Median_GetWindow() == 63);
+
+    // 窗口达到15以上时流式明显快于冒泡，且差距随窗口增大
+    CHECK_MSG(stream_ns[2] < bubble_ns[2], "15: %.1f vs %.1f", stream_ns[2], bubble_ns[2]);
+    CHECK_MSG(stream_ns[4] * 5 < bubble_ns[4], "63: %.1f vs %.1f", stream_ns[4], bubble_ns[4]);
+    CHECK(bubble_ns[4] / stream_ns[4] > bubble_ns[2] / stream_ns[2]);
+
+    return sim_test_result("median");
+}
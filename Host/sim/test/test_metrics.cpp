@@ -0,0 +1,235 @@
+// 驱动计数器与耗时直方图：METRICS_BUCKET在0、1、各2^k边界、2^22-1、2^22与2^23以上的分桶；
+// 虚拟OPT3001按字节注入NACK，软件IIC读写的四个阶段（地址+写、寄存器地址、写数据、地址+读）
+// 各自对应的计数器每次注入恰好加1、其余计数器不变；
+// 整机固件运行中注入NACK后经串口发metrics命令，解析"M c"/"M h"行：NACK阶段计数合计的增量等于注入次数，
+// 直方图只列非零桶、桶号在范围内且IIC事务直方图非空
+#include "sim_core.h"
+#include "sim_opt3001.h"
+#include "sim_test.h"
+
+#include "delay.h"
+#include "metrics.h"
+#include "opt3001.h"
+
+#include <cstdlib>
+#include <map>
+#include <sstream>
+#include <string>
+
+int firmware_main(void);
+
+namespace {
+
+void check_buckets()
+{
+    const u32 last = METRICS_BUCKETS - 1;
+    u32 k;
+
+    CHECK(METRICS_BUCKET(0UL) == 0);
+    CHECK(METRICS_BUCKET(1UL) == 1);
+    // 第k桶为[2^(k-1), 2^k)
+    for (k = 1; k < last; k++) {
+        CHECK_MSG(METRICS_BUCKET(1UL << (k - 1)) == k, "2^%u", (unsigned)(k - 1));
+        CHECK_MSG(METRICS_BUCKET((1UL << k) - 1) == k, "2^%u-1", (unsigned)k);
+    }
+    CHECK(METRICS_BUCKET((1UL << 22) - 1) == 22);
+    // 最后一桶从2^22起收纳更大的值
+    CHECK(METRICS_BUCKET(1UL << 22) == last);
+    CHECK(METRICS_BUCKET(1UL << 23) == last);
+    CHECK(METRICS_BUCKET((1UL << 23) + 12345) == last);
+    CHECK(METRICS_BUCKET(0xFFFFFFFFUL) == last);
+}
+
+struct Counters {
+    u32 v[METRIC_COUNTERS];
+};
+
+Counters snapshot()
+{
+    Counters c;
+
+    for (int i = 0; i < METRIC_COUNTERS; i++)
+        c.v[i] = Metrics_Registry.counter[i];
+    return c;
+}
+
+// 相对before，id恰好增加n，其余计数器不变
+void check_delta(const Counters &before, int id, u32 n, const char *what)
+{
+    for (int i = 0; i < METRIC_COUNTERS; i++) {
+        u32 d = Metrics_Registry.counter[i] - before.v[i];
+
+        CHECK_MSG(d == (i == id ? n : 0), "%s：%s 增加 %u", what, Metrics_CounterName((Metrics_CounterTypeDef)i),
+                  (unsigned)d);
+    }
+}
+
+const int kRepeats = 3;
+
+// 同步读写：每种注入重复kRepeats次，之间用一次成功的读把总线与指针缓存恢复到已知状态
+void check_phases(sim::Opt3001 &dev)
+{
+    OPT3001_HandleTypeDef h;
+    Counters before;
+    int i;
+
+    CHECK(sim_sensor_init(&h, &dev, &OPT3001_DefaultBus, OPT3001_ADDR, 0) == 0);
+
+    const struct {
+        const char *what;
+        unsigned skip;              // 注入前正常应答的字节数
+        bool write;
+        bool cached;                // 读：先把指针指向结果寄存器，只发addr+R
+        int id;
+    } cases[] = {
+        { "写：地址+写", 0, true, false, METRIC_NACK_ADDR_W },
+        { "写：寄存器地址", 1, true, false, METRIC_NACK_REG },
+        { "写：数据高字节", 2, true, false, METRIC_NACK_DATA },
+        { "写：数据低字节", 3, true, false, METRIC_NACK_DATA },
+        { "读：地址+写", 0, false, false, METRIC_NACK_ADDR_W },
+        { "读：寄存器地址", 1, false, false, METRIC_NACK_REG },
+        { "读：地址+读", 2, false, false, METRIC_NACK_ADDR_R },
+        { "读（指针缓存）：地址+读", 0, false, true, METRIC_NACK_ADDR_R },
+    };
+
+    std::printf("  注入阶段                  计数器     增量\n");
+    for (const auto &c : cases) {
+        before = snapshot();
+        for (i = 0; i < kRepeats; i++) {
+            if (c.cached)
+                CHECK(OPT3001_Sensor_ReadReg(&h, OPT3001_RESULT_REG) != 0xFFFF);
+            else
+                h.reg_ptr = OPT3001_PTR_UNKNOWN;
+            dev.nack_next(1, c.skip);
+            if (c.write)
+                CHECK(OPT3001_Sensor_WriteReg(&h, OPT3001_LOW_LIMIT_REG, 0x1234) == 1);
+            else
+                CHECK(OPT3001_Sensor_ReadReg(&h, OPT3001_RESULT_REG) == 0xFFFF);
+            // 注入已用完：下一次读写正常完成
+            CHECK(OPT3001_Sensor_ReadReg(&h, OPT3001_MANUF_ID_REG) == 0x5449);
+        }
+        check_delta(before, c.id, kRepeats, c.what);
+        std::printf("  %-24s  %-9s  %u\n", c.what, Metrics_CounterName((Metrics_CounterTypeDef)c.id),
+                    (unsigned)(Metrics_Registry.counter[c.id] - before.v[c.id]));
+    }
+}
+
+/********************* metrics命令输出解析 *********************/
+struct Dump {
+    std::map<std::string, unsigned long> counter;
+    std::map<std::string, std::map<int, unsigned long>> hist;
+    int lines = 0;
+};
+
+// 取输出中最后一次metrics命令的"M c"行及其后的"M h"行
+Dump parse(const std::string &out)
+{
+    Dump d;
+    size_t pos = out.rfind("M c");
+    std::istringstream in(pos == std::string::npos ? std::string() : out.substr(pos));
+    std::string line, tok, name;
+
+    while (std::getline(in, line)) {
+        if (!line.empty() && line.back() == '\r')
+            line.pop_back();
+        if (line.compare(0, 2, "M ") != 0)
+            break;
+        std::istringstream ls(line.substr(2));
+        ls >> tok;
+        d.lines++;
+        if (tok == "c") {
+            while (ls >> tok) {
+                size_t eq = tok.find('=');
+                CHECK_MSG(eq != std::string::npos, "%s", tok.c_str());
+                if (eq != std::string::npos)
+                    d.counter[tok.substr(0, eq)] = std::strtoul(tok.c_str() + eq + 1, 0, 10);
+            }
+        } else if (tok == "h") {
+            ls >> name;
+            d.hist[name];
+            while (ls >> tok) {
+                size_t colon = tok.find(':');
+                CHECK_MSG(colon != std::string::npos, "%s", tok.c_str());
+                if (colon != std::string::npos)
+                    d.hist[name][std::atoi(tok.c_str())] = std::strtoul(tok.c_str() + colon + 1, 0, 10);
+            }
+        }
+    }
+    return d;
+}
+
+Dump metrics_command()
+{
+    sim::uart_clear_output();
+    sim::uart_inject("metrics\r\n");
+    // 9600bps下导出约300字节，留足发送时间
+    sim::run_firmware(firmware_main, sim::ms_to_cycles(1000));
+    return parse(sim::uart_output());
+}
+
+unsigned long nack_phases(Dump &d)
+{
+    return d.counter["nack_aw"] + d.counter["nack_reg"] + d.counter["nack_data"] + d.counter["nack_ar"];
+}
+
+void check_command(sim::Opt3001 &dev)
+{
+    Dump before, after;
+    int i;
+
+    sim::run_firmware(firmware_main, sim::ms_to_cycles(3000));
+    before = metrics_command();
+
+    // 每条计数器一项，名称与登记表一致；每个直方图一行
+    CHECK_MSG(before.counter.size() == METRIC_COUNTERS, "%u counters", (unsigned)before.counter.size());
+    for (i = 0; i < METRIC_COUNTERS; i++)
+        CHECK_MSG(before.counter.count(Metrics_CounterName((Metrics_CounterTypeDef)i)) == 1, "%s",
+                  Metrics_CounterName((Metrics_CounterTypeDef)i));
+    CHECK(before.lines == 1 + METRIC_HISTS);
+    for (i = 0; i < METRIC_HISTS; i++)
+        CHECK_MSG(before.hist.count(Metrics_HistName((Metrics_HistTypeDef)i)) == 1, "%s",
+                  Metrics_HistName((Metrics_HistTypeDef)i));
+    for (auto &h : before.hist) {
+        for (auto &b : h.second)
+            CHECK_MSG(b.first >= 0 && b.first < METRICS_BUCKETS && b.second > 0, "%s %d:%lu", h.first.c_str(),
+                      b.first, b.second);
+    }
+    CHECK(!before.hist["i2c"].empty());
+
+    // 运行中每隔2s注入一个NACK（落在哪个阶段取决于当时的事务），重试成功后再导出
+    for (i = 0; i < kRepeats; i++) {
+        dev.nack_next(1);
+        sim::run_firmware(firmware_main, sim::ms_to_cycles(2000));
+    }
+    after = metrics_command();
+    // 导出值与登记表一致（导出之后没有新的NACK）
+    for (i = METRIC_NACK_ADDR_W; i <= METRIC_NACK_ADDR_R; i++)
+        CHECK(after.counter[Metrics_CounterName((Metrics_CounterTypeDef)i)] == Metrics_Registry.counter[i]);
+    std::printf("  metrics命令：NACK阶段计数 %lu -> %lu，重试 %lu -> %lu\n", nack_phases(before), nack_phases(after),
+                before.counter["retry"], after.counter["retry"]);
+    CHECK_MSG(nack_phases(after) - nack_phases(before) == (unsigned long)kRepeats, "%lu -> %lu",
+              nack_phases(before), nack_phases(after));
+    CHECK(after.counter["retry"] > before.counter["retry"]);
+}
+
+}
+
+int main()
+{
+    sim::Opt3001 dev(OPT3001_ADDR);
+
+    dev.lux = [](double) { return 420.0; };
+    dev.attach_wire(OPT3001_IIC_PORT, OPT3001_IIC_SCL_PIN, OPT3001_IIC_SDA_PIN);
+    dev.attach_int(OPT3001_INT_PORT, OPT3001_INT_PIN);
+
+    check_buckets();
+
+    SysTick_Init();
+    DWT_Init();
+    OPT3001_Bus_Init(&OPT3001_DefaultBus);
+    check_phases(dev);
+
+    check_command(dev);
+
+    return sim_test_result("metrics");
+}
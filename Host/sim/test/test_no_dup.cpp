@@ -0,0 +1,194 @@
+// 转换完成驱动的采集：两个虚拟OPT3001（800ms转换，INT线与到PB5），光照缓慢上升使每次转换的
+// 结果各不相同，把每个样本对回产生它的那次转换：同一次转换不得出现两次（零重复），
+// 时间戳落在转换完成之后；对照改造前每100ms读一次结果寄存器的重复比例。
+// 同一源文件分别按INT触发（opt3001_fw）与查询CRF（OPT3001_INT_ENABLE=0）构建
+#include "sim_core.h"
+#include "sim_opt3001.h"
+#include "sim_test.h"
+
+#include "delay.h"
+#include "opt3001.h"
+#include "opt3001_adapt.h"
+#include "opt3001_health.h"
+#include "opt3001_sched.h"
+
+#include <memory>
+#include <vector>
+
+namespace {
+
+const int kRunMs = 8000;
+const int kSensors = 2;
+// 主循环兜底查询间隔，与main.c的CYCLE_INTERVAL_MS一致
+#if OPT3001_INT_ENABLE
+const int kCycleMs = 1000;
+const double kStampTolUs = 5000;        // 线与INT补发事件时以本轮结束时刻打戳
+#else
+const int kCycleMs = 100;
+const double kStampTolUs = kCycleMs * 1000 + 5000;
+#endif
+
+struct Conversion {
+    double end_us;                      // 仿真时钟上的转换完成时刻
+    uint16_t raw;
+};
+
+struct Sample {
+    uint16_t raw;
+    double stamp_us;                    // 固件时间戳换算到仿真时钟
+};
+
+sim::Opt3001 *g_dev[kSensors];
+std::vector<Conversion> g_conv[kSensors];
+std::vector<Sample> g_samples[kSensors];
+uint64_t g_last_end[kSensors];
+
+void on_sample(OPT3001_HandleTypeDef *h, u16 raw, u32 clux, u32 stamp_us)
+{
+    Sample s;
+
+    (void)clux;
+    if (raw == 0)
+        return;
+    s.raw = raw;
+    s.stamp_us = stamp_us + (sim::now_us() - micros());
+    g_samples[h->id].push_back(s);
+}
+
+// 转换结束后器件排定下一次的结束时刻：结束时刻变化即完成了一次，记下当时的结果寄存器
+void track_conversions(uint64_t until)
+{
+    for (int i = 0; i < kSensors; i++) {
+        uint64_t end = g_dev[i]->conversion_end();
+
+        if (end != g_last_end[i]) {
+            if (g_last_end[i] != UINT64_MAX && g_last_end[i] < until) {
+                Conversion c = { sim::cycles_to_us(g_last_end[i]), g_dev[i]->reg(OPT3001_RESULT_REG) };
+                g_conv[i].push_back(c);
+            }
+            g_last_end[i] = end;
+        }
+    }
+}
+
+// 样本对应的转换序号（结果值唯一），找不到返回-1
+int match(int i, uint16_t raw)
+{
+    for (size_t k = 0; k < g_conv[i].size(); k++)
+        if (g_conv[i][k].raw == raw)
+            return (int)k;
+    return -1;
+}
+
+}
+
+int main()
+{
+    std::unique_ptr<sim::Opt3001> dev[kSensors];
+    OPT3001_HandleTypeDef h[kSensors];
+    OPT3001_AdaptStatsTypeDef as;
+    uint64_t run_end, end, next_cycle;
+    int i, old_reads = 0, old_dups = 0;
+
+    for (i = 0; i < kSensors; i++) {
+        dev[i].reset(new sim::Opt3001((uint8_t)(OPT3001_ADDR_MIN + i)));
+        g_dev[i] = dev[i].get();
+        g_dev[i]->lux = [i](double t) { return 300.0 + 100.0 * i + 2.0 * t; };
+        g_dev[i]->conv_scale = 1.0 + 0.03 * i;      // 两个器件的转换相位逐渐错开
+        g_dev[i]->attach_wire(OPT3001_IIC_PORT, OPT3001_IIC_SCL_PIN, OPT3001_IIC_SDA_PIN);
+        g_dev[i]->attach_int(OPT3001_INT_PORT, OPT3001_INT_PIN);
+    }
+    SysTick_Init();
+    DWT_Init();
+    OPT3001_Bus_Init(&OPT3001_DefaultBus);
+
+    // 改造前：800ms转换，每100ms读一次结果寄存器，同一次转换被读出多次
+    {
+        OPT3001_HandleTypeDef old = OPT3001_HANDLE_INIT(&OPT3001_DefaultBus, OPT3001_ADDR_MIN, 0);
+        u16 raw, prev = 0;
+
+        CHECK(OPT3001_Sensor_Configure(&old, OPT3001_CONFIG_DEFAULT) == 0);
+        end = sim::now() + sim::ms_to_cycles(4000);
+        sim::advance(sim::ms_to_cycles(900));
+        while (sim::now() < end) {
+            sim::advance(sim::ms_to_cycles(100));
+            raw = OPT3001_Sensor_ReadReg(&old, OPT3001_RESULT_REG);
+            old_reads++;
+            if (raw == prev)
+                old_dups++;
+            prev = raw;
+        }
+    }
+
+    // 改造后：按转换完成采集，另按主循环的兜底间隔查询
+    for (i = 0; i < kSensors; i++) {
+        CHECK(sim_sensor_init(&h[i], g_dev[i], &OPT3001_DefaultBus, (u8)(OPT3001_ADDR_MIN + i), (u8)i) == 0);
+        CHECK(OPT3001_Sensor_Configure(&h[i], OPT3001_CONFIG_DEFAULT) == 0);
+        CHECK(OPT3001_Sensor_EnableEoc(&h[i]) == 0);
+        g_last_end[i] = g_dev[i]->conversion_end();
+    }
+    OPT3001_Async_Init();
+    OPT3001_Sched_Init(h, kSensors, on_sample);
+    OPT3001_Health_Init(h, kSensors);
+    OPT3001_Adapt_Init(h, kSensors);
+
+    // 结束后再运行一段，使运行期间完成的最后一次转换也被读出
+    run_end = sim::now() + sim::ms_to_cycles(kRunMs);
+    end = run_end + sim::ms_to_cycles(kCycleMs + 100);
+    next_cycle = sim::now() + sim::ms_to_cycles(kCycleMs);
+    while (sim::now() < end) {
+        if (sim::now() >= next_cycle) {
+            OPT3001_Sched_StartCycle();
+            next_cycle += sim::ms_to_cycles(kCycleMs);
+        }
+        OPT3001_Sched_Poll();
+        sim::advance(sim::us_to_cycles(100));
+        track_conversions(run_end);
+    }
+
+    std::printf("  改造前：每100ms读结果寄存器 %d 次，其中重复 %d 次\n", old_reads, old_dups);
+    CHECK(old_dups * 10 >= old_reads * 7);
+
+    for (i = 0; i < kSensors; i++) {
+        std::vector<int> seen(g_conv[i].size(), 0);
+        int counted = 0, dups = 0, unknown = 0, missed = 0;
+        double worst_lag = 0;
+
+        for (const Sample &s : g_samples[i]) {
+            int k = match(i, s.raw);
+            double lag;
+
+            if (k < 0) {
+                // 收尾期间完成的转换不在统计范围内
+                if (s.stamp_us < sim::cycles_to_us(run_end))
+                    unknown++;
+                continue;
+            }
+            counted++;
+            if (seen[k]++)
+                dups++;
+            lag = s.stamp_us - g_conv[i][k].end_us;
+            CHECK_MSG(lag >= -2 && lag <= kStampTolUs, "sensor %d conversion %d: stamp lag %.0fus", i, k, lag);
+            if (lag > worst_lag)
+                worst_lag = lag;
+        }
+        for (size_t k = 0; k < seen.size(); k++)
+            if (!seen[k])
+                missed++;
+        // 自适应控制器改写配置后的第一个转换跨越新旧配置，被有意丢弃
+        OPT3001_Adapt_GetStats((u8)i, &as);
+        std::printf("  传感器%d：转换 %d 次，样本 %d 个，重复 %d，丢弃 %d，时间戳最大滞后 %.0f us\n",
+                    i, (int)g_conv[i].size(), counted, dups, (int)as.discarded, worst_lag);
+
+        CHECK_MSG(dups == 0, "sensor %d: %d duplicate samples", i, dups);
+        CHECK_MSG(unknown == 0, "sensor %d: %d samples match no conversion", i, unknown);
+        CHECK_MSG(missed == (int)as.discarded, "sensor %d: missed %d, discarded %d", i, missed, (int)as.discarded);
+        CHECK(g_conv[i].size() >= kRunMs / 800 / (1.0 + 0.03 * i) - 1);
+    }
+
+#if OPT3001_INT_ENABLE
+    return sim_test_result("no_dup_int");
+#else
+    return sim_test_result("no_dup_crf");
+#endif
+}
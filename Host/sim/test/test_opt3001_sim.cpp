@@ -0,0 +1,69 @@
+// 虚拟OPT3001自检：固件软件IIC读写0x00~0x03/0x7E/0x7F，转换计时、CRF读清、限值比较与上电复位值
+#include "sim_core.h"
+#include "sim_opt3001.h"
+#include "sim_test.h"
+
+#include "delay.h"
+#include "opt3001.h"
+
+int main()
+{
+    sim::Opt3001 dev(OPT3001_ADDR);
+    double level = 500.0;
+    OPT3001_HandleTypeDef h = OPT3001_HANDLE_INIT(&OPT3001_DefaultBus, OPT3001_ADDR, 0);
+    u16 cfg;
+
+    dev.lux = [&level](double) { return level; };
+    dev.attach_wire(OPT3001_IIC_PORT, OPT3001_IIC_SCL_PIN, OPT3001_IIC_SDA_PIN);
+    SysTick_Init();
+    DWT_Init();
+    OPT3001_Bus_Init(&OPT3001_DefaultBus);
+
+    // 上电值
+    CHECK(OPT3001_Sensor_Identify(&h) == 0);
+    CHECK(OPT3001_Sensor_ReadReg(&h, OPT3001_CONFIG_REG) == 0xC810);
+    CHECK(OPT3001_Sensor_ReadReg(&h, OPT3001_LOW_LIMIT_REG) == 0xC000);
+    CHECK(OPT3001_Sensor_ReadReg(&h, OPT3001_HIGH_LIMIT_REG) == 0xBFFF);
+    CHECK(OPT3001_Bus_Probe(&OPT3001_DefaultBus, 0x45) != 0);
+
+    // 100ms连续转换：未到转换时间CRF为0，到时后置位，读配置后清零
+    CHECK(OPT3001_Sensor_WriteReg(&h, OPT3001_CONFIG_REG, OPT3001_CONFIG_FASTBOOT) == 0);
+    CHECK(dev.converting());
+    sim::advance(sim::ms_to_cycles(50));
+    CHECK(!(OPT3001_Sensor_ReadReg(&h, OPT3001_CONFIG_REG) & OPT3001_CFG_CRF));
+    sim::advance(sim::ms_to_cycles(60));
+    cfg = OPT3001_Sensor_ReadReg(&h, OPT3001_CONFIG_REG);
+    CHECK(cfg & OPT3001_CFG_CRF);
+    CHECK((cfg & 0xFE1F) == OPT3001_CONFIG_FASTBOOT);
+    CHECK(!(OPT3001_Sensor_ReadReg(&h, OPT3001_CONFIG_REG) & OPT3001_CFG_CRF));
+    {
+        u32 clux = OPT3001_RawToCentiLux(OPT3001_Sensor_ReadReg(&h, OPT3001_RESULT_REG));
+        CHECK_MSG(clux > 49500 && clux < 50500, "clux=%u", (unsigned)clux);
+    }
+
+    // 窗口限值：高于上限置FH，锁存模式读配置后清零
+    CHECK(OPT3001_Sensor_WriteReg(&h, OPT3001_HIGH_LIMIT_REG, OPT3001_CentiLuxToLimit(100000, 1)) == 0);
+    CHECK(OPT3001_Sensor_WriteReg(&h, OPT3001_LOW_LIMIT_REG, OPT3001_CentiLuxToLimit(1000, 0)) == 0);
+    level = 2000.0;
+    sim::advance(sim::ms_to_cycles(220));
+    CHECK(OPT3001_Sensor_ReadReg(&h, OPT3001_CONFIG_REG) & OPT3001_CFG_FH);
+    CHECK(!(OPT3001_Sensor_ReadReg(&h, OPT3001_CONFIG_REG) & OPT3001_CFG_FH));
+
+    // 写入的只读位被忽略
+    CHECK(OPT3001_Sensor_WriteReg(&h, OPT3001_CONFIG_REG, 0xCFFF) == 0);
+    CHECK((OPT3001_Sensor_ReadReg(&h, OPT3001_CONFIG_REG) & 0x01E0) == 0);
+
+    // 上电复位：寄存器回到上电值，指针归零
+    dev.power_on_reset();
+    CHECK(dev.pointer() == 0);
+    CHECK(!dev.converting());
+    CHECK(dev.reg(OPT3001_CONFIG_REG) == 0xC810);
+
+    // 不在线：地址无应答
+    dev.present = false;
+    CHECK(OPT3001_Bus_Probe(&OPT3001_DefaultBus, OPT3001_ADDR) != 0);
+    dev.present = true;
+    CHECK(OPT3001_Bus_Probe(&OPT3001_DefaultBus, OPT3001_ADDR) == 0);
+
+    return sim_test_result("opt3001_sim");
+}
@@ -0,0 +1,168 @@
+// 睡眠与占空比：主循环按固件方式Poll调度器后Power_Idle睡眠，核对Power_GetDuty与仿真时钟的
+// 实际睡眠时间一致，并比较忙等轮询、INT调度（1/4个传感器）与事件模式的CPU占用
+#include "sim_core.h"
+#include "sim_opt3001.h"
+#include "sim_test.h"
+
+#include "delay.h"
+#include "opt3001.h"
+#include "opt3001_adapt.h"
+#include "opt3001_health.h"
+#include "opt3001_sched.h"
+#include "power.h"
+
+#include <memory>
+
+namespace {
+
+const int kRunMs = 3000;
+const int kPollMs = 500;        // 忙等基线每次读micros()都在仿真中逐次展开，只跑半秒
+
+struct Result {
+    unsigned fw_permille;       // Power_GetLoadPermille（最近1秒窗口）
+    unsigned sim_permille;      // 同一窗口内仿真时钟的非睡眠比例
+    int samples;
+};
+
+int g_samples;
+
+void on_sample(OPT3001_HandleTypeDef *h, u16 raw, u32 clux, u32 stamp_us)
+{
+    (void)h;
+    (void)clux;
+    (void)stamp_us;
+    if (raw != 0)
+        g_samples++;
+}
+
+sim::Opt3001 *g_dev[4];
+OPT3001_HandleTypeDef g_h[4];
+
+// 上一种配置的读取全部结束后再同步访问总线
+void drain()
+{
+    uint64_t end = sim::now() + sim::ms_to_cycles(100);
+
+    while ((OPT3001_Sched_IsBusy() || OPT3001_Async_Pending() != 0) && sim::now() < end) {
+        OPT3001_Sched_Poll();
+        sim::advance(sim::us_to_cycles(100));
+    }
+    CHECK(!OPT3001_Sched_IsBusy() && OPT3001_Async_Pending() == 0);
+}
+
+void setup(int n, u16 config)
+{
+    int i;
+
+    drain();
+    for (i = 0; i < 4; i++)
+        g_dev[i]->power_on_reset();
+    for (i = 0; i < n; i++) {
+        CHECK(sim_sensor_init(&g_h[i], nullptr, &OPT3001_DefaultBus, (u8)(OPT3001_ADDR_MIN + i), (u8)i) == 0);
+        CHECK(OPT3001_Sensor_Configure(&g_h[i], config) == 0);
+    }
+    OPT3001_Async_Init();
+    OPT3001_Sched_Init(g_h, (u8)n, on_sample);
+    OPT3001_Health_Init(g_h, (u8)n);
+    OPT3001_Adapt_Init(g_h, (u8)n);
+}
+
+// 主循环：与main.c相同，处理样本后睡眠到下一个中断
+Result run_sleeping()
+{
+    uint64_t end = sim::now() + sim::ms_to_cycles(kRunMs);
+    uint64_t win_now = 0, win_sleep = 0, last_now = 0, last_sleep = 0;
+    Power_DutyTypeDef prev = { 0, 0 }, duty;
+    Result r = { 0, 0, 0 };
+
+    g_samples = 0;
+    Power_Init();
+    while (sim::now() < end) {
+        OPT3001_Sched_Poll();
+        Power_Idle();
+        // 窗口滚动时记下这一秒内仿真时钟的睡眠周期作为对照
+        Power_GetDuty(&duty);
+        if (duty.busy_us != prev.busy_us || duty.idle_us != prev.idle_us) {
+            win_now = sim::now() - last_now;
+            win_sleep = sim::sleep_cycles() - last_sleep;
+            prev = duty;
+        }
+        if (duty.busy_us == prev.busy_us && win_now == 0) {
+            last_now = sim::now();
+            last_sleep = sim::sleep_cycles();
+        }
+    }
+    r.fw_permille = Power_GetLoadPermille();
+    r.sim_permille = win_now ? (unsigned)(1000 - win_sleep * 1000 / win_now) : 0;
+    r.samples = g_samples;
+    return r;
+}
+
+}
+
+int main()
+{
+    std::unique_ptr<sim::Opt3001> dev[4];
+    Result poll, single, quad, event;
+    uint64_t t0, s0;
+    int i;
+
+    for (i = 0; i < 4; i++) {
+        dev[i].reset(new sim::Opt3001((uint8_t)(OPT3001_ADDR_MIN + i)));
+        g_dev[i] = dev[i].get();
+        g_dev[i]->lux = [i](double) { return 300.0 + 20.0 * i; };
+        g_dev[i]->conv_scale = 1.0 + 0.01 * i;
+        g_dev[i]->attach_wire(OPT3001_IIC_PORT, OPT3001_IIC_SCL_PIN, OPT3001_IIC_SDA_PIN);
+        g_dev[i]->attach_int(OPT3001_INT_PORT, OPT3001_INT_PIN);
+    }
+    SysTick_Init();
+    DWT_Init();
+    OPT3001_Bus_Init(&OPT3001_DefaultBus);
+
+    // 改造前的主循环：Delay_ms(100)忙等后阻塞读取，从不睡眠
+    setup(1, OPT3001_CONFIG_FASTBOOT);
+    t0 = sim::now();
+    s0 = sim::sleep_cycles();
+    poll.samples = 0;
+    while (sim::now() - t0 < sim::ms_to_cycles(kPollMs)) {
+        Delay_ms(100);
+        if (OPT3001_Sensor_ReadCentiLux(&g_h[0]) != OPT3001_CLUX_INVALID)
+            poll.samples++;
+    }
+    poll.sim_permille = (unsigned)(1000 - (sim::sleep_cycles() - s0) * 1000 / (sim::now() - t0));
+    poll.fw_permille = poll.sim_permille;
+
+    // INT驱动的调度器 + WFI睡眠
+    setup(1, OPT3001_CONFIG_FASTBOOT);
+    single = run_sleeping();
+    setup(4, OPT3001_CONFIG_FASTBOOT);
+    quad = run_sleeping();
+
+    // 事件模式：光照不变时传感器不拉INT，只有SysTick唤醒
+    setup(4, OPT3001_CONFIG_FASTBOOT);
+    CHECK(OPT3001_Sched_SetEventMode(1) == 0);
+    event = run_sleeping();
+
+    std::printf("  配置              CPU占用(‰) 固件/仿真   样本/s\n");
+    std::printf("  忙等轮询(1个)      %4u / %4u          %.1f\n", poll.fw_permille, poll.sim_permille, poll.samples * 1000.0 / kPollMs);
+    std::printf("  INT调度(1个)       %4u / %4u          %.1f\n", single.fw_permille, single.sim_permille, single.samples * 1000.0 / kRunMs);
+    std::printf("  INT调度(4个)       %4u / %4u          %.1f\n", quad.fw_permille, quad.sim_permille, quad.samples * 1000.0 / kRunMs);
+    std::printf("  事件模式(4个)      %4u / %4u          %.1f\n", event.fw_permille, event.sim_permille, event.samples * 1000.0 / kRunMs);
+
+    // 固件统计与仿真时钟一致（睡眠前后各一次micros()的误差）
+    CHECK_MSG(single.fw_permille + 5 >= single.sim_permille && single.fw_permille <= single.sim_permille + 5,
+              "single fw=%u sim=%u", single.fw_permille, single.sim_permille);
+    CHECK_MSG(quad.fw_permille + 5 >= quad.sim_permille && quad.fw_permille <= quad.sim_permille + 5,
+              "quad fw=%u sim=%u", quad.fw_permille, quad.sim_permille);
+
+    // 忙等始终满载；睡眠后占用随传感器数增加但远低于满载，事件模式最低
+    CHECK(poll.sim_permille >= 990);
+    CHECK(single.sim_permille < 200 && quad.sim_permille < 500);
+    CHECK(single.sim_permille < quad.sim_permille);
+    CHECK(event.sim_permille <= single.sim_permille);
+    // 采样率不因睡眠而下降（INT调度的首个样本在配置后一个转换周期才到，允许差1个）
+    CHECK_MSG(single.samples + 1 >= poll.samples * kRunMs / kPollMs,
+              "single=%d/%dms poll=%d/%dms", single.samples, kRunMs, poll.samples, kPollMs);
+
+    return sim_test_result("power");
+}
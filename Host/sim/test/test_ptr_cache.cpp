@@ -0,0 +1,310 @@
+// 寄存器指针缓存：虚拟OPT3001按字节记录指针写入与总线字节。核对：
+// 连续读结果寄存器只有首次写指针（5→3字节、2→1个START），每次读省下的总线时间；
+// 写操作把指针留在被写的寄存器，换读其他寄存器时重新写指针；
+// 同步/异步事务混合并随机注入NACK时，缓存要么为“未知”、要么与器件的实际指针一致，成功的读全部来自目标寄存器；
+// 事务之间器件静默复位（指针归零）后，读配置寄存器都能被M位识别，直到重新写入配置。
+// 最后按main.c的节奏运行调度器，统计每个样本的总线字节、START与配置寄存器读，对照不缓存指针、每轮都查询配置的读法。
+// 同一源文件分别按INT触发（opt3001_fw）与查询CRF（OPT3001_INT_ENABLE=0）构建
+#include "sim_core.h"
+#include "sim_opt3001.h"
+#include "sim_test.h"
+
+#include "delay.h"
+#include "opt3001.h"
+#include "opt3001_adapt.h"
+#include "opt3001_async.h"
+#include "opt3001_health.h"
+#include "opt3001_sched.h"
+
+#include <random>
+
+namespace {
+
+const double kLux = 300;
+const u16 kFlags = OPT3001_CFG_OVF | OPT3001_CFG_CRF | OPT3001_CFG_FH | OPT3001_CFG_FL;
+const int kRunMs = 60000;
+// 主循环兜底查询间隔，与main.c的CYCLE_INTERVAL_MS一致
+#if OPT3001_INT_ENABLE
+const int kCycleMs = 1000;
+#else
+const int kCycleMs = 100;
+#endif
+
+sim::Opt3001 *g_dev;
+std::mt19937 g_rng(24);
+u32 g_samples;
+
+bool drained()
+{
+    return OPT3001_Async_Pending() == 0;
+}
+
+struct AsyncResult {
+    bool done;
+    OPT3001_XferResultTypeDef result;
+    u16 data;
+};
+
+void on_xfer(const OPT3001_XferTypeDef *xfer)
+{
+    AsyncResult *r = (AsyncResult *)xfer->ctx;
+
+    r->done = true;
+    r->result = xfer->result;
+    r->data = xfer->data;
+}
+
+void on_sample(OPT3001_HandleTypeDef *h, u16 raw, u32 clux, u32 stamp_us)
+{
+    (void)h;
+    (void)raw;
+    (void)clux;
+    (void)stamp_us;
+    g_samples++;
+}
+
+// 一次读：同步或异步，返回是否成功
+bool read_reg(OPT3001_HandleTypeDef *h, u8 reg, bool async, u16 *data)
+{
+    if (async) {
+        AsyncResult r = { false, OPT3001_XFER_OK, 0 };
+
+        if (OPT3001_Async_ReadReg(h, reg, on_xfer, &r) != 0)
+            return false;
+        sim::advance_until(drained, sim::ms_to_cycles(200));
+        *data = r.data;
+        return r.done && r.result == OPT3001_XFER_OK;
+    }
+    *data = OPT3001_Sensor_ReadReg(h, reg);
+    return h->reg_ptr == reg;
+}
+
+bool write_reg(OPT3001_HandleTypeDef *h, u8 reg, u16 data, bool async)
+{
+    if (async) {
+        AsyncResult r = { false, OPT3001_XFER_OK, 0 };
+
+        if (OPT3001_Async_WriteReg(h, reg, data, on_xfer, &r) != 0)
+            return false;
+        sim::advance_until(drained, sim::ms_to_cycles(200));
+        return r.done && r.result == OPT3001_XFER_OK;
+    }
+    return OPT3001_Sensor_WriteReg(h, reg, data) == 0;
+}
+
+// 读回值是否来自目标寄存器：结果寄存器在读的过程中可能恰好完成一次转换，前后两个值都算；
+// 配置寄存器的标志位读后清零，不参与比较
+bool from_register(u8 reg, u16 got, u16 before)
+{
+    u16 after = g_dev->reg(reg);
+
+    if (reg == OPT3001_CONFIG_REG)
+        return ((got ^ before) & ~kFlags) == 0;
+    return got == before || got == after;
+}
+
+}
+
+int main()
+{
+    sim::Opt3001 dev(OPT3001_ADDR);
+    OPT3001_HandleTypeDef h;
+    static const u8 kRegs[] = { OPT3001_RESULT_REG, OPT3001_CONFIG_REG, OPT3001_LOW_LIMIT_REG, OPT3001_HIGH_LIMIT_REG,
+                                OPT3001_MANUF_ID_REG, OPT3001_DEVICE_ID_REG };
+    sim::Opt3001::Stats s0;
+    uint64_t t0;
+    double cached_us, uncached_us;
+    u16 v;
+    int i;
+
+    g_dev = &dev;
+    dev.lux = [](double) { return kLux; };
+    dev.attach_wire(OPT3001_IIC_PORT, OPT3001_IIC_SCL_PIN, OPT3001_IIC_SDA_PIN);
+    dev.attach_int(OPT3001_INT_PORT, OPT3001_INT_PIN);
+    SysTick_Init();
+    DWT_Init();
+    OPT3001_Bus_Init(&OPT3001_DefaultBus);
+    OPT3001_Async_Init();
+    CHECK(sim_sensor_init(&h, &dev, &OPT3001_DefaultBus, OPT3001_ADDR, 0) == 0);
+    CHECK(OPT3001_Sensor_Configure(&h, OPT3001_CONFIG_DEFAULT) == 0);
+    sim::advance(sim::ms_to_cycles(900));
+
+    // 稳态读结果：首次写指针，其余只有 START + addr+R + 2个数据字节
+    h.reg_ptr = OPT3001_PTR_UNKNOWN;
+    dev.reset_stats();
+    t0 = sim::now();
+    OPT3001_Sensor_ReadReg(&h, OPT3001_RESULT_REG);
+    uncached_us = sim::cycles_to_us(sim::now() - t0);
+    CHECK(dev.stats().bytes == 5 && dev.stats().starts == 2 && dev.stats().ptr_writes == 1);
+    dev.reset_stats();
+    t0 = sim::now();
+    for (i = 0; i < 100; i++)
+        CHECK(OPT3001_Sensor_ReadReg(&h, OPT3001_RESULT_REG) == dev.reg(OPT3001_RESULT_REG));
+    cached_us = sim::cycles_to_us(sim::now() - t0) / 100;
+    CHECK(dev.stats().bytes == 300 && dev.stats().starts == 100 && dev.stats().ptr_writes == 0);
+    std::printf("  读结果寄存器：不缓存 5字节/%.0f us，缓存命中 3字节/%.0f us，每次省 %.0f us\n", uncached_us,
+                cached_us, uncached_us - cached_us);
+    CHECK(cached_us < uncached_us * 0.7);
+
+    // 异步事务按执行时刻的缓存决定步骤：同样只有首次写指针
+    h.reg_ptr = OPT3001_PTR_UNKNOWN;
+    dev.reset_stats();
+    for (i = 0; i < 10; i++)
+        CHECK(read_reg(&h, OPT3001_RESULT_REG, true, &v) && v == dev.reg(OPT3001_RESULT_REG));
+    CHECK(dev.stats().bytes == 5 + 9 * 3 && dev.stats().ptr_writes == 1);
+
+    // 写操作移动指针：写下限后读下限命中缓存，再读结果要重新写指针
+    CHECK(write_reg(&h, OPT3001_LOW_LIMIT_REG, 0x1234, false) && h.reg_ptr == OPT3001_LOW_LIMIT_REG);
+    dev.reset_stats();
+    CHECK(read_reg(&h, OPT3001_LOW_LIMIT_REG, false, &v) && v == 0x1234);
+    CHECK(dev.stats().bytes == 3 && dev.stats().ptr_writes == 0);
+    dev.reset_stats();
+    CHECK(read_reg(&h, OPT3001_RESULT_REG, true, &v) && v == dev.reg(OPT3001_RESULT_REG));
+    CHECK(dev.stats().bytes == 5 && dev.stats().ptr_writes == 1);
+    CHECK(write_reg(&h, OPT3001_LOW_LIMIT_REG, 0x0000, true) && h.reg_ptr == OPT3001_LOW_LIMIT_REG);
+
+    // 随机读写并注入NACK（地址、指针或数据字节）：每次事务结束后缓存不得与器件指针矛盾
+    {
+        u32 ops = 0, failed = 0, hits = 0, wrong = 0, mismatch = 0;
+
+        for (i = 0; i < 1000; i++) {
+            u8 reg = kRegs[g_rng() % 6];
+            bool async = g_rng() % 2, ok;
+            bool hit = h.reg_ptr == reg;
+            u16 before = dev.reg(reg);
+
+            if (g_rng() % 10 == 0)
+                dev.nack_next(1 + g_rng() % 3);
+            if (g_rng() % 5 == 0 && reg != OPT3001_MANUF_ID_REG && reg != OPT3001_DEVICE_ID_REG &&
+                reg != OPT3001_RESULT_REG) {
+                ok = write_reg(&h, reg, reg == OPT3001_CONFIG_REG ? OPT3001_CONFIG_DEFAULT : (u16)(g_rng() & 0xBFFF),
+                               async);
+            } else {
+                ok = read_reg(&h, reg, async, &v);
+                if (ok && !from_register(reg, v, before))
+                    wrong++;
+                if (ok && hit)
+                    hits++;
+            }
+            dev.nack_next(0);
+            ops++;
+            if (!ok)
+                failed++;
+            if (ok ? h.reg_ptr != dev.pointer() : h.reg_ptr != OPT3001_PTR_UNKNOWN)
+                mismatch++;
+            if (h.reg_ptr != OPT3001_PTR_UNKNOWN && h.reg_ptr != dev.pointer())
+                mismatch++;
+        }
+        std::printf("  随机读写 %u 次（10%%注入NACK）：失败 %u，缓存命中 %u，读错寄存器 %u，缓存与器件指针矛盾 %u\n",
+                    (unsigned)ops, (unsigned)failed, (unsigned)hits, (unsigned)wrong, (unsigned)mismatch);
+        CHECK(wrong == 0 && mismatch == 0);
+        CHECK(failed > 0 && hits > 0);
+    }
+
+    // 事务之间器件静默复位：指针回到结果寄存器、转为关断模式；缓存仍指向配置寄存器时读到的是结果寄存器，
+    // 两种情况下M位都不是连续转换，重新写入配置之前每次读配置都被识别
+    {
+        u32 resets = 0, stale = 0, config_reads = 0, caught = 0, wrong = 0;
+        bool reset = false;
+
+        for (i = 0; i < 1000; i++) {
+            u8 reg = g_rng() % 2 ? OPT3001_CONFIG_REG : OPT3001_RESULT_REG;
+            bool async = g_rng() % 2;
+            u16 before;
+
+            if (g_rng() % 40 == 0) {
+                dev.power_on_reset();
+                reset = true;
+                resets++;
+            }
+            if (g_rng() % 20 == 0) {
+                if (write_reg(&h, OPT3001_CONFIG_REG, OPT3001_CONFIG_DEFAULT, async))
+                    reset = false;
+                continue;
+            }
+            if (reset && reg == OPT3001_CONFIG_REG && h.reg_ptr == reg && dev.pointer() != reg)
+                stale++;
+            before = dev.reg(reg);
+            if (!read_reg(&h, reg, async, &v))
+                continue;
+            if (reg == OPT3001_CONFIG_REG && reset) {
+                config_reads++;
+                if ((v & OPT3001_CFG_M) != OPT3001_CFG_M)
+                    caught++;
+            } else if (!from_register(reg, v, before)) {
+                wrong++;
+            }
+        }
+        std::printf("  静默复位 %u 次：复位后读配置 %u 次（其中缓存过期 %u 次），被M位识别 %u 次，其他读错 %u\n",
+                    (unsigned)resets, (unsigned)config_reads, (unsigned)stale, (unsigned)caught, (unsigned)wrong);
+        CHECK(resets > 0 && stale > 0);
+        CHECK(caught == config_reads && wrong == 0);
+    }
+
+    // 调度器：按主循环的兜底间隔运行，每个样本的总线开销对照改造前（每轮读配置、每次读都写指针）
+    {
+        uint64_t end, next_cycle;
+        u32 cycles = 0, skipped;
+        double bytes, starts, before_bytes, before_starts, bus_us;
+
+        CHECK(sim_sensor_init(&h, &dev, &OPT3001_DefaultBus, OPT3001_ADDR, 0) == 0);
+        CHECK(OPT3001_Sensor_Configure(&h, OPT3001_CONFIG_DEFAULT) == 0);
+        CHECK(OPT3001_Sensor_EnableEoc(&h) == 0);
+        OPT3001_Async_Init();
+        OPT3001_Sched_Init(&h, 1, on_sample);
+        OPT3001_Health_Init(&h, 1);
+        OPT3001_Adapt_Init(&h, 1);
+        sim::advance(sim::ms_to_cycles(2000));
+        dev.reset_stats();
+        g_samples = 0;
+        skipped = OPT3001_Sched_GetSkipped();
+
+        end = sim::now() + sim::ms_to_cycles(kRunMs);
+        next_cycle = sim::now();
+        while (sim::now() < end) {
+            if (sim::now() >= next_cycle) {
+                if (OPT3001_Sched_StartCycle() == 0)
+                    cycles++;
+                next_cycle += sim::ms_to_cycles(kCycleMs);
+            }
+            OPT3001_Sched_Poll();
+            OPT3001_Health_Poll();
+            sim::advance(sim::us_to_cycles(100));
+        }
+        skipped = OPT3001_Sched_GetSkipped() - skipped;
+        s0 = dev.stats();
+        bytes = (double)s0.bytes / g_samples;
+        starts = (double)s0.starts / g_samples;
+        // 改造前：每次读都是5字节、2个START；查询方式每轮都读配置
+#if OPT3001_INT_ENABLE
+        before_bytes = (double)(s0.config_reads + s0.result_reads) * 5 / g_samples;
+#else
+        before_bytes = (double)(s0.config_reads + skipped + s0.result_reads) * 5 / g_samples;
+#endif
+        before_starts = before_bytes * 2 / 5;
+        bus_us = (before_bytes - bytes) * 9 * 1e6 / OPT3001_IIC_SPEED;
+        std::printf("  调度器 %d s：样本 %u，轮次 %u，跳过查询 %u，配置读 %u，指针写 %u\n", kRunMs / 1000,
+                    (unsigned)g_samples, (unsigned)cycles, (unsigned)skipped, (unsigned)s0.config_reads,
+                    (unsigned)s0.ptr_writes);
+        std::printf("  每样本：%.1f 字节/%.1f 个START（改造前 %.1f/%.1f），省总线时间约 %.0f us\n", bytes, starts,
+                    before_bytes, before_starts, bus_us);
+        CHECK(g_samples >= kRunMs / 800 - 2);
+        CHECK(s0.result_reads == g_samples);
+#if OPT3001_INT_ENABLE
+        // 锁存INT每次转换都要读配置释放，缓存省不下指针写入，但不应多读
+        CHECK(s0.config_reads <= g_samples + cycles / 10 + 2);
+        CHECK(bytes <= before_bytes);
+#else
+        // 查询方式：转换时间内不再查询，配置读接近每样本1~2次；连续两次读结果之间的配置读把指针移走
+        CHECK(skipped > 0);
+        CHECK(s0.config_reads <= 2 * g_samples + 2);
+        CHECK(bytes <= before_bytes * 0.5);
+#endif
+    }
+
+#if OPT3001_INT_ENABLE
+    return sim_test_result("ptr_cache_int");
+#else
+    return sim_test_result("ptr_cache_crf");
+#endif
+}
@@ -0,0 +1,125 @@
+// 样本环形缓冲：生产者与消费者各一个线程（对应采集中断与串口输出），生产者不停写入，
+// 消费者按8条一批取出并不时停顿制造溢出。核对每条记录完整（无半写记录）、顺序不乱、
+// 取出条数 + 溢出计数 = 写入条数，且序号间隔与丢失的记录一一对应；另在单线程下核对满/空边界
+#include "sim_test.h"
+
+#include "sample_ring.h"
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+namespace {
+
+const u32 kRecords = 2000000;
+
+// 记录内容由写入序号决定，消费者据此检查每个字段是否来自同一次写入
+SampleRing_RecordTypeDef make(u32 i)
+{
+    SampleRing_RecordTypeDef r;
+
+    r.stamp_us = i;
+    r.clux = i * 3 + 7;
+    r.seq = 0;
+    r.raw = (u16)(i ^ 0x5A5A);
+    r.sensor = (u8)(i % 8);
+    r.status = (u8)(i % 4);
+    r.jump = (u8)(i >> 8);
+    r.pending = (u8)i;
+    return r;
+}
+
+bool intact(const SampleRing_RecordTypeDef &r)
+{
+    u32 i = r.stamp_us;
+
+    return r.clux == i * 3 + 7 && r.raw == (u16)(i ^ 0x5A5A) && r.sensor == (u8)(i % 8) &&
+           r.status == (u8)(i % 4) && r.jump == (u8)(i >> 8) && r.pending == (u8)i;
+}
+
+}
+
+int main()
+{
+    std::atomic<bool> done(false);
+    SampleRing_RecordTypeDef out[8], rec;
+    u32 received = 0, torn = 0, disorder = 0, seq_mismatch = 0, pauses = 0;
+    u32 last_stamp = 0;
+    u16 last_seq = 0;
+    bool first = true;
+    u8 n, i;
+
+    // 单线程边界：写满SAMPLE_RING_SIZE条后再写被拒绝并计数，取出从最旧的开始，序号跳过被丢弃的一条
+    SampleRing_Init();
+    for (u32 k = 0; k < SAMPLE_RING_SIZE; k++) {
+        rec = make(k);
+        CHECK(SampleRing_Push(&rec) == 0);
+    }
+    rec = make(SAMPLE_RING_SIZE);
+    CHECK(SampleRing_Push(&rec) == 1);
+    CHECK(SampleRing_Count() == SAMPLE_RING_SIZE && SampleRing_GetOverflow() == 1);
+    CHECK(SampleRing_Drain(out, 8) == 8);
+    CHECK(out[0].stamp_us == 0 && out[0].seq == 0 && out[7].stamp_us == 7);
+    CHECK(SampleRing_Drain(out, 8) == 8 && SampleRing_Drain(out, 8) == 8 && SampleRing_Drain(out, 8) == 8);
+    CHECK(SampleRing_Drain(out, 8) == 0 && SampleRing_Count() == 0);
+    rec = make(100);
+    CHECK(SampleRing_Push(&rec) == 0);
+    CHECK(SampleRing_Drain(out, 8) == 1 && out[0].seq == SAMPLE_RING_SIZE + 1);
+
+    // 双线程压力：生产者不因缓冲满而等待。生产者每写一批、消费者取空时各让出一次CPU，
+    // 单核主机上也能频繁交替；时间片抢占则让双方在读写下标/记录的任意位置被打断
+    SampleRing_Init();
+    std::thread producer([&done] {
+        for (u32 k = 0; k < kRecords; k++) {
+            SampleRing_RecordTypeDef r = make(k);
+            SampleRing_Push(&r);
+            if (k % 24 == 0)
+                std::this_thread::yield();
+        }
+        done = true;
+    });
+
+    for (;;) {
+        bool finished = done;
+
+        n = SampleRing_Drain(out, 8);
+        for (i = 0; i < n; i++) {
+            if (!intact(out[i]))
+                torn++;
+            if (!first) {
+                if (out[i].stamp_us <= last_stamp)
+                    disorder++;
+                // 两条记录之间被丢弃的条数，从序号与写入编号看应当一致
+                else if ((u16)(out[i].seq - last_seq) != (u16)(out[i].stamp_us - last_stamp))
+                    seq_mismatch++;
+            } else if (out[i].seq != (u16)out[i].stamp_us) {
+                seq_mismatch++;
+            }
+            first = false;
+            last_stamp = out[i].stamp_us;
+            last_seq = out[i].seq;
+            received++;
+        }
+        // 模拟串口偶尔跟不上：每取出约5万条停顿一下
+        if (n != 0 && received / 50000 != (received - n) / 50000) {
+            std::this_thread::sleep_for(std::chrono::microseconds(200));
+            pauses++;
+        }
+        if (finished && n == 0)
+            break;
+        if (n == 0)
+            std::this_thread::yield();
+    }
+    producer.join();
+
+    std::printf("  写入 %u 条，取出 %u 条，溢出 %u 条（消费者停顿 %u 次）\n", (unsigned)kRecords,
+                (unsigned)received, (unsigned)SampleRing_GetOverflow(), (unsigned)pauses);
+    CHECK_MSG(torn == 0, "torn=%u", (unsigned)torn);
+    CHECK_MSG(disorder == 0, "disorder=%u", (unsigned)disorder);
+    CHECK_MSG(seq_mismatch == 0, "seq_mismatch=%u", (unsigned)seq_mismatch);
+    CHECK(received + SampleRing_GetOverflow() == kRecords);
+    CHECK(SampleRing_GetOverflow() > 0);
+    CHECK(SampleRing_Count() == 0);
+
+    return sim_test_result("sample_ring");
+}
@@ -0,0 +1,187 @@
+// 屏幕状态分类的回放测试：四台亮度/环境光差别很大的屏幕（普通屏、暗屏、强环境光、户外高亮屏），
+// 各回放一段带真值的光照序列：上电后几次亮灭学习基线，再依次经历亮屏（含人影遮挡）、熄屏、
+// 低亮、短暂通信错误、持续通信错误、量程异常、亮灭往返，叠加±3%噪声与缓慢的环境光漂移。
+// 逐个真值状态变化核对事件：类型正确、确认延迟不超过确认时间加两个采样周期、起始时刻误差不超过一个周期；
+// 不对应任何真值变化的事件即误报，要求为0；短于确认时间的遮挡/通信错误不产生事件
+#include "sim_test.h"
+
+#include "opt3001.h"
+#include "screen_state.h"
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+namespace {
+
+// 一段真值：持续时间、真实状态、光照（lux）、传感器状态
+struct Segment {
+    u32 ms;
+    u8 truth;
+    double lux;
+    u8 status;
+};
+
+struct Unit {
+    const char *name;
+    double on, dim, off;                // 三种状态下的光照（lux）
+    u32 period_ms;                      // 采样周期
+};
+
+const Unit kUnits[] = {
+    { "普通屏", 400, 30, 2, 100 },
+    { "暗屏", 60, 5, 0.3, 800 },
+    { "强环境光", 1500, 600, 250, 100 },
+    { "户外高亮", 20000, 4000, 800, 800 },
+};
+
+const u32 kWarmupMs = 120000;           // 学习阶段：其中的事件不计入统计
+
+std::vector<Segment> script(const Unit &u)
+{
+    std::vector<Segment> s;
+
+    // 上电后亮灭三次学习两条基线
+    for (int i = 0; i < 3; i++) {
+        s.push_back({ 20000, SCREEN_ON, u.on, OPT3001_STATUS_NORMAL });
+        s.push_back({ 20000, SCREEN_OFF, u.off, OPT3001_STATUS_NORMAL });
+    }
+    // 回放段
+    s.push_back({ 60000, SCREEN_ON, u.on, OPT3001_STATUS_NORMAL });
+    s.push_back({ 40000, SCREEN_OFF, u.off, OPT3001_STATUS_NORMAL });
+    s.push_back({ 30000, SCREEN_ON, u.on, OPT3001_STATUS_NORMAL });
+    s.push_back({ 15000, SCREEN_DIM, u.dim, OPT3001_STATUS_NORMAL });
+    s.push_back({ 30000, SCREEN_ON, u.on, OPT3001_STATUS_NORMAL });
+    s.push_back({ 1500, SCREEN_ON, 0, OPT3001_STATUS_COMM_ERR });      // 短于故障确认时间：仍算亮屏
+    s.push_back({ 30000, SCREEN_ON, u.on, OPT3001_STATUS_NORMAL });
+    s.push_back({ 6000, SCREEN_FAULT, 0, OPT3001_STATUS_COMM_ERR });
+    s.push_back({ 30000, SCREEN_ON, u.on, OPT3001_STATUS_NORMAL });
+    s.push_back({ 5000, SCREEN_FAULT, 0, OPT3001_STATUS_RANGE_ERR });
+    s.push_back({ 20000, SCREEN_ON, u.on, OPT3001_STATUS_NORMAL });
+    for (int i = 0; i < 5; i++) {
+        s.push_back({ 8000, SCREEN_OFF, u.off, OPT3001_STATUS_NORMAL });
+        s.push_back({ 8000, SCREEN_ON, u.on, OPT3001_STATUS_NORMAL });
+    }
+    s.push_back({ 15000, SCREEN_DIM, u.dim, OPT3001_STATUS_NORMAL });
+    s.push_back({ 30000, SCREEN_OFF, u.off, OPT3001_STATUS_NORMAL });
+    return s;
+}
+
+struct Transition {
+    u32 at_ms;
+    u8 to;
+    bool seen;
+};
+
+struct Result {
+    u32 transitions, missed, false_events, wrong_onset, shades;
+    double mean_latency, max_latency;
+};
+
+Result replay(const Unit &u, std::mt19937 &rng)
+{
+    std::normal_distribution<double> noise(0, 0.03);
+    std::vector<Segment> segs = script(u);
+    std::vector<Transition> truth;
+    Result r = { 0, 0, 0, 0, 0, 0, 0 };
+    Screen_EventTypeDef ev;
+    u32 t = 0, seg_start = 0, shade_until = 0, latency_sum = 0, matched = 0;
+    u8 prev = SCREEN_UNKNOWN;
+
+    Screen_Init();
+    for (const Segment &seg : segs) {
+        // 真值变化在段起点（短暂通信错误段的真值仍是亮屏，不算变化）
+        if (seg.truth != prev && seg_start >= kWarmupMs)
+            truth.push_back({ seg_start, seg.truth, false });
+        prev = seg.truth;
+        seg_start += seg.ms;
+    }
+
+    seg_start = 0;
+    for (const Segment &seg : segs) {
+        for (; t < seg_start + seg.ms; t += u.period_ms) {
+            double lux = seg.lux;
+            u32 clux;
+
+            // 环境光缓慢漂移±20%（周期5分钟）；亮屏稳定后偶尔有人影遮挡，光照降到30%持续200ms
+            // （落在状态变化的同一时刻时无法区分真值延迟，故只在段起点1s之后出现）
+            lux *= 1.0 + 0.2 * std::sin(t / 300000.0 * 2 * M_PI);
+            lux *= 1.0 + noise(rng);
+            if (seg.truth == SCREEN_ON && u.period_ms <= 100 && t >= seg_start + 1000 && t >= shade_until + 5000 &&
+                rng() % 50 == 0) {
+                shade_until = t + 200;
+                r.shades++;
+            }
+            if (t < shade_until)
+                lux *= 0.3;
+            clux = seg.status == OPT3001_STATUS_NORMAL ? (u32)(lux * 100 + 0.5) : 0;
+
+            if (!Screen_Update(0, clux, seg.status, t, &ev) || t < kWarmupMs)
+                continue;
+            // 匹配最近一个已发生、尚未匹配且类型相同的真值变化
+            Transition *hit = nullptr;
+            for (Transition &tr : truth) {
+                if (tr.at_ms <= t && !tr.seen && tr.to == ev.to)
+                    hit = &tr;
+            }
+            if (hit == nullptr || t - hit->at_ms > SCREEN_DWELL_MS + SCREEN_FAULT_DWELL_MS + 2 * u.period_ms) {
+                r.false_events++;
+                std::fprintf(stderr, "  %s：%u ms 误报 %s -> %s\n", u.name, (unsigned)t, Screen_StateName(ev.from),
+                             Screen_StateName(ev.to));
+                continue;
+            }
+            hit->seen = true;
+            {
+                u32 dwell = ev.to == SCREEN_FAULT ? SCREEN_FAULT_DWELL_MS : SCREEN_DWELL_MS;
+                u32 latency = t - hit->at_ms;
+
+                if (latency > dwell + 2 * u.period_ms)
+                    r.missed++;
+                // 事件的起始时刻：候选状态首次出现，即真值变化后的第一个样本
+                if (ev.stamp_ms < hit->at_ms || ev.stamp_ms - hit->at_ms >= u.period_ms)
+                    r.wrong_onset++;
+                latency_sum += latency;
+                matched++;
+                if (latency > r.max_latency)
+                    r.max_latency = latency;
+            }
+        }
+        seg_start += seg.ms;
+    }
+    for (const Transition &tr : truth) {
+        r.transitions++;
+        if (!tr.seen)
+            r.missed++;
+    }
+    r.mean_latency = matched ? (double)latency_sum / matched : -1;
+    return r;
+}
+
+}
+
+int main()
+{
+    std::mt19937 rng(2026);
+    u32 total_transitions = 0, total_false = 0;
+
+    std::printf("  屏幕      周期(ms)  状态变化  漏报  误报  起点错  遮挡  平均延迟(ms)  最大延迟(ms)\n");
+    for (const Unit &u : kUnits) {
+        Result r = replay(u, rng);
+        Screen_InfoTypeDef info;
+
+        Screen_GetInfo(0, &info);
+        std::printf("  %-8s %8u  %8u  %4u  %4u  %6u  %4u  %12.0f  %12.0f   基线 %.2f/%.0f lux\n", u.name,
+                    (unsigned)u.period_ms, (unsigned)r.transitions, (unsigned)r.missed, (unsigned)r.false_events,
+                    (unsigned)r.wrong_onset, (unsigned)r.shades, r.mean_latency, r.max_latency, info.off_base / 100.0,
+                    info.on_base / 100.0);
+        CHECK_MSG(r.missed == 0, "%s: %u missed", u.name, (unsigned)r.missed);
+        CHECK_MSG(r.false_events == 0, "%s: %u false", u.name, (unsigned)r.false_events);
+        CHECK_MSG(r.wrong_onset == 0, "%s: %u wrong onset", u.name, (unsigned)r.wrong_onset);
+        CHECK(r.transitions >= 20);
+        total_transitions += r.transitions;
+        total_false += r.false_events;
+    }
+    std::printf("  合计 %u 次状态变化，误报 %u 次\n", (unsigned)total_transitions, (unsigned)total_false);
+
+    return sim_test_result("screen_state");
+}
@@ -0,0 +1,259 @@
+// 周期统计汇总的数值精度：按固定种子生成多种光照分布（室内噪声、全量程大值、亮灭屏双峰、
+// 单调爬升、常数、带尖峰），样本数3~60000，Stats_Add累加后Stats_Close的结果与两遍法精确批量统计比较：
+// 样本数/最小/最大/各状态计数完全一致，均值与标准差只差整数截断；P²分位数以“估计值在样本中的秩”衡量，
+// 与浮点P²参照相差不超过0.5%，不足5个样本时按最近秩精确。短周期逐段关闭时长周期不受影响
+#include "sim_test.h"
+
+#include "stats_rollup.h"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+namespace {
+
+const double kProb[STATS_QUANTILES] = { 0.05, 0.50, 0.95 };
+
+struct Batch {
+    u32 count, min, max;
+    double mean, stddev;
+    std::vector<u32> sorted;
+};
+
+// 两遍法：先求均值再求偏差平方和，long double避免相消
+Batch exact(const std::vector<u32> &v)
+{
+    Batch b;
+    long double sum = 0, ss = 0;
+
+    b.count = (u32)v.size();
+    b.sorted = v;
+    std::sort(b.sorted.begin(), b.sorted.end());
+    b.min = b.sorted.front();
+    b.max = b.sorted.back();
+    for (u32 x : v)
+        sum += x;
+    b.mean = (double)(sum / v.size());
+    for (u32 x : v)
+        ss += (x - (long double)b.mean) * (x - (long double)b.mean);
+    b.stddev = v.size() > 1 ? (double)std::sqrt(ss / (v.size() - 1)) : 0;
+    return b;
+}
+
+// 估计值在样本中的经验分位（≤它的样本比例与<它的样本比例之间取最接近p的一点）
+double rank_error(const Batch &b, u32 est, double p)
+{
+    double lo = (double)(std::lower_bound(b.sorted.begin(), b.sorted.end(), est) - b.sorted.begin()) / b.count;
+    double hi = (double)(std::upper_bound(b.sorted.begin(), b.sorted.end(), est) - b.sorted.begin()) / b.count;
+
+    if (p < lo)
+        return lo - p;
+    if (p > hi)
+        return p - hi;
+    return 0;
+}
+
+// 参照：浮点P²（Jain & Chlamtac 1985原文算法），用来区分算法本身的偏差与整数实现的误差
+double p2_reference(const std::vector<u32> &v, double p)
+{
+    double q[5], n[5], want[5], dn[5] = { 0, p / 2, p, (1 + p) / 2, 1 };
+    size_t k;
+
+    if (v.size() < 5)
+        return -1;
+    for (int i = 0; i < 5; i++)
+        q[i] = v[i];
+    std::sort(q, q + 5);
+    for (int i = 0; i < 5; i++) {
+        n[i] = i + 1;
+        want[i] = 1 + 4 * dn[i];
+    }
+    for (size_t j = 5; j < v.size(); j++) {
+        double x = v[j];
+
+        if (x < q[0]) {
+            q[0] = x;
+            k = 0;
+        } else if (x >= q[4]) {
+            q[4] = x;
+            k = 3;
+        } else {
+            for (k = 0; k < 3 && x >= q[k + 1]; k++)
+                ;
+        }
+        for (size_t i = k + 1; i < 5; i++)
+            n[i]++;
+        for (int i = 0; i < 5; i++)
+            want[i] += dn[i];
+        for (int i = 1; i < 4; i++) {
+            double d = want[i] - n[i];
+
+            if ((d >= 1 && n[i + 1] - n[i] > 1) || (d <= -1 && n[i - 1] - n[i] < -1)) {
+                double s = d > 0 ? 1 : -1;
+                double y = q[i] + s / (n[i + 1] - n[i - 1]) *
+                                      ((n[i] - n[i - 1] + s) * (q[i + 1] - q[i]) / (n[i + 1] - n[i]) +
+                                       (n[i + 1] - n[i] - s) * (q[i] - q[i - 1]) / (n[i] - n[i - 1]));
+                if (q[i - 1] < y && y < q[i + 1])
+                    q[i] = y;
+                else
+                    q[i] += s * (q[i + (int)s] - q[i]) / (n[i + (int)s] - n[i]);
+                n[i] += s;
+            }
+        }
+    }
+    return q[2];
+}
+
+enum Shape { INDOOR, FULL_SCALE, BIMODAL, RAMP, CONSTANT, SPIKES, SHAPES };
+const char *const kShapeName[SHAPES] = { "室内噪声", "全量程", "亮灭双峰", "爬升", "常数", "尖峰" };
+
+std::vector<u32> make(Shape shape, u32 n, std::mt19937 &rng)
+{
+    std::normal_distribution<double> noise(0, 1);
+    std::vector<u32> v(n);
+
+    for (u32 i = 0; i < n; i++) {
+        double x;
+
+        switch (shape) {
+        case INDOOR:                    // 300lux ±2%
+            x = 30000 + 600 * noise(rng);
+            break;
+        case FULL_SCALE:                // 接近OPT3001满量程83865lux
+            x = 8000000 + 200000 * noise(rng);
+            break;
+        case BIMODAL:                   // 30%时间灭屏5lux，其余600lux
+            x = rng() % 10 < 3 ? 500 + 20 * noise(rng) : 60000 + 1500 * noise(rng);
+            break;
+        case RAMP:
+            x = 1000 + 7.0 * i;
+            break;
+        case CONSTANT:
+            x = 12345;
+            break;
+        default:                        // 室内噪声上每50个样本一个20倍尖峰
+            x = (i % 50 == 7 ? 600000 : 30000) + 300 * noise(rng);
+            break;
+        }
+        v[i] = (u32)std::max(0.0, std::min(x, 8386560.0));
+    }
+    return v;
+}
+
+}
+
+int main()
+{
+    const u32 sizes[] = { 1, 2, 3, 4, 5, 6, 10, 100, 1000, 10000, 60000 };
+    std::mt19937 rng(42);
+    double worst_mean = 0, worst_sd_rel = 0, worst_rank[STATS_QUANTILES] = { 0 },
+           worst_ref[STATS_QUANTILES] = { 0 };
+
+    std::printf("  分布      样本数   均值误差  标准差误差  p5秩误差  p50秩误差  p95秩误差\n");
+    for (int s = 0; s < SHAPES; s++) {
+        for (u32 n : sizes) {
+            std::vector<u32> v = make((Shape)s, n, rng);
+            Batch b = exact(v);
+            Stats_RollupTypeDef r;
+            double mean_err, sd_err, rank[STATS_QUANTILES];
+
+            Stats_Init();
+            for (u32 x : v)
+                Stats_Add(0, x, 0);
+            Stats_Close(0, 0, &r);
+
+            CHECK(r.count == n && r.min == b.min && r.max == b.max);
+            CHECK(r.status[0] == n && r.status[1] == 0 && r.status[2] == 0 && r.status[3] == 0);
+            // 均值：偏移量上的整数除法截断，误差小于1（0.01lux）
+            mean_err = std::fabs(r.mean - b.mean);
+            CHECK_MSG(mean_err < 1.0, "%s n=%u: mean %u vs %.3f", kShapeName[s], (unsigned)n, (unsigned)r.mean,
+                      b.mean);
+            // 标准差：截断的均值带来的方差误差不超过|Σd|/(n-1)，再加开方取整
+            sd_err = std::fabs(r.stddev - b.stddev);
+            CHECK_MSG(sd_err <= 1.0 + b.stddev * 1e-6, "%s n=%u: sd %u vs %.3f", kShapeName[s], (unsigned)n,
+                      (unsigned)r.stddev, b.stddev);
+            worst_mean = std::max(worst_mean, mean_err);
+            if (b.stddev > 0)
+                worst_sd_rel = std::max(worst_sd_rel, sd_err / b.stddev);
+
+            for (int j = 0; j < STATS_QUANTILES; j++) {
+                rank[j] = rank_error(b, r.quantile[j], kProb[j]);
+                // 不足5个样本：最近秩，估计值就是排序后的某个样本
+                if (n < 5)
+                    CHECK(r.quantile[j] == b.sorted[(u32)((n - 1) * kProb[j] + 0.5)]);
+                // 样本数足够时：整数实现与浮点P²的秩偏差相差不超过0.5%，P²本身不超过5%
+                // （尖峰分布上p50的标记被抛物线插值拉偏，浮点实现同样如此）
+                if (n >= 1000) {
+                    double ref = rank_error(b, (u32)(p2_reference(v, kProb[j]) + 0.5), kProb[j]);
+
+                    CHECK_MSG(rank[j] <= ref + 0.005 && rank[j] <= 0.05, "%s n=%u p%.0f: %u rank error %.3f (ref %.3f)",
+                              kShapeName[s], (unsigned)n, kProb[j] * 100, (unsigned)r.quantile[j], rank[j], ref);
+                    worst_rank[j] = std::max(worst_rank[j], rank[j]);
+                    worst_ref[j] = std::max(worst_ref[j], ref);
+                }
+                // 估计值总在样本范围内
+                CHECK(r.quantile[j] >= b.min && r.quantile[j] <= b.max);
+            }
+            if (n >= 1000 || n == 10)
+                std::printf("  %-8s %7u  %8.3f  %10.3f  %8.3f  %9.3f  %9.3f\n", kShapeName[s], (unsigned)n,
+                            mean_err, sd_err, rank[0], rank[1], rank[2]);
+        }
+    }
+    std::printf("  最大误差：均值 %.3f（0.01lux），标准差 %.2e（相对），分位秩 %.3f/%.3f/%.3f（浮点P² %.3f/%.3f/%.3f）\n",
+                worst_mean, worst_sd_rel, worst_rank[0], worst_rank[1], worst_rank[2], worst_ref[0], worst_ref[1],
+                worst_ref[2]);
+
+    // 状态计数与两级周期：异常样本只计数，不进入数值统计；每1000个样本关闭一次短周期，
+    // 长周期仍对全部样本给出与批量统计相同的结果
+    {
+        std::vector<u32> all, chunk;
+        u32 status_count[STATS_STATUS_COUNT] = { 0 }, short_status[STATS_STATUS_COUNT] = { 0 };
+        u32 mismatched_short = 0;
+        Stats_RollupTypeDef r;
+
+        Stats_Init();
+        for (u32 i = 0; i < 20000; i++) {
+            u32 x = 30000 + rng() % 2000;
+            u8 st = rng() % 10 < 8 ? 0 : 1 + rng() % 3;
+
+            Stats_Add(3, st == 0 ? x : 9999999, st);
+            status_count[st]++;
+            short_status[st]++;
+            if (st == 0) {
+                all.push_back(x);
+                chunk.push_back(x);
+            }
+            if (i % 1000 == 999) {
+                Batch b = exact(chunk);
+                Stats_Close(0, 3, &r);
+                if (r.count != b.count || r.min != b.min || r.max != b.max || std::fabs(r.mean - b.mean) >= 1.0)
+                    mismatched_short++;
+                for (int k = 0; k < STATS_STATUS_COUNT; k++)
+                    if (r.status[k] != short_status[k])
+                        mismatched_short++;
+                std::fill(short_status, short_status + STATS_STATUS_COUNT, 0);
+                chunk.clear();
+            }
+        }
+        CHECK_MSG(mismatched_short == 0, "%u short-interval mismatches", (unsigned)mismatched_short);
+
+        Batch b = exact(all);
+        Stats_Close(1, 3, &r);
+        CHECK(r.sensor == 3 && r.level == 1);
+        CHECK(r.count == b.count && r.min == b.min && r.max == b.max);
+        CHECK(std::fabs(r.mean - b.mean) < 1.0 && std::fabs(r.stddev - b.stddev) <= 1.0);
+        for (int k = 0; k < STATS_STATUS_COUNT; k++)
+            CHECK(r.status[k] == status_count[k]);
+        for (int j = 0; j < STATS_QUANTILES; j++)
+            CHECK(rank_error(b, r.quantile[j], kProb[j]) <= 0.02);
+
+        // 关闭后累加器清空；其他传感器不受影响
+        Stats_Close(1, 3, &r);
+        CHECK(r.count == 0 && r.status[0] == 0 && r.mean == 0);
+        Stats_Close(1, 2, &r);
+        CHECK(r.count == 0);
+    }
+
+    return sim_test_result("stats_rollup");
+}
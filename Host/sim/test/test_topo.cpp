@@ -0,0 +1,99 @@
+// 拓扑缓存：两条总线上的虚拟OPT3001，新芯片首次发现写入Flash，再次上电命中缓存；
+// 新接入（缓存外候选地址有应答）、掉线与topo命令清除缓存都回到按候选地址重新发现
+#include "sim_core.h"
+#include "sim_opt3001.h"
+#include "sim_test.h"
+
+#include "delay.h"
+#include "opt3001.h"
+#include "opt3001_topo.h"
+
+namespace {
+
+// 第二条总线：PA0=SCL，PA1=SDA
+const OPT3001_BusTypeDef kBusA = { 0, GPIOA, GPIO_Pin_0, GPIO_Pin_1, RCC_APB2Periph_GPIOA };
+const OPT3001_BusTypeDef *const kBuses[] = { &OPT3001_DefaultBus, &kBusA };
+
+OPT3001_HandleTypeDef g_sensors[OPT3001_MAX_SENSORS];
+double g_discover_us;
+
+u8 discover()
+{
+    uint64_t t0 = sim::now();
+    u8 n = OPT3001_Topo_Discover(kBuses, 2, g_sensors, OPT3001_MAX_SENSORS);
+
+    g_discover_us = sim::cycles_to_us(sim::now() - t0);
+    return n;
+}
+
+bool found(u8 n, const OPT3001_BusTypeDef *bus, u8 addr)
+{
+    for (u8 i = 0; i < n; i++)
+        if (g_sensors[i].bus == bus && g_sensors[i].addr == addr && g_sensors[i].id == i)
+            return true;
+    return false;
+}
+
+}
+
+int main()
+{
+    sim::Opt3001 b44(0x44), a46(0x46), b45(0x45);
+    double miss_us, hit_us;
+    u8 n;
+
+    b44.attach_wire(OPT3001_IIC_PORT, OPT3001_IIC_SCL_PIN, OPT3001_IIC_SDA_PIN);
+    a46.attach_wire(GPIOA, GPIO_Pin_0, GPIO_Pin_1);
+    b45.attach_wire(OPT3001_IIC_PORT, OPT3001_IIC_SCL_PIN, OPT3001_IIC_SDA_PIN);
+    b45.present = false;
+    SysTick_Init();
+    DWT_Init();
+    OPT3001_Bus_Init(&OPT3001_DefaultBus);
+    OPT3001_Bus_Init(&kBusA);
+    sim::flash_erase_all();
+
+    // 新芯片：缓存为空，按候选地址读ID，结果写入Flash最后一页
+    n = discover();
+    miss_us = g_discover_us;
+    CHECK(n == 2 && !OPT3001_Topo_CacheHit());
+    CHECK(found(n, &OPT3001_DefaultBus, 0x44) && found(n, &kBusA, 0x46));
+    CHECK(((const OPT3001_TopoTypeDef *)OPT3001_TOPO_FLASH_ADDR)->magic == OPT3001_TOPO_MAGIC);
+
+    // 再次上电：命中缓存，顺序与编号不变，总线时间更短
+    n = discover();
+    hit_us = g_discover_us;
+    CHECK(n == 2 && OPT3001_Topo_CacheHit());
+    CHECK(found(n, &OPT3001_DefaultBus, 0x44) && found(n, &kBusA, 0x46));
+    CHECK_MSG(hit_us < miss_us, "hit %.0fus, miss %.0fus", hit_us, miss_us);
+    std::printf("发现耗时：重新发现 %.0f us，缓存命中 %.0f us\n", miss_us, hit_us);
+
+    // 新接入0x45：缓存外的候选地址应答，转入重新发现并更新缓存
+    b45.present = true;
+    n = discover();
+    CHECK(n == 3 && !OPT3001_Topo_CacheHit());
+    CHECK(found(n, &OPT3001_DefaultBus, 0x45));
+    n = discover();
+    CHECK(n == 3 && OPT3001_Topo_CacheHit());
+
+    // 缓存中的传感器掉线：ID核对失败，重新发现只剩在线的
+    a46.present = false;
+    n = discover();
+    CHECK(n == 2 && !OPT3001_Topo_CacheHit());
+    CHECK(!found(n, &kBusA, 0x46));
+    a46.present = true;
+
+    // 全部掉线：不覆盖Flash中的有效记录，重新接好后直接命中
+    b44.present = b45.present = a46.present = false;
+    CHECK(discover() == 0);
+    b44.present = b45.present = true;
+    n = discover();
+    CHECK(n == 2 && OPT3001_Topo_CacheHit());
+
+    // topo命令：清除缓存，下次重新发现
+    OPT3001_Topo_Invalidate();
+    CHECK(((const OPT3001_TopoTypeDef *)OPT3001_TOPO_FLASH_ADDR)->magic == 0xFFFFFFFF);
+    n = discover();
+    CHECK(n == 2 && !OPT3001_Topo_CacheHit());
+
+    return sim_test_result("topo");
+}
@@ -0,0 +1,132 @@
+// USART1 DMA双缓冲发送：9600bps下每个样本一行文本（与main.c的样本行相同），
+// 对比原fputc逐字节等待TXE时主循环被占用的时间与写入双缓冲的时间；
+// 100ms一个样本连续输出不丢字节且线上顺序不变，两块缓冲都满时限时等待、超时丢弃并计数
+#include "sim_core.h"
+#include "sim_test.h"
+
+#include "delay.h"
+#include "usart1_dma.h"
+
+#include <cstring>
+#include <string>
+
+namespace {
+
+const u32 kBaud = 9600;
+
+void usart1_init()
+{
+    USART_InitTypeDef init;
+
+    RCC_APB2PeriphClockCmd(RCC_APB2Periph_USART1 | RCC_APB2Periph_GPIOA, ENABLE);
+    init.USART_BaudRate = kBaud;
+    init.USART_WordLength = USART_WordLength_8b;
+    init.USART_StopBits = USART_StopBits_1;
+    init.USART_Parity = USART_Parity_No;
+    init.USART_HardwareFlowControl = USART_HardwareFlowControl_None;
+    init.USART_Mode = USART_Mode_Tx | USART_Mode_Rx;
+    USART_Init(USART1, &init);
+    USART_Cmd(USART1, ENABLE);
+}
+
+// 改造前的fputc：写DR后等待TXE
+void blocking_puts(const std::string &s)
+{
+    for (char c : s) {
+        USART_SendData(USART1, (u8)c);
+        while (USART_GetFlagStatus(USART1, USART_FLAG_TXE) == RESET)
+            ;
+    }
+}
+
+bool tx_complete()
+{
+    return USART_GetFlagStatus(USART1, USART_FLAG_TC) == SET;
+}
+
+std::string sample_line(int i)
+{
+    char buf[96];
+
+    std::snprintf(buf, sizeof buf, "传感器0 当前光照强度：%d.%02d lux（正常，间隔100 ms）\r\n", 300 + i, i % 100);
+    return buf;
+}
+
+}
+
+int main()
+{
+    const double byte_us = 10e6 / kBaud;
+    std::string line = sample_line(0), expect;
+    double blocking_us, dma_us, worst_us = 0, burst_us;
+    uint64_t t0, next;
+    u16 written;
+    int i;
+
+    SysTick_Init();
+    DWT_Init();
+    usart1_init();
+
+    // 改造前：一行文本占用主循环约(字节数-1)个字节时间（最后一个字节进入移位寄存器即返回）
+    t0 = sim::now();
+    blocking_puts(line);
+    blocking_us = sim::cycles_to_us(sim::now() - t0);
+    CHECK(sim::advance_until(tx_complete, sim::ms_to_cycles(10)) == 0);
+    CHECK(sim::uart_output() == line);
+    sim::uart_clear_output();
+
+    // 改造后：100ms一个样本，写入双缓冲后立即返回，DMA在后台发送
+    USART1_DMA_Init();
+    next = sim::now();
+    for (i = 0; i < 20; i++) {
+        std::string s = sample_line(i);
+        double us;
+
+        sim::advance(next - sim::now());
+        t0 = sim::now();
+        CHECK(USART1_DMA_Write((const u8 *)s.data(), (u16)s.size()) == s.size());
+        us = sim::cycles_to_us(sim::now() - t0);
+        if (us > worst_us)
+            worst_us = us;
+        expect += s;
+        next += sim::ms_to_cycles(100);
+    }
+    dma_us = worst_us;
+    CHECK(USART1_DMA_Flush(200000) == 0);
+    CHECK_MSG(sim::uart_output() == expect, "got %u bytes, expected %u", (unsigned)sim::uart_output().size(),
+              (unsigned)expect.size());
+    CHECK(USART1_DMA_GetDropped() == 0 && USART1_DMA_Pending() == 0);
+
+    std::printf("  每样本一行 %u 字节，9600bps线上 %.1f ms\n", (unsigned)line.size(), line.size() * byte_us / 1000);
+    std::printf("  主循环占用：逐字节等待TXE %.0f us，DMA双缓冲 %.1f us（最坏）\n", blocking_us, dma_us);
+    CHECK_MSG(blocking_us >= (line.size() - 1) * byte_us - 1, "blocking %.0fus", blocking_us);
+    CHECK_MSG(dma_us < 50, "dma %.1fus", dma_us);
+
+    // 背压：一次写入超过两块缓冲，等待上限后丢弃其余字节并计数；已接受的字节原样发出
+    {
+        std::string burst(600, 'x');
+
+        for (i = 0; i < (int)burst.size(); i++)
+            burst[i] = (char)('A' + i % 26);
+        sim::uart_clear_output();
+        t0 = sim::now();
+        written = USART1_DMA_Write((const u8 *)burst.data(), (u16)burst.size());
+        burst_us = sim::cycles_to_us(sim::now() - t0);
+        std::printf("  一次写入600字节：接受 %u，丢弃 %u，等待 %.0f ms\n", (unsigned)written,
+                    (unsigned)USART1_DMA_GetDropped(), burst_us / 1000);
+        CHECK(written < burst.size() && written >= 2 * USART1_DMA_BUF_SIZE);
+        CHECK(USART1_DMA_GetDropped() == burst.size() - written);
+        // micros()按整微秒计，等待时间可比上限少不足1us
+        CHECK_MSG(burst_us + 1 >= USART1_DMA_WAIT_US && burst_us <= USART1_DMA_WAIT_US + 2 * byte_us,
+                  "waited %.0fus", burst_us);
+        CHECK(USART1_DMA_Flush(500000) == 0);
+        CHECK(sim::uart_output() == burst.substr(0, written));
+    }
+
+    // 刷新超时：发送未完成时按给定时间返回1
+    CHECK(USART1_DMA_Write((const u8 *)line.data(), (u16)line.size()) == line.size());
+    CHECK(USART1_DMA_Flush(1000) == 1);
+    CHECK(USART1_DMA_Flush(200000) == 0);
+
+    return sim_test_result("usart_dma");
+}
@@ -0,0 +1,185 @@
+#include "telemetry_decoder.h"
+
+namespace telemetry {
+
+namespace {
+constexpr std::size_t kMaxChunk = 512;  // 超长的段只可能是文本，截断保存
+
+uint32_t get24(const uint8_t *p)
+{
+    return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) | (static_cast<uint32_t>(p[2]) << 16);
+}
+
+uint32_t get32(const uint8_t *p)
+{
+    return get24(p) | (static_cast<uint32_t>(p[3]) << 24);
+}
+
+uint16_t get16(const uint8_t *p)
+{
+    return static_cast<uint16_t>(p[0] | (p[1] << 8));
+}
+
+bool crc_ok(const std::vector<uint8_t> &frame)
+{
+    std::size_t n = frame.size() - 2;
+    return crc16(frame.data(), n) == get16(&frame[n]);
+}
+}  // namespace
+
+uint16_t crc16(const uint8_t *data, std::size_t len)
+{
+    uint16_t crc = 0xFFFF;
+    for (std::size_t i = 0; i < len; ++i) {
+        crc ^= static_cast<uint16_t>(data[i]) << 8;
+        for (int b = 0; b < 8; ++b)
+            crc = (crc & 0x8000) ? static_cast<uint16_t>((crc << 1) ^ 0x1021) : static_cast<uint16_t>(crc << 1);
+    }
+    return crc;
+}
+
+bool cobs_decode(const uint8_t *in, std::size_t len, std::vector<uint8_t> &out)
+{
+    out.clear();
+    std::size_t i = 0;
+    while (i < len) {
+        uint8_t code = in[i++];
+        if (code == 0 || i + code - 1 > len)
+            return false;
+        for (uint8_t k = 1; k < code; ++k)
+            out.push_back(in[i++]);
+        if (code < 0xFF && i < len)
+            out.push_back(0);
+    }
+    return true;
+}
+
+bool parse_frame(const std::vector<uint8_t> &frame, Sample &sample)
+{
+    if (frame.size() != kFrameLen || !crc_ok(frame))
+        return false;
+    if ((frame[9] >> 6) != kTypeSample)
+        return false;
+
+    sample.seq = get16(&frame[0]);
+    sample.stamp_us = get32(&frame[2]);
+    sample.clux = get24(&frame[6]);
+    sample.status = (frame[9] >> 3) & 0x07;
+    sample.sensor = frame[9] & 0x07;
+    return true;
+}
+
+bool parse_rollup(const std::vector<uint8_t> &frame, Rollup &rollup)
+{
+    if (frame.size() != kRollupFrameLen || !crc_ok(frame))
+        return false;
+    if ((frame[0] >> 6) != kTypeRollup)
+        return false;
+
+    rollup.sensor = frame[0] & 0x07;
+    rollup.level = (frame[0] >> 3) & 0x07;
+    rollup.stamp_ms = get32(&frame[1]);
+    rollup.count = get16(&frame[5]);
+    rollup.min = get24(&frame[7]);
+    rollup.max = get24(&frame[10]);
+    rollup.mean = get24(&frame[13]);
+    rollup.stddev = get24(&frame[16]);
+    rollup.p5 = get24(&frame[19]);
+    rollup.p50 = get24(&frame[22]);
+    rollup.p95 = get24(&frame[25]);
+    for (int i = 0; i < 4; ++i)
+        rollup.status[i] = get16(&frame[28 + i * 2]);
+    return true;
+}
+
+bool parse_state(const std::vector<uint8_t> &frame, ScreenEvent &event)
+{
+    if (frame.size() != kStateFrameLen || !crc_ok(frame))
+        return false;
+    uint8_t type = frame[0] >> 6;
+    if (type != kTypeEvent && type != kTypeHeartbeat)
+        return false;
+
+    event.heartbeat = type == kTypeHeartbeat;
+    event.sensor = frame[0] & 0x07;
+    event.stamp_ms = get32(&frame[1]);
+    event.from = frame[5] >> 4;
+    event.to = frame[5] & 0x0F;
+    event.duration_ms = get32(&frame[6]);
+    event.clux = get24(&frame[10]);
+    event.off_base = get24(&frame[13]);
+    event.on_base = get24(&frame[16]);
+    return true;
+}
+
+const char *screen_state_name(uint8_t state)
+{
+    switch (static_cast<ScreenState>(state)) {
+    case ScreenState::Off: return "off";
+    case ScreenState::Dim: return "dim";
+    case ScreenState::On: return "on";
+    case ScreenState::Fault: return "fault";
+    default: return "unknown";
+    }
+}
+
+void Decoder::feed(const uint8_t *data, std::size_t len)
+{
+    for (std::size_t i = 0; i < len; ++i) {
+        if (data[i] == 0) {
+            finish_chunk();
+            continue;
+        }
+        if (chunk_.size() < kMaxChunk)
+            chunk_.push_back(data[i]);
+    }
+}
+
+bool Decoder::looks_like_text(const std::vector<uint8_t> &chunk)
+{
+    for (uint8_t c : chunk) {
+        if (c < 0x20 && c != '\r' && c != '\n' && c != '\t')
+            return false;
+    }
+    return true;
+}
+
+void Decoder::finish_chunk()
+{
+    if (chunk_.empty())
+        return;
+
+    Sample sample;
+    Rollup rollup;
+    ScreenEvent event;
+    bool decoded = cobs_decode(chunk_.data(), chunk_.size(), frame_);
+    if (decoded && parse_rollup(frame_, rollup)) {
+        ++stats_.rollups;
+        if (rollup_handler_)
+            rollup_handler_(rollup);
+    } else if (decoded && parse_state(frame_, event)) {
+        ++(event.heartbeat ? stats_.heartbeats : stats_.events);
+        if (event_handler_)
+            event_handler_(event);
+    } else if (decoded && parse_frame(frame_, sample)) {
+        ++stats_.frames;
+        if (have_seq_ && sample.seq != next_seq_)
+            stats_.lost += static_cast<uint16_t>(sample.seq - next_seq_);
+        have_seq_ = true;
+        next_seq_ = static_cast<uint16_t>(sample.seq + 1);
+        if (sample_handler_)
+            sample_handler_(sample);
+    } else if (looks_like_text(chunk_)) {
+        ++stats_.text_chunks;
+        if (text_handler_)
+            text_handler_(std::string(chunk_.begin(), chunk_.end()));
+    } else if (decoded && (frame_.size() == kFrameLen || frame_.size() == kRollupFrameLen ||
+                           frame_.size() == kStateFrameLen)) {
+        ++stats_.crc_errors;
+    } else {
+        ++stats_.cobs_errors;
+    }
+    chunk_.clear();
+}
+
+}  // namespace telemetry
@@ -0,0 +1,130 @@
+// 显示屏监测下位机二进制遥测帧解码（与 STM32/Hardware/telemetry.h 的帧格式对应）
+#ifndef TELEMETRY_DECODER_H
+#define TELEMETRY_DECODER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace telemetry {
+
+// 帧类型由帧长区分，再以类型位复核
+constexpr std::size_t kPayloadLen = 10;
+constexpr std::size_t kFrameLen = kPayloadLen + 2;
+constexpr std::size_t kRollupPayloadLen = 36;
+constexpr std::size_t kRollupFrameLen = kRollupPayloadLen + 2;
+constexpr uint8_t kTypeSample = 0;
+constexpr std::size_t kStatePayloadLen = 19;
+constexpr std::size_t kStateFrameLen = kStatePayloadLen + 2;
+constexpr uint8_t kTypeRollup = 1;
+constexpr uint8_t kTypeEvent = 2;
+constexpr uint8_t kTypeHeartbeat = 3;
+
+// 传感器状态（与 OPT3001_StatusTypeDef 对应）
+enum class Status : uint8_t { Normal = 0, CommErr = 1, RangeErr = 2, JumpErr = 3 };
+
+struct Sample {
+    uint16_t seq = 0;       // 入队序号
+    uint32_t stamp_us = 0;  // 下位机 micros() 时间戳（约71分钟回绕）
+    uint32_t clux = 0;      // 光照（0.01lux）
+    uint8_t status = 0;
+    uint8_t sensor = 0;
+
+    double lux() const { return clux / 100.0; }
+};
+
+// 每个统计周期每个传感器一条汇总（光照单位0.01lux）
+struct Rollup {
+    uint8_t sensor = 0;
+    uint8_t level = 0;          // 0：短周期（1s），1：长周期（1min）
+    uint32_t stamp_ms = 0;      // 周期结束时刻（下位机 millis()）
+    uint16_t count = 0;         // 状态正常、参与数值统计的样本数
+    uint32_t min = 0;
+    uint32_t max = 0;
+    uint32_t mean = 0;
+    uint32_t stddev = 0;        // 样本标准差
+    uint32_t p5 = 0;
+    uint32_t p50 = 0;
+    uint32_t p95 = 0;
+    uint16_t status[4] = {0, 0, 0, 0};   // 各 Status 的样本数
+
+    double variance() const { return static_cast<double>(stddev) * stddev; }
+};
+
+// 屏幕状态（与 Screen_StateTypeDef 对应）
+enum class ScreenState : uint8_t { Unknown = 0, Off = 1, Dim = 2, On = 3, Fault = 4 };
+
+// 屏幕状态变化事件或状态心跳（光照单位0.01lux）
+struct ScreenEvent {
+    bool heartbeat = false;
+    uint8_t sensor = 0;
+    uint32_t stamp_ms = 0;      // 事件：新状态首次出现时刻；心跳：发送时刻（下位机 millis()）
+    uint8_t from = 0;           // 心跳时与 to 相同
+    uint8_t to = 0;
+    uint32_t duration_ms = 0;   // 事件：确认用时；心跳：已处于当前状态的时长
+    uint32_t clux = 0;
+    uint32_t off_base = 0;      // 熄屏基线
+    uint32_t on_base = 0;       // 亮屏基线
+};
+
+struct Stats {
+    uint64_t frames = 0;        // 解码成功的样本帧
+    uint64_t rollups = 0;       // 解码成功的汇总帧
+    uint64_t events = 0;        // 屏幕状态变化事件帧
+    uint64_t heartbeats = 0;    // 状态心跳帧
+    uint64_t crc_errors = 0;    // CRC错误
+    uint64_t cobs_errors = 0;   // COBS格式错误/长度不符
+    uint64_t lost = 0;          // 按序号推算的丢失样本数
+    uint64_t text_chunks = 0;   // 夹在帧之间的调试文本段
+};
+
+// CRC16-CCITT（多项式0x1021，初值0xFFFF）
+uint16_t crc16(const uint8_t *data, std::size_t len);
+
+// COBS解码一段不含分隔符的数据，格式错误返回false
+bool cobs_decode(const uint8_t *in, std::size_t len, std::vector<uint8_t> &out);
+
+// 解析一帧（COBS解码后的数据），长度、CRC或类型不符返回false
+bool parse_frame(const std::vector<uint8_t> &frame, Sample &sample);
+bool parse_rollup(const std::vector<uint8_t> &frame, Rollup &rollup);
+bool parse_state(const std::vector<uint8_t> &frame, ScreenEvent &event);
+
+// 状态名（英文，用于CSV/终端）
+const char *screen_state_name(uint8_t state);
+
+// 流式解码器：按0x00切分，逐段解码；不是合法帧且全为可打印字符/换行的段按文本回调
+class Decoder {
+public:
+    using SampleHandler = std::function<void(const Sample &)>;
+    using RollupHandler = std::function<void(const Rollup &)>;
+    using EventHandler = std::function<void(const ScreenEvent &)>;
+    using TextHandler = std::function<void(const std::string &)>;
+
+    void on_sample(SampleHandler handler) { sample_handler_ = std::move(handler); }
+    void on_rollup(RollupHandler handler) { rollup_handler_ = std::move(handler); }
+    void on_event(EventHandler handler) { event_handler_ = std::move(handler); }
+    void on_text(TextHandler handler) { text_handler_ = std::move(handler); }
+
+    void feed(const uint8_t *data, std::size_t len);
+    const Stats &stats() const { return stats_; }
+
+private:
+    void finish_chunk();
+    static bool looks_like_text(const std::vector<uint8_t> &chunk);
+
+    std::vector<uint8_t> chunk_;
+    std::vector<uint8_t> frame_;
+    SampleHandler sample_handler_;
+    RollupHandler rollup_handler_;
+    EventHandler event_handler_;
+    TextHandler text_handler_;
+    Stats stats_;
+    bool have_seq_ = false;
+    uint16_t next_seq_ = 0;
+};
+
+}  // namespace telemetry
+
+#endif
@@ -0,0 +1,171 @@
+// 遥测帧转储工具：从串口设备、文件或标准输入读取下位机输出，逐行打印样本
+//   telemetry_dump [-b 波特率] [-c] [-q] [设备或文件，缺省为标准输入]
+//   -c  CSV输出（样本：S,seq,stamp_us,sensor,lux,status；
+//              汇总：R,stamp_ms,sensor,level,count,min,max,mean,stddev,p5,p50,p95,各状态计数；
+//              屏幕状态事件/心跳：E|H,stamp_ms,sensor,from,to,duration_ms,lux,off_base,on_base）
+//   -q  不打印夹在帧之间的调试文本
+#include "telemetry_decoder.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#include <fcntl.h>
+#include <termios.h>
+#include <unistd.h>
+
+namespace {
+
+const char *status_name(uint8_t status)
+{
+    switch (static_cast<telemetry::Status>(status)) {
+    case telemetry::Status::Normal:   return "normal";
+    case telemetry::Status::CommErr:  return "comm_err";
+    case telemetry::Status::RangeErr: return "range_err";
+    case telemetry::Status::JumpErr:  return "jump_pending";
+    }
+    return "unknown";
+}
+
+speed_t baud_constant(long baud)
+{
+    switch (baud) {
+    case 9600:   return B9600;
+    case 19200:  return B19200;
+    case 38400:  return B38400;
+    case 57600:  return B57600;
+    case 115200: return B115200;
+    case 230400: return B230400;
+    default:     return 0;
+    }
+}
+
+// 串口设为原始模式（8N1，无流控）；普通文件不做处理
+bool configure_tty(int fd, long baud)
+{
+    if (!isatty(fd))
+        return true;
+    speed_t speed = baud_constant(baud);
+    if (speed == 0) {
+        std::fprintf(stderr, "unsupported baud rate %ld\n", baud);
+        return false;
+    }
+    termios tio{};
+    if (tcgetattr(fd, &tio) != 0)
+        return false;
+    cfmakeraw(&tio);
+    tio.c_cflag |= CLOCAL | CREAD;
+    tio.c_cflag &= ~(CSTOPB | PARENB | CRTSCTS);
+    tio.c_cc[VMIN] = 1;
+    tio.c_cc[VTIME] = 0;
+    cfsetispeed(&tio, speed);
+    cfsetospeed(&tio, speed);
+    return tcsetattr(fd, TCSANOW, &tio) == 0;
+}
+
+void usage(const char *prog)
+{
+    std::fprintf(stderr, "usage: %s [-b baud] [-c] [-q] [device|file|-]\n", prog);
+}
+
+}  // namespace
+
+int main(int argc, char **argv)
+{
+    long baud = 9600;
+    bool csv = false;
+    bool quiet = false;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "b:cqh")) != -1) {
+        switch (opt) {
+        case 'b': baud = std::strtol(optarg, nullptr, 10); break;
+        case 'c': csv = true; break;
+        case 'q': quiet = true; break;
+        default:  usage(argv[0]); return opt == 'h' ? 0 : 2;
+        }
+    }
+
+    int fd = STDIN_FILENO;
+    if (optind < argc && std::strcmp(argv[optind], "-") != 0) {
+        fd = open(argv[optind], O_RDONLY | O_NOCTTY);
+        if (fd < 0) {
+            std::fprintf(stderr, "%s: %s\n", argv[optind], std::strerror(errno));
+            return 1;
+        }
+    }
+    if (!configure_tty(fd, baud))
+        return 1;
+
+    telemetry::Decoder decoder;
+    decoder.on_sample([csv](const telemetry::Sample &s) {
+        if (csv)
+            std::printf("S,%u,%lu,%u,%.2f,%s\n", s.seq, static_cast<unsigned long>(s.stamp_us), s.sensor,
+                        s.lux(), status_name(s.status));
+        else
+            std::printf("#%-5u %10.3f s  sensor %u  %10.2f lux  %s\n", s.seq, s.stamp_us / 1e6, s.sensor,
+                        s.lux(), status_name(s.status));
+        std::fflush(stdout);
+    });
+    decoder.on_rollup([csv](const telemetry::Rollup &r) {
+        if (csv)
+            std::printf("R,%lu,%u,%u,%u,%.2f,%.2f,%.2f,%.2f,%.2f,%.2f,%.2f,%u,%u,%u,%u\n",
+                        static_cast<unsigned long>(r.stamp_ms), r.sensor, r.level, r.count, r.min / 100.0,
+                        r.max / 100.0, r.mean / 100.0, r.stddev / 100.0, r.p5 / 100.0, r.p50 / 100.0,
+                        r.p95 / 100.0, r.status[0], r.status[1], r.status[2], r.status[3]);
+        else
+            std::printf("%10.3f s  sensor %u  %-4s n=%-5u min %.2f max %.2f mean %.2f sd %.2f "
+                        "p5/p50/p95 %.2f/%.2f/%.2f  status %u/%u/%u/%u\n",
+                        r.stamp_ms / 1e3, r.sensor, r.level ? "1min" : "1s", r.count, r.min / 100.0,
+                        r.max / 100.0, r.mean / 100.0, r.stddev / 100.0, r.p5 / 100.0, r.p50 / 100.0,
+                        r.p95 / 100.0, r.status[0], r.status[1], r.status[2], r.status[3]);
+        std::fflush(stdout);
+    });
+    decoder.on_event([csv](const telemetry::ScreenEvent &e) {
+        if (csv)
+            std::printf("%c,%lu,%u,%s,%s,%lu,%.2f,%.2f,%.2f\n", e.heartbeat ? 'H' : 'E',
+                        static_cast<unsigned long>(e.stamp_ms), e.sensor, telemetry::screen_state_name(e.from),
+                        telemetry::screen_state_name(e.to), static_cast<unsigned long>(e.duration_ms),
+                        e.clux / 100.0, e.off_base / 100.0, e.on_base / 100.0);
+        else if (e.heartbeat)
+            std::printf("%10.3f s  sensor %u  heartbeat %s for %.1f s  %.2f lux  baseline %.2f/%.2f\n",
+                        e.stamp_ms / 1e3, e.sensor, telemetry::screen_state_name(e.to), e.duration_ms / 1e3,
+                        e.clux / 100.0, e.off_base / 100.0, e.on_base / 100.0);
+        else
+            std::printf("%10.3f s  sensor %u  %s -> %s  confirmed in %lu ms  %.2f lux\n", e.stamp_ms / 1e3,
+                        e.sensor, telemetry::screen_state_name(e.from), telemetry::screen_state_name(e.to),
+                        static_cast<unsigned long>(e.duration_ms), e.clux / 100.0);
+        std::fflush(stdout);
+    });
+    if (!quiet) {
+        decoder.on_text([](const std::string &text) {
+            std::fputs(text.c_str(), stderr);
+        });
+    }
+
+    uint8_t buf[256];
+    for (;;) {
+        ssize_t n = read(fd, buf, sizeof(buf));
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            break;
+        decoder.feed(buf, static_cast<std::size_t>(n));
+    }
+    // 流结束时补一个分隔符，处理最后一段
+    const uint8_t delim = 0;
+    decoder.feed(&delim, 1);
+
+    const telemetry::Stats &st = decoder.stats();
+    std::fprintf(stderr, "frames %llu, rollups %llu, events %llu, heartbeats %llu, lost %llu, crc errors %llu, cobs errors %llu, text chunks %llu\n",
+                 static_cast<unsigned long long>(st.frames), static_cast<unsigned long long>(st.rollups),
+                 static_cast<unsigned long long>(st.events), static_cast<unsigned long long>(st.heartbeats),
+                 static_cast<unsigned long long>(st.lost),
+                 static_cast<unsigned long long>(st.crc_errors), static_cast<unsigned long long>(st.cobs_errors),
+                 static_cast<unsigned long long>(st.text_chunks));
+    if (fd != STDIN_FILENO)
+        close(fd);
+    return 0;
+}
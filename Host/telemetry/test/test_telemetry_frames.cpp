@@ -0,0 +1,223 @@
+// 遥测帧端到端：固件Telemetry_SendSample/SendRollup/SendEvent/SendHeartbeat经仿真USART1 DMA发出，
+// 线上字节交给主机端telemetry::Decoder解码，逐字段与发送内容比较（含24位光照饱和）；
+// 帧之间夹调试文本（按main.c的fputc输出）时文本段原样分离、前后帧不受影响；
+// 样本序号跳过3个时按丢失3个计数；改写一帧的一个CRC字节时记为CRC错误且不回调，下一帧照常解码
+#include "sim_core.h"
+#include "sim_test.h"
+
+#include "delay.h"
+#include "telemetry.h"
+#include "usart1_dma.h"
+
+#include "telemetry_decoder.h"
+
+#include <string>
+#include <vector>
+
+namespace {
+
+const u32 kBaud = 115200;
+
+void usart1_init()
+{
+    USART_InitTypeDef init;
+
+    RCC_APB2PeriphClockCmd(RCC_APB2Periph_USART1 | RCC_APB2Periph_GPIOA, ENABLE);
+    init.USART_BaudRate = kBaud;
+    init.USART_WordLength = USART_WordLength_8b;
+    init.USART_StopBits = USART_StopBits_1;
+    init.USART_Parity = USART_Parity_No;
+    init.USART_HardwareFlowControl = USART_HardwareFlowControl_None;
+    init.USART_Mode = USART_Mode_Tx | USART_Mode_Rx;
+    USART_Init(USART1, &init);
+    USART_Cmd(USART1, ENABLE);
+    USART1_DMA_Init();
+}
+
+// 与main.c的fputc相同：先标记有文本，再逐字节写入发送缓冲
+void put_text(const std::string &s)
+{
+    for (char ch : s) {
+        u8 c = (u8)ch;
+
+        Telemetry_NoteText();
+        USART1_DMA_Write(&c, 1);
+    }
+}
+
+// 等发送缓冲清空后取走线上字节
+std::string drain()
+{
+    std::string out;
+
+    CHECK(USART1_DMA_Flush(200000) == 0);
+    out = sim::uart_output();
+    sim::uart_clear_output();
+    return out;
+}
+
+SampleRing_RecordTypeDef make_sample(u16 seq)
+{
+    SampleRing_RecordTypeDef rec = {};
+
+    rec.seq = seq;
+    rec.stamp_us = 1000000u + seq * 800123u;
+    rec.clux = seq == 5 ? 0x1234567u : 30000u + seq * 37u;    // 5号超出24位，按0xFFFFFF饱和
+    rec.sensor = (u8)(seq % 4);
+    rec.status = (u8)(seq % 3 == 0 ? 0 : seq % 4);
+    return rec;
+}
+
+struct Collected {
+    std::vector<telemetry::Sample> samples;
+    std::vector<telemetry::Rollup> rollups;
+    std::vector<telemetry::ScreenEvent> events;
+    std::vector<std::string> text;
+};
+
+void attach(telemetry::Decoder &dec, Collected &c)
+{
+    dec.on_sample([&c](const telemetry::Sample &s) { c.samples.push_back(s); });
+    dec.on_rollup([&c](const telemetry::Rollup &r) { c.rollups.push_back(r); });
+    dec.on_event([&c](const telemetry::ScreenEvent &e) { c.events.push_back(e); });
+    dec.on_text([&c](const std::string &t) { c.text.push_back(t); });
+}
+
+void feed(telemetry::Decoder &dec, const std::string &bytes)
+{
+    dec.feed(reinterpret_cast<const uint8_t *>(bytes.data()), bytes.size());
+}
+
+bool same_sample(const telemetry::Sample &s, const SampleRing_RecordTypeDef &rec)
+{
+    u32 clux = rec.clux > TELEMETRY_CLUX_MAX ? TELEMETRY_CLUX_MAX : rec.clux;
+
+    return s.seq == rec.seq && s.stamp_us == rec.stamp_us && s.clux == clux && s.status == rec.status &&
+           s.sensor == rec.sensor;
+}
+
+}
+
+int main()
+{
+    const std::string text = "传感器1 通信失败，总线恢复\r\n";
+    Stats_RollupTypeDef roll = {};
+    Screen_EventTypeDef ev = {};
+    Screen_InfoTypeDef info = {};
+    std::vector<SampleRing_RecordTypeDef> sent;
+    telemetry::Decoder dec;
+    Collected got;
+    std::string frame;
+    u16 seq;
+    size_t i;
+
+    SysTick_Init();
+    DWT_Init();
+    usart1_init();
+    Telemetry_SetBinary(1);
+    attach(dec, got);
+
+    // 样本0~9、调试文本、样本10~19，然后各一条汇总、事件、心跳，最后样本23（20~22未发出）
+    for (seq = 0; seq < 20; seq++) {
+        if (seq == 10) {
+            feed(dec, drain());
+            put_text(text);
+        }
+        sent.push_back(make_sample(seq));
+        CHECK(Telemetry_SendSample(&sent.back()) > 0);
+    }
+    feed(dec, drain());
+
+    roll.sensor = 2;
+    roll.level = 1;
+    roll.count = 75;
+    roll.min = 29000;
+    roll.max = 0x2000000;       // 饱和
+    roll.mean = 30012;
+    roll.stddev = 345;
+    roll.quantile[0] = 29500;
+    roll.quantile[1] = 30010;
+    roll.quantile[2] = 30600;
+    roll.status[0] = 75;
+    roll.status[1] = 3;
+    roll.status[3] = 1;
+    CHECK(Telemetry_SendRollup(&roll, 60000) == TELEMETRY_ROLLUP_FRAME_LEN + 2);
+
+    ev.sensor = 1;
+    ev.from = SCREEN_ON;
+    ev.to = SCREEN_OFF;
+    ev.stamp_ms = 123456;
+    ev.confirm_ms = 2400;
+    ev.clux = 150;
+    info.state = SCREEN_OFF;
+    info.since_ms = 123456;
+    info.clux = 140;
+    info.off_base = 120;
+    info.on_base = 45000;
+    CHECK(Telemetry_SendEvent(&ev, &info) > 0);
+    CHECK(Telemetry_SendHeartbeat(1, &info, 183456) > 0);
+
+    sent.push_back(make_sample(23));
+    CHECK(Telemetry_SendSample(&sent.back()) > 0);
+    feed(dec, drain());
+
+    std::printf("  样本 %u  汇总 %u  事件 %u  心跳 %u  文本段 %u  丢失 %u  CRC错误 %u  COBS错误 %u\n",
+                (unsigned)dec.stats().frames, (unsigned)dec.stats().rollups, (unsigned)dec.stats().events,
+                (unsigned)dec.stats().heartbeats, (unsigned)dec.stats().text_chunks, (unsigned)dec.stats().lost,
+                (unsigned)dec.stats().crc_errors, (unsigned)dec.stats().cobs_errors);
+
+    // 样本逐字段一致，文本段原样分离，序号跳过20~22记为丢失3个
+    CHECK(got.samples.size() == sent.size());
+    for (i = 0; i < got.samples.size() && i < sent.size(); i++)
+        CHECK_MSG(same_sample(got.samples[i], sent[i]), "sample %u", (unsigned)i);
+    CHECK(got.samples.size() > 5 && got.samples[5].clux == TELEMETRY_CLUX_MAX);
+    CHECK(got.text.size() == 1 && got.text[0] == text);
+    CHECK(dec.stats().lost == 3);
+    CHECK(dec.stats().crc_errors == 0 && dec.stats().cobs_errors == 0);
+
+    CHECK(got.rollups.size() == 1);
+    if (got.rollups.size() == 1) {
+        const telemetry::Rollup &r = got.rollups[0];
+
+        CHECK(r.sensor == 2 && r.level == 1 && r.stamp_ms == 60000 && r.count == 75);
+        CHECK(r.min == 29000 && r.max == TELEMETRY_CLUX_MAX && r.mean == 30012 && r.stddev == 345);
+        CHECK(r.p5 == 29500 && r.p50 == 30010 && r.p95 == 30600);
+        CHECK(r.status[0] == 75 && r.status[1] == 3 && r.status[2] == 0 && r.status[3] == 1);
+    }
+
+    CHECK(got.events.size() == 2);
+    if (got.events.size() == 2) {
+        const telemetry::ScreenEvent &e = got.events[0], &hb = got.events[1];
+
+        CHECK(!e.heartbeat && e.sensor == 1 && e.stamp_ms == 123456 && e.duration_ms == 2400);
+        CHECK(e.from == SCREEN_ON && e.to == SCREEN_OFF && e.clux == 150);
+        CHECK(e.off_base == 120 && e.on_base == 45000);
+        CHECK(hb.heartbeat && hb.sensor == 1 && hb.stamp_ms == 183456 && hb.duration_ms == 60000);
+        CHECK(hb.from == SCREEN_OFF && hb.to == SCREEN_OFF && hb.clux == 140);
+    }
+
+    // 改写CRC低字节（帧尾分隔符前第2个字节，取非零值以免拆开帧）：该帧不回调，下一帧照常解码
+    {
+        telemetry::Decoder bad;
+        Collected c;
+        SampleRing_RecordTypeDef a = make_sample(30), b = make_sample(31);
+        size_t pos;
+
+        attach(bad, c);
+        Telemetry_SendSample(&a);
+        frame = drain();
+        pos = frame.size() - 3;
+        frame[pos] = (char)(frame[pos] == 0x01 ? 0x02 : frame[pos] ^ 0x01);
+        feed(bad, frame);
+        Telemetry_SendSample(&b);
+        feed(bad, drain());
+
+        std::printf("  改写CRC字节：CRC错误 %u，解码样本 %u\n", (unsigned)bad.stats().crc_errors,
+                    (unsigned)bad.stats().frames);
+        CHECK(bad.stats().crc_errors == 1 && bad.stats().cobs_errors == 0);
+        CHECK(c.samples.size() == 1 && same_sample(c.samples[0], b));
+        CHECK(c.text.empty());
+    }
+
+    return sim_test_result("telemetry_frames");
+}
@@ -0,0 +1,103 @@
+#include "cmd_parser.h"
+
+void Cmd_Init(Cmd_ParserTypeDef *p, const Cmd_EntryTypeDef *table, u8 count)
+{
+    p->len = 0;
+    p->overflow = 0;
+    p->table = table;
+    p->count = count;
+}
+
+u8 Cmd_StrEq(const char *a, const char *b)
+{
+    while(*a && *a == *b)
+    {
+        a++;
+        b++;
+    }
+    return *a == *b;
+}
+
+u8 Cmd_ParseU32(const char *s, u32 *out)
+{
+    u32 v = 0, base = 10, d;
+
+    if(s[0] == '0' && (s[1] == 'x' || s[1] == 'X'))
+    {
+        base = 16;
+        s += 2;
+    }
+    if(*s == 0)
+        return 1;
+    for(; *s; s++)
+    {
+        if(*s >= '0' && *s <= '9')
+            d = *s - '0';
+        else if(base == 16 && *s >= 'a' && *s <= 'f')
+            d = *s - 'a' + 10;
+        else if(base == 16 && *s >= 'A' && *s <= 'F')
+            d = *s - 'A' + 10;
+        else
+            return 1;
+        if(v > (0xFFFFFFFF - d) / base)
+            return 1;
+        v = v * base + d;
+    }
+    *out = v;
+    return 0;
+}
+
+// 原地切分整行并查表分派
+static Cmd_ResultTypeDef Cmd_Dispatch(Cmd_ParserTypeDef *p)
+{
+    char *argv[CMD_ARGS_MAX];
+    char *c = p->line;
+    u8 argc = 0, i;
+
+    p->line[p->len] = 0;
+    while(*c)
+    {
+        while(*c == ' ' || *c == '\t')
+            *c++ = 0;
+        if(*c == 0)
+            break;
+        if(argc >= CMD_ARGS_MAX)
+            return CMD_BAD_ARGS;
+        argv[argc++] = c;
+        while(*c && *c != ' ' && *c != '\t')
+            c++;
+    }
+    if(argc == 0)
+        return CMD_NONE;
+
+    for(i=0; i<p->count; i++)
+    {
+        if(!Cmd_StrEq(argv[0], p->table[i].name))
+            continue;
+        if(argc - 1 < p->table[i].min_args || argc - 1 > p->table[i].max_args)
+            return CMD_BAD_ARGS;
+        return p->table[i].handler(argc, argv) == 0 ? CMD_OK : CMD_BAD_VALUE;
+    }
+    return CMD_UNKNOWN;
+}
+
+Cmd_ResultTypeDef Cmd_Feed(Cmd_ParserTypeDef *p, u8 ch)
+{
+    Cmd_ResultTypeDef res;
+
+    if(ch == '\r' || ch == '\n')
+    {
+        res = p->overflow ? CMD_TOO_LONG : (p->len ? Cmd_Dispatch(p) : CMD_NONE);
+        p->len = 0;
+        p->overflow = 0;
+        return res;
+    }
+    // 控制字符与非ASCII字节（如线路噪声）当作空格，不影响下一行
+    if(ch < 0x20 || ch >= 0x7F)
+        ch = ' ';
+    if(p->len >= CMD_LINE_MAX)
+        p->overflow = 1;
+    else
+        p->line[p->len++] = (char)ch;
+    return CMD_NONE;
+}
@@ -0,0 +1,51 @@
+#ifndef __CMD_PARSER_H
+#define __CMD_PARSER_H
+
+#include "stm32f10x.h"
+
+/********************* 串口命令解析参数 *********************/
+// 文本行命令，以\r或\n结束，空格分隔参数；解析器只使用调用者提供的静态状态，
+// 不分配内存，每个字节O(1)，整行分派O(CMD_LINE_MAX)，不依赖硬件，可在主机上做模糊测试
+#define CMD_LINE_MAX     40     // 单行最大字符数（超长行整行丢弃）
+#define CMD_ARGS_MAX     4      // 含命令名在内的最大参数个数
+
+// 解析结果
+typedef enum {
+    CMD_NONE = 0,       // 尚未收到完整一行（或空行）
+    CMD_OK,             // 已执行
+    CMD_UNKNOWN,        // 未知命令
+    CMD_BAD_ARGS,       // 参数个数不符
+    CMD_BAD_VALUE,      // 处理函数拒绝（参数值非法/当前状态不允许）
+    CMD_TOO_LONG        // 行超长被丢弃
+} Cmd_ResultTypeDef;
+
+// 命令处理函数：argv[0]为命令名，argv指向行缓冲内部（仅在调用期间有效）
+// 返回0：成功，非0：参数值非法
+typedef u8 (*Cmd_HandlerFunc)(u8 argc, char **argv);
+
+typedef struct {
+    const char *name;
+    u8 min_args;        // 不含命令名
+    u8 max_args;
+    Cmd_HandlerFunc handler;
+    const char *help;
+} Cmd_EntryTypeDef;
+
+typedef struct {
+    char line[CMD_LINE_MAX + 1];
+    u8   len;
+    u8   overflow;      // 1：本行已超长，丢弃到行尾
+    const Cmd_EntryTypeDef *table;
+    u8   count;
+} Cmd_ParserTypeDef;
+
+/********************* 函数声明 *********************/
+void Cmd_Init(Cmd_ParserTypeDef *p, const Cmd_EntryTypeDef *table, u8 count);
+// 输入一个字节，收到行结束时分派并返回结果
+Cmd_ResultTypeDef Cmd_Feed(Cmd_ParserTypeDef *p, u8 ch);
+// 解析无符号整数（十进制或0x十六进制，溢出/非法字符返回1）
+u8 Cmd_ParseU32(const char *s, u32 *out);
+// 字符串相等
+u8 Cmd_StrEq(const char *a, const char *b);
+
+#endif
@@ -1,57 +1,72 @@
 #include "delay.h"
 
-static u8  fac_us = 0;  // 微秒延时倍乘数
-static u16 fac_ms = 0;  // 毫秒延时倍乘数
+static u8  fac_us = 0;  // 每微秒的SysTick计数
+static u16 fac_ms = 0;  // 每毫秒的SysTick计数（即重装载值+1）
+static volatile u32 sys_ms = 0;  // 毫秒节拍计数
 
-// SysTick初始化（加static消除原型警告，仅本文件使用）
+// SysTick初始化：HCLK/8（72MHz下为9MHz）计数，每1ms中断一次，之后一直运行
 void SysTick_Init(void)
 {
-    // 选择HCLK/8作为SysTick时钟源（72MHz系统时钟下，SysTick时钟为9MHz）
-    SysTick_CLKSourceConfig(SysTick_CLKSource_HCLK_Div8);
-    // 计算1us需要的时钟周期数：9MHz = 9个周期/1us
     fac_us = SystemCoreClock / 8000000;
-    // 计算1ms需要的时钟周期数
-    fac_ms = (u16)fac_us * 1000;
+    fac_ms = (u16)fac_us * (1000000 / SYSTICK_FREQ_HZ);
+
+    SysTick->CTRL = 0;
+    SysTick->LOAD = fac_ms - 1;
+    SysTick->VAL  = 0;
+    // 最低优先级，不影响TIM2/I2C等总线中断的时序
+    NVIC_SetPriority(SysTick_IRQn, (1 << __NVIC_PRIO_BITS) - 1);
+    SysTick->CTRL = SysTick_CTRL_TICKINT_Msk | SysTick_CTRL_ENABLE_Msk;  // CLKSOURCE=0：HCLK/8
 }
 
-// 微秒级延时（精度：1us）
-void Delay_us(u32 us)
+u32 millis(void)
+{
+    return sys_ms;
+}
+
+// 毫秒节拍 + SysTick当前计数值；在更高优先级中断里调用时，
+// SysTick中断可能已挂起但尚未执行，此时补上这1ms
+u32 micros(void)
 {
-    u32 temp;
-    // 加载延时计数值
-    SysTick->LOAD = (u32)us * fac_us;
-    // 清空当前计数值
-    SysTick->VAL  = 0x00;
-    // 启动SysTick定时器
-    SysTick->CTRL |= SysTick_CTRL_ENABLE_Msk;
-    // 等待计数完成（COUNTFLAG位置1）
+    u32 ms, val, pend;
+
     do
     {
-        temp = SysTick->CTRL;
-    } while((temp & 0x01) && !(temp & (1 << 16)));
-    // 关闭定时器
-    SysTick->CTRL &= ~SysTick_CTRL_ENABLE_Msk;
-    // 清空计数值
-    SysTick->VAL  = 0x00;
+        ms   = sys_ms;
+        val  = SysTick->VAL;
+        pend = SCB->ICSR & SCB_ICSR_PENDSTSET_Msk;
+    } while(ms != sys_ms);
+
+    if(pend && val > (u32)fac_ms / 2)
+        ms++;
+    return ms * 1000 + (fac_ms - 1 - val) / fac_us;
 }
 
-// 毫秒级延时（精度：1ms）
+// 微秒级延时（精度：1us）
+void Delay_us(u32 us)
+{
+    u32 start = micros();
+    while(micros() - start < us);
+}
+
+// 毫秒级延时（依赖SysTick中断推进，不能在关中断或更高优先级的中断中调用）
 void Delay_ms(u32 ms)
 {
-    u32 temp;
-    // 加载延时计数值
-    SysTick->LOAD = (u32)ms * fac_ms;
-    // 清空当前计数值
-    SysTick->VAL  = 0x00;
-    // 启动SysTick定时器
-    SysTick->CTRL |= SysTick_CTRL_ENABLE_Msk;
-    // 等待计数完成
-    do
-    {
-        temp = SysTick->CTRL;
-    } while((temp & 0x01) && !(temp & (1 << 16)));
-    // 关闭定时器
-    SysTick->CTRL &= ~SysTick_CTRL_ENABLE_Msk;
-    // 清空计数值
-    SysTick->VAL  = 0x00;
+    u32 start = micros();
+    while(micros() - start < ms * 1000);
+}
+
+// 1ms节拍中断
+void SysTick_Handler(void)
+{
+    sys_ms++;
+}
+
+// 使能DWT周期计数器，供纳秒级时序和周期统计使用（重复调用无副作用）
+void DWT_Init(void)
+{
+    if(DWT->CTRL & DWT_CTRL_CYCCNTENA_Msk)
+        return;
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
 }
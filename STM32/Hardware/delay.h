@@ -3,9 +3,18 @@
 
 #include "stm32f10x.h"
 
+// 系统节拍：SysTick以1kHz自由运行，不再在延时函数中重新装载
+#define SYSTICK_FREQ_HZ  1000
+
+// 判断时间戳now是否已到达deadline（无符号回绕安全，适用于毫秒和微秒）
+#define TIME_REACHED(now, deadline)  ((s32)((u32)(now) - (u32)(deadline)) >= 0)
+
 // 函数声明（修复SysTick_Init未声明问题）
 void SysTick_Init(void);
-void Delay_us(u32 us);  // 微秒级延时
-void Delay_ms(u32 ms);  // 毫秒级延时
+u32  millis(void);      // 上电以来的毫秒数（约49.7天回绕）
+u32  micros(void);      // 上电以来的微秒数（约71.6分钟回绕）
+void Delay_us(u32 us);  // 微秒级延时（忙等，仅用于初始化/调试路径）
+void Delay_ms(u32 ms);  // 毫秒级延时（忙等，主循环请改用截止时间或软件定时器）
+void DWT_Init(void);    // 使能DWT周期计数器（CYCCNT，按HCLK计数）
 
 #endif
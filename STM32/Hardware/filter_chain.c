@@ -0,0 +1,308 @@
+#include "filter_chain.h"
+
+#if (FILTER_HAMPEL_WINDOW < 3) || ((FILTER_HAMPEL_WINDOW % 2) == 0)
+#error "FILTER_HAMPEL_WINDOW 须为不小于3的奇数"
+#endif
+#if (FILTER_JUMP_CONFIRM < 1) || (FILTER_JUMP_CONFIRM > 255)
+#error "FILTER_JUMP_CONFIRM 须为1~255"
+#endif
+#if (FILTER_KALMAN_Q + FILTER_KALMAN_R) >= 65536
+#error "FILTER_KALMAN_Q + FILTER_KALMAN_R 须小于65536（增益按32位Q16计算）"
+#endif
+
+typedef Filter_ResultTypeDef (*Filter_ProcessFunc)(Filter_StateTypeDef *st, u32 *value);
+
+// 运行时参数（中值窗口由median_filter模块保存）
+static Filter_ParamsTypeDef params = {
+    FILTER_JUMP_LOG_Q8, FILTER_JUMP_FLOOR, FILTER_JUMP_CONFIRM, FILTER_EMA_SHIFT,
+    MEDIAN_WINDOW_SIZE, FILTER_DECIM_FACTOR, FILTER_HAMPEL_K_Q8, FILTER_KALMAN_Q, FILTER_KALMAN_R
+};
+
+/********************* 辅助函数 *********************/
+static u32 Filter_AbsDiff(u32 a, u32 b)
+{
+    return a > b ? a - b : b - a;
+}
+
+// 小窗口中值（n<=FILTER_HAMPEL_WINDOW，插入排序，会改写buf）
+static u32 Filter_SmallMedian(u32 *buf, u8 n)
+{
+    u8 i, j;
+    u32 v;
+
+    for(i=1; i<n; i++)
+    {
+        v = buf[i];
+        for(j=i; j>0 && buf[j-1]>v; j--)
+            buf[j] = buf[j-1];
+        buf[j] = v;
+    }
+    return buf[(n - 1) / 2];
+}
+
+// log2(v)，Q8定点：整数部分由CLZ得到，小数部分取尾数高8位线性近似（误差<0.09倍频程）
+u16 FilterChain_Log2Q8(u32 v)
+{
+    u8 e;
+    u32 frac;
+
+    if(v == 0)
+        return 0;
+    e = 31 - __CLZ(v);
+    frac = e >= 8 ? (v >> (e - 8)) : (v << (8 - e));
+    return (u16)((e << 8) | (frac & 0xFF));
+}
+
+// 跳变确认后清空各级历史，避免中值/平均把新旧两个等级混在一起
+static void Filter_ResetHistory(Filter_StateTypeDef *st)
+{
+    Median_Init(&st->median);
+    st->ema.init = 0;
+    st->hampel.head = 0;
+    st->hampel.count = 0;
+    st->kalman.init = 0;
+    st->decim.sum = 0;
+    st->decim.count = 0;
+}
+
+/********************* 各级处理函数 *********************/
+static Filter_ResultTypeDef Filter_Range(Filter_StateTypeDef *st, u32 *value)
+{
+    (void)st;
+    if(*value < FILTER_RANGE_MIN || *value > FILTER_RANGE_MAX)
+        return FILTER_RANGE_ERR;
+    return FILTER_OK;
+}
+
+// 与上一次链输出在log2域比较，首个样本不判断。
+// 越界样本先作为候选等级，连续jump_confirm次落在候选附近即接受为新等级
+static Filter_ResultTypeDef Filter_Jump(Filter_StateTypeDef *st, u32 *value)
+{
+    Filter_JumpStateTypeDef *js = &st->jump;
+    u16 lv;
+
+    js->accepted = 0;
+    if(js->last == 0)
+        return FILTER_OK;
+
+    lv = FilterChain_Log2Q8(*value + params.jump_floor);
+    if(Filter_AbsDiff(lv, FilterChain_Log2Q8(js->last + params.jump_floor)) <= params.jump_log_q8)
+    {
+        js->pending = 0;        // 回到原等级，放弃候选
+        return FILTER_OK;
+    }
+
+    if(js->pending == 0 || Filter_AbsDiff(lv, js->cand_log) > params.jump_log_q8)
+    {
+        js->cand_log = lv;      // 新的候选等级
+        js->pending = 1;
+    }
+    else
+    {
+        js->pending++;
+    }
+    if(js->pending < params.jump_confirm)
+        return FILTER_JUMP_ERR;
+
+    js->accepted = js->pending;
+    js->pending = 0;
+    Filter_ResetHistory(st);
+    return FILTER_OK;
+}
+
+static Filter_ResultTypeDef Filter_Median(Filter_StateTypeDef *st, u32 *value)
+{
+    *value = Median_Update(&st->median, *value);
+    return FILTER_OK;
+}
+
+// y += (x - y) / 2^SHIFT，内部保留4位小数避免小信号被截断
+static Filter_ResultTypeDef Filter_Ema(Filter_StateTypeDef *st, u32 *value)
+{
+    Filter_EmaStateTypeDef *ema = &st->ema;
+    s32 x_q4 = (s32)(*value << 4);
+
+    if(!ema->init)
+    {
+        ema->y_q4 = x_q4;
+        ema->init = 1;
+    }
+    else
+    {
+        ema->y_q4 += (x_q4 - ema->y_q4) >> params.ema_shift;
+    }
+    *value = (u32)(ema->y_q4 + 8) >> 4;
+    return FILTER_OK;
+}
+
+// 当前样本偏离窗口中值超过 k*MAD 时用中值替换
+static Filter_ResultTypeDef Filter_Hampel(Filter_StateTypeDef *st, u32 *value)
+{
+    Filter_HampelStateTypeDef *hs = &st->hampel;
+    u32 tmp[FILTER_HAMPEL_WINDOW];
+    u32 med, mad;
+    u8 i;
+
+    hs->ring[hs->head] = *value;
+    if(++hs->head >= FILTER_HAMPEL_WINDOW)
+        hs->head = 0;
+    if(hs->count < FILTER_HAMPEL_WINDOW)
+        hs->count++;
+    if(hs->count < 3)
+        return FILTER_OK;
+
+    for(i=0; i<hs->count; i++)
+        tmp[i] = hs->ring[i];
+    med = Filter_SmallMedian(tmp, hs->count);
+    for(i=0; i<hs->count; i++)
+        tmp[i] = Filter_AbsDiff(hs->ring[i], med);
+    mad = Filter_SmallMedian(tmp, hs->count);
+
+    if(Filter_AbsDiff(*value, med) > (u32)(((uint64_t)mad * params.hampel_k_q8) >> 8))
+        *value = med;
+    return FILTER_OK;
+}
+
+// 标量卡尔曼（常值模型）：P<=Q+R<65536，增益K用Q16表示
+static Filter_ResultTypeDef Filter_Kalman(Filter_StateTypeDef *st, u32 *value)
+{
+    Filter_KalmanStateTypeDef *kf = &st->kalman;
+    u32 k_q16;
+    s32 diff;
+
+    if(!kf->init)
+    {
+        kf->x = *value;
+        kf->p = params.kalman_r;
+        kf->init = 1;
+        return FILTER_OK;
+    }
+    kf->p += params.kalman_q;
+    k_q16 = (kf->p << 16) / (kf->p + params.kalman_r);
+    diff = (s32)(*value - kf->x);
+    kf->x = (u32)((s32)kf->x + (s32)(((int64_t)diff * k_q16) >> 16));
+    kf->p -= (kf->p * k_q16) >> 16;
+    *value = kf->x;
+    return FILTER_OK;
+}
+
+// 每decim_factor个样本输出一次平均值
+static Filter_ResultTypeDef Filter_Decim(Filter_StateTypeDef *st, u32 *value)
+{
+    Filter_DecimStateTypeDef *dc = &st->decim;
+
+    dc->sum += *value;
+    if(++dc->count < params.decim_factor)
+        return FILTER_HOLD;
+    *value = (dc->sum + params.decim_factor / 2) / params.decim_factor;
+    dc->sum = 0;
+    dc->count = 0;
+    return FILTER_OK;
+}
+
+/********************* 级表与当前链 *********************/
+static const Filter_ProcessFunc stage_func[FILTER_STAGE_COUNT] = {
+    Filter_Range, Filter_Jump, Filter_Median, Filter_Ema, Filter_Hampel, Filter_Kalman, Filter_Decim
+};
+
+static Filter_StageStatsTypeDef stage_stats[FILTER_STAGE_COUNT] = {
+    {"range", 0, 0, 0}, {"jump", 0, 0, 0}, {"median", 0, 0, 0}, {"ema", 0, 0, 0},
+    {"hampel", 0, 0, 0}, {"kalman", 0, 0, 0}, {"decim", 0, 0, 0}
+};
+
+static u8 chain[FILTER_CHAIN_MAX] = FILTER_CHAIN_DEFAULT;
+static u8 chain_len = sizeof((u8[])FILTER_CHAIN_DEFAULT);
+
+/********************* 对外接口 *********************/
+Filter_ResultTypeDef FilterChain_Run(Filter_StateTypeDef *st, u32 *value)
+{
+    Filter_ResultTypeDef res = FILTER_OK;
+    Filter_StageStatsTypeDef *ss;
+    u32 start, cycles;
+    u8 i;
+
+    for(i=0; i<chain_len && res == FILTER_OK; i++)
+    {
+        start = DWT->CYCCNT;
+        res = stage_func[chain[i]](st, value);
+        cycles = DWT->CYCCNT - start;
+
+        ss = &stage_stats[chain[i]];
+        ss->calls++;
+        ss->cycles += cycles;
+        if(cycles > ss->max)
+            ss->max = cycles;
+    }
+    if(res == FILTER_OK)
+        st->jump.last = *value;
+    return res;
+}
+
+void FilterChain_Reset(Filter_StateTypeDef *st)
+{
+    const Filter_StateTypeDef init = FILTER_STATE_INIT;
+
+    *st = init;
+}
+
+u8 FilterChain_Select(const u8 *ids, u8 count)
+{
+    u8 i;
+
+    if(count == 0 || count > FILTER_CHAIN_MAX)
+        return 1;
+    for(i=0; i<count; i++)
+    {
+        if(ids[i] >= FILTER_STAGE_COUNT)
+            return 1;
+    }
+    for(i=0; i<count; i++)
+        chain[i] = ids[i];
+    chain_len = count;
+    return 0;
+}
+
+u8 FilterChain_Length(void)
+{
+    return chain_len;
+}
+
+u8 FilterChain_StageAt(u8 n)
+{
+    return n < chain_len ? (u8)chain[n] : (u8)FILTER_STAGE_COUNT;
+}
+
+void FilterChain_GetParams(Filter_ParamsTypeDef *out)
+{
+    *out = params;
+    out->median_window = Median_GetWindow();
+}
+
+u8 FilterChain_SetParams(const Filter_ParamsTypeDef *in)
+{
+    if(in->jump_log_q8 == 0 || in->jump_confirm == 0 || in->ema_shift > 8 ||
+       in->decim_factor == 0 || (u32)in->kalman_q + in->kalman_r >= 65536 || in->kalman_r == 0)
+        return 1;
+    if(Median_SetWindow(in->median_window) != 0)
+        return 1;
+    params = *in;
+    return 0;
+}
+
+void FilterChain_GetStats(u8 stage_id, Filter_StageStatsTypeDef *stats)
+{
+    if(stage_id < FILTER_STAGE_COUNT)
+        *stats = stage_stats[stage_id];
+}
+
+void FilterChain_ResetStats(void)
+{
+    u8 i;
+
+    for(i=0; i<FILTER_STAGE_COUNT; i++)
+    {
+        stage_stats[i].calls = 0;
+        stage_stats[i].cycles = 0;
+        stage_stats[i].max = 0;
+    }
+}
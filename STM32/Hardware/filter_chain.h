@@ -0,0 +1,130 @@
+#ifndef __FILTER_CHAIN_H
+#define __FILTER_CHAIN_H
+
+#include "stm32f10x.h"
+#include "median_filter.h"
+
+/********************* 滤波链：各级参数（光照单位均为0.01lux） *********************/
+#define FILTER_RANGE_MIN        1         // 量程下限（0.01lux）
+#define FILTER_RANGE_MAX        8388608   // 量程上限（83886.08lux）
+// 跳变判定在log2域进行（Q8，256=一倍频程），亮/暗处同一比例变化判定一致；
+// 越界样本连续FILTER_JUMP_CONFIRM次落在同一新等级才被接受，最坏接受延迟为CONFIRM次转换
+#define FILTER_JUMP_LOG_Q8      256       // 跳变阈值：与上次输出相差超过2倍（或不足1/2）
+#define FILTER_JUMP_FLOOR       100       // 取对数前加的底数（1lux），避免暗处噪声被放大
+#define FILTER_JUMP_CONFIRM     3         // 新等级确认次数（1：不拒绝，立即接受）
+#define FILTER_EMA_SHIFT        2         // EMA系数 alpha = 1/2^SHIFT
+#define FILTER_HAMPEL_WINDOW    7         // Hampel窗口（奇数，含当前样本）
+#define FILTER_HAMPEL_K_Q8      1139      // 判定阈值 3*1.4826*MAD（Q8）
+#define FILTER_KALMAN_Q         100       // 过程噪声方差（0.01lux^2）
+#define FILTER_KALMAN_R         2500      // 观测噪声方差（0.01lux^2）
+#define FILTER_DECIM_FACTOR     4         // 抽取：每N个样本取平均输出一次
+
+/********************* 级编号与链配置 *********************/
+typedef enum {
+    FILTER_STAGE_RANGE = 0,   // 量程检查
+    FILTER_STAGE_JUMP,        // 跳变拒绝
+    FILTER_STAGE_MEDIAN,      // 流式中值
+    FILTER_STAGE_EMA,         // 指数滑动平均
+    FILTER_STAGE_HAMPEL,      // Hampel离群值替换
+    FILTER_STAGE_KALMAN,      // 标量卡尔曼
+    FILTER_STAGE_DECIM,       // 平均抽取
+    FILTER_STAGE_COUNT
+} Filter_StageIdTypeDef;
+
+#define FILTER_CHAIN_MAX        FILTER_STAGE_COUNT
+
+// 编译时默认链（按部署调整延迟/噪声取舍），运行时可用FilterChain_Select替换
+#define FILTER_CHAIN_DEFAULT    { FILTER_STAGE_RANGE, FILTER_STAGE_JUMP, FILTER_STAGE_MEDIAN }
+
+// 单级处理结果
+typedef enum {
+    FILTER_OK = 0,      // 输出value，进入下一级
+    FILTER_HOLD,        // 样本被吸收（如抽取未满），本次无输出
+    FILTER_RANGE_ERR,   // 量程异常，样本丢弃
+    FILTER_JUMP_ERR     // 跳变异常，样本丢弃
+} Filter_ResultTypeDef;
+
+/********************* 每个传感器一份的各级状态 *********************/
+typedef struct {
+    u32 last;                               // 上一次链输出（跳变级参考）
+    u16 cand_log;                           // 候选新等级（log2 Q8）
+    u8  pending;                            // 候选等级已连续出现的次数
+    u8  accepted;                           // 本次样本确认了新等级（值为确认所用次数）
+} Filter_JumpStateTypeDef;
+
+typedef struct {
+    s32 y_q4;                               // 输出（Q4）
+    u8  init;
+} Filter_EmaStateTypeDef;
+
+typedef struct {
+    u32 ring[FILTER_HAMPEL_WINDOW];
+    u8  head;
+    u8  count;
+} Filter_HampelStateTypeDef;
+
+typedef struct {
+    u32 x;                                  // 估计值
+    u32 p;                                  // 估计方差
+    u8  init;
+} Filter_KalmanStateTypeDef;
+
+typedef struct {
+    u32 sum;
+    u8  count;
+} Filter_DecimStateTypeDef;
+
+typedef struct {
+    Filter_JumpStateTypeDef   jump;
+    Median_TypeDef            median;
+    Filter_EmaStateTypeDef    ema;
+    Filter_HampelStateTypeDef hampel;
+    Filter_KalmanStateTypeDef kalman;
+    Filter_DecimStateTypeDef  decim;
+} Filter_StateTypeDef;
+
+// 零初始化即为初始状态
+#define FILTER_STATE_INIT  { {0, 0, 0, 0}, MEDIAN_INIT, {0, 0}, {{0}, 0, 0}, {0, 0, 0}, {0, 0} }
+
+// 运行时可调参数（所有传感器共用），上电为上面的编译时默认值
+typedef struct {
+    u16 jump_log_q8;      // 跳变阈值（log2 Q8）
+    u16 jump_floor;       // 跳变判定底数（0.01lux）
+    u8  jump_confirm;     // 新等级确认次数（1~255）
+    u8  ema_shift;        // EMA系数移位（0~8）
+    u8  median_window;    // 中值窗口（3~MEDIAN_WINDOW_MAX的奇数）
+    u8  decim_factor;     // 抽取因子（1~255）
+    u16 hampel_k_q8;      // Hampel判定阈值（Q8）
+    u16 kalman_q;         // 卡尔曼过程噪声方差
+    u16 kalman_r;         // 卡尔曼观测噪声方差（Q+R<65536）
+} Filter_ParamsTypeDef;
+
+// 各级耗时统计（所有传感器合计，DWT周期）
+typedef struct {
+    const char *name;
+    u32 calls;
+    u32 cycles;     // 累计周期
+    u32 max;        // 单次最大周期
+} Filter_StageStatsTypeDef;
+
+/********************* 函数声明 *********************/
+// 运行当前链：value为输入，处理完成后为输出（返回FILTER_OK才有输出）
+Filter_ResultTypeDef FilterChain_Run(Filter_StateTypeDef *st, u32 *value);
+// 清空一个传感器的全部级状态
+void FilterChain_Reset(Filter_StateTypeDef *st);
+// 运行时替换链（ids为级编号列表，返回0：成功）；各传感器状态需由调用者复位
+u8 FilterChain_Select(const u8 *ids, u8 count);
+// 当前链长度与第n级编号
+u8 FilterChain_Length(void);
+u8 FilterChain_StageAt(u8 n);
+// 读取/设置运行时参数（返回0：成功，1：参数越界，未修改）；
+// 改变中值窗口后各传感器状态需由调用者复位
+void FilterChain_GetParams(Filter_ParamsTypeDef *params);
+u8 FilterChain_SetParams(const Filter_ParamsTypeDef *params);
+// log2近似（Q8，256=一倍频程，分段线性），供跳变判定及其它按比例比较光照的模块使用
+u16 FilterChain_Log2Q8(u32 v);
+// 读取/清零各级耗时统计
+void FilterChain_GetStats(u8 stage_id, Filter_StageStatsTypeDef *stats);
+void FilterChain_ResetStats(void);
+
+#endif
@@ -0,0 +1,460 @@
+#include "i2c1_dma.h"
+
+/********************* 传输状态机 *********************/
+typedef enum {
+    I2C1_STATE_IDLE = 0,
+    I2C1_STATE_START_W,   // 已发START，等待SB后发送addr+W
+    I2C1_STATE_ADDR_W,    // 等待addr+W的ADDR事件
+    I2C1_STATE_TX,        // DMA发送寄存器地址+数据，等待BTF后STOP
+    I2C1_STATE_PTR,       // 读操作：寄存器地址已写入DR，等待BTF后重复起始
+    I2C1_STATE_START_R,   // 已发重复START（或不写指针的读），等待SB后发送addr+R
+    I2C1_STATE_ADDR_R,    // 等待addr+R的ADDR事件
+    I2C1_STATE_RX         // DMA接收中，等待DMA传输完成后STOP
+} I2C1_StateTypeDef;
+
+static volatile I2C1_StateTypeDef i2c1_state = I2C1_STATE_IDLE;
+static volatile I2C1_DMA_ResultTypeDef i2c1_result = I2C1_DMA_OK;
+static u8  i2c1_addr;                            // 7位从机地址
+static u8  i2c1_reg;                             // 寄存器地址（读操作用）
+static u8  i2c1_is_read;                         // 1：读操作
+static u8  i2c1_is_probe;                        // 1：仅地址探测
+static u8  i2c1_no_ptr;                          // 1：读操作不写指针，从器件当前指针读
+static u8  i2c1_tx_len;                          // 写操作DMA字节数（含寄存器地址）
+static u8  i2c1_rx_len;
+static u8 *i2c1_rx_buf;
+static u8  i2c1_tx_buf[1 + I2C1_DMA_MAX_LEN];    // 寄存器地址 + 待写数据
+static I2C1_DMA_Callback i2c1_cb;
+static void *i2c1_cb_ctx;
+
+/********************* 内部函数 *********************/
+// 结束本次传输并通知调用者（中断上下文）
+static void I2C1_DMA_Finish(I2C1_DMA_ResultTypeDef result)
+{
+    I2C1_DMA_Callback cb = i2c1_cb;
+
+    DMA1_Channel6->CCR &= ~DMA_CCR1_EN;
+    DMA1_Channel7->CCR &= ~DMA_CCR1_EN;
+    I2C1->CR2 &= ~(I2C_CR2_DMAEN | I2C_CR2_LAST);
+
+    i2c1_result = result;
+    i2c1_state  = I2C1_STATE_IDLE;
+    i2c1_cb     = 0;
+    if(cb)
+        cb(result, i2c1_cb_ctx);
+}
+
+// 配置I2C1外设：400kHz Fast-mode，占空比2:1
+static void I2C1_DMA_PeriphConfig(void)
+{
+    I2C_InitTypeDef I2C_InitStruct;
+
+    I2C_DeInit(I2C1);
+    I2C_InitStruct.I2C_ClockSpeed = I2C1_DMA_SPEED;
+    I2C_InitStruct.I2C_Mode = I2C_Mode_I2C;
+    I2C_InitStruct.I2C_DutyCycle = I2C_DutyCycle_2;
+    I2C_InitStruct.I2C_OwnAddress1 = 0x00;
+    I2C_InitStruct.I2C_Ack = I2C_Ack_Enable;
+    I2C_InitStruct.I2C_AcknowledgedAddress = I2C_AcknowledgedAddress_7bit;
+    I2C_Init(I2C1, &I2C_InitStruct);
+
+    // 使能事件/错误中断，缓冲中断不开（数据由DMA搬运）
+    I2C1->CR2 |= I2C_CR2_ITEVTEN | I2C_CR2_ITERREN;
+    I2C_Cmd(I2C1, ENABLE);
+}
+
+// 启动一次传输（调用前已填好参数）
+static I2C1_DMA_ResultTypeDef I2C1_DMA_Start(I2C1_DMA_Callback cb, void *ctx)
+{
+    if(i2c1_state != I2C1_STATE_IDLE || (I2C1->SR2 & I2C_SR2_BUSY))
+        return I2C1_DMA_BUSY;
+
+    i2c1_cb     = cb;
+    i2c1_cb_ctx = ctx;
+
+    if(!i2c1_is_read && !i2c1_is_probe)
+    {
+        // 写操作：ADDR清除后由DMA1通道6把寄存器地址和数据依次推入DR
+        DMA1_Channel6->CCR   = 0;
+        DMA1_Channel6->CMAR  = (u32)i2c1_tx_buf;
+        DMA1_Channel6->CNDTR = i2c1_tx_len;
+        DMA1_Channel6->CCR   = DMA_CCR1_DIR | DMA_CCR1_MINC | DMA_CCR1_PL_1 | DMA_CCR1_TEIE;
+        DMA1_Channel6->CCR  |= DMA_CCR1_EN;
+        I2C1->CR2 |= I2C_CR2_DMAEN;
+    }
+
+    i2c1_result = I2C1_DMA_BUSY;
+    // 不写指针的读操作：第一个START后直接发addr+R
+    i2c1_state  = i2c1_no_ptr ? I2C1_STATE_START_R : I2C1_STATE_START_W;
+    I2C1->CR1 |= I2C_CR1_ACK | I2C_CR1_START;
+    return I2C1_DMA_OK;
+}
+
+// 阻塞等待当前传输结束，超时则复位外设
+static I2C1_DMA_ResultTypeDef I2C1_DMA_Wait(void)
+{
+    u32 timeout = 0;
+
+    while(i2c1_state != I2C1_STATE_IDLE)
+    {
+        if(++timeout > I2C1_DMA_TIMEOUT)
+        {
+            I2C1_DMA_Abort();
+            break;
+        }
+    }
+    return i2c1_result;
+}
+
+/********************* 对外接口 *********************/
+void I2C1_DMA_Init(void)
+{
+    GPIO_InitTypeDef GPIO_InitStruct;
+    NVIC_InitTypeDef NVIC_InitStruct;
+
+    RCC_APB2PeriphClockCmd(I2C1_DMA_RCC, ENABLE);
+    RCC_APB1PeriphClockCmd(RCC_APB1Periph_I2C1, ENABLE);
+    RCC_AHBPeriphClockCmd(RCC_AHBPeriph_DMA1, ENABLE);
+
+    // PB6/PB7复用开漏输出（外部上拉）
+    GPIO_InitStruct.GPIO_Pin = I2C1_DMA_SCL_PIN | I2C1_DMA_SDA_PIN;
+    GPIO_InitStruct.GPIO_Mode = GPIO_Mode_AF_OD;
+    GPIO_InitStruct.GPIO_Speed = GPIO_Speed_50MHz;
+    GPIO_Init(I2C1_DMA_PORT, &GPIO_InitStruct);
+
+    I2C1_DMA_PeriphConfig();
+
+    // DMA1通道6（I2C1_TX）、通道7（I2C1_RX）外设地址固定为DR
+    DMA1_Channel6->CCR  = 0;
+    DMA1_Channel6->CPAR = (u32)&I2C1->DR;
+    DMA1_Channel7->CCR  = 0;
+    DMA1_Channel7->CPAR = (u32)&I2C1->DR;
+
+    NVIC_InitStruct.NVIC_IRQChannelPreemptionPriority = 1;
+    NVIC_InitStruct.NVIC_IRQChannelSubPriority = 0;
+    NVIC_InitStruct.NVIC_IRQChannelCmd = ENABLE;
+    NVIC_InitStruct.NVIC_IRQChannel = I2C1_EV_IRQn;
+    NVIC_Init(&NVIC_InitStruct);
+    NVIC_InitStruct.NVIC_IRQChannel = I2C1_ER_IRQn;
+    NVIC_Init(&NVIC_InitStruct);
+    NVIC_InitStruct.NVIC_IRQChannel = DMA1_Channel6_IRQn;
+    NVIC_Init(&NVIC_InitStruct);
+    NVIC_InitStruct.NVIC_IRQChannel = DMA1_Channel7_IRQn;
+    NVIC_Init(&NVIC_InitStruct);
+
+    i2c1_state = I2C1_STATE_IDLE;
+}
+
+I2C1_DMA_ResultTypeDef I2C1_DMA_WriteAsync(u8 addr, u8 reg, const u8 *data, u8 len,
+                                           I2C1_DMA_Callback cb, void *ctx)
+{
+    u8 i;
+
+    if(len > I2C1_DMA_MAX_LEN)
+        return I2C1_DMA_BUS_ERR;
+    if(i2c1_state != I2C1_STATE_IDLE)
+        return I2C1_DMA_BUSY;
+
+    i2c1_addr     = addr;
+    i2c1_is_read  = 0;
+    i2c1_is_probe = 0;
+    i2c1_no_ptr   = 0;
+    i2c1_tx_buf[0] = reg;
+    for(i=0; i<len; i++)
+        i2c1_tx_buf[1 + i] = data[i];
+    i2c1_tx_len = len + 1;
+
+    return I2C1_DMA_Start(cb, ctx);
+}
+
+I2C1_DMA_ResultTypeDef I2C1_DMA_ReadAsync(u8 addr, u8 reg, u8 *data, u8 len,
+                                          I2C1_DMA_Callback cb, void *ctx)
+{
+    // DMA接收依赖LAST位自动NACK，至少需要2个字节
+    if(len < 2)
+        return I2C1_DMA_BUS_ERR;
+    if(i2c1_state != I2C1_STATE_IDLE)
+        return I2C1_DMA_BUSY;
+
+    i2c1_addr     = addr;
+    i2c1_reg      = reg;
+    i2c1_is_read  = 1;
+    i2c1_is_probe = 0;
+    i2c1_no_ptr   = 0;
+    i2c1_rx_buf   = data;
+    i2c1_rx_len   = len;
+
+    return I2C1_DMA_Start(cb, ctx);
+}
+
+I2C1_DMA_ResultTypeDef I2C1_DMA_ReadCurrentAsync(u8 addr, u8 *data, u8 len,
+                                                 I2C1_DMA_Callback cb, void *ctx)
+{
+    if(len < 2)
+        return I2C1_DMA_BUS_ERR;
+    if(i2c1_state != I2C1_STATE_IDLE)
+        return I2C1_DMA_BUSY;
+
+    i2c1_addr     = addr;
+    i2c1_is_read  = 1;
+    i2c1_is_probe = 0;
+    i2c1_no_ptr   = 1;
+    i2c1_rx_buf   = data;
+    i2c1_rx_len   = len;
+
+    return I2C1_DMA_Start(cb, ctx);
+}
+
+// 中止当前传输：软件复位I2C1并重新配置，结果记为超时（不回调）
+void I2C1_DMA_Abort(void)
+{
+    I2C1->CR1 |= I2C_CR1_SWRST;
+    I2C1->CR1 &= ~I2C_CR1_SWRST;
+    I2C1_DMA_PeriphConfig();
+    i2c1_cb = 0;
+    I2C1_DMA_Finish(I2C1_DMA_TIMEOUT_ERR);
+}
+
+u8 I2C1_DMA_LineState(void)
+{
+    u8 state = 0;
+
+    if(!(I2C1_DMA_PORT->IDR & I2C1_DMA_SDA_PIN))
+        state |= I2C1_DMA_SDA_LOW;
+    if(!(I2C1_DMA_PORT->IDR & I2C1_DMA_SCL_PIN))
+        state |= I2C1_DMA_SCL_LOW;
+    return state;
+}
+
+// 半个100kHz周期（恢复时不追求速度）
+static void I2C1_DMA_HalfBit(void)
+{
+    u32 start = DWT->CYCCNT;
+    while((DWT->CYCCNT - start) < SystemCoreClock / 200000);
+}
+
+// 从机卡在字节中途拉住SDA时，I2C1只会一直报BUSY；外设无法自己产生多余时钟，
+// 需把引脚切为开漏GPIO手动补时钟，SDA释放后发STOP，最后复位外设并恢复复用功能
+u8 I2C1_DMA_Recover(void)
+{
+    GPIO_InitTypeDef GPIO_InitStruct;
+    u8 i;
+
+    I2C1->CR1 &= ~I2C_CR1_PE;
+    I2C1_DMA_PORT->BSRR = I2C1_DMA_SCL_PIN | I2C1_DMA_SDA_PIN;
+    GPIO_InitStruct.GPIO_Pin = I2C1_DMA_SCL_PIN | I2C1_DMA_SDA_PIN;
+    GPIO_InitStruct.GPIO_Mode = GPIO_Mode_Out_OD;
+    GPIO_InitStruct.GPIO_Speed = GPIO_Speed_50MHz;
+    GPIO_Init(I2C1_DMA_PORT, &GPIO_InitStruct);
+
+    for(i=0; i<I2C1_DMA_RECOVER_CLOCKS && !(I2C1_DMA_PORT->IDR & I2C1_DMA_SDA_PIN); i++)
+    {
+        I2C1_DMA_PORT->BRR = I2C1_DMA_SCL_PIN;
+        I2C1_DMA_HalfBit();
+        I2C1_DMA_PORT->BSRR = I2C1_DMA_SCL_PIN;
+        I2C1_DMA_HalfBit();
+    }
+    // STOP：SCL低时拉低SDA，SCL高后释放SDA
+    I2C1_DMA_PORT->BRR = I2C1_DMA_SCL_PIN;
+    I2C1_DMA_HalfBit();
+    I2C1_DMA_PORT->BRR = I2C1_DMA_SDA_PIN;
+    I2C1_DMA_HalfBit();
+    I2C1_DMA_PORT->BSRR = I2C1_DMA_SCL_PIN;
+    I2C1_DMA_HalfBit();
+    I2C1_DMA_PORT->BSRR = I2C1_DMA_SDA_PIN;
+    I2C1_DMA_HalfBit();
+
+    GPIO_InitStruct.GPIO_Mode = GPIO_Mode_AF_OD;
+    GPIO_Init(I2C1_DMA_PORT, &GPIO_InitStruct);
+    I2C1_DMA_Abort();
+    return I2C1_DMA_LineState();
+}
+
+u8 I2C1_DMA_IsBusy(void)
+{
+    return i2c1_state != I2C1_STATE_IDLE;
+}
+
+I2C1_DMA_ResultTypeDef I2C1_DMA_GetResult(void)
+{
+    return i2c1_result;
+}
+
+I2C1_DMA_ResultTypeDef I2C1_DMA_WriteReg(u8 addr, u8 reg, u16 data)
+{
+    u8 buf[2];
+    I2C1_DMA_ResultTypeDef res;
+
+    buf[0] = (data >> 8) & 0xFF;
+    buf[1] = data & 0xFF;
+    res = I2C1_DMA_WriteAsync(addr, reg, buf, 2, 0, 0);
+    if(res != I2C1_DMA_OK)
+        return res;
+    return I2C1_DMA_Wait();
+}
+
+I2C1_DMA_ResultTypeDef I2C1_DMA_ReadReg(u8 addr, u8 reg, u16 *data)
+{
+    u8 buf[2];
+    I2C1_DMA_ResultTypeDef res;
+
+    res = I2C1_DMA_ReadAsync(addr, reg, buf, 2, 0, 0);
+    if(res != I2C1_DMA_OK)
+        return res;
+    res = I2C1_DMA_Wait();
+    if(res == I2C1_DMA_OK)
+        *data = ((u16)buf[0] << 8) | buf[1];
+    return res;
+}
+
+I2C1_DMA_ResultTypeDef I2C1_DMA_ReadCurrent(u8 addr, u16 *data)
+{
+    u8 buf[2];
+    I2C1_DMA_ResultTypeDef res;
+
+    res = I2C1_DMA_ReadCurrentAsync(addr, buf, 2, 0, 0);
+    if(res != I2C1_DMA_OK)
+        return res;
+    res = I2C1_DMA_Wait();
+    if(res == I2C1_DMA_OK)
+        *data = ((u16)buf[0] << 8) | buf[1];
+    return res;
+}
+
+u8 I2C1_DMA_Probe(u8 addr)
+{
+    if(i2c1_state != I2C1_STATE_IDLE)
+        return 1;
+
+    i2c1_addr     = addr;
+    i2c1_is_read  = 0;
+    i2c1_is_probe = 1;
+    i2c1_no_ptr   = 0;
+    if(I2C1_DMA_Start(0, 0) != I2C1_DMA_OK)
+        return 1;
+    return I2C1_DMA_Wait() != I2C1_DMA_OK;
+}
+
+/********************* 中断服务函数 *********************/
+// I2C1事件中断：推进状态机
+void I2C1_EV_IRQHandler(void)
+{
+    u16 sr1 = I2C1->SR1;
+
+    switch(i2c1_state)
+    {
+        case I2C1_STATE_START_W:
+            if(sr1 & I2C_SR1_SB)
+            {
+                I2C1->DR = (u16)(i2c1_addr << 1);          // 读SR1+写DR清除SB
+                i2c1_state = I2C1_STATE_ADDR_W;
+            }
+            break;
+
+        case I2C1_STATE_ADDR_W:
+            if(sr1 & I2C_SR1_ADDR)
+            {
+                (void)I2C1->SR2;                           // 读SR1+SR2清除ADDR
+                if(i2c1_is_probe)
+                {
+                    I2C1->CR1 |= I2C_CR1_STOP;
+                    I2C1_DMA_Finish(I2C1_DMA_OK);
+                }
+                else if(i2c1_is_read)
+                {
+                    I2C1->DR = i2c1_reg;                   // 写寄存器指针
+                    i2c1_state = I2C1_STATE_PTR;
+                }
+                else
+                {
+                    i2c1_state = I2C1_STATE_TX;            // DMA接管后续字节
+                }
+            }
+            break;
+
+        case I2C1_STATE_TX:
+            // 最后一个字节移出且DMA已搬空，发送STOP
+            if((sr1 & I2C_SR1_BTF) && DMA1_Channel6->CNDTR == 0)
+            {
+                I2C1->CR1 |= I2C_CR1_STOP;
+                I2C1_DMA_Finish(I2C1_DMA_OK);
+            }
+            break;
+
+        case I2C1_STATE_PTR:
+            if(sr1 & I2C_SR1_BTF)
+            {
+                I2C1->CR1 |= I2C_CR1_START;                // 重复起始
+                i2c1_state = I2C1_STATE_START_R;
+            }
+            break;
+
+        case I2C1_STATE_START_R:
+            if(sr1 & I2C_SR1_SB)
+            {
+                // 在ADDR清除前准备好DMA接收，最后一个字节由LAST位自动NACK
+                DMA1_Channel7->CCR   = 0;
+                DMA1_Channel7->CMAR  = (u32)i2c1_rx_buf;
+                DMA1_Channel7->CNDTR = i2c1_rx_len;
+                DMA1_Channel7->CCR   = DMA_CCR1_MINC | DMA_CCR1_PL_1 | DMA_CCR1_TCIE | DMA_CCR1_TEIE;
+                DMA1_Channel7->CCR  |= DMA_CCR1_EN;
+                I2C1->CR2 |= I2C_CR2_DMAEN | I2C_CR2_LAST;
+                I2C1->CR1 |= I2C_CR1_ACK;
+
+                I2C1->DR = (u16)((i2c1_addr << 1) | 0x01);
+                i2c1_state = I2C1_STATE_ADDR_R;
+            }
+            break;
+
+        case I2C1_STATE_ADDR_R:
+            if(sr1 & I2C_SR1_ADDR)
+            {
+                (void)I2C1->SR2;                           // 清除ADDR，DMA开始接收
+                i2c1_state = I2C1_STATE_RX;
+            }
+            break;
+
+        default:
+            // 非预期事件：读SR2清除残留标志
+            (void)I2C1->SR2;
+            break;
+    }
+}
+
+// I2C1错误中断：NACK/总线错误/仲裁丢失
+void I2C1_ER_IRQHandler(void)
+{
+    u16 sr1 = I2C1->SR1;
+    I2C1_DMA_ResultTypeDef res;
+
+    res = (sr1 & I2C_SR1_AF) ? I2C1_DMA_NACK : I2C1_DMA_BUS_ERR;
+    I2C1->SR1 = (u16)~(I2C_SR1_AF | I2C_SR1_BERR | I2C_SR1_ARLO | I2C_SR1_OVR | I2C_SR1_TIMEOUT);
+
+    if(!(sr1 & I2C_SR1_ARLO))
+        I2C1->CR1 |= I2C_CR1_STOP;                      // 仲裁丢失时已自动退出主模式
+    if(i2c1_state != I2C1_STATE_IDLE)
+        I2C1_DMA_Finish(res);
+}
+
+// DMA1通道6（TX）：仅处理传输错误，正常结束由BTF事件收尾
+void DMA1_Channel6_IRQHandler(void)
+{
+    if(DMA1->ISR & DMA_ISR_TEIF6)
+    {
+        DMA1->IFCR = DMA_IFCR_CGIF6;
+        I2C1->CR1 |= I2C_CR1_STOP;
+        I2C1_DMA_Finish(I2C1_DMA_BUS_ERR);
+    }
+}
+
+// DMA1通道7（RX）：接收完成后发送STOP
+void DMA1_Channel7_IRQHandler(void)
+{
+    u32 isr = DMA1->ISR;
+
+    DMA1->IFCR = DMA_IFCR_CGIF7;
+    I2C1->CR1 |= I2C_CR1_STOP;
+    if(isr & DMA_ISR_TEIF7)
+        I2C1_DMA_Finish(I2C1_DMA_BUS_ERR);
+    else if(isr & DMA_ISR_TCIF7)
+        I2C1_DMA_Finish(I2C1_DMA_OK);
+}
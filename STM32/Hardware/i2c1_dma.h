@@ -0,0 +1,62 @@
+#ifndef __I2C1_DMA_H
+#define __I2C1_DMA_H
+
+#include "stm32f10x.h"
+
+/********************* 硬件I2C1引脚/速率定义 *********************/
+// 注意：I2C1固定映射为 PB6=SCL、PB7=SDA，
+// 与软件IIC的默认接线（PB7=SCL、PB6=SDA）相反，启用硬件后端前需对调两根线
+#define I2C1_DMA_SCL_PIN       GPIO_Pin_6
+#define I2C1_DMA_SDA_PIN       GPIO_Pin_7
+#define I2C1_DMA_PORT          GPIOB
+#define I2C1_DMA_RCC           RCC_APB2Periph_GPIOB
+#define I2C1_DMA_SPEED         400000   // Fast-mode 400kHz
+#define I2C1_DMA_MAX_LEN       4        // 单次传输最大数据字节数（寄存器均为16位）
+#define I2C1_DMA_TIMEOUT       100000   // 阻塞封装的最大等待次数
+#define I2C1_DMA_RECOVER_CLOCKS 9       // 总线恢复时补发的SCL时钟数
+#define I2C1_DMA_SDA_LOW       0x01     // 线路状态：SDA被拉低
+#define I2C1_DMA_SCL_LOW       0x02     // 线路状态：SCL被拉低
+
+// 传输结果
+typedef enum {
+    I2C1_DMA_OK = 0,     // 传输完成
+    I2C1_DMA_BUSY,       // 总线忙/上一次传输未完成
+    I2C1_DMA_NACK,       // 从机无应答
+    I2C1_DMA_BUS_ERR,    // 总线错误/仲裁丢失
+    I2C1_DMA_TIMEOUT_ERR // 软件超时
+} I2C1_DMA_ResultTypeDef;
+
+// 传输完成回调（在中断上下文中调用）
+typedef void (*I2C1_DMA_Callback)(I2C1_DMA_ResultTypeDef result, void *ctx);
+
+/********************* 函数声明 *********************/
+// I2C1 + DMA1通道6/7初始化
+void I2C1_DMA_Init(void);
+// 异步写：START + addr+W + reg + data[0..len-1] + STOP
+I2C1_DMA_ResultTypeDef I2C1_DMA_WriteAsync(u8 addr, u8 reg, const u8 *data, u8 len,
+                                           I2C1_DMA_Callback cb, void *ctx);
+// 异步读：START + addr+W + reg + RESTART + addr+R + DMA接收len字节(len>=2) + STOP
+I2C1_DMA_ResultTypeDef I2C1_DMA_ReadAsync(u8 addr, u8 reg, u8 *data, u8 len,
+                                          I2C1_DMA_Callback cb, void *ctx);
+// 异步读当前指针：START + addr+R + DMA接收len字节(len>=2) + STOP（指针须已由上一次访问指向目标寄存器）
+I2C1_DMA_ResultTypeDef I2C1_DMA_ReadCurrentAsync(u8 addr, u8 *data, u8 len,
+                                                 I2C1_DMA_Callback cb, void *ctx);
+// 中止当前传输并复位I2C1（用于上层超时处理）
+void I2C1_DMA_Abort(void);
+// 空闲时的线路状态（I2C1_DMA_SDA_LOW/SCL_LOW位组合）
+u8 I2C1_DMA_LineState(void);
+// 总线恢复：引脚临时切为GPIO补发时钟+STOP，再复位I2C1（返回恢复后的线路状态）
+u8 I2C1_DMA_Recover(void);
+// 当前是否有传输在进行
+u8 I2C1_DMA_IsBusy(void);
+// 上一次传输的结果
+I2C1_DMA_ResultTypeDef I2C1_DMA_GetResult(void);
+
+// 阻塞封装（等待完成期间CPU仍可响应其它中断）
+I2C1_DMA_ResultTypeDef I2C1_DMA_WriteReg(u8 addr, u8 reg, u16 data);
+I2C1_DMA_ResultTypeDef I2C1_DMA_ReadReg(u8 addr, u8 reg, u16 *data);
+I2C1_DMA_ResultTypeDef I2C1_DMA_ReadCurrent(u8 addr, u16 *data);
+// 地址探测：发送addr+W，返回0表示有应答
+u8 I2C1_DMA_Probe(u8 addr);
+
+#endif
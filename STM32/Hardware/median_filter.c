@@ -0,0 +1,81 @@
+#include "median_filter.h"
+#include <string.h>
+
+static u8 median_window = MEDIAN_WINDOW_SIZE;
+
+// 返回第一个不小于value的位置（0~n）
+static u8 Median_LowerBound(const u32 *sorted, u8 n, u32 value)
+{
+    u8 lo = 0, hi = n, mid;
+
+    while(lo < hi)
+    {
+        mid = (lo + hi) >> 1;
+        if(sorted[mid] < value)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+void Median_Init(Median_TypeDef *m)
+{
+    m->head = 0;
+    m->count = 0;
+}
+
+u32 Median_Update(Median_TypeDef *m, u32 value)
+{
+    u32 *s = m->sorted;
+    u32 old;
+    u8 n = median_window, old_pos, pos;
+
+    // 窗口未满：直接插入
+    if(m->count < n)
+    {
+        pos = Median_LowerBound(s, m->count, value);
+        memmove(&s[pos + 1], &s[pos], (m->count - pos) * sizeof(u32));
+        s[pos] = value;
+        m->ring[m->count] = value;
+        m->count++;
+        return s[(m->count - 1) / 2];
+    }
+
+    // 窗口已满：新样本替换最旧样本
+    old = m->ring[m->head];
+    m->ring[m->head] = value;
+    if(++m->head >= n)
+        m->head = 0;
+    if(value == old)
+        return s[n / 2];
+
+    old_pos = Median_LowerBound(s, n, old);
+    pos = Median_LowerBound(s, n, value);
+    if(value > old)
+    {
+        // (old_pos, pos)之间的元素左移一位，新值落在pos-1
+        memmove(&s[old_pos], &s[old_pos + 1], (pos - 1 - old_pos) * sizeof(u32));
+        s[pos - 1] = value;
+    }
+    else
+    {
+        // [pos, old_pos)之间的元素右移一位，新值落在pos
+        memmove(&s[pos + 1], &s[pos], (old_pos - pos) * sizeof(u32));
+        s[pos] = value;
+    }
+    return s[n / 2];
+}
+
+u8 Median_SetWindow(u8 size)
+{
+    if(size < 3 || size > MEDIAN_WINDOW_MAX || (size % 2) == 0)
+        return 1;
+    median_window = size;
+    return 0;
+}
+
+u8 Median_GetWindow(void)
+{
+    return median_window;
+}
@@ -0,0 +1,46 @@
+#ifndef __MEDIAN_FILTER_H
+#define __MEDIAN_FILTER_H
+
+#include "stm32f10x.h"
+
+/********************* 流式中值滤波 *********************/
+// 存储按窗口上限MEDIAN_WINDOW_MAX（奇数，3~63）随实例静态分配；
+// 实际窗口MEDIAN_WINDOW_SIZE为默认值，运行时可在3~MEDIAN_WINDOW_MAX之间调整（set median）
+// 上限是编译选项：缺省15，每个传感器占用8*15=120字节；噪声大的安装需要15~63的窗口时，
+// 在工程C/C++选项的Define中加 MEDIAN_WINDOW_MAX=63（每个传感器504字节，8个传感器约4KB RAM）。
+// 超过上限的set median在运行时被拒绝，并提示当前编译的上限
+#ifndef MEDIAN_WINDOW_MAX
+#define MEDIAN_WINDOW_MAX   15
+#endif
+#ifndef MEDIAN_WINDOW_SIZE
+#define MEDIAN_WINDOW_SIZE  3
+#endif
+
+#if (MEDIAN_WINDOW_MAX < 3) || (MEDIAN_WINDOW_MAX > 63) || ((MEDIAN_WINDOW_MAX % 2) == 0)
+#error "MEDIAN_WINDOW_MAX 须为3~63之间的奇数"
+#endif
+#if (MEDIAN_WINDOW_SIZE < 3) || (MEDIAN_WINDOW_SIZE > MEDIAN_WINDOW_MAX) || ((MEDIAN_WINDOW_SIZE % 2) == 0)
+#error "MEDIAN_WINDOW_SIZE 须为3~MEDIAN_WINDOW_MAX之间的奇数"
+#endif
+
+// ring按到达顺序保存样本，sorted始终有序：
+// 每个样本二分查找旧值与新值的位置，只搬移两者之间的元素，不复制、不整体排序
+typedef struct {
+    u32 ring[MEDIAN_WINDOW_MAX];
+    u32 sorted[MEDIAN_WINDOW_MAX];
+    u8  head;    // 最旧样本在ring中的位置
+    u8  count;   // 已填充样本数（未满时取已有样本的中值）
+} Median_TypeDef;
+
+// 零初始化即为空窗口
+#define MEDIAN_INIT  { {0}, {0}, 0, 0 }
+
+/********************* 函数声明 *********************/
+void Median_Init(Median_TypeDef *m);
+// 加入新样本，返回当前窗口中值
+u32  Median_Update(Median_TypeDef *m, u32 value);
+// 设置所有实例的窗口大小（返回0：成功，1：不是3~MEDIAN_WINDOW_MAX的奇数）；各实例须随后清空
+u8   Median_SetWindow(u8 size);
+u8   Median_GetWindow(void);
+
+#endif
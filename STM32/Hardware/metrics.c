@@ -0,0 +1,31 @@
+#include "metrics.h"
+
+Metrics_RegistryTypeDef Metrics_Registry;
+
+// 登记表超出RAM预算时数组长度为负，编译失败
+typedef char Metrics_BudgetCheck[(sizeof(Metrics_RegistryTypeDef) <= METRICS_RAM_BUDGET) ? 1 : -1];
+
+static const char *const counter_names[METRIC_COUNTERS] = {
+    "nack_aw", "nack_reg", "nack_data", "nack_ar", "nack_hw", "bus_busy", "timeout", "retry",
+    "range", "jump", "ring_ovf", "tx_drop", "rx_drop", "rx_ovr", "bus_rec"
+};
+
+static const char *const hist_names[METRIC_HISTS] = {
+    "i2c", "loop"
+};
+
+void Metrics_Set(Metrics_CounterTypeDef id, u32 value)
+{
+    if(id < METRIC_COUNTERS)
+        Metrics_Registry.counter[id] = value;
+}
+
+const char *Metrics_CounterName(Metrics_CounterTypeDef id)
+{
+    return id < METRIC_COUNTERS ? counter_names[id] : "?";
+}
+
+const char *Metrics_HistName(Metrics_HistTypeDef id)
+{
+    return id < METRIC_HISTS ? hist_names[id] : "?";
+}
@@ -0,0 +1,62 @@
+#ifndef __METRICS_H
+#define __METRICS_H
+
+#include "stm32f10x.h"
+
+/********************* 驱动计数器与耗时直方图 *********************/
+// 固定大小的静态登记表：计数器只增不减（32位自然回绕），
+// 直方图按log2分桶统计DWT周期数：第k桶为[2^(k-1), 2^k)，第0桶为0周期，最后一桶收纳更大的值。
+// 每次更新只是一次数组自增（直方图多一条CLZ），可以放在中断和IIC位操作路径上
+#define METRICS_ENABLE      1
+#define METRICS_BUCKETS     24        // 最大桶下限2^22周期（72MHz下约58ms）
+#define METRICS_RAM_BUDGET  512       // 登记表RAM上限（字节），超出时编译报错
+
+typedef enum {
+    METRIC_NACK_ADDR_W = 0,    // 地址+写无应答
+    METRIC_NACK_REG,           // 寄存器地址无应答
+    METRIC_NACK_DATA,          // 写数据无应答
+    METRIC_NACK_ADDR_R,        // 地址+读无应答
+    METRIC_NACK_HW,            // 硬件I2C1无应答/总线错误（不区分阶段）
+    METRIC_BUS_BUSY,           // START时总线未释放
+    METRIC_I2C_TIMEOUT,        // 事务超时
+    METRIC_I2C_RETRY,          // 事务重试
+    METRIC_RANGE_ERR,          // 量程异常样本
+    METRIC_JUMP_REJECT,        // 跳变待确认而未输出的样本
+    METRIC_RING_OVERRUN,       // 样本环形缓冲溢出（由sample_ring同步）
+    METRIC_UART_TX_DROP,       // 串口发送背压丢弃字节（由usart1_dma同步）
+    METRIC_UART_RX_DROP,       // 串口接收缓冲满丢弃字节（由usart1_rx同步）
+    METRIC_UART_RX_OVERRUN,    // 串口接收硬件溢出（由usart1_rx同步）
+    METRIC_BUS_RECOVERY,       // 总线恢复序列执行次数
+    METRIC_COUNTERS
+} Metrics_CounterTypeDef;
+
+typedef enum {
+    METRIC_HIST_I2C_XFER = 0,  // 单次异步IIC事务耗时（从发起到完成，含每个重试的单次尝试）
+    METRIC_HIST_LOOP,          // 主循环单次迭代的运行时间（不含睡眠）
+    METRIC_HISTS
+} Metrics_HistTypeDef;
+
+typedef struct {
+    u32 counter[METRIC_COUNTERS];
+    u32 hist[METRIC_HISTS][METRICS_BUCKETS];
+} Metrics_RegistryTypeDef;
+
+extern Metrics_RegistryTypeDef Metrics_Registry;
+
+#if METRICS_ENABLE
+#define METRICS_BUCKET(cycles) \
+    ((cycles) >= (1UL << (METRICS_BUCKETS - 1)) ? (METRICS_BUCKETS - 1) : (32 - __CLZ(cycles)))
+#define METRIC_INC(id)            (Metrics_Registry.counter[id]++)
+#define METRIC_HIST(id, cycles)   (Metrics_Registry.hist[id][METRICS_BUCKET(cycles)]++)
+#else
+#define METRIC_INC(id)
+#define METRIC_HIST(id, cycles)
+#endif
+
+/********************* 函数声明 *********************/
+// 由其它模块维护的计数器在导出前同步到登记表
+void Metrics_Set(Metrics_CounterTypeDef id, u32 value);
+const char *Metrics_CounterName(Metrics_CounterTypeDef id);
+const char *Metrics_HistName(Metrics_HistTypeDef id);
+
+#endif
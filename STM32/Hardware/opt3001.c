@@ -1,363 +1,626 @@
 #include "opt3001.h"
 #include "delay.h"  
+#include "metrics.h"
 
-/********************* 微秒级延时封装（加static消除原型警告） *********************/
-static void OPT3001_DelayUs(u32 us)
+/********************* 总线时序（DWT周期数，OPT3001_IIC_Init中按主频校准） *********************/
+static u32 iic_t_low;    // SCL低电平保持（含tSU;DAT）
+static u32 iic_t_high;   // SCL高电平保持（含tSU;STA/tHD;STA/tSU;STO）
+static u32 iic_t_buf;    // STOP到下一次START的总线空闲时间
+
+/********************* 软件IIC总线统计 *********************/
+#if OPT3001_IIC_STATS
+static OPT3001_IIC_StatsTypeDef iic_stats;
+#define IIC_STAT_INC(field)  (iic_stats.field++)
+#else
+#define IIC_STAT_INC(field)
+#endif
+
+// 基于DWT周期计数器的忙等，起点取自调用时刻
+static void OPT3001_IIC_Wait(u32 cycles)
+{
+    u32 start = DWT->CYCCNT;
+    while((DWT->CYCCNT - start) < cycles);
+}
+
+// 释放SCL并等待其真正变高（从机时钟延展时会被拉住，带超时）
+static void OPT3001_IIC_SCL_Release(const OPT3001_BusTypeDef *bus)
+{
+    u32 start;
+
+    IIC_SCL_HIGH(bus);
+    IIC_STAT_INC(scl_pulses);
+    start = DWT->CYCCNT;
+    while(!IIC_SCL_READ(bus) && (DWT->CYCCNT - start) < OPT3001_IIC_STRETCH_CYC);
+}
+
+// 纳秒换算为DWT周期，并扣除单个半周期内引脚操作的固定开销
+static u32 OPT3001_IIC_NsToCycles(u32 ns, u32 overhead)
 {
-    Delay_us(us+10); // 调用通用延时函数
+    u32 cycles = (ns * (SystemCoreClock / 1000000) + 999) / 1000;
+    return (cycles > overhead) ? (cycles - overhead) : 0;
 }
 
 /********************* IIC底层驱动实现 *********************/
-// IIC引脚初始化（推挽输出，软件控制电平）
-void OPT3001_IIC_Init(void)
+// IIC引脚初始化（开漏输出，外部上拉；SDA读写无需切换方向）
+void OPT3001_IIC_Init(const OPT3001_BusTypeDef *bus)
 {
     GPIO_InitTypeDef GPIO_InitStruct;
+    u32 start, overhead;
     
     // 使能GPIO时钟
-    RCC_APB2PeriphClockCmd(OPT3001_IIC_RCC, ENABLE);
+    RCC_APB2PeriphClockCmd(bus->rcc, ENABLE);
     
-    // 配置SCL和SDA引脚为推挽输出
-    GPIO_InitStruct.GPIO_Pin = OPT3001_IIC_SCL_PIN | OPT3001_IIC_SDA_PIN;
-    GPIO_InitStruct.GPIO_Mode = GPIO_Mode_Out_PP;  // 推挽输出
+    // 配置SCL和SDA引脚为开漏输出：写1释放总线，IDR可直接读回实际电平
+    GPIO_InitStruct.GPIO_Pin = bus->scl_pin | bus->sda_pin;
+    GPIO_InitStruct.GPIO_Mode = GPIO_Mode_Out_OD;
     GPIO_InitStruct.GPIO_Speed = GPIO_Speed_50MHz;
-    GPIO_Init(OPT3001_IIC_PORT, &GPIO_InitStruct);
+    GPIO_Init(bus->port, &GPIO_InitStruct);
     
     // 初始化IIC总线为高电平
-    IIC_SCL_HIGH();
-    IIC_SDA_HIGH();
+    IIC_SCL_HIGH(bus);
+    IIC_SDA_HIGH(bus);
+
+    // 校准（各总线共用同一套时序，只做一次）：
+    // 测量一次“释放SCL+零等待”的实际开销，只从高电平半周期中扣除——
+    // 每个时钟只有一次释放，从低电平里再扣一次会使周期短于标称（100kHz下约101kHz）
+    if(iic_t_high != 0)
+        return;
+    DWT_Init();
+    start = DWT->CYCCNT;
+    OPT3001_IIC_SCL_Release(bus);
+    OPT3001_IIC_Wait(0);
+    overhead = DWT->CYCCNT - start;
+
+    iic_t_low  = OPT3001_IIC_NsToCycles(OPT3001_IIC_T_LOW_NS,  0);
+    iic_t_high = OPT3001_IIC_NsToCycles(OPT3001_IIC_T_HIGH_NS, overhead);
+    iic_t_buf  = OPT3001_IIC_NsToCycles(OPT3001_IIC_T_BUF_NS,  0);
 }
 
 // IIC起始信号：SCL高电平时，SDA由高变低
-void OPT3001_IIC_Start(void)
+// 释放两根线后仍读到低电平说明有从机占住总线，此时不发START，由上层按通信失败处理
+u8 OPT3001_IIC_Start(const OPT3001_BusTypeDef *bus)
 {
-    IIC_SDA_HIGH();
-    IIC_SCL_HIGH();
-    OPT3001_DelayUs(2);
-    IIC_SDA_LOW();
-    OPT3001_DelayUs(2);
-    IIC_SCL_LOW();  // 拉低SCL，准备发送/接收数据
+    IIC_STAT_INC(starts);
+    IIC_SDA_HIGH(bus);
+    if(!IIC_SCL_READ(bus))
+        OPT3001_IIC_Wait(iic_t_low);    // 重复起始：SCL仍为低，补足tLOW/tSU;DAT后再释放
+    OPT3001_IIC_SCL_Release(bus);
+    OPT3001_IIC_Wait(iic_t_high);   // tSU;STA（重复起始时）
+    if(!IIC_SDA_READ(bus) || !IIC_SCL_READ(bus))
+    {
+        METRIC_INC(METRIC_BUS_BUSY);
+        return 1;
+    }
+    IIC_SDA_LOW(bus);
+    OPT3001_IIC_Wait(iic_t_high);   // tHD;STA
+    IIC_SCL_LOW(bus);               // 拉低SCL，准备发送/接收数据
+    return 0;
 }
 
 // IIC停止信号：SCL高电平时，SDA由低变高
-void OPT3001_IIC_Stop(void)
+void OPT3001_IIC_Stop(const OPT3001_BusTypeDef *bus)
 {
-    IIC_SDA_LOW();
-    IIC_SCL_HIGH();
-    OPT3001_DelayUs(2);
-    IIC_SDA_HIGH();
-    OPT3001_DelayUs(2);
+    IIC_SDA_LOW(bus);
+    OPT3001_IIC_Wait(iic_t_low);
+    OPT3001_IIC_SCL_Release(bus);
+    OPT3001_IIC_Wait(iic_t_high);   // tSU;STO
+    IIC_SDA_HIGH(bus);
+    OPT3001_IIC_Wait(iic_t_buf);    // tBUF
 }
 
 // IIC等待应答（返回1：无应答，0：有应答）
-// IIC等待应答
-u8 OPT3001_IIC_WaitAck(void)
+u8 OPT3001_IIC_WaitAck(const OPT3001_BusTypeDef *bus)
 {
-    u8 timeout = 0;
+    u8 nack;
     
-    SDA_IN();        // 【关键】切为输入模式，STM32停止强压3.3V
-    OPT3001_DelayUs(1);
-    IIC_SCL_HIGH();
-    OPT3001_DelayUs(1);
+    IIC_SDA_HIGH(bus);              // 释放SDA，由从机拉低应答
+    OPT3001_IIC_Wait(iic_t_low);
+    OPT3001_IIC_SCL_Release(bus);
+    OPT3001_IIC_Wait(iic_t_high);
+    nack = IIC_SDA_READ(bus) ? 1 : 0;
+    IIC_SCL_LOW(bus); 
     
-    while(IIC_SDA_READ()) // 此时 OPT3004 就能轻松把 SDA 拉低了
-    {
-        timeout++;
-        if(timeout > 250)
-        {
-            OPT3001_IIC_Stop();
-            SDA_OUT(); // 【关键】超时退出前切回输出
-            return 1; 
-        }
-    }
-    
-    IIC_SCL_LOW(); 
-    SDA_OUT();       // 【关键】收到应答后，切回推挽输出准备下一步发送
-    return 0;       
+    if(nack)
+        OPT3001_IIC_Stop(bus);      // 无应答：结束本次传输
+    return nack;       
 }
 
 // IIC发送应答（ack=0：发送应答，ack=1：发送非应答）
-void OPT3001_IIC_SendAck(u8 ack)
+void OPT3001_IIC_SendAck(const OPT3001_BusTypeDef *bus, u8 ack)
 {
-    IIC_SCL_LOW();
     if(ack)
-        IIC_SDA_HIGH();  // 非应答
+        IIC_SDA_HIGH(bus);  // 非应答
     else
-        IIC_SDA_LOW();   // 应答
-    OPT3001_DelayUs(1);
-    IIC_SCL_HIGH();      // 高电平期间，从机读取应答
-    OPT3001_DelayUs(1);
-    IIC_SCL_LOW();       // 拉低SCL
-    IIC_SDA_HIGH();      // 释放SDA
+        IIC_SDA_LOW(bus);   // 应答
+    OPT3001_IIC_Wait(iic_t_low);
+    OPT3001_IIC_SCL_Release(bus);   // 高电平期间，从机读取应答
+    OPT3001_IIC_Wait(iic_t_high);
+    IIC_SCL_LOW(bus);    // 拉低SCL
+    IIC_SDA_HIGH(bus);   // 释放SDA
 }
 
-// IIC发送一个字节
-void OPT3001_IIC_SendByte(u8 byte)
+// IIC发送一个字节（调用前SCL为低）
+void OPT3001_IIC_SendByte(const OPT3001_BusTypeDef *bus, u8 byte)
 {
     u8 i;
     
-    IIC_SCL_LOW();  // 拉低SCL，准备发送
+    IIC_STAT_INC(bytes);
     for(i=0; i<8; i++)
     {
         // 发送最高位
         if(byte & 0x80)
-            IIC_SDA_HIGH();
+            IIC_SDA_HIGH(bus);
         else
-            IIC_SDA_LOW();
+            IIC_SDA_LOW(bus);
         byte <<= 1;
-        OPT3001_DelayUs(1);
-        IIC_SCL_HIGH();  // 高电平期间，从机读取数据
-        OPT3001_DelayUs(1);
-        IIC_SCL_LOW();   // 拉低SCL，准备下一位
+        OPT3001_IIC_Wait(iic_t_low);    // tSU;DAT包含在低电平时间内
+        OPT3001_IIC_SCL_Release(bus);   // 高电平期间，从机读取数据
+        OPT3001_IIC_Wait(iic_t_high);
+        IIC_SCL_LOW(bus);               // 拉低SCL，准备下一位
     }
-    OPT3001_DelayUs(1);
 }
 
 // IIC接收一个字节（ack=0：发送应答，ack=1：发送非应答）
-// IIC接收一个字节
-u8 OPT3001_IIC_ReceiveByte(u8 ack)
+u8 OPT3001_IIC_ReceiveByte(const OPT3001_BusTypeDef *bus, u8 ack)
 {
     u8 i, byte = 0;
     
-    SDA_IN();        // 【关键】准备接收数据，切为输入模式
+    IIC_STAT_INC(bytes);
+    IIC_SDA_HIGH(bus);                  // 释放SDA，开漏模式下即可读取从机数据
     
     for(i=0; i<8; i++)
     {
-        IIC_SCL_LOW();
-        OPT3001_DelayUs(1);
-        IIC_SCL_HIGH();  
+        OPT3001_IIC_Wait(iic_t_low);
+        OPT3001_IIC_SCL_Release(bus);
+        OPT3001_IIC_Wait(iic_t_high);
         byte <<= 1;
-        if(IIC_SDA_READ())
+        if(IIC_SDA_READ(bus))
             byte |= 0x01;
-        OPT3001_DelayUs(1);
+        IIC_SCL_LOW(bus);
     }
     
-    SDA_OUT();       // 【关键】8位全部读完，切回输出模式以发送应答(ACK)
-    OPT3001_IIC_SendAck(ack);  
+    OPT3001_IIC_SendAck(bus, ack);  
     return byte;
 }
+
+// 空闲时两根线都应被上拉为高
+static u8 OPT3001_IIC_LineState(const OPT3001_BusTypeDef *bus)
+{
+    u8 state = 0;
+
+    IIC_SCL_HIGH(bus);
+    IIC_SDA_HIGH(bus);
+    OPT3001_IIC_Wait(iic_t_high);
+    if(!IIC_SDA_READ(bus))
+        state |= OPT3001_BUS_SDA_LOW;
+    if(!IIC_SCL_READ(bus))
+        state |= OPT3001_BUS_SCL_LOW;
+    return state;
+}
+
+// 总线恢复：SDA释放前逐个补发SCL时钟（最多9个），从机移出剩余位后会在某个时钟高电平释放SDA，
+// 随后发STOP让所有从机的状态机回到空闲
+static u8 OPT3001_IIC_Recover(const OPT3001_BusTypeDef *bus)
+{
+    u8 i;
+
+    IIC_SDA_HIGH(bus);
+    for(i=0; i<OPT3001_IIC_RECOVER_CLOCKS && !IIC_SDA_READ(bus); i++)
+    {
+        IIC_SCL_LOW(bus);
+        OPT3001_IIC_Wait(iic_t_low);
+        OPT3001_IIC_SCL_Release(bus);
+        OPT3001_IIC_Wait(iic_t_high);
+    }
+    IIC_SCL_LOW(bus);
+    OPT3001_IIC_Stop(bus);
+    return OPT3001_IIC_LineState(bus);
+}
+
+#if OPT3001_IIC_STATS
+void OPT3001_IIC_GetStats(OPT3001_IIC_StatsTypeDef *stats)
+{
+    *stats = iic_stats;
+}
+
+void OPT3001_IIC_ResetStats(void)
+{
+    iic_stats.scl_pulses = 0;
+    iic_stats.bytes = 0;
+    iic_stats.starts = 0;
+}
+#endif
+
+/********************* 默认总线与兼容接口使用的默认实例 *********************/
+const OPT3001_BusTypeDef OPT3001_DefaultBus = {
+    OPT3001_USE_HW_I2C, OPT3001_IIC_PORT, OPT3001_IIC_SCL_PIN, OPT3001_IIC_SDA_PIN, OPT3001_IIC_RCC
+};
+
+static OPT3001_HandleTypeDef opt3001_default = OPT3001_HANDLE_INIT(&OPT3001_DefaultBus, OPT3001_ADDR, 0);
+
+/********************* 总线级操作（按总线类型分派） *********************/
+void OPT3001_Bus_Init(const OPT3001_BusTypeDef *bus)
+{
+#if OPT3001_USE_HW_I2C
+    if(bus->hw)
+    {
+        I2C1_DMA_Init();
+        return;
+    }
+#endif
+    OPT3001_IIC_Init(bus);
+}
+
+// 地址探测：发送addr+W后检查应答
+u8 OPT3001_Bus_Probe(const OPT3001_BusTypeDef *bus, u8 addr)
+{
+    u8 nack;
+
+#if OPT3001_USE_HW_I2C
+    if(bus->hw)
+        return I2C1_DMA_Probe(addr);
+#endif
+    if(OPT3001_IIC_Start(bus))
+        return 1;
+    OPT3001_IIC_SendByte(bus, addr << 1);
+    nack = OPT3001_IIC_WaitAck(bus);    // 无应答时WaitAck内部已发STOP
+    if(!nack)
+        OPT3001_IIC_Stop(bus);
+    return nack;
+}
+
+u8 OPT3001_Bus_IsStuck(const OPT3001_BusTypeDef *bus)
+{
+#if OPT3001_USE_HW_I2C
+    if(bus->hw)
+        return I2C1_DMA_LineState();
+#endif
+    return OPT3001_IIC_LineState(bus);
+}
+
+u8 OPT3001_Bus_Recover(const OPT3001_BusTypeDef *bus)
+{
+#if OPT3001_USE_HW_I2C
+    if(bus->hw)
+        return I2C1_DMA_Recover();
+#endif
+    return OPT3001_IIC_Recover(bus);
+}
+
 /********************* OPT3001传感器驱动实现 *********************/
 // 写OPT3001寄存器（16位数据）
-u8 OPT3001_WriteReg(u8 reg_addr, u16 data)
+// 写操作同时改变器件的寄存器指针：先作废缓存，成功后记为该寄存器
+u8 OPT3001_Sensor_WriteReg(OPT3001_HandleTypeDef *h, u8 reg_addr, u16 data)
 {
-    OPT3001_IIC_Start();
+    const OPT3001_BusTypeDef *bus = h->bus;
+
+    h->reg_ptr = OPT3001_PTR_UNKNOWN;
+#if OPT3001_USE_HW_I2C
+    // 硬件I2C1后端：DMA搬运数据，等待期间仅轮询完成标志
+    if(bus->hw)
+    {
+        if(I2C1_DMA_WriteReg(h->addr, reg_addr, data) != I2C1_DMA_OK)
+            return 1;
+        h->reg_ptr = reg_addr;
+        return 0;
+    }
+#endif
+    if(OPT3001_IIC_Start(bus))
+        return 1;
     // 发送从机地址+写命令（0x44<<1 | 0 = 0x88）
-    OPT3001_IIC_SendByte(OPT3001_ADDR << 1);
-    if(OPT3001_IIC_WaitAck())  // 等待从机应答
+    OPT3001_IIC_SendByte(bus, h->addr << 1);
+    if(OPT3001_IIC_WaitAck(bus))  // 等待从机应答
+    {
+        METRIC_INC(METRIC_NACK_ADDR_W);
         return 1;
+    }
     
     // 发送寄存器地址
-    OPT3001_IIC_SendByte(reg_addr);
-    if(OPT3001_IIC_WaitAck())
+    OPT3001_IIC_SendByte(bus, reg_addr);
+    if(OPT3001_IIC_WaitAck(bus))
+    {
+        METRIC_INC(METRIC_NACK_REG);
         return 1;
+    }
     
     // 发送高8位数据
-    OPT3001_IIC_SendByte((data >> 8) & 0xFF);
-    if(OPT3001_IIC_WaitAck())
+    OPT3001_IIC_SendByte(bus, (data >> 8) & 0xFF);
+    if(OPT3001_IIC_WaitAck(bus))
+    {
+        METRIC_INC(METRIC_NACK_DATA);
         return 1;
+    }
     
     // 发送低8位数据
-    OPT3001_IIC_SendByte(data & 0xFF);
-    if(OPT3001_IIC_WaitAck())
+    OPT3001_IIC_SendByte(bus, data & 0xFF);
+    if(OPT3001_IIC_WaitAck(bus))
+    {
+        METRIC_INC(METRIC_NACK_DATA);
         return 1;
+    }
     
-    OPT3001_IIC_Stop();
+    OPT3001_IIC_Stop(bus);
+    h->reg_ptr = reg_addr;
     return 0;  // 写入成功
 }
 
 // 读OPT3001寄存器（16位数据）
-u16 OPT3001_ReadReg(u8 reg_addr)
+// 缓存的指针与目标寄存器一致时直接从 START + addr+R 开始（见OPT3001_PTR_CACHE）
+u16 OPT3001_Sensor_ReadReg(OPT3001_HandleTypeDef *h, u8 reg_addr)
 {
+    const OPT3001_BusTypeDef *bus = h->bus;
+    u8 cached = OPT3001_PTR_CACHE && h->reg_ptr == reg_addr;
     u16 data = 0;
     
-    OPT3001_IIC_Start();
-    // 发送从机地址+写命令
-    OPT3001_IIC_SendByte(OPT3001_ADDR << 1);
-    if(OPT3001_IIC_WaitAck())
-        return 0xFFFF;  // 读取失败
+    h->reg_ptr = OPT3001_PTR_UNKNOWN;
+#if OPT3001_USE_HW_I2C
+    if(bus->hw)
+    {
+        if((cached ? I2C1_DMA_ReadCurrent(h->addr, &data)
+                   : I2C1_DMA_ReadReg(h->addr, reg_addr, &data)) != I2C1_DMA_OK)
+            return 0xFFFF;  // 读取失败
+        h->reg_ptr = reg_addr;
+        return data;
+    }
+#endif
+    if(!cached)
+    {
+        if(OPT3001_IIC_Start(bus))
+            return 0xFFFF;
+        // 发送从机地址+写命令
+        OPT3001_IIC_SendByte(bus, h->addr << 1);
+        if(OPT3001_IIC_WaitAck(bus))
+        {
+            METRIC_INC(METRIC_NACK_ADDR_W);
+            return 0xFFFF;  // 读取失败
+        }
+        
+        // 发送寄存器地址
+        OPT3001_IIC_SendByte(bus, reg_addr);
+        if(OPT3001_IIC_WaitAck(bus))
+        {
+            METRIC_INC(METRIC_NACK_REG);
+            return 0xFFFF;
+        }
+    }
     
-    // 发送寄存器地址
-    OPT3001_IIC_SendByte(reg_addr);
-    if(OPT3001_IIC_WaitAck())
+    // （重复）起始信号
+    if(OPT3001_IIC_Start(bus))
         return 0xFFFF;
-    
-    // 重复起始信号
-    OPT3001_IIC_Start();
     // 发送从机地址+读命令（0x44<<1 | 1 = 0x89）
-    OPT3001_IIC_SendByte((OPT3001_ADDR << 1) | 0x01);
-    if(OPT3001_IIC_WaitAck())
+    OPT3001_IIC_SendByte(bus, (h->addr << 1) | 0x01);
+    if(OPT3001_IIC_WaitAck(bus))
+    {
+        METRIC_INC(METRIC_NACK_ADDR_R);
         return 0xFFFF;
+    }
     
     // 接收高8位（发送应答）- 修复函数名笔误
-    data = OPT3001_IIC_ReceiveByte(0) << 8;
+    data = OPT3001_IIC_ReceiveByte(bus, 0) << 8;
     // 接收低8位（发送非应答）
-    data |= OPT3001_IIC_ReceiveByte(1);
+    data |= OPT3001_IIC_ReceiveByte(bus, 1);
     
-    OPT3001_IIC_Stop();
+    OPT3001_IIC_Stop(bus);
+    h->reg_ptr = reg_addr;
     return data;
 }
 
-// OPT3001初始化（连续转换模式，100ms转换一次）
-u8 OPT3001_Init(void)
+// OPT3001初始化（连续转换模式，写入后回读校验）
+u8 OPT3001_Sensor_Init(OPT3001_HandleTypeDef *h)
 {
-    u16 config = 0;
-    
-    // 初始化IIC总线
-    OPT3001_IIC_Init();
-    
-    // 配置寄存器：
-    // - 12-13位：MODE=11（连续转换模式）
-    // - 9-11位：CONV_TIME=100（转换时间100ms）
-    // - 其余位：默认值
-    config = 0xCE00;
-    
-	// 1. 测试写入（如果这步报错，说明地址不对、线没接好、或没收到ACK）
-    if(OPT3001_WriteReg(OPT3001_CONFIG_REG, config) != 0)
-    {
-        //printf("Debug: I2C通信失败，未收到ACK响应\r\n");
-        return 1;  
-    }
-	
-    // 写入配置寄存器
-    if(OPT3001_WriteReg(OPT3001_CONFIG_REG, config) != 0)
+    // 配置寄存器：自动量程、800ms转换、连续转换、INT锁存（见OPT3001_CONFIG_DEFAULT）
+    // 写入失败说明地址不对、线没接好、或没收到ACK
+    if(OPT3001_Sensor_WriteReg(h, OPT3001_CONFIG_REG, OPT3001_CONFIG_DEFAULT) != 0)
         return 1;  // 初始化失败
+    if(OPT3001_Sensor_EnableEoc(h) != 0)
+        return 1;
     
-    // 验证配置是否写入成功
-    if(OPT3001_ReadReg(OPT3001_CONFIG_REG) != config)
+    // 验证配置是否写入成功（只比较可写位，忽略OVF/CRF/FH/FL等只读标志）
+    if((OPT3001_Sensor_ReadReg(h, OPT3001_CONFIG_REG) & 0xFE1F) != OPT3001_CONFIG_DEFAULT)
         return 1;
     
     return 0;  // 初始化成功
 }
 
-// 读取光照强度（单位：lux）
-float OPT3001_ReadLux(void)
+// 读ID确认器件（只访问已知候选地址，不做全地址扫描）
+u8 OPT3001_Sensor_Identify(OPT3001_HandleTypeDef *h)
 {
-    u16 raw_data;
-    u8 exponent;
-    u16 mantissa;
-    float lux;
-    
-    // 读取结果寄存器
-    raw_data = OPT3001_ReadReg(OPT3001_RESULT_REG);
-    if(raw_data == 0xFFFF)
-        return -1.0f;  // 读取失败
-    
-    // 解析原始数据：高4位=指数，低12位=尾数
-    exponent = (raw_data >> 12) & 0x0F;
-    mantissa = raw_data & 0x0FFF;
-    
-    // 计算光照值（显式类型转换，消除警告）
-    lux = (float)mantissa * (float)(1 << exponent) * 0.01f;
-    
-    return lux;
+    if(OPT3001_Sensor_ReadReg(h, OPT3001_MANUF_ID_REG) != OPT3001_MANUF_ID)
+        return 1;
+    if(OPT3001_Sensor_ReadReg(h, OPT3001_DEVICE_ID_REG) != OPT3001_DEVICE_ID)
+        return 1;
+    return 0;
 }
 
+u8 OPT3001_Sensor_Configure(OPT3001_HandleTypeDef *h, u16 config)
+{
+    return OPT3001_Sensor_WriteReg(h, OPT3001_CONFIG_REG, config);
+}
+
+u8 OPT3001_Sensor_EnableEoc(OPT3001_HandleTypeDef *h)
+{
+    return OPT3001_Sensor_WriteReg(h, OPT3001_LOW_LIMIT_REG, OPT3001_LOW_LIMIT_EOC);
+}
+
+// 查询一次CRF，不等待：等待由调用者的软件定时器按间隔重复调用
+u8 OPT3001_Sensor_PollReady(OPT3001_HandleTypeDef *h)
+{
+    u16 config = OPT3001_Sensor_ReadReg(h, OPT3001_CONFIG_REG);
+
+    if(config == 0xFFFF)
+        return 2;
+    return (config & OPT3001_CFG_CRF) ? 0 : 1;
+}
+
+// 原始结果寄存器值换算为光照值（单位：lux）
+float OPT3001_RawToLux(u16 raw_data)
+{
+    return (float)OPT3001_RawToCentiLux(raw_data) * 0.01f;
+}
 
-/********************* 异常处理全局变量（静态，仅本文件使用） *********************/
-static OPT3001_StatusTypeDef opt3001_status = OPT3001_STATUS_NORMAL; // 传感器状态
-static float last_valid_lux = 0.0f;                                // 上一次有效值
-static float filter_window[FILTER_WINDOW_SIZE] = {0};               // 滑动窗口缓存
-static u8 window_index = 0;                                        // 窗口索引
+// 解析原始数据：高4位=指数，低12位=尾数，0.01lux * 尾数 * 2^指数
+u32 OPT3001_RawToCentiLux(u16 raw_data)
+{
+    return (u32)(raw_data & 0x0FFF) << ((raw_data >> 12) & 0x0F);
+}
 
-/********************* 辅助函数：滑动窗口均值滤波 ********************
-static float OPT3001_SlidingAvgFilter(float new_val)
+// 阈值寄存器与结果寄存器格式相同（指数0~11），尾数超过12位时逐级右移
+u16 OPT3001_CentiLuxToLimit(u32 centi_lux, u8 round_up)
 {
-    // 1. 将新值存入窗口，覆盖最旧的值
-    filter_window[window_index] = new_val;
-    // 2. 更新索引（循环覆盖）
-    window_index = (window_index + 1) % FILTER_WINDOW_SIZE;
-    // 3. 计算窗口内所有值的平均值
-    float sum = 0.0f;
-    for(u8 i=0; i<FILTER_WINDOW_SIZE; i++)
+    u8 exponent = 0;
+
+    while(centi_lux > 0x0FFF && exponent < 11)
     {
-        sum += filter_window[i];
+        centi_lux = (centi_lux + (round_up ? 1 : 0)) >> 1;
+        exponent++;
     }
-    return sum / FILTER_WINDOW_SIZE;
+    if(centi_lux > 0x0FFF)
+        centi_lux = 0x0FFF;
+    return ((u16)exponent << 12) | (u16)centi_lux;
+}
+
+// 读取光照强度（单位：0.01lux）
+u32 OPT3001_Sensor_ReadCentiLux(OPT3001_HandleTypeDef *h)
+{
+    u16 raw_data;
+    
+    // 读取结果寄存器
+    raw_data = OPT3001_Sensor_ReadReg(h, OPT3001_RESULT_REG);
+    if(raw_data == 0xFFFF)
+        return OPT3001_CLUX_INVALID;  // 读取失败
+    
+    return OPT3001_RawToCentiLux(raw_data);
 }
-*/
 
-// 辅助函数：滑动窗口中值滤波（窗口大小建议奇数：3/5）
-static float OPT3001_SlidingMedianFilter(float new_val)
+/********************* 对单次读数执行滤波链 *********************/
+// raw_clux为OPT3001_CLUX_INVALID表示通信失败（重试已耗尽）；同步与异步读取路径共用
+u8 OPT3001_Sensor_Process(OPT3001_HandleTypeDef *h, u32 raw_clux, u32 *out)
 {
-	  float temp[FILTER_WINDOW_SIZE];
-		u8 i,j;
-	
-    // 1. 存入新值
-    filter_window[window_index] = new_val;
-    window_index = (window_index + 1) % FILTER_WINDOW_SIZE;
+    u32 value = raw_clux;
 
-    // 2. 复制窗口数据并排序
+    *out = h->last_valid_clux;      // 异常时沿用上次有效值，避免数据中断
 
-    for(i=0; i<FILTER_WINDOW_SIZE; i++) temp[i] = filter_window[i];
-    // 简单冒泡排序
-    for(i=0; i<FILTER_WINDOW_SIZE-1; i++)
+    // 通信异常不进入滤波链
+    if(raw_clux == OPT3001_CLUX_INVALID)
     {
-        for(j=0; j<FILTER_WINDOW_SIZE-1-i; j++)
-        {
-            if(temp[j] > temp[j+1])
-            {
-                float t = temp[j];
-                temp[j] = temp[j+1];
-                temp[j+1] = t;
-            }
-        }
+        h->status = OPT3001_STATUS_COMM_ERR;
+        return 0;
     }
 
-    // 3. 返回中间值（中值）
-    return temp[FILTER_WINDOW_SIZE/2];
+    switch(FilterChain_Run(&h->filter, &value))
+    {
+        case FILTER_OK:
+            h->status = OPT3001_STATUS_NORMAL;
+            h->last_valid_clux = value;
+            *out = value;
+            return 1;
+        case FILTER_HOLD:
+            h->status = OPT3001_STATUS_NORMAL;
+            return 0;
+        case FILTER_RANGE_ERR:
+            METRIC_INC(METRIC_RANGE_ERR);
+            h->status = OPT3001_STATUS_RANGE_ERR;
+            return 0;
+        case FILTER_JUMP_ERR:
+        default:
+            METRIC_INC(METRIC_JUMP_REJECT);
+            h->status = OPT3001_STATUS_JUMP_ERR;
+            return 0;
+    }
 }
+
+u32 OPT3001_Sensor_FilterCentiLux(OPT3001_HandleTypeDef *h, u32 raw_clux)
+{
+    u32 out;
+
+    OPT3001_Sensor_Process(h, raw_clux, &out);
+    return out;
+}
+
 /********************* 带异常处理的光照值读取函数 *********************/
-float OPT3001_ReadLux_WithFilter(void)
+u32 OPT3001_Sensor_ReadCentiLux_WithFilter(OPT3001_HandleTypeDef *h)
 {
-    float raw_lux = -1.0f;
+    u32 raw_clux = OPT3001_CLUX_INVALID;
     u8 retry_cnt = 0;
-    float current_lux = 0.0f;
 
-    // ========== 步骤1：通信异常处理（重试读取） ==========
+    // 通信异常处理：立即重试，不在调用内等待（需要间隔的重试走异步队列，见opt3001_async.h）
+    // 总线被从机拉死时重试没有意义，先恢复总线再重试
     while(retry_cnt < OPT3001_MAX_RETRY)
     {
-        raw_lux = OPT3001_ReadLux(); // 调用原读取函数
-        if(raw_lux != -1.0f) break;  // 读取成功则退出重试
-        retry_cnt++;
-        Delay_ms(10);                // 重试间隔（避免频繁读取）
-    }
-    if(raw_lux == -1.0f)
-    {
-        opt3001_status = OPT3001_STATUS_COMM_ERR;
-        return last_valid_lux;       // 沿用上次有效值，避免数据中断
+        raw_clux = OPT3001_Sensor_ReadCentiLux(h); // 调用原读取函数
+        if(raw_clux != OPT3001_CLUX_INVALID) break;  // 读取成功则退出重试
+        if(OPT3001_Bus_IsStuck(h->bus))
+            OPT3001_Bus_Recover(h->bus);
+        if(++retry_cnt < OPT3001_MAX_RETRY)
+            METRIC_INC(METRIC_I2C_RETRY);
     }
 
-    // ========== 步骤2：量程异常处理 ==========
-    if(raw_lux < OPT3001_MIN_VAL || raw_lux > OPT3001_MAX_VAL)
-    {
-        opt3001_status = OPT3001_STATUS_RANGE_ERR;
-        return last_valid_lux;
-    }
+    return OPT3001_Sensor_FilterCentiLux(h, raw_clux);
+}
 
-    // ========== 步骤3：跳变异常处理（限幅） ==========
-    if(last_valid_lux != 0.0f) // 非第一次读取时才判断跳变
-    {
-        float diff = raw_lux - last_valid_lux;
-        if(diff > OPT3001_JUMP_THRESH || diff < -OPT3001_JUMP_THRESH)
-        {
-            opt3001_status = OPT3001_STATUS_JUMP_ERR;
-            return last_valid_lux;
-        }
-    }
+/********************* 浮点接口（仅在边界换算） *********************/
+float OPT3001_Sensor_ReadLux(OPT3001_HandleTypeDef *h)
+{
+    u32 clux = OPT3001_Sensor_ReadCentiLux(h);
+
+    if(clux == OPT3001_CLUX_INVALID)
+        return -1.0f;  // 读取失败
+    return (float)clux * 0.01f;
+}
+
+float OPT3001_Sensor_ReadLux_WithFilter(OPT3001_HandleTypeDef *h)
+{
+    return (float)OPT3001_Sensor_ReadCentiLux_WithFilter(h) * 0.01f;
+}
+
+// raw_lux<0 表示通信失败
+float OPT3001_Sensor_FilterLux(OPT3001_HandleTypeDef *h, float raw_lux)
+{
+    u32 raw_clux = raw_lux < 0.0f ? OPT3001_CLUX_INVALID : (u32)(raw_lux * 100.0f + 0.5f);
+
+    return (float)OPT3001_Sensor_FilterCentiLux(h, raw_clux) * 0.01f;
+}
+
+/********************* 单传感器兼容接口 *********************/
+u8 OPT3001_WriteReg(u8 reg_addr, u16 data)
+{
+    return OPT3001_Sensor_WriteReg(&opt3001_default, reg_addr, data);
+}
+
+u16 OPT3001_ReadReg(u8 reg_addr)
+{
+    return OPT3001_Sensor_ReadReg(&opt3001_default, reg_addr);
+}
+
+u8 OPT3001_Probe(u8 addr)
+{
+    return OPT3001_Bus_Probe(&OPT3001_DefaultBus, addr);
+}
+
+u8 OPT3001_Init(void)
+{
+    // 初始化IIC总线
+    OPT3001_Bus_Init(&OPT3001_DefaultBus);
+    return OPT3001_Sensor_Init(&opt3001_default);
+}
 
-    // ========== 步骤4：噪声滤波（滑动均值） ==========
-    //current_lux = OPT3001_SlidingAvgFilter(raw_lux);
-		current_lux = OPT3001_SlidingMedianFilter(raw_lux);
+float OPT3001_ReadLux(void)
+{
+    return OPT3001_Sensor_ReadLux(&opt3001_default);
+}
 
-    // ========== 步骤5：更新状态和历史值 ==========
-    opt3001_status = OPT3001_STATUS_NORMAL;
-    last_valid_lux = current_lux; // 保存本次有效值
+float OPT3001_ReadLux_WithFilter(void)
+{
+    return OPT3001_Sensor_ReadLux_WithFilter(&opt3001_default);
+}
 
-    return current_lux;
+float OPT3001_FilterLux(float raw_lux)
+{
+    return OPT3001_Sensor_FilterLux(&opt3001_default, raw_lux);
 }
 
 /********************* 获取传感器状态（用于故障排查） *********************/
 OPT3001_StatusTypeDef OPT3001_GetStatus(void)
 {
-    return opt3001_status;
+    return opt3001_default.status;
 }
-
@@ -2,6 +2,16 @@
 #define __OPT3001_H
 
 #include "stm32f10x.h"
+#include "filter_chain.h"
+
+/********************* 总线后端选择 *********************/
+// 1：硬件I2C1 + DMA（400kHz，见i2c1_dma.h，需PB6=SCL、PB7=SDA）
+// 0：软件模拟IIC（下方引脚定义）
+#define OPT3001_USE_HW_I2C     0
+
+#if OPT3001_USE_HW_I2C
+#include "i2c1_dma.h"
+#endif
 
 /********************* IIC引脚定义（可根据硬件修改） *********************/
 #define OPT3001_IIC_SCL_PIN    GPIO_Pin_7
@@ -15,64 +25,227 @@
 #define OPT3001_CONFIG_REG     0x01    // 配置寄存器
 #define OPT3001_LOW_LIMIT_REG  0x02    // 下限阈值寄存器
 #define OPT3001_HIGH_LIMIT_REG 0x03    // 上限阈值寄存器
+#define OPT3001_MANUF_ID_REG   0x7E    // 制造商ID寄存器
+#define OPT3001_DEVICE_ID_REG  0x7F    // 器件ID寄存器
+#define OPT3001_MANUF_ID       0x5449  // "TI"
+#define OPT3001_DEVICE_ID      0x3001
+
+/********************* 配置寄存器取值 *********************/
+// [15:12]RN=1100自动量程 [11]CT(0:100ms 1:800ms) [10:9]M=11连续转换 [4]L=1锁存
+// 锁存模式下INT拉低后保持，直到读配置寄存器才释放（多个传感器INT线与时不丢事件）
+#define OPT3001_CONFIG_DEFAULT  0xCE10  // 常规运行：自动量程、800ms、连续转换、INT锁存
+#define OPT3001_CONFIG_FASTBOOT 0xC610  // 快速启动：自动量程、100ms、连续转换、INT锁存
+#define OPT3001_CFG_OVF        0x0100  // 溢出标志
+#define OPT3001_CFG_CRF        0x0080  // 转换完成标志（读配置寄存器后清零）
+#define OPT3001_CFG_FH         0x0040  // 高于上限标志（锁存窗口模式下读配置寄存器后清零）
+#define OPT3001_CFG_FL         0x0020  // 低于下限标志
+#define OPT3001_CFG_L          0x0010  // INT锁存
+#define OPT3001_CFG_M          0x0600  // 转换模式字段（本驱动始终为11连续转换，读回不符说明数据无效）
+#define OPT3001_CFG_CT         0x0800  // 转换时间（1：800ms，0：100ms）
+#define OPT3001_CFG_RN_MASK    0xF000  // 量程字段RN[15:12]
+#define OPT3001_CFG_RN_AUTO    0xC     // RN=1100自动量程（字段值，写入时左移12位）
+#define OPT3001_LOW_LIMIT_EOC  0xC000  // 下限寄存器指数位=11：INT进入转换完成指示模式
+
+/********************* INT引脚（转换完成中断） *********************/
+// 1：INT（开漏，低有效）接PB5/EXTI5，每次转换完成触发一次采集；多个传感器的INT可线与到同一引脚
+// 0：不接INT，按周期查询CRF，只有CRF置位时才读取结果寄存器（也可在工程Define中指定）
+#ifndef OPT3001_INT_ENABLE
+#define OPT3001_INT_ENABLE     1
+#endif
+#define OPT3001_INT_PIN        GPIO_Pin_5
+#define OPT3001_INT_PORT       GPIOB
+#define OPT3001_INT_RCC        RCC_APB2Periph_GPIOB
+#define OPT3001_INT_PORTSRC    GPIO_PortSourceGPIOB
+#define OPT3001_INT_PINSRC     GPIO_PinSource5
+#define OPT3001_INT_LINE       5
+#define OPT3001_INT_IRQn       EXTI9_5_IRQn
+#define OPT3001_INT_IRQHandler EXTI9_5_IRQHandler
+
+/********************* 软件IIC速率与时序 *********************/
+// 总线速率：100000（Standard-mode）或 400000（Fast-mode），也可在工程Define中指定
+#ifndef OPT3001_IIC_SPEED
+#define OPT3001_IIC_SPEED      100000
+#endif
+
+#if OPT3001_IIC_SPEED == 400000
+// Fast-mode：tLOW>=1.3us，tHIGH>=0.6us（预留300ns上升沿），tBUF>=1.3us
+#define OPT3001_IIC_T_LOW_NS   1400
+#define OPT3001_IIC_T_HIGH_NS  1100
+#define OPT3001_IIC_T_BUF_NS   1300
+#elif OPT3001_IIC_SPEED == 100000
+// Standard-mode：tLOW>=4.7us，tHIGH>=4.0us（预留1us上升沿），tBUF>=4.7us
+#define OPT3001_IIC_T_LOW_NS   5000
+#define OPT3001_IIC_T_HIGH_NS  5000
+#define OPT3001_IIC_T_BUF_NS   4700
+#else
+#error "OPT3001_IIC_SPEED 仅支持 100000 / 400000"
+#endif
+
+#define OPT3001_IIC_STRETCH_CYC 7200   // 从机时钟延展最长等待（72MHz下约100us）
+
+// 总线卡死恢复：从机在字节中途复位/被打断时会一直拉低SDA，
+// 主机补发最多9个SCL时钟让其移出剩余位，再发STOP使总线回到空闲
+#define OPT3001_IIC_RECOVER_CLOCKS 9
+#define OPT3001_BUS_SDA_LOW    0x01    // 空闲时SDA被拉低
+#define OPT3001_BUS_SCL_LOW    0x02    // 空闲时SCL被拉低（时钟延展卡死，补时钟无效）
+
+// 1：统计软件IIC的SCL脉冲/字节/START数，用于评估驱动改动对总线开销的影响
+#define OPT3001_IIC_STATS      1
+
+#if OPT3001_IIC_STATS
+typedef struct {
+    u32 scl_pulses;          // SCL时钟脉冲数（含ACK位）
+    u32 bytes;               // 收发字节数（含地址字节）
+    u32 starts;              // START/重复START次数
+} OPT3001_IIC_StatsTypeDef;
+#endif
+
+/********************* 寄存器指针缓存 *********************/
+// OPT3001的读操作从当前指针处读出，指针只在写操作（含读前的指针写）时改变。
+// 1：记录每个传感器最后写入的指针，再次读同一寄存器时省去 addr+W + 指针 + 重复START，
+//    只发 START + addr+R + 2个数据字节（总线字节5→3）；任何失败都把缓存作废，下次重新写指针
+// 器件上电复位后指针回到0x00（结果寄存器），配置寄存器读回再由M位校验兜底
+#define OPT3001_PTR_CACHE      1
+#define OPT3001_PTR_UNKNOWN    0xFF    // 指针状态未知（上电/通信失败后）
+
+/********************* 总线描述 *********************/
+#define OPT3001_MAX_SENSORS    8       // 单个调度器管理的传感器上限
+#define OPT3001_ADDR_MIN       0x44    // ADDR引脚可选地址 0x44~0x47
+#define OPT3001_ADDR_MAX       0x47
+
+// 总线描述：软件IIC为同一端口上的一对SCL/SDA引脚
+typedef struct {
+    u8  hw;                  // 1：硬件I2C1（需OPT3001_USE_HW_I2C），0：软件IIC
+    GPIO_TypeDef *port;      // 软件IIC端口
+    u16 scl_pin;
+    u16 sda_pin;
+    u32 rcc;                 // 端口APB2时钟
+} OPT3001_BusTypeDef;
+
+// 默认总线：上方引脚定义（硬件后端时为I2C1）
+extern const OPT3001_BusTypeDef OPT3001_DefaultBus;
 
 /********************* IIC底层操作宏 *********************/
-/********************* IIC底层操作宏 *********************/
-// PB6 动态方向切换宏
-// SDA_IN: 清除原有配置 -> 设为上拉/下拉输入 -> ODR写1开启内部微弱上拉
-#define SDA_IN()  {GPIOB->CRL &= 0xF0FFFFFF; GPIOB->CRL |= (u32)8<<24; GPIOB->ODR |= 1<<6;}  
-// SDA_OUT: 设为推挽输出 50MHz
-#define SDA_OUT() {GPIOB->CRL &= 0xF0FFFFFF; GPIOB->CRL |= (u32)3<<24;}  
-
-#define IIC_SCL_HIGH()  GPIO_SetBits(OPT3001_IIC_PORT, OPT3001_IIC_SCL_PIN)
-#define IIC_SCL_LOW()   GPIO_ResetBits(OPT3001_IIC_PORT, OPT3001_IIC_SCL_PIN)
-#define IIC_SDA_HIGH()  GPIO_SetBits(OPT3001_IIC_PORT, OPT3001_IIC_SDA_PIN)
-#define IIC_SDA_LOW()   GPIO_ResetBits(OPT3001_IIC_PORT, OPT3001_IIC_SDA_PIN)
-#define IIC_SDA_READ()  GPIO_ReadInputDataBit(OPT3001_IIC_PORT, OPT3001_IIC_SDA_PIN)
+// 引脚为开漏输出：写1即释放总线，IDR直接读取总线实际电平，无需切换方向
+#define IIC_SCL_HIGH(bus)  ((bus)->port->BSRR = (bus)->scl_pin)
+#define IIC_SCL_LOW(bus)   ((bus)->port->BRR  = (bus)->scl_pin)
+#define IIC_SDA_HIGH(bus)  ((bus)->port->BSRR = (bus)->sda_pin)
+#define IIC_SDA_LOW(bus)   ((bus)->port->BRR  = (bus)->sda_pin)
+#define IIC_SDA_READ(bus)  ((bus)->port->IDR & (bus)->sda_pin)
+#define IIC_SCL_READ(bus)  ((bus)->port->IDR & (bus)->scl_pin)
 
 /********************* 函数声明（修复参数不匹配问题） *********************/
 // IIC底层初始化
-void OPT3001_IIC_Init(void);
-// IIC起始信号
-void OPT3001_IIC_Start(void);
+void OPT3001_IIC_Init(const OPT3001_BusTypeDef *bus);
+// IIC起始信号（返回1：SDA/SCL未释放，总线占用或卡死，未发出START）
+u8 OPT3001_IIC_Start(const OPT3001_BusTypeDef *bus);
 // IIC停止信号
-void OPT3001_IIC_Stop(void);
+void OPT3001_IIC_Stop(const OPT3001_BusTypeDef *bus);
 // IIC发送应答
-void OPT3001_IIC_SendAck(u8 ack);
+void OPT3001_IIC_SendAck(const OPT3001_BusTypeDef *bus, u8 ack);
 // IIC等待应答
-u8 OPT3001_IIC_WaitAck(void);
+u8 OPT3001_IIC_WaitAck(const OPT3001_BusTypeDef *bus);
 // IIC发送一个字节
-void OPT3001_IIC_SendByte(u8 byte);
+void OPT3001_IIC_SendByte(const OPT3001_BusTypeDef *bus, u8 byte);
 // IIC接收一个字节（带ack参数，和实现对齐）
-u8 OPT3001_IIC_ReceiveByte(u8 ack);
+u8 OPT3001_IIC_ReceiveByte(const OPT3001_BusTypeDef *bus, u8 ack);
 
-// OPT3001寄存器写操作
-u8 OPT3001_WriteReg(u8 reg_addr, u16 data);
-// OPT3001寄存器读操作
-u16 OPT3001_ReadReg(u8 reg_addr);
-// OPT3001传感器初始化
-u8 OPT3001_Init(void);
-// 读取光照强度（单位：lux）
-float OPT3001_ReadLux(void);
+#if OPT3001_IIC_STATS
+// 读取/清零软件IIC统计（所有软件总线合计）
+void OPT3001_IIC_GetStats(OPT3001_IIC_StatsTypeDef *stats);
+void OPT3001_IIC_ResetStats(void);
+#endif
+
+// 总线初始化（软件IIC配置引脚，硬件后端初始化I2C1）
+void OPT3001_Bus_Init(const OPT3001_BusTypeDef *bus);
+// 地址探测（返回0：有应答），两种后端通用
+u8 OPT3001_Bus_Probe(const OPT3001_BusTypeDef *bus, u8 addr);
+// 空闲总线的线路状态（OPT3001_BUS_SDA_LOW/SCL_LOW位组合，0表示正常），须在无事务进行时调用
+u8 OPT3001_Bus_IsStuck(const OPT3001_BusTypeDef *bus);
+// 补发时钟+STOP恢复卡死的总线，返回恢复后的线路状态（0：已释放）
+u8 OPT3001_Bus_Recover(const OPT3001_BusTypeDef *bus);
+// 原始值换算为0.01lux整数（尾数<<指数），采集/滤波/上报全程使用此整数
+u32 OPT3001_RawToCentiLux(u16 raw_data);
+// 结果寄存器原始值换算为lux（浮点，仅供外部接口使用）
+float OPT3001_RawToLux(u16 raw_data);
+// 0.01lux整数编码为上/下限寄存器值（round_up：1向上取整，用于上限；0向下取整，用于下限）
+u16 OPT3001_CentiLuxToLimit(u32 centi_lux, u8 round_up);
 
 
 /********************* 异常处理相关定义 *********************/
+// 光照值统一用0.01lux为单位的u32（Cortex-M3无FPU，避免软件浮点）
 #define OPT3001_MAX_RETRY    3       // 通信异常重试次数
-#define OPT3001_MIN_VAL      0.01f   // 传感器最小有效量程
-#define OPT3001_MAX_VAL      83886.08f // 传感器最大有效量程
-#define OPT3001_JUMP_THRESH  500.0f  // 跳变阈值（可根据场景调整）
-#define FILTER_WINDOW_SIZE   3       // 滑动窗口大小（3~5为宜）
+// 量程/跳变阈值及各级滤波参数见filter_chain.h
+#define OPT3001_CLUX_INVALID 0xFFFFFFFF // 读取失败标记
 
 // 传感器状态枚举
 typedef enum {
     OPT3001_STATUS_NORMAL,   // 正常
     OPT3001_STATUS_COMM_ERR, // 通信错误
     OPT3001_STATUS_RANGE_ERR,// 量程异常
-    OPT3001_STATUS_JUMP_ERR  // 跳变异常
+    OPT3001_STATUS_JUMP_ERR  // 跳变待确认（新等级未达到确认次数）
 } OPT3001_StatusTypeDef;
 
+// 传感器实例：总线、地址以及各自独立的滤波/状态
+typedef struct {
+    const OPT3001_BusTypeDef *bus;              // 所在总线
+    u8  addr;                                   // 从机地址 0x44~0x47
+    u8  id;                                     // 传感器编号（上报用）
+    u8  reg_ptr;                                // 器件当前寄存器指针（OPT3001_PTR_UNKNOWN：未知）
+    OPT3001_StatusTypeDef status;               // 最近一次读取状态
+    u32 last_valid_clux;                        // 上一次有效值（0.01lux）
+    Filter_StateTypeDef filter;                 // 滤波链各级状态（0.01lux）
+} OPT3001_HandleTypeDef;
+
+// 静态初始化：OPT3001_HandleTypeDef s = OPT3001_HANDLE_INIT(&bus, 0x45, 1);
+#define OPT3001_HANDLE_INIT(bus_, addr_, id_) \
+    { (bus_), (addr_), (id_), OPT3001_PTR_UNKNOWN, OPT3001_STATUS_NORMAL, 0, FILTER_STATE_INIT }
+
+/********************* 实例接口 *********************/
+// OPT3001寄存器写操作
+u8 OPT3001_Sensor_WriteReg(OPT3001_HandleTypeDef *h, u8 reg_addr, u16 data);
+// OPT3001寄存器读操作（失败返回0xFFFF）；指针已指向该寄存器时省去指针写入
+u16 OPT3001_Sensor_ReadReg(OPT3001_HandleTypeDef *h, u8 reg_addr);
+// OPT3001传感器初始化（总线需已初始化）
+u8 OPT3001_Sensor_Init(OPT3001_HandleTypeDef *h);
+// 读制造商/器件ID确认是OPT3001（返回0：匹配）
+u8 OPT3001_Sensor_Identify(OPT3001_HandleTypeDef *h);
+// 单次写入配置寄存器（不回读校验）
+u8 OPT3001_Sensor_Configure(OPT3001_HandleTypeDef *h, u16 config);
+// 读一次配置寄存器查询CRF，不等待（返回0：转换已完成，1：尚未完成，2：通信失败）
+u8 OPT3001_Sensor_PollReady(OPT3001_HandleTypeDef *h);
+// INT设为转换完成指示模式（写下限寄存器，返回0：成功）
+u8 OPT3001_Sensor_EnableEoc(OPT3001_HandleTypeDef *h);
+// 读取光照强度（单位：0.01lux，失败返回OPT3001_CLUX_INVALID）
+u32 OPT3001_Sensor_ReadCentiLux(OPT3001_HandleTypeDef *h);
+// 带异常处理的读取（单位：0.01lux）：失败时恢复总线后立即重试，不在调用内等待
+u32 OPT3001_Sensor_ReadCentiLux_WithFilter(OPT3001_HandleTypeDef *h);
+// 已读取的光照值经过滤波链（OPT3001_CLUX_INVALID表示通信失败），供异步路径使用
+// 返回1：*out为新输出；0：无新输出（通信/量程/跳变异常或被抽取级吸收，*out为上次有效值）
+u8 OPT3001_Sensor_Process(OPT3001_HandleTypeDef *h, u32 raw_clux, u32 *out);
+// 同上，只返回结果（无新输出时为上次有效值）
+u32 OPT3001_Sensor_FilterCentiLux(OPT3001_HandleTypeDef *h, u32 raw_clux);
+
+// 浮点接口（单位：lux），内部仍走整数流程，仅在返回时换算
+float OPT3001_Sensor_ReadLux(OPT3001_HandleTypeDef *h);
+float OPT3001_Sensor_ReadLux_WithFilter(OPT3001_HandleTypeDef *h);
+float OPT3001_Sensor_FilterLux(OPT3001_HandleTypeDef *h, float raw_lux);
+
+/********************* 单传感器兼容接口（默认总线 + OPT3001_ADDR） *********************/
+// OPT3001寄存器写操作
+u8 OPT3001_WriteReg(u8 reg_addr, u16 data);
+// OPT3001寄存器读操作
+u16 OPT3001_ReadReg(u8 reg_addr);
+// 地址探测（返回0：有应答）
+u8 OPT3001_Probe(u8 addr);
+// OPT3001传感器初始化（含默认总线初始化）
+u8 OPT3001_Init(void);
+// 读取光照强度（单位：lux）
+float OPT3001_ReadLux(void);
 // 新增带异常处理的读取函数声明
 float OPT3001_ReadLux_WithFilter(void);
+// 对已读取的光照值做量程/跳变/中值处理（raw_lux<0表示通信失败），供异步路径使用
+float OPT3001_FilterLux(float raw_lux);
 // 获取传感器状态（用于故障排查）
 OPT3001_StatusTypeDef OPT3001_GetStatus(void);
 
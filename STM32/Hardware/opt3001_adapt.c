@@ -0,0 +1,163 @@
+#include "opt3001_adapt.h"
+#include "delay.h"
+
+/********************* 控制器状态（按传感器编号） *********************/
+typedef struct {
+    OPT3001_HandleTypeDef *h;
+    u16 config;                 // 已生效的配置
+    u16 config_pending;         // 写入中的配置
+    u8  writing;                // 1：配置写入排队中
+    volatile u8  settling;      // 1：等待丢弃跨越重配置的那次转换
+    volatile u32 cfg_stamp;     // 配置写入完成时刻（us）
+    u32 prev_clux;
+    u32 stable_since;           // 最近一次动态样本的时刻（us）
+    u32 switches;
+    u32 discarded;
+} OPT3001_AdaptStateTypeDef;
+
+static OPT3001_AdaptStateTypeDef adapt[OPT3001_MAX_SENSORS];
+static u8 adapt_count = 0;
+
+/********************* 辅助函数 *********************/
+// 满量程为 40.95lux * 2^RN，选满足余量的最小RN（0~11）
+static u8 OPT3001_Adapt_PickRange(u32 clux)
+{
+    u8 rn = 0;
+
+    while(rn < 11 && ((u32)0x0FFF << rn) < clux * OPT3001_ADAPT_PIN_HEADROOM)
+        rn++;
+    return rn;
+}
+
+static u16 OPT3001_Adapt_Compose(u8 slow, u8 rn)
+{
+    return (OPT3001_CONFIG_DEFAULT & ~(OPT3001_CFG_RN_MASK | OPT3001_CFG_CT)) |
+           ((u16)rn << 12) | (slow ? OPT3001_CFG_CT : 0);
+}
+
+// 转换时间由CT位决定
+static u8 OPT3001_Adapt_IsSlow(u16 config)
+{
+    return (config & OPT3001_CFG_CT) != 0;
+}
+
+/********************* 配置写入（完成回调在中断上下文） *********************/
+static void OPT3001_Adapt_WriteDone(const OPT3001_XferTypeDef *xfer)
+{
+    OPT3001_AdaptStateTypeDef *st = (OPT3001_AdaptStateTypeDef *)xfer->ctx;
+
+    st->writing = 0;
+    if(xfer->result != OPT3001_XFER_OK)
+        return;                     // 配置未改变，下个样本重新决策
+    st->config = st->config_pending;
+    st->cfg_stamp = micros();
+    st->settling = 1;
+}
+
+static void OPT3001_Adapt_Apply(OPT3001_AdaptStateTypeDef *st, u16 config)
+{
+    if(st->writing || config == st->config)
+        return;
+    st->config_pending = config;
+    if(OPT3001_Async_WriteReg(st->h, OPT3001_CONFIG_REG, config, OPT3001_Adapt_WriteDone, st) == 0)
+    {
+        st->writing = 1;
+        st->switches++;
+    }
+}
+
+/********************* 对外接口 *********************/
+void OPT3001_Adapt_Init(OPT3001_HandleTypeDef *sensors, u8 count)
+{
+    u8 i;
+
+    if(count > OPT3001_MAX_SENSORS)
+        count = OPT3001_MAX_SENSORS;
+    for(i=0; i<count; i++)
+    {
+        adapt[i].h = &sensors[i];
+        adapt[i].config = OPT3001_CONFIG_DEFAULT;
+        adapt[i].writing = 0;
+        adapt[i].settling = 0;
+        adapt[i].prev_clux = OPT3001_CLUX_INVALID;
+        adapt[i].stable_since = micros();
+        adapt[i].switches = 0;
+        adapt[i].discarded = 0;
+    }
+    adapt_count = count;
+}
+
+u8 OPT3001_Adapt_OnSample(OPT3001_HandleTypeDef *h, u32 raw_clux, u32 stamp_us)
+{
+    OPT3001_AdaptStateTypeDef *st;
+    u16 dlog;
+    u8 rn;
+
+    if(h->id >= adapt_count)
+        return 0;
+    st = &adapt[h->id];
+
+    // 通信失败不是一次转换：不消耗稳定期，照常交给滤波流程上报状态
+    if(raw_clux == OPT3001_CLUX_INVALID)
+        return 0;
+    // 写入完成后第一个完成的转换可能跨越了新旧配置，丢弃；
+    // 完成时刻早于写入的是旧配置下的完整转换，保留
+    if(st->settling && (s32)(stamp_us - st->cfg_stamp) >= 0)
+    {
+        st->settling = 0;
+        st->discarded++;
+        return 1;
+    }
+    if(st->prev_clux == OPT3001_CLUX_INVALID)
+    {
+        st->prev_clux = raw_clux;       // 首个样本只作为比较基准
+        return 0;
+    }
+
+    dlog = (u16)(FilterChain_Log2Q8(raw_clux + 100) - FilterChain_Log2Q8(st->prev_clux + 100));
+    if((s16)dlog < 0)
+        dlog = (u16)-(s16)dlog;
+    st->prev_clux = raw_clux;
+
+    // 固定量程时接近满量程也按动态处理，立即恢复自动量程
+    rn = (st->config & OPT3001_CFG_RN_MASK) >> 12;
+    if(dlog > OPT3001_ADAPT_DYN_LOG_Q8 ||
+       (rn != OPT3001_CFG_RN_AUTO && raw_clux >= ((u32)0x0FF0 << rn)))
+    {
+        st->stable_since = stamp_us;
+        OPT3001_Adapt_Apply(st, OPT3001_Adapt_Compose(0, OPT3001_CFG_RN_AUTO));
+        return 0;
+    }
+
+    // 持续稳定：切回800ms，按当前等级固定量程
+    if((u32)(stamp_us - st->stable_since) >= (u32)OPT3001_ADAPT_STABLE_MS * 1000 &&
+       !OPT3001_Adapt_IsSlow(st->config))
+    {
+#if OPT3001_ADAPT_PIN_RANGE
+        OPT3001_Adapt_Apply(st, OPT3001_Adapt_Compose(1, OPT3001_Adapt_PickRange(raw_clux)));
+#else
+        OPT3001_Adapt_Apply(st, OPT3001_Adapt_Compose(1, OPT3001_CFG_RN_AUTO));
+#endif
+    }
+    return 0;
+}
+
+// 调用时不应有排队中的配置写入（健康监测只在异步队列为空时重新初始化）
+void OPT3001_Adapt_Reset(u8 id)
+{
+    if(id >= adapt_count)
+        return;
+    adapt[id].config = OPT3001_CONFIG_DEFAULT;
+    adapt[id].settling = 0;
+    adapt[id].prev_clux = OPT3001_CLUX_INVALID;
+    adapt[id].stable_since = micros();
+}
+
+void OPT3001_Adapt_GetStats(u8 id, OPT3001_AdaptStatsTypeDef *stats)
+{
+    if(id >= adapt_count)
+        return;
+    stats->config = adapt[id].config;
+    stats->switches = adapt[id].switches;
+    stats->discarded = adapt[id].discarded;
+}
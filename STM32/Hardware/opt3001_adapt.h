@@ -0,0 +1,32 @@
+#ifndef __OPT3001_ADAPT_H
+#define __OPT3001_ADAPT_H
+
+#include "opt3001_async.h"
+
+/********************* 自适应转换时间/量程参数 *********************/
+// 光照变化时切到100ms转换以快速跟随，持续稳定后切回800ms低噪声积分，
+// 稳定时可把量程固定在当前等级（避免自动量程的切换与稳定时间）
+#define OPT3001_ADAPT_ENABLE       1
+#define OPT3001_ADAPT_DYN_LOG_Q8   24     // 相邻样本log2差超过24/256（约7%）视为动态
+#define OPT3001_ADAPT_STABLE_MS    3000   // 连续稳定超过该时间切回800ms
+#define OPT3001_ADAPT_PIN_RANGE    1      // 1：稳定时固定量程RN，0：始终自动量程
+#define OPT3001_ADAPT_PIN_HEADROOM 2      // 固定量程时满量程至少为当前值的2倍
+
+// 统计（每个传感器）
+typedef struct {
+    u16 config;      // 当前生效配置
+    u32 switches;    // 重配置次数
+    u32 discarded;   // 因跨越重配置而丢弃的样本数
+} OPT3001_AdaptStatsTypeDef;
+
+/********************* 函数声明 *********************/
+// 绑定传感器（上电配置为OPT3001_CONFIG_DEFAULT之后调用）
+void OPT3001_Adapt_Init(OPT3001_HandleTypeDef *sensors, u8 count);
+// 每个样本进入滤波前调用（主循环上下文）：更新控制器，必要时排队写配置
+// 返回1：该样本的转换跨越了一次重配置，应丢弃
+u8 OPT3001_Adapt_OnSample(OPT3001_HandleTypeDef *h, u32 raw_clux, u32 stamp_us);
+// 传感器被重新初始化（配置回到OPT3001_CONFIG_DEFAULT）后调用，控制器从头开始
+void OPT3001_Adapt_Reset(u8 id);
+void OPT3001_Adapt_GetStats(u8 id, OPT3001_AdaptStatsTypeDef *stats);
+
+#endif
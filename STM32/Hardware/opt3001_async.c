@@ -0,0 +1,332 @@
+#include "opt3001_async.h"
+#include "metrics.h"
+
+/********************* 队列与状态机变量 *********************/
+// 环形队列：主循环写尾，中断读头；提交时短暂关中断（回调内也可能提交）
+static OPT3001_XferTypeDef xfer_queue[OPT3001_ASYNC_QUEUE_SIZE];
+static volatile u8 queue_head = 0;
+static volatile u8 queue_tail = 0;
+static volatile u8 queue_count = 0;
+static volatile u32 xfer_total = 0;   // 累计提交的事务数（评估总线流量）
+
+static u8  xfer_step = 0;          // 当前事务执行到的步骤
+static u8  xfer_active = 0;        // 1：当前事务已在总线上
+static u8  xfer_cached = 0;        // 1：本次尝试为不写指针的读（指针缓存命中）
+static u16 xfer_wait_ticks = 0;    // 重试前剩余等待节拍
+static u32 xfer_start_cyc = 0;     // 当前尝试的发起时刻（DWT周期）
+
+#define ASYNC_RETRY_TICKS   ((OPT3001_ASYNC_RETRY_MS * 1000) / OPT3001_ASYNC_TICK_US)
+#define ASYNC_TIMEOUT_TICKS ((OPT3001_ASYNC_TIMEOUT_MS * 1000) / OPT3001_ASYNC_TICK_US)
+
+/********************* TIM2服务节拍控制 *********************/
+static void OPT3001_Async_TickStart(void)
+{
+    TIM2->CNT = 0;
+    TIM2->CR1 |= TIM_CR1_CEN;
+}
+
+static void OPT3001_Async_TickStop(void)
+{
+    TIM2->CR1 &= ~TIM_CR1_CEN;
+}
+
+/********************* 事务收尾（中断上下文） *********************/
+static void OPT3001_Async_Complete(OPT3001_XferResultTypeDef result)
+{
+    OPT3001_XferTypeDef *xfer = &xfer_queue[queue_head];
+    OPT3001_XferTypeDef done;
+
+    METRIC_HIST(METRIC_HIST_I2C_XFER, DWT->CYCCNT - xfer_start_cyc);
+    if(result == OPT3001_XFER_TIMEOUT)
+        METRIC_INC(METRIC_I2C_TIMEOUT);
+    xfer_active = 0;
+    xfer_step = 0;
+    // 成功的读写都把器件指针留在该寄存器；失败时指针状态未知，重试走完整的指针写入
+    if(xfer->ptr)
+        *xfer->ptr = (result == OPT3001_XFER_OK) ? xfer->reg : OPT3001_PTR_UNKNOWN;
+
+    // 失败且仍有重试次数：留在队头，等待重试间隔后重新发起
+    if(result != OPT3001_XFER_OK && xfer->retries > 0)
+    {
+        METRIC_INC(METRIC_I2C_RETRY);
+        xfer->retries--;
+        xfer_wait_ticks = ASYNC_RETRY_TICKS;
+        return;
+    }
+
+    // 先出队再回调：回调内提交的后续事务（如CRF置位后读结果）可以用上刚释放的槽位，
+    // 否则队列排满时（OPT3001_MAX_SENSORS个传感器同时查询）会被判为队列满
+    done = *xfer;
+    done.result = result;
+    queue_head = (queue_head + 1) % OPT3001_ASYNC_QUEUE_SIZE;
+    queue_count--;
+    if(done.cb)
+        done.cb(&done);
+
+    if(queue_count == 0)
+        OPT3001_Async_TickStop();
+}
+
+#if OPT3001_USE_HW_I2C
+/********************* 硬件I2C1总线：节拍负责发起/超时，I2C中断负责推进 *********************/
+static u8 xfer_rx_buf[2];
+static u16 xfer_busy_ticks = 0;    // 硬件事务已持续的节拍
+
+static void OPT3001_Async_HwDone(I2C1_DMA_ResultTypeDef result, void *ctx)
+{
+    (void)ctx;
+    if(result == I2C1_DMA_OK)
+    {
+        if(xfer_queue[queue_head].is_read)
+            xfer_queue[queue_head].data = ((u16)xfer_rx_buf[0] << 8) | xfer_rx_buf[1];
+        OPT3001_Async_Complete(OPT3001_XFER_OK);
+    }
+    else if(result == I2C1_DMA_TIMEOUT_ERR)
+    {
+        OPT3001_Async_Complete(OPT3001_XFER_TIMEOUT);
+    }
+    else
+    {
+        METRIC_INC(METRIC_NACK_HW);
+        OPT3001_Async_Complete(OPT3001_XFER_NACK);
+    }
+}
+
+static void OPT3001_Async_ServiceHw(OPT3001_XferTypeDef *xfer)
+{
+    u8 buf[2];
+    I2C1_DMA_ResultTypeDef res;
+
+    if(xfer_active)
+    {
+        if(++xfer_busy_ticks > ASYNC_TIMEOUT_TICKS)
+        {
+            I2C1_DMA_Abort();
+            OPT3001_Async_Complete(OPT3001_XFER_TIMEOUT);
+        }
+        return;
+    }
+
+    if(xfer_cached)
+    {
+        res = I2C1_DMA_ReadCurrentAsync(xfer->addr, xfer_rx_buf, 2, OPT3001_Async_HwDone, 0);
+    }
+    else if(xfer->is_read)
+    {
+        res = I2C1_DMA_ReadAsync(xfer->addr, xfer->reg, xfer_rx_buf, 2, OPT3001_Async_HwDone, 0);
+    }
+    else
+    {
+        buf[0] = (xfer->data >> 8) & 0xFF;
+        buf[1] = xfer->data & 0xFF;
+        res = I2C1_DMA_WriteAsync(xfer->addr, xfer->reg, buf, 2, OPT3001_Async_HwDone, 0);
+    }
+    if(res == I2C1_DMA_OK)
+    {
+        xfer_active = 1;
+        xfer_busy_ticks = 0;
+    }
+    // 总线忙则下个节拍再试
+}
+#endif
+
+/********************* 软件IIC总线：每个节拍执行一个总线步骤 *********************/
+enum {
+    STEP_START = 0,
+    STEP_ADDR_W,
+    STEP_REG,
+    STEP_DATA_HI,
+    STEP_DATA_LO,
+    STEP_ADDR_R,
+    STEP_RECV_HI,
+    STEP_RECV_LO,
+    STEP_STOP
+};
+
+static const u8 read_steps[]  = {STEP_START, STEP_ADDR_W, STEP_REG, STEP_START, STEP_ADDR_R,
+                                 STEP_RECV_HI, STEP_RECV_LO, STEP_STOP};
+static const u8 write_steps[] = {STEP_START, STEP_ADDR_W, STEP_REG, STEP_DATA_HI, STEP_DATA_LO,
+                                 STEP_STOP};
+// 指针缓存命中：省去addr+W、指针字节和重复START，8步缩短为5步
+static const u8 cur_steps[]   = {STEP_START, STEP_ADDR_R, STEP_RECV_HI, STEP_RECV_LO, STEP_STOP};
+
+// 发送一个字节并检查应答（无应答时WaitAck内部已发STOP）
+static u8 OPT3001_Async_Send(const OPT3001_BusTypeDef *bus, u8 byte)
+{
+    OPT3001_IIC_SendByte(bus, byte);
+    return OPT3001_IIC_WaitAck(bus);
+}
+
+// START失败（总线被占住）同样按无应答处理，由重试/健康监测接手
+static void OPT3001_Async_ServiceSoft(OPT3001_XferTypeDef *xfer)
+{
+    const OPT3001_BusTypeDef *bus = xfer->bus;
+    const u8 *steps = xfer_cached ? cur_steps : xfer->is_read ? read_steps : write_steps;
+    u8 nsteps = xfer_cached ? sizeof(cur_steps) : xfer->is_read ? sizeof(read_steps) : sizeof(write_steps);
+    u8 nack = 0;
+
+    switch(steps[xfer_step])
+    {
+        case STEP_START:   nack = OPT3001_IIC_Start(bus); break;
+        case STEP_ADDR_W:
+            if((nack = OPT3001_Async_Send(bus, xfer->addr << 1)) != 0)
+                METRIC_INC(METRIC_NACK_ADDR_W);
+            break;
+        case STEP_REG:
+            if((nack = OPT3001_Async_Send(bus, xfer->reg)) != 0)
+                METRIC_INC(METRIC_NACK_REG);
+            break;
+        case STEP_DATA_HI:
+            if((nack = OPT3001_Async_Send(bus, (xfer->data >> 8) & 0xFF)) != 0)
+                METRIC_INC(METRIC_NACK_DATA);
+            break;
+        case STEP_DATA_LO:
+            if((nack = OPT3001_Async_Send(bus, xfer->data & 0xFF)) != 0)
+                METRIC_INC(METRIC_NACK_DATA);
+            break;
+        case STEP_ADDR_R:
+            if((nack = OPT3001_Async_Send(bus, (xfer->addr << 1) | 0x01)) != 0)
+                METRIC_INC(METRIC_NACK_ADDR_R);
+            break;
+        case STEP_RECV_HI: xfer->data = (u16)OPT3001_IIC_ReceiveByte(bus, 0) << 8; break;
+        case STEP_RECV_LO: xfer->data |= OPT3001_IIC_ReceiveByte(bus, 1); break;
+        case STEP_STOP:    OPT3001_IIC_Stop(bus); break;
+        default: break;
+    }
+
+    if(nack)
+    {
+        OPT3001_Async_Complete(OPT3001_XFER_NACK);
+        return;
+    }
+    xfer_active = 1;
+    if(++xfer_step >= nsteps)
+        OPT3001_Async_Complete(OPT3001_XFER_OK);
+}
+
+static void OPT3001_Async_Service(OPT3001_XferTypeDef *xfer)
+{
+    // 尚未上总线：本次尝试从这里开始计时（硬件后端总线忙时每个节拍重新计），
+    // 并按执行时刻的指针决定是否省去指针写入（排在前面的事务可能已改变指针）
+    if(!xfer_active)
+    {
+        xfer_start_cyc = DWT->CYCCNT;
+        xfer_cached = OPT3001_PTR_CACHE && xfer->is_read && xfer->ptr && *xfer->ptr == xfer->reg;
+    }
+#if OPT3001_USE_HW_I2C
+    if(xfer->bus->hw)
+    {
+        OPT3001_Async_ServiceHw(xfer);
+        return;
+    }
+#endif
+    OPT3001_Async_ServiceSoft(xfer);
+}
+
+/********************* 对外接口 *********************/
+void OPT3001_Async_Init(void)
+{
+    NVIC_InitTypeDef NVIC_InitStruct;
+
+    // TIM2：1MHz计数，溢出周期为一个服务节拍；仅在队列非空时运行
+    RCC_APB1PeriphClockCmd(RCC_APB1Periph_TIM2, ENABLE);
+    TIM2->CR1  = 0;
+    TIM2->PSC  = (u16)(SystemCoreClock / 1000000 - 1);
+    TIM2->ARR  = OPT3001_ASYNC_TICK_US - 1;
+    TIM2->EGR  = TIM_EGR_UG;    // 立即装载PSC
+    TIM2->SR   = 0;
+    TIM2->DIER = TIM_DIER_UIE;
+
+    // 与I2C1事件/DMA中断同一抢占优先级，互不打断
+    NVIC_InitStruct.NVIC_IRQChannel = TIM2_IRQn;
+    NVIC_InitStruct.NVIC_IRQChannelPreemptionPriority = 1;
+    NVIC_InitStruct.NVIC_IRQChannelSubPriority = 1;
+    NVIC_InitStruct.NVIC_IRQChannelCmd = ENABLE;
+    NVIC_Init(&NVIC_InitStruct);
+
+    queue_head = queue_tail = queue_count = 0;
+    xfer_step = xfer_active = xfer_cached = 0;
+    xfer_wait_ticks = 0;
+}
+
+u8 OPT3001_Async_Submit(const OPT3001_XferTypeDef *xfer)
+{
+    u32 primask = __get_PRIMASK();
+
+    __disable_irq();
+    if(queue_count >= OPT3001_ASYNC_QUEUE_SIZE)
+    {
+        __set_PRIMASK(primask);
+        return 1;
+    }
+    xfer_queue[queue_tail] = *xfer;
+    xfer_total++;
+    queue_tail = (queue_tail + 1) % OPT3001_ASYNC_QUEUE_SIZE;
+    if(queue_count++ == 0)
+        OPT3001_Async_TickStart();
+    __set_PRIMASK(primask);
+    return 0;
+}
+
+u8 OPT3001_Async_ReadReg(OPT3001_HandleTypeDef *h, u8 reg_addr, OPT3001_XferCallback cb, void *ctx)
+{
+    OPT3001_XferTypeDef xfer;
+
+    xfer.bus     = h->bus;
+    xfer.addr    = h->addr;
+    xfer.reg     = reg_addr;
+    xfer.is_read = 1;
+    xfer.retries = OPT3001_MAX_RETRY - 1;
+    xfer.data    = 0;
+    xfer.ptr     = &h->reg_ptr;
+    xfer.result  = OPT3001_XFER_OK;
+    xfer.cb      = cb;
+    xfer.ctx     = ctx;
+    return OPT3001_Async_Submit(&xfer);
+}
+
+u8 OPT3001_Async_WriteReg(OPT3001_HandleTypeDef *h, u8 reg_addr, u16 data, OPT3001_XferCallback cb, void *ctx)
+{
+    OPT3001_XferTypeDef xfer;
+
+    xfer.bus     = h->bus;
+    xfer.addr    = h->addr;
+    xfer.reg     = reg_addr;
+    xfer.is_read = 0;
+    xfer.retries = OPT3001_MAX_RETRY - 1;
+    xfer.data    = data;
+    xfer.ptr     = &h->reg_ptr;
+    xfer.result  = OPT3001_XFER_OK;
+    xfer.cb      = cb;
+    xfer.ctx     = ctx;
+    return OPT3001_Async_Submit(&xfer);
+}
+
+u8 OPT3001_Async_Pending(void)
+{
+    return queue_count;
+}
+
+u32 OPT3001_Async_GetXferCount(void)
+{
+    return xfer_total;
+}
+
+/********************* 中断服务函数 *********************/
+// TIM2节拍：等待重试间隔，或推进队头事务
+void TIM2_IRQHandler(void)
+{
+    TIM2->SR = (u16)~TIM_SR_UIF;
+
+    if(queue_count == 0)
+    {
+        OPT3001_Async_TickStop();
+        return;
+    }
+    if(xfer_wait_ticks > 0)
+    {
+        xfer_wait_ticks--;
+        return;
+    }
+    OPT3001_Async_Service(&xfer_queue[queue_head]);
+}
@@ -0,0 +1,52 @@
+#ifndef __OPT3001_ASYNC_H
+#define __OPT3001_ASYNC_H
+
+#include "opt3001.h"
+
+/********************* 异步事务队列参数 *********************/
+#define OPT3001_ASYNC_QUEUE_SIZE   8      // 排队事务数上限
+#define OPT3001_ASYNC_TICK_US      200    // TIM2服务节拍（软件IIC每节拍推进一个字节，100kHz下约占一半）
+#define OPT3001_ASYNC_RETRY_MS     10     // 失败后重试间隔（不再占用主循环）
+#define OPT3001_ASYNC_TIMEOUT_MS   5      // 硬件I2C单次事务超时
+
+// 事务结果
+typedef enum {
+    OPT3001_XFER_OK = 0,    // 成功
+    OPT3001_XFER_NACK,      // 无应答/总线错误（重试耗尽）
+    OPT3001_XFER_TIMEOUT    // 事务超时（重试耗尽）
+} OPT3001_XferResultTypeDef;
+
+typedef struct OPT3001_Xfer OPT3001_XferTypeDef;
+
+// 完成回调（在TIM2或I2C1中断上下文中调用，应尽快返回）
+typedef void (*OPT3001_XferCallback)(const OPT3001_XferTypeDef *xfer);
+
+// 事务描述符：提交时整体拷贝进队列，调用者无需保留
+struct OPT3001_Xfer {
+    const OPT3001_BusTypeDef *bus;     // 所在总线
+    u8  addr;                          // 7位从机地址
+    u8  reg;                           // 寄存器地址
+    u8  is_read;                       // 1：读寄存器，0：写寄存器
+    u8  retries;                       // 失败后剩余重试次数
+    u16 data;                          // 写入值 / 读出值
+    u8 *ptr;                           // 器件寄存器指针缓存（0：不使用，每次都写指针）
+    OPT3001_XferResultTypeDef result;  // 完成时填写
+    OPT3001_XferCallback cb;
+    void *ctx;                         // 透传给回调的用户参数
+};
+
+/********************* 函数声明 *********************/
+// 初始化TIM2服务节拍（总线本身由OPT3001_Init初始化）
+void OPT3001_Async_Init(void);
+// 提交事务（返回0：成功，1：队列满）
+u8 OPT3001_Async_Submit(const OPT3001_XferTypeDef *xfer);
+// 便捷封装：读/写指定传感器寄存器，共尝试OPT3001_MAX_RETRY次；
+// 使用传感器的寄存器指针缓存，执行时指针已指向目标寄存器的读操作不再写指针
+u8 OPT3001_Async_ReadReg(OPT3001_HandleTypeDef *h, u8 reg_addr, OPT3001_XferCallback cb, void *ctx);
+u8 OPT3001_Async_WriteReg(OPT3001_HandleTypeDef *h, u8 reg_addr, u16 data, OPT3001_XferCallback cb, void *ctx);
+// 队列中尚未完成的事务数
+u8 OPT3001_Async_Pending(void);
+// 上电以来提交的事务总数（不含重试）
+u32 OPT3001_Async_GetXferCount(void);
+
+#endif
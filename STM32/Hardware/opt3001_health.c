@@ -0,0 +1,169 @@
+#include "opt3001_health.h"
+#include "opt3001_sched.h"
+#include "opt3001_adapt.h"
+#include "delay.h"
+
+/********************* 健康状态（按传感器编号） *********************/
+typedef enum {
+    HEALTH_ONLINE = 0,     // 正常采集
+    HEALTH_OFFLINE,        // 等待退避到期后恢复
+    HEALTH_RECOVERING      // 已重新初始化，等待第一个有效读数
+} OPT3001_HealthStateTypeDef;
+
+typedef struct {
+    OPT3001_HandleTypeDef *h;
+    u8  state;
+    u8  fails;             // 连续失败轮数
+    u8  type;              // 本次故障类型（OPT3001_FAULT_TYPES表示尚未判定）
+    u32 fail_since;        // 首次失败时刻（ms）
+    u32 backoff;           // 当前退避间隔（ms）
+    u32 next_try;          // 下次恢复尝试时刻（ms）
+} OPT3001_HealthCtxTypeDef;
+
+static OPT3001_HealthCtxTypeDef health[OPT3001_MAX_SENSORS];
+static u8 health_count = 0;
+static OPT3001_RecoveryStatsTypeDef health_stats[OPT3001_FAULT_TYPES];
+static u32 health_bus_recoveries = 0;
+
+/********************* 恢复流程 *********************/
+// 本次尝试失败：按当前间隔安排下次尝试，间隔翻倍（不超过上限）
+static void OPT3001_Health_Backoff(OPT3001_HealthCtxTypeDef *c, u32 now)
+{
+    c->next_try = now + c->backoff;
+    c->backoff = c->backoff * 2 > OPT3001_HEALTH_BACKOFF_MAX ? OPT3001_HEALTH_BACKOFF_MAX : c->backoff * 2;
+}
+
+// 总线卡死先补时钟+STOP；线路正常后重新写入配置并回读校验，恢复当前采集模式的阈值
+static u8 OPT3001_Health_TryRecover(OPT3001_HealthCtxTypeDef *c)
+{
+    u8 line = OPT3001_Bus_IsStuck(c->h->bus);
+
+    if(c->type == OPT3001_FAULT_TYPES)
+    {
+        c->type = line ? OPT3001_FAULT_BUS_STUCK : OPT3001_FAULT_NO_ACK;
+        health_stats[c->type].faults++;
+    }
+    health_stats[c->type].attempts++;
+    if(line)
+    {
+        health_bus_recoveries++;
+        if(OPT3001_Bus_Recover(c->h->bus) != 0)
+            return 1;       // SCL被拉住或从机仍不释放SDA，等下次退避
+    }
+    if(OPT3001_Sensor_Init(c->h) != 0 || OPT3001_Sched_ApplyMode(c->h) != 0)
+        return 1;
+    FilterChain_Reset(&c->h->filter);
+#if OPT3001_ADAPT_ENABLE
+    OPT3001_Adapt_Reset(c->h->id);
+#endif
+    return 0;
+}
+
+/********************* 对外接口 *********************/
+void OPT3001_Health_Init(OPT3001_HandleTypeDef *sensors, u8 count)
+{
+    u8 i;
+
+    if(count > OPT3001_MAX_SENSORS)
+        count = OPT3001_MAX_SENSORS;
+    for(i=0; i<count; i++)
+    {
+        health[i].h = &sensors[i];
+        health[i].state = HEALTH_ONLINE;
+        health[i].fails = 0;
+        health[i].type = OPT3001_FAULT_TYPES;
+    }
+    health_count = count;
+}
+
+void OPT3001_Health_OnResult(OPT3001_HandleTypeDef *h, u8 ok)
+{
+    OPT3001_HealthCtxTypeDef *c;
+    OPT3001_RecoveryStatsTypeDef *st;
+    u32 now = millis();
+    u32 elapsed;
+
+    if(h->id >= health_count)
+        return;
+    c = &health[h->id];
+
+    if(ok)
+    {
+        // 恢复后第一个有效读数：记录从首次失败起的总耗时
+        if(c->state == HEALTH_RECOVERING)
+        {
+            st = &health_stats[c->type];
+            elapsed = now - c->fail_since;
+            st->recovered++;
+            st->last_ms = elapsed;
+            st->total_ms += elapsed;
+            if(elapsed > st->max_ms)
+                st->max_ms = elapsed;
+        }
+        c->state = HEALTH_ONLINE;
+        c->fails = 0;
+        return;
+    }
+
+    if(c->state == HEALTH_OFFLINE)
+        return;                     // 离线期间的失败由调度器代报，不计入
+    if(c->state == HEALTH_RECOVERING)
+    {
+        // 初始化成功但读取仍失败：退回离线，继续退避
+        c->state = HEALTH_OFFLINE;
+        OPT3001_Health_Backoff(c, now);
+        return;
+    }
+    if(c->fails++ == 0)
+        c->fail_since = now;
+    // 线路被拉死不会自行消失，不必等满失败轮数（仅在总线上没有其它事务时检查线路）
+    if(OPT3001_Async_Pending() == 0 && OPT3001_Bus_IsStuck(h->bus))
+        c->fails = OPT3001_HEALTH_FAIL_LIMIT;
+    if(c->fails >= OPT3001_HEALTH_FAIL_LIMIT)
+    {
+        c->state = HEALTH_OFFLINE;
+        c->type = OPT3001_FAULT_TYPES;
+        c->backoff = OPT3001_HEALTH_BACKOFF_MIN;
+        c->next_try = now;          // 首次恢复立即尝试
+    }
+}
+
+u8 OPT3001_Health_IsOnline(u8 id)
+{
+    return id >= health_count || health[id].state != HEALTH_OFFLINE;
+}
+
+void OPT3001_Health_Poll(void)
+{
+    OPT3001_HealthCtxTypeDef *c;
+    u32 now = millis();
+    u8 i;
+
+    // 恢复序列和重新初始化直接驱动总线，必须在没有异步事务时进行
+    if(OPT3001_Sched_IsBusy() || OPT3001_Async_Pending() != 0)
+        return;
+
+    for(i=0; i<health_count; i++)
+    {
+        c = &health[i];
+        if(c->state != HEALTH_OFFLINE || !TIME_REACHED(now, c->next_try))
+            continue;
+        if(OPT3001_Health_TryRecover(c) == 0)
+        {
+            c->state = HEALTH_RECOVERING;
+            continue;
+        }
+        OPT3001_Health_Backoff(c, now);
+    }
+}
+
+void OPT3001_Health_GetStats(OPT3001_FaultTypeDef type, OPT3001_RecoveryStatsTypeDef *stats)
+{
+    if(type < OPT3001_FAULT_TYPES)
+        *stats = health_stats[type];
+}
+
+u32 OPT3001_Health_GetBusRecoveries(void)
+{
+    return health_bus_recoveries;
+}
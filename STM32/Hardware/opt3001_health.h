@@ -0,0 +1,44 @@
+#ifndef __OPT3001_HEALTH_H
+#define __OPT3001_HEALTH_H
+
+#include "opt3001.h"
+
+/********************* 传感器健康监测参数 *********************/
+// 连续多轮通信失败的传感器转为离线：调度器不再为它占用总线，
+// 由主循环按指数退避尝试恢复（总线卡死先补时钟+STOP，再重新初始化传感器）
+#define OPT3001_HEALTH_ENABLE       1
+#define OPT3001_HEALTH_FAIL_LIMIT   3       // 连续失败轮数达到该值转为离线
+#define OPT3001_HEALTH_BACKOFF_MIN  100     // 首次恢复尝试前等待（ms）
+#define OPT3001_HEALTH_BACKOFF_MAX  10000   // 退避间隔上限（ms）
+#define OPT3001_HEALTH_STALL_MS     1000    // 一轮读取超过该时间未完成视为采集停滞（不再喂狗）
+
+// 故障类型（首次恢复尝试时按线路状态判定）
+typedef enum {
+    OPT3001_FAULT_BUS_STUCK = 0,   // 总线被拉死（SDA/SCL空闲时为低）
+    OPT3001_FAULT_NO_ACK,          // 总线正常但传感器无应答/数据无效（掉线、掉电、复位）
+    OPT3001_FAULT_TYPES
+} OPT3001_FaultTypeDef;
+
+// 恢复耗时统计：从首次通信失败到恢复后第一个有效读数
+typedef struct {
+    u32 faults;        // 进入离线的次数
+    u32 recovered;     // 已恢复次数
+    u32 attempts;      // 恢复尝试次数（含失败）
+    u32 last_ms;       // 最近一次恢复耗时
+    u32 max_ms;        // 最大恢复耗时
+    u32 total_ms;      // 累计恢复耗时（求平均）
+} OPT3001_RecoveryStatsTypeDef;
+
+/********************* 函数声明 *********************/
+void OPT3001_Health_Init(OPT3001_HandleTypeDef *sensors, u8 count);
+// 每个读取结果调用一次（主循环上下文，OPT3001_Sched_Poll内）
+void OPT3001_Health_OnResult(OPT3001_HandleTypeDef *h, u8 ok);
+// 传感器是否在线（离线时调度器跳过总线访问）
+u8 OPT3001_Health_IsOnline(u8 id);
+// 主循环调用：调度空闲且退避到期时执行总线恢复/重新初始化（阻塞，单次约1ms）
+void OPT3001_Health_Poll(void);
+void OPT3001_Health_GetStats(OPT3001_FaultTypeDef type, OPT3001_RecoveryStatsTypeDef *stats);
+// 总线恢复序列执行次数
+u32 OPT3001_Health_GetBusRecoveries(void);
+
+#endif
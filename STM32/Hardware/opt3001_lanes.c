@@ -0,0 +1,351 @@
+#include "opt3001_lanes.h"
+#include "delay.h"
+#include "metrics.h"
+
+/********************* 总线时序（DWT周期数，OPT3001_Lanes_Init中按主频校准） *********************/
+static u32 lanes_t_low;
+static u32 lanes_t_high;
+static u32 lanes_t_buf;
+
+#if OPT3001_IIC_STATS
+static OPT3001_IIC_StatsTypeDef lanes_stats;
+#define LANES_STAT_INC(field)  (lanes_stats.field++)
+#else
+#define LANES_STAT_INC(field)
+#endif
+
+// 默认多通道总线
+const OPT3001_LaneBusTypeDef OPT3001_DefaultLanes = {
+    OPT3001_LANES_PORT, OPT3001_LANES_SCL_PIN, OPT3001_LANES_COUNT,
+    {GPIO_Pin_0, GPIO_Pin_1, GPIO_Pin_2, GPIO_Pin_3, GPIO_Pin_4, GPIO_Pin_5, GPIO_Pin_6, GPIO_Pin_7},
+    OPT3001_LANES_RCC
+};
+
+/********************* 辅助函数 *********************/
+static void OPT3001_Lanes_Wait(u32 cycles)
+{
+    u32 start = DWT->CYCCNT;
+    while((DWT->CYCCNT - start) < cycles);
+}
+
+// 释放SCL并等待其真正变高（任一从机时钟延展都会拉住共用的SCL）
+static void OPT3001_Lanes_SCL_Release(const OPT3001_LaneBusTypeDef *bus)
+{
+    u32 start;
+
+    bus->port->BSRR = bus->scl_pin;
+    LANES_STAT_INC(scl_pulses);
+    start = DWT->CYCCNT;
+    while(!(bus->port->IDR & bus->scl_pin) && (DWT->CYCCNT - start) < OPT3001_IIC_STRETCH_CYC);
+}
+
+static u32 OPT3001_Lanes_NsToCycles(u32 ns, u32 overhead)
+{
+    u32 cycles = (ns * (SystemCoreClock / 1000000) + 999) / 1000;
+    return (cycles > overhead) ? (cycles - overhead) : 0;
+}
+
+// 通道位图换算为引脚位图
+static u16 OPT3001_Lanes_Pins(const OPT3001_LaneBusTypeDef *bus, u8 lanes)
+{
+    u16 pins = 0;
+    u8 i;
+
+    for(i=0; i<bus->count; i++)
+    {
+        if(lanes & (1 << i))
+            pins |= bus->sda_pin[i];
+    }
+    return pins;
+}
+
+// 一次IDR采样换算为“SDA为低”的通道位图
+static u8 OPT3001_Lanes_LowLanes(const OPT3001_LaneBusTypeDef *bus, u16 idr)
+{
+    u8 low = 0, i;
+
+    for(i=0; i<bus->count; i++)
+    {
+        if(!(idr & bus->sda_pin[i]))
+            low |= 1 << i;
+    }
+    return low;
+}
+
+static void OPT3001_Lanes_Fill(u8 *bytes, u8 value)
+{
+    u8 i;
+
+    for(i=0; i<OPT3001_LANES_MAX; i++)
+        bytes[i] = value;
+}
+
+/********************* 底层位操作 *********************/
+void OPT3001_Lanes_Init(const OPT3001_LaneBusTypeDef *bus)
+{
+    GPIO_InitTypeDef GPIO_InitStruct;
+    u16 all = OPT3001_Lanes_Pins(bus, 0xFF);
+    u32 start, overhead;
+
+    RCC_APB2PeriphClockCmd(bus->rcc, ENABLE);
+    GPIO_InitStruct.GPIO_Pin = bus->scl_pin | all;
+    GPIO_InitStruct.GPIO_Mode = GPIO_Mode_Out_OD;
+    GPIO_InitStruct.GPIO_Speed = GPIO_Speed_50MHz;
+    GPIO_Init(bus->port, &GPIO_InitStruct);
+    bus->port->BSRR = bus->scl_pin | all;
+
+    // 校准同OPT3001_IIC_Init：“释放SCL+零等待”的开销只从高电平半周期中扣除
+    if(lanes_t_high != 0)
+        return;
+    DWT_Init();
+    start = DWT->CYCCNT;
+    OPT3001_Lanes_SCL_Release(bus);
+    OPT3001_Lanes_Wait(0);
+    overhead = DWT->CYCCNT - start;
+
+    lanes_t_low  = OPT3001_Lanes_NsToCycles(OPT3001_IIC_T_LOW_NS,  0);
+    lanes_t_high = OPT3001_Lanes_NsToCycles(OPT3001_IIC_T_HIGH_NS, overhead);
+    lanes_t_buf  = OPT3001_Lanes_NsToCycles(OPT3001_IIC_T_BUF_NS,  0);
+}
+
+// 释放全部SDA和SCL后采样：SCL被拉住则全部失败，SDA被占住的通道不参与本次事务
+u8 OPT3001_Lanes_Start(const OPT3001_LaneBusTypeDef *bus, u8 lanes)
+{
+    u16 idr;
+    u8 busy;
+
+    LANES_STAT_INC(starts);
+    bus->port->BSRR = OPT3001_Lanes_Pins(bus, 0xFF);
+    if(!(bus->port->IDR & bus->scl_pin))
+        OPT3001_Lanes_Wait(lanes_t_low);    // 重复起始：SCL仍为低，补足tLOW/tSU;DAT后再释放
+    OPT3001_Lanes_SCL_Release(bus);
+    OPT3001_Lanes_Wait(lanes_t_high);
+    idr = bus->port->IDR;
+    if(!(idr & bus->scl_pin))
+    {
+        METRIC_INC(METRIC_BUS_BUSY);
+        return 0;
+    }
+    busy = OPT3001_Lanes_LowLanes(bus, idr) & lanes;
+    if(busy)
+    {
+        METRIC_INC(METRIC_BUS_BUSY);
+        lanes &= ~busy;
+    }
+    if(lanes == 0)
+        return 0;
+    bus->port->BRR = OPT3001_Lanes_Pins(bus, lanes);
+    OPT3001_Lanes_Wait(lanes_t_high);
+    bus->port->BRR = bus->scl_pin;
+    return lanes;
+}
+
+void OPT3001_Lanes_Stop(const OPT3001_LaneBusTypeDef *bus, u8 lanes)
+{
+    bus->port->BRR = OPT3001_Lanes_Pins(bus, lanes);
+    OPT3001_Lanes_Wait(lanes_t_low);
+    OPT3001_Lanes_SCL_Release(bus);
+    OPT3001_Lanes_Wait(lanes_t_high);
+    bus->port->BSRR = OPT3001_Lanes_Pins(bus, 0xFF);
+    OPT3001_Lanes_Wait(lanes_t_buf);
+}
+
+// 8个位的BSRR值先算好（低16位置1、高16位清0），时钟期间每位只写一次BSRR
+u8 OPT3001_Lanes_SendByte(const OPT3001_LaneBusTypeDef *bus, const u8 *bytes, u8 lanes)
+{
+    u32 bsrr[8];
+    u16 set, reset, all = OPT3001_Lanes_Pins(bus, 0xFF);
+    u8 b, i, mask;
+
+    LANES_STAT_INC(bytes);
+    for(b=0; b<8; b++)
+    {
+        mask = 0x80 >> b;
+        set = 0;
+        reset = 0;
+        for(i=0; i<bus->count; i++)
+        {
+            if((lanes & (1 << i)) && !(bytes[i] & mask))
+                reset |= bus->sda_pin[i];
+            else
+                set |= bus->sda_pin[i];
+        }
+        bsrr[b] = set | ((u32)reset << 16);
+    }
+
+    for(b=0; b<8; b++)
+    {
+        bus->port->BSRR = bsrr[b];
+        OPT3001_Lanes_Wait(lanes_t_low);
+        OPT3001_Lanes_SCL_Release(bus);
+        OPT3001_Lanes_Wait(lanes_t_high);
+        bus->port->BRR = bus->scl_pin;
+    }
+
+    // 应答位：释放全部SDA，SCL高电平期间一次采样
+    bus->port->BSRR = all;
+    OPT3001_Lanes_Wait(lanes_t_low);
+    OPT3001_Lanes_SCL_Release(bus);
+    OPT3001_Lanes_Wait(lanes_t_high);
+    b = OPT3001_Lanes_LowLanes(bus, bus->port->IDR) & lanes;
+    bus->port->BRR = bus->scl_pin;
+    return b;
+}
+
+// 每位一次IDR采样存起来，8位收完再按通道拆分
+void OPT3001_Lanes_ReceiveByte(const OPT3001_LaneBusTypeDef *bus, u8 *bytes, u8 lanes, u8 nack)
+{
+    u16 idr[8];
+    u16 all = OPT3001_Lanes_Pins(bus, 0xFF);
+    u8 b, i, byte;
+
+    LANES_STAT_INC(bytes);
+    bus->port->BSRR = all;
+    for(b=0; b<8; b++)
+    {
+        OPT3001_Lanes_Wait(lanes_t_low);
+        OPT3001_Lanes_SCL_Release(bus);
+        OPT3001_Lanes_Wait(lanes_t_high);
+        idr[b] = bus->port->IDR;
+        bus->port->BRR = bus->scl_pin;
+    }
+
+    // 应答位：只向参与的通道发应答，其余通道保持释放
+    if(!nack)
+        bus->port->BRR = OPT3001_Lanes_Pins(bus, lanes);
+    OPT3001_Lanes_Wait(lanes_t_low);
+    OPT3001_Lanes_SCL_Release(bus);
+    OPT3001_Lanes_Wait(lanes_t_high);
+    bus->port->BRR = bus->scl_pin;
+    bus->port->BSRR = all;
+
+    for(i=0; i<bus->count; i++)
+    {
+        byte = 0;
+        for(b=0; b<8; b++)
+            byte = (byte << 1) | ((idr[b] & bus->sda_pin[i]) ? 1 : 0);
+        bytes[i] = byte;
+    }
+}
+
+#if OPT3001_IIC_STATS
+void OPT3001_Lanes_GetStats(OPT3001_IIC_StatsTypeDef *stats)
+{
+    *stats = lanes_stats;
+}
+
+void OPT3001_Lanes_ResetStats(void)
+{
+    lanes_stats.scl_pulses = 0;
+    lanes_stats.bytes = 0;
+    lanes_stats.starts = 0;
+}
+#endif
+
+/********************* 寄存器访问 *********************/
+// 发送一个阶段（地址/指针/数据字节），返回仍有应答的通道；有通道退出时计入该阶段的无应答计数
+static u8 OPT3001_Lanes_Phase(const OPT3001_LaneBusTypeDef *bus, const u8 *bytes, u8 lanes,
+                              Metrics_CounterTypeDef nack_metric)
+{
+    u8 acked;
+
+    if(lanes == 0)
+        return 0;
+    acked = OPT3001_Lanes_SendByte(bus, bytes, lanes);
+    if(acked != lanes)
+        METRIC_INC(nack_metric);
+    return acked;
+}
+
+u8 OPT3001_Lanes_Probe(const OPT3001_LaneBusTypeDef *bus, u8 addr, u8 lanes)
+{
+    u8 bytes[OPT3001_LANES_MAX];
+    u8 started, ok;
+
+    started = OPT3001_Lanes_Start(bus, lanes);
+    if(started == 0)
+        return 0;
+    OPT3001_Lanes_Fill(bytes, addr << 1);
+    ok = OPT3001_Lanes_SendByte(bus, bytes, started);
+    OPT3001_Lanes_Stop(bus, started);
+    return ok;
+}
+
+// 每个阶段后只保留有应答的通道；最后在所有发过START的通道上统一STOP
+u8 OPT3001_Lanes_ReadReg(const OPT3001_LaneBusTypeDef *bus, u8 addr, u8 reg, u8 lanes, u16 *data)
+{
+    u8 bytes[OPT3001_LANES_MAX];
+    u8 hi[OPT3001_LANES_MAX];
+    u8 started, ok, i;
+
+    for(i=0; i<bus->count; i++)
+        data[i] = 0xFFFF;
+    started = OPT3001_Lanes_Start(bus, lanes);
+    if(started == 0)
+        return 0;
+
+    OPT3001_Lanes_Fill(bytes, addr << 1);
+    ok = OPT3001_Lanes_Phase(bus, bytes, started, METRIC_NACK_ADDR_W);
+    OPT3001_Lanes_Fill(bytes, reg);
+    ok = OPT3001_Lanes_Phase(bus, bytes, ok, METRIC_NACK_REG);
+    // 重复起始：只在仍参与的通道上发出
+    if(ok)
+        ok = OPT3001_Lanes_Start(bus, ok);
+    OPT3001_Lanes_Fill(bytes, (addr << 1) | 0x01);
+    ok = OPT3001_Lanes_Phase(bus, bytes, ok, METRIC_NACK_ADDR_R);
+    if(ok)
+    {
+        OPT3001_Lanes_ReceiveByte(bus, hi, ok, 0);
+        OPT3001_Lanes_ReceiveByte(bus, bytes, ok, 1);
+        for(i=0; i<bus->count; i++)
+        {
+            if(ok & (1 << i))
+                data[i] = ((u16)hi[i] << 8) | bytes[i];
+        }
+    }
+    OPT3001_Lanes_Stop(bus, started);
+    return ok;
+}
+
+u8 OPT3001_Lanes_WriteReg(const OPT3001_LaneBusTypeDef *bus, u8 addr, u8 reg, u8 lanes, const u16 *data)
+{
+    u8 bytes[OPT3001_LANES_MAX];
+    u8 started, ok, i;
+
+    started = OPT3001_Lanes_Start(bus, lanes);
+    if(started == 0)
+        return 0;
+
+    OPT3001_Lanes_Fill(bytes, addr << 1);
+    ok = OPT3001_Lanes_Phase(bus, bytes, started, METRIC_NACK_ADDR_W);
+    OPT3001_Lanes_Fill(bytes, reg);
+    ok = OPT3001_Lanes_Phase(bus, bytes, ok, METRIC_NACK_REG);
+    for(i=0; i<bus->count; i++)
+        bytes[i] = (data[i] >> 8) & 0xFF;
+    ok = OPT3001_Lanes_Phase(bus, bytes, ok, METRIC_NACK_DATA);
+    for(i=0; i<bus->count; i++)
+        bytes[i] = data[i] & 0xFF;
+    ok = OPT3001_Lanes_Phase(bus, bytes, ok, METRIC_NACK_DATA);
+    OPT3001_Lanes_Stop(bus, started);
+    return ok;
+}
+
+u8 OPT3001_Lanes_SensorInit(const OPT3001_LaneBusTypeDef *bus, u8 addr, u8 lanes)
+{
+    u16 data[OPT3001_LANES_MAX];
+    u8 i;
+
+    for(i=0; i<OPT3001_LANES_MAX; i++)
+        data[i] = OPT3001_CONFIG_DEFAULT;
+    lanes = OPT3001_Lanes_WriteReg(bus, addr, OPT3001_CONFIG_REG, lanes, data);
+    for(i=0; i<OPT3001_LANES_MAX; i++)
+        data[i] = OPT3001_LOW_LIMIT_EOC;
+    lanes = OPT3001_Lanes_WriteReg(bus, addr, OPT3001_LOW_LIMIT_REG, lanes, data);
+    lanes = OPT3001_Lanes_ReadReg(bus, addr, OPT3001_CONFIG_REG, lanes, data);
+    for(i=0; i<bus->count; i++)
+    {
+        if((data[i] & 0xFE1F) != OPT3001_CONFIG_DEFAULT)
+            lanes &= ~(1 << i);
+    }
+    return lanes;
+}
@@ -0,0 +1,62 @@
+#ifndef __OPT3001_LANES_H
+#define __OPT3001_LANES_H
+
+#include "opt3001.h"
+
+/********************* 多通道锁步软件IIC *********************/
+// OPT3001只有4个地址，更大的阵列需要多条总线。各总线共用一根SCL，每条总线（通道）一根SDA，
+// 全部SDA在同一GPIO端口：每个位周期用一次BSRR写同时驱动所有通道，一次IDR读同时采样所有通道，
+// 同地址的N个传感器在单个传感器的总线时间内完成读写（时序与OPT3001_IIC_*相同）。
+// 某个通道无应答后即退出本次事务（SDA保持释放），其余通道继续，最后统一发STOP
+// 1：启用（main.c启动时初始化并测时，提供lanes命令）
+#define OPT3001_LANES_ENABLE   0
+#define OPT3001_LANES_MAX      8       // 通道上限（位图为u8）
+
+// 默认接线：PA8=SCL，PA0~PA3=通道0~3的SDA（PA0~PA7可接满8个通道）
+#define OPT3001_LANES_PORT     GPIOA
+#define OPT3001_LANES_SCL_PIN  GPIO_Pin_8
+#define OPT3001_LANES_RCC      RCC_APB2Periph_GPIOA
+#define OPT3001_LANES_COUNT    4
+
+// 多通道总线描述：sda_pin[i]为通道i的SDA，与scl_pin同在port上
+typedef struct {
+    GPIO_TypeDef *port;
+    u16 scl_pin;
+    u8  count;                          // 通道数（1~OPT3001_LANES_MAX）
+    u16 sda_pin[OPT3001_LANES_MAX];
+    u32 rcc;                            // 端口APB2时钟
+} OPT3001_LaneBusTypeDef;
+
+// 默认多通道总线：上方引脚定义
+extern const OPT3001_LaneBusTypeDef OPT3001_DefaultLanes;
+
+/********************* 底层位操作（lanes为参与的通道位图） *********************/
+// 引脚初始化（开漏输出，外部上拉）并校准时序
+void OPT3001_Lanes_Init(const OPT3001_LaneBusTypeDef *bus);
+// 在lanes上发START，返回实际发出START的通道（SDA被占住的通道剔除；SCL被拉住时返回0）
+u8 OPT3001_Lanes_Start(const OPT3001_LaneBusTypeDef *bus, u8 lanes);
+// 在lanes上发STOP
+void OPT3001_Lanes_Stop(const OPT3001_LaneBusTypeDef *bus, u8 lanes);
+// 各通道同时发送bytes[i]并读取应答，返回有应答的通道（不在lanes中的通道SDA保持释放）
+u8 OPT3001_Lanes_SendByte(const OPT3001_LaneBusTypeDef *bus, const u8 *bytes, u8 lanes);
+// 各通道同时接收一个字节到bytes[i]（nack=0：向lanes发送应答，1：发送非应答）
+void OPT3001_Lanes_ReceiveByte(const OPT3001_LaneBusTypeDef *bus, u8 *bytes, u8 lanes, u8 nack);
+
+#if OPT3001_IIC_STATS
+// 多通道总线的SCL脉冲/字节/START统计（字节按总线计，不乘通道数）
+void OPT3001_Lanes_GetStats(OPT3001_IIC_StatsTypeDef *stats);
+void OPT3001_Lanes_ResetStats(void);
+#endif
+
+/********************* 寄存器访问（同地址传感器并行） *********************/
+// 以下函数返回全部字节都有应答的通道位图，未置位的通道即无应答/总线占用
+// 地址探测
+u8 OPT3001_Lanes_Probe(const OPT3001_LaneBusTypeDef *bus, u8 addr, u8 lanes);
+// 读寄存器：data[i]为通道i的读数（失败通道为0xFFFF）
+u8 OPT3001_Lanes_ReadReg(const OPT3001_LaneBusTypeDef *bus, u8 addr, u8 reg, u8 lanes, u16 *data);
+// 写寄存器：各通道写入各自的data[i]
+u8 OPT3001_Lanes_WriteReg(const OPT3001_LaneBusTypeDef *bus, u8 addr, u8 reg, u8 lanes, const u16 *data);
+// 各通道写入默认配置并设为转换完成指示模式，回读校验（同OPT3001_Sensor_Init）
+u8 OPT3001_Lanes_SensorInit(const OPT3001_LaneBusTypeDef *bus, u8 addr, u8 lanes);
+
+#endif
@@ -0,0 +1,410 @@
+#include "opt3001_sched.h"
+#include "opt3001_adapt.h"
+#include "opt3001_health.h"
+#include "delay.h"
+
+/********************* 调度器状态 *********************/
+// 各传感器独立连续转换，一轮内所有读取背靠背排队，
+// 总线时间远小于转换时间，单个传感器的采样率不随传感器数量线性下降。
+// 每个传感器先读配置寄存器：CRF置位才继续读结果寄存器，
+// 同一次转换只会进入滤波一次，未完成转换的查询不产生样本。
+// 事件模式下改为检查FH/FL：只有越出窗口才读结果，并立即重新居中窗口。
+// 距上次转换完成不足一个转换时间的传感器不查询（见OPT3001_SCHED_SKIP_ENABLE）
+static OPT3001_HandleTypeDef *sched_sensors = 0;
+static u8 sched_count = 0;
+static OPT3001_SampleCallback sched_cb = 0;
+
+static volatile u8  sched_pending = 0;                       // 已排队未返回（位图）
+static volatile u8  sched_ready = 0;                         // 有新样本/通信失败待处理（位图）
+static volatile u8  sched_ok = 0;                            // 读取成功（位图）
+static volatile u16 sched_raw[OPT3001_MAX_SENSORS];          // 结果寄存器原始值
+static volatile u32 sched_stamp[OPT3001_MAX_SENSORS];        // 样本时间戳（us）
+static u8  sched_active = 0;                                 // 1：本轮尚未处理完
+static u8  sched_paused = 0;
+static u32 sched_start_cyc = 0;
+static u32 sched_start_ms = 0;
+static volatile u32 sched_end_cyc = 0;
+static u32 sched_cycle_us = 0;
+
+static volatile u8  sched_int_flag = 0;                      // INT边沿待处理
+static volatile u32 sched_int_stamp = 0;                     // INT边沿时刻
+static volatile u8  sched_by_int = 0;                        // 本轮由INT触发
+static u8  sched_event_mode = 0;                             // 1：阈值窗口事件模式
+
+static volatile u8  sched_conv_valid = 0;                    // 已知最近一次转换完成时刻（位图）
+static volatile u8  sched_conv_slow = 0;                     // 最近读到的CT=800ms（位图）
+static volatile u32 sched_conv_stamp[OPT3001_MAX_SENSORS];   // 最近一次转换完成时刻（us）
+static u8  sched_skip_mask = 0;                              // 本轮跳过的传感器（位图）
+static u32 sched_skipped = 0;
+
+/********************* 事件模式窗口 *********************/
+// 以raw对应的光照为中心计算窗口，下限向下、上限向上取整
+static void OPT3001_Sched_Window(u16 raw, u16 *low, u16 *high)
+{
+    u32 centi = OPT3001_RawToCentiLux(raw);
+    u32 band = centi / 100 * OPT3001_EVENT_BAND_PCT;
+
+    if(band < OPT3001_EVENT_MIN_BAND)
+        band = OPT3001_EVENT_MIN_BAND;
+    *low  = OPT3001_CentiLuxToLimit(centi > band ? centi - band : 0, 0);
+    *high = OPT3001_CentiLuxToLimit(centi + band, 1);
+}
+
+// 中断上下文：新窗口排队写入（队列满时沿用旧窗口，下次越限再居中）
+static void OPT3001_Sched_Recenter(u8 idx, u16 raw)
+{
+    u16 low, high;
+
+    OPT3001_Sched_Window(raw, &low, &high);
+    OPT3001_Async_WriteReg(&sched_sensors[idx], OPT3001_LOW_LIMIT_REG, low, 0, 0);
+    OPT3001_Async_WriteReg(&sched_sensors[idx], OPT3001_HIGH_LIMIT_REG, high, 0, 0);
+}
+
+/********************* 读取完成回调（中断上下文） *********************/
+static void OPT3001_Sched_Finish(u8 idx, u8 ok)
+{
+    u8 bit = 1 << idx;
+
+    if(ok)
+        sched_ok |= bit;
+    else
+        sched_ok &= ~bit;
+    // 通信失败后器件可能已复位或重新初始化，转换时刻不再可信，恢复每轮查询；
+    // 失败样本以失败时刻为时间戳（成功样本已在读结果寄存器前打戳），不沿用上一个样本的时刻
+    if(!ok)
+    {
+        sched_conv_valid &= ~bit;
+        sched_stamp[idx] = micros();
+    }
+    sched_ready |= bit;
+    sched_pending &= ~bit;
+    if(sched_pending == 0)
+        sched_end_cyc = DWT->CYCCNT;
+}
+
+static void OPT3001_Sched_ReadDone(const OPT3001_XferTypeDef *xfer)
+{
+    u8 idx = (u8)(u32)xfer->ctx;
+
+    if(xfer->result != OPT3001_XFER_OK)
+    {
+        OPT3001_Sched_Finish(idx, 0);
+        return;
+    }
+
+    if(xfer->reg == OPT3001_CONFIG_REG)
+    {
+        // 模式位不是连续转换：读到的不是有效配置（总线干扰/器件复位），按通信失败处理
+        if((xfer->data & OPT3001_CFG_M) != OPT3001_CFG_M)
+        {
+            OPT3001_Sched_Finish(idx, 0);
+            return;
+        }
+        // CRF置位即刚结束一次转换（事件模式下FH/FL也只在转换结束时更新），记录作为跳过查询的基准
+        if(xfer->data & OPT3001_CFG_CRF)
+        {
+            sched_conv_stamp[idx] = sched_by_int ? sched_int_stamp : micros();
+            if(xfer->data & OPT3001_CFG_CT)
+                sched_conv_slow |= 1 << idx;
+            else
+                sched_conv_slow &= ~(1 << idx);
+            sched_conv_valid |= 1 << idx;
+        }
+        // 转换未完成（事件模式：未越限）：本轮不产生样本
+        if(!(xfer->data & (sched_event_mode ? (OPT3001_CFG_FH | OPT3001_CFG_FL) : OPT3001_CFG_CRF)))
+        {
+            sched_pending &= ~(1 << idx);
+            if(sched_pending == 0)
+                sched_end_cyc = DWT->CYCCNT;
+            return;
+        }
+        sched_stamp[idx] = sched_by_int ? sched_int_stamp : micros();
+        if(OPT3001_Async_ReadReg(&sched_sensors[idx], OPT3001_RESULT_REG,
+                                 OPT3001_Sched_ReadDone, xfer->ctx) != 0)
+            OPT3001_Sched_Finish(idx, 0);
+        return;
+    }
+
+    sched_raw[idx] = xfer->data;
+    if(sched_event_mode)
+        OPT3001_Sched_Recenter(idx, xfer->data);
+    OPT3001_Sched_Finish(idx, 1);
+}
+
+/********************* INT引脚（EXTI） *********************/
+#if OPT3001_INT_ENABLE
+static void OPT3001_Sched_IntInit(void)
+{
+    GPIO_InitTypeDef GPIO_InitStruct;
+    NVIC_InitTypeDef NVIC_InitStruct;
+
+    // INT为开漏输出，使用内部上拉
+    RCC_APB2PeriphClockCmd(OPT3001_INT_RCC | RCC_APB2Periph_AFIO, ENABLE);
+    GPIO_InitStruct.GPIO_Pin = OPT3001_INT_PIN;
+    GPIO_InitStruct.GPIO_Mode = GPIO_Mode_IPU;
+    GPIO_InitStruct.GPIO_Speed = GPIO_Speed_50MHz;
+    GPIO_Init(OPT3001_INT_PORT, &GPIO_InitStruct);
+    GPIO_EXTILineConfig(OPT3001_INT_PORTSRC, OPT3001_INT_PINSRC);
+
+    // 下降沿触发（INT低有效）
+    EXTI->RTSR &= ~(1 << OPT3001_INT_LINE);
+    EXTI->FTSR |= 1 << OPT3001_INT_LINE;
+    EXTI->PR    = 1 << OPT3001_INT_LINE;
+    EXTI->IMR  |= 1 << OPT3001_INT_LINE;
+
+    NVIC_InitStruct.NVIC_IRQChannel = OPT3001_INT_IRQn;
+    NVIC_InitStruct.NVIC_IRQChannelPreemptionPriority = 1;
+    NVIC_InitStruct.NVIC_IRQChannelSubPriority = 2;
+    NVIC_InitStruct.NVIC_IRQChannelCmd = ENABLE;
+    NVIC_Init(&NVIC_InitStruct);
+}
+
+// INT边沿只记录时刻，读取在主循环中发起
+void OPT3001_INT_IRQHandler(void)
+{
+    if(EXTI->PR & (1 << OPT3001_INT_LINE))
+    {
+        EXTI->PR = 1 << OPT3001_INT_LINE;
+        sched_int_stamp = micros();
+        sched_int_flag = 1;
+    }
+}
+#endif
+
+/********************* 对外接口 *********************/
+void OPT3001_Sched_Init(OPT3001_HandleTypeDef *sensors, u8 count, OPT3001_SampleCallback cb)
+{
+    if(count > OPT3001_MAX_SENSORS)
+        count = OPT3001_MAX_SENSORS;
+    sched_sensors = sensors;
+    sched_count = count;
+    sched_cb = cb;
+    sched_pending = sched_ready = sched_ok = 0;
+    sched_active = 0;
+    sched_paused = 0;
+    sched_int_flag = 0;
+    sched_conv_valid = 0;
+    DWT_Init();
+#if OPT3001_INT_ENABLE
+    OPT3001_Sched_IntInit();
+    // 上电前已锁存的INT不会再产生边沿，先按一次事件处理
+    if(!(OPT3001_INT_PORT->IDR & OPT3001_INT_PIN))
+    {
+        sched_int_stamp = micros();
+        sched_int_flag = 1;
+    }
+#endif
+}
+
+#if OPT3001_SCHED_SKIP_ENABLE
+// 距上次转换完成不足 转换时间×(1-余量) 时，本次转换不可能已结束。
+// 转换时间取读回的CT与自适应控制器当前配置中较短的一个（切到100ms后立即按新节奏查询）
+static u8 OPT3001_Sched_NotDue(u8 idx, u32 now_us)
+{
+    u32 conv_us;
+#if OPT3001_ADAPT_ENABLE
+    OPT3001_AdaptStatsTypeDef as;
+#endif
+
+    if(!(sched_conv_valid & (1 << idx)))
+        return 0;
+    conv_us = (sched_conv_slow & (1 << idx)) ? 800000 : 100000;
+#if OPT3001_ADAPT_ENABLE
+    OPT3001_Adapt_GetStats(idx, &as);
+    if(!(as.config & OPT3001_CFG_CT))
+        conv_us = 100000;
+#endif
+    return (u32)(now_us - sched_conv_stamp[idx]) < conv_us / 100 * (100 - OPT3001_SCHED_CONV_TOL_PCT);
+}
+#endif
+
+static u8 OPT3001_Sched_Begin(u8 by_int)
+{
+    u32 now_us = micros();
+    u8 i;
+
+    if(sched_active || sched_count == 0)
+        return 1;
+
+    sched_start_cyc = DWT->CYCCNT;
+    sched_end_cyc = sched_start_cyc;        // 全部跳过时本轮耗时为0
+    sched_start_ms = millis();
+    sched_skip_mask = 0;
+    sched_by_int = by_int;
+    sched_active = 1;
+    for(i=0; i<sched_count; i++)
+    {
+        sched_pending |= 1 << i;
+#if OPT3001_HEALTH_ENABLE
+        // 离线传感器不占用总线，仍按通信失败上报状态，等待健康监测重新初始化
+        if(!OPT3001_Health_IsOnline(i))
+        {
+            __disable_irq();
+            OPT3001_Sched_Finish(i, 0);
+            __enable_irq();
+            continue;
+        }
+#endif
+#if OPT3001_SCHED_SKIP_ENABLE
+        if(OPT3001_Sched_NotDue(i, now_us))
+        {
+            sched_pending &= ~(1 << i);
+            sched_skip_mask |= 1 << i;
+            sched_skipped++;
+            continue;
+        }
+#endif
+        if(OPT3001_Async_ReadReg(&sched_sensors[i], OPT3001_CONFIG_REG,
+                                 OPT3001_Sched_ReadDone, (void *)(u32)i) != 0)
+        {
+            // 队列满：本传感器记为通信失败，交给滤波流程沿用上次有效值
+            __disable_irq();
+            OPT3001_Sched_Finish(i, 0);
+            __enable_irq();
+        }
+    }
+    return 0;
+}
+
+u8 OPT3001_Sched_StartCycle(void)
+{
+    return OPT3001_Sched_Begin(0);
+}
+
+// 事件模式的样本本身就是跳变，不经过中值/跳变滤波
+static u32 OPT3001_Sched_EventLux(OPT3001_HandleTypeDef *h, u8 ok, u16 raw)
+{
+    if(!ok)
+    {
+        h->status = OPT3001_STATUS_COMM_ERR;
+        return h->last_valid_clux;
+    }
+    h->status = OPT3001_STATUS_NORMAL;
+    h->last_valid_clux = OPT3001_RawToCentiLux(raw);
+    return h->last_valid_clux;
+}
+
+u8 OPT3001_Sched_Poll(void)
+{
+    u8 ready, ok, i;
+    u16 raw;
+    u32 clux;
+
+    if(!sched_active)
+    {
+        if(sched_int_flag && !sched_paused)
+        {
+            sched_int_flag = 0;
+            OPT3001_Sched_Begin(1);
+        }
+        return 0;
+    }
+
+    __disable_irq();
+    ready = sched_ready;
+    ok = sched_ok;
+    sched_ready = 0;
+    __enable_irq();
+
+    for(i=0; i<sched_count; i++)
+    {
+        if(!(ready & (1 << i)))
+            continue;
+        raw = sched_raw[i];
+        clux = (ok & (1 << i)) ? OPT3001_RawToCentiLux(raw) : OPT3001_CLUX_INVALID;
+#if OPT3001_HEALTH_ENABLE
+        OPT3001_Health_OnResult(&sched_sensors[i], (ok & (1 << i)) != 0);
+#endif
+        if(sched_event_mode)
+            clux = OPT3001_Sched_EventLux(&sched_sensors[i], ok & (1 << i), raw);
+#if OPT3001_ADAPT_ENABLE
+        // 转换跨越了转换时间/量程切换，新旧配置混合，丢弃
+        else if(OPT3001_Adapt_OnSample(&sched_sensors[i], clux, sched_stamp[i]))
+            continue;
+#endif
+        // 被抽取级吸收的样本不回调；异常样本仍回调以上报状态
+        else if(!OPT3001_Sensor_Process(&sched_sensors[i], clux, &clux) &&
+                sched_sensors[i].status == OPT3001_STATUS_NORMAL)
+            continue;
+        if(sched_cb)
+            sched_cb(&sched_sensors[i], (ok & (1 << i)) ? raw : 0, clux, sched_stamp[i]);
+    }
+
+    if(sched_pending != 0 || sched_ready != 0)
+        return 0;
+
+    sched_cycle_us = (sched_end_cyc - sched_start_cyc) / (SystemCoreClock / 1000000);
+    sched_active = 0;
+#if OPT3001_INT_ENABLE
+    // 线与的INT仍为低：本轮读取期间又有传感器完成转换，没有新的下降沿，补一次事件
+    // 若本轮有传感器被跳过，它可能提前完成了转换（超出余量）正拉着INT，下一轮不再跳过
+    if(!(OPT3001_INT_PORT->IDR & OPT3001_INT_PIN))
+    {
+        sched_conv_valid &= ~sched_skip_mask;
+        sched_int_stamp = micros();
+        sched_int_flag = 1;
+    }
+#endif
+    return 1;
+}
+
+u32 OPT3001_Sched_GetCycleTime(void)
+{
+    return sched_cycle_us;
+}
+
+u32 OPT3001_Sched_GetSkipped(void)
+{
+    return sched_skipped;
+}
+
+u8 OPT3001_Sched_IsBusy(void)
+{
+    return sched_active;
+}
+
+u32 OPT3001_Sched_GetBusyMs(void)
+{
+    return sched_active ? millis() - sched_start_ms : 0;
+}
+
+void OPT3001_Sched_Pause(u8 pause)
+{
+    sched_paused = pause;
+}
+
+// 进入事件模式时把窗口设为空（下限取最大、上限取0），下一次转换必然越限，
+// 由越限处理读出当前值并居中窗口；退出时恢复转换完成指示
+static u8 OPT3001_Sched_SetupLimits(OPT3001_HandleTypeDef *h, u8 event_mode)
+{
+    u8 err = 0;
+
+    if(event_mode)
+    {
+        err |= OPT3001_Sensor_WriteReg(h, OPT3001_LOW_LIMIT_REG, 0xBFFF);
+        err |= OPT3001_Sensor_WriteReg(h, OPT3001_HIGH_LIMIT_REG, 0x0000);
+    }
+    else
+    {
+        err |= OPT3001_Sensor_EnableEoc(h);
+    }
+    return err;
+}
+
+u8 OPT3001_Sched_SetEventMode(u8 enable)
+{
+    u8 i, err = 0;
+
+    if(sched_active || OPT3001_Async_Pending() != 0)
+        return 1;
+
+    for(i=0; i<sched_count; i++)
+        err |= OPT3001_Sched_SetupLimits(&sched_sensors[i], enable);
+    sched_event_mode = enable;
+    return err;
+}
+
+u8 OPT3001_Sched_ApplyMode(OPT3001_HandleTypeDef *h)
+{
+    return OPT3001_Sched_SetupLimits(h, sched_event_mode);
+}
@@ -0,0 +1,47 @@
+#ifndef __OPT3001_SCHED_H
+#define __OPT3001_SCHED_H
+
+#include "opt3001_async.h"
+
+/********************* 阈值窗口事件模式 *********************/
+// 以当前光照为中心设置上/下限（锁存窗口比较），光照留在窗口内时传感器不拉INT，总线无流量；
+// 越限时读取、上报并重新居中窗口
+#define OPT3001_EVENT_BAND_PCT     10     // 窗口半宽（当前值的百分比）
+#define OPT3001_EVENT_MIN_BAND     100    // 窗口半宽下限（0.01lux，避免暗处噪声频繁触发）
+
+/********************* 按转换时间跳过查询 *********************/
+// CRF只在转换结束时置位：记录每个传感器最近一次转换完成的时刻，距其不足一个转换时间
+// （扣除器件转换时间的偏差余量）时本轮不读配置寄存器，避免无效查询占用总线并来回切换指针；
+// 稳态下每个样本只剩一次配置读 + 一次结果读
+#define OPT3001_SCHED_SKIP_ENABLE  1
+#define OPT3001_SCHED_CONV_TOL_PCT 15     // 转换时间偏差余量（%）
+
+// 单个样本处理完成回调（主循环上下文，在OPT3001_Sched_Poll内调用）
+// raw：结果寄存器原始值（通信失败时为0）；clux：滤波后的光照值（0.01lux）；
+// stamp_us：转换完成时刻（micros()，INT触发时为中断边沿时刻）
+typedef void (*OPT3001_SampleCallback)(OPT3001_HandleTypeDef *h, u16 raw, u32 clux, u32 stamp_us);
+
+/********************* 函数声明 *********************/
+// 绑定传感器表（最多OPT3001_MAX_SENSORS个）及样本回调；OPT3001_INT_ENABLE时同时配置INT引脚的EXTI
+void OPT3001_Sched_Init(OPT3001_HandleTypeDef *sensors, u8 count, OPT3001_SampleCallback cb);
+// 为全部传感器排队读取配置寄存器（转换未到期的跳过），CRF置位的再读结果寄存器
+// （返回0：已启动，1：上一轮未完成或无传感器）
+u8 OPT3001_Sched_StartCycle(void);
+// 主循环调用：INT触发时发起一轮；对已返回的新样本滤波并回调（返回1：本轮全部完成）
+u8 OPT3001_Sched_Poll(void);
+// 最近一轮从发起到最后一个读数返回的耗时（us）
+u32 OPT3001_Sched_GetCycleTime(void);
+// 当前是否有一轮读取在进行
+u8 OPT3001_Sched_IsBusy(void);
+// 因转换未到期而跳过的配置寄存器查询次数（累计）
+u32 OPT3001_Sched_GetSkipped(void);
+// 当前一轮已进行的时间（ms，空闲时为0），用于判断采集是否停滞
+u32 OPT3001_Sched_GetBusyMs(void);
+// 暂停/恢复INT触发的采集（暂停期间的INT事件在恢复后处理），用于主循环临时独占总线
+void OPT3001_Sched_Pause(u8 pause);
+// 切换事件模式（1：阈值窗口事件，0：每次转换采集）；需在调度空闲时调用（返回0：成功）
+u8 OPT3001_Sched_SetEventMode(u8 enable);
+// 传感器重新初始化后按当前模式恢复阈值寄存器（阻塞访问，需在调度空闲时调用，返回0：成功）
+u8 OPT3001_Sched_ApplyMode(OPT3001_HandleTypeDef *h);
+
+#endif
@@ -0,0 +1,163 @@
+#include "opt3001_topo.h"
+
+static u8 topo_cache_hit = 0;
+
+/********************* Flash读写（直接操作FLASH寄存器） *********************/
+#define FLASH_KEY1  0x45670123
+#define FLASH_KEY2  0xCDEF89AB
+
+static void Topo_FlashWaitBusy(void)
+{
+    while(FLASH->SR & FLASH_SR_BSY);
+}
+
+static void Topo_FlashUnlock(void)
+{
+    if(FLASH->CR & FLASH_CR_LOCK)
+    {
+        FLASH->KEYR = FLASH_KEY1;
+        FLASH->KEYR = FLASH_KEY2;
+    }
+}
+
+static void Topo_FlashErasePage(u32 addr)
+{
+    Topo_FlashWaitBusy();
+    FLASH->CR |= FLASH_CR_PER;
+    FLASH->AR  = addr;
+    FLASH->CR |= FLASH_CR_STRT;
+    Topo_FlashWaitBusy();
+    FLASH->CR &= ~FLASH_CR_PER;
+}
+
+// 按半字编程（F1系列Flash编程单位为16位）
+static void Topo_FlashWrite(u32 addr, const u8 *data, u16 len)
+{
+    u16 i;
+
+    FLASH->CR |= FLASH_CR_PG;
+    for(i=0; i<len; i+=2)
+    {
+        *(volatile u16 *)(addr + i) = (u16)data[i] | ((u16)data[i + 1] << 8);
+        Topo_FlashWaitBusy();
+    }
+    FLASH->CR &= ~FLASH_CR_PG;
+}
+
+static u32 Topo_Checksum(const OPT3001_TopoTypeDef *topo)
+{
+    const u8 *p = (const u8 *)topo;
+    u32 sum = 0x5A5A5A5A;
+    u8 i;
+
+    for(i=0; i<sizeof(OPT3001_TopoTypeDef) - sizeof(u32); i++)
+        sum = (sum << 5) + (sum >> 27) + p[i];
+    return sum;
+}
+
+static void Topo_Save(const OPT3001_TopoTypeDef *topo)
+{
+    Topo_FlashUnlock();
+    Topo_FlashErasePage(OPT3001_TOPO_FLASH_ADDR);
+    Topo_FlashWrite(OPT3001_TOPO_FLASH_ADDR, (const u8 *)topo, sizeof(OPT3001_TopoTypeDef));
+    FLASH->CR |= FLASH_CR_LOCK;
+}
+
+/********************* 发现流程 *********************/
+static void Topo_Fill(OPT3001_HandleTypeDef *h, const OPT3001_BusTypeDef *bus, u8 addr, u8 id)
+{
+    OPT3001_HandleTypeDef init = OPT3001_HANDLE_INIT(bus, addr, id);
+    *h = init;
+}
+
+// 缓存外的候选地址有应答返回1
+static u8 Topo_ProbeUncached(const OPT3001_BusTypeDef *const *buses, u8 bus_count,
+                             const OPT3001_TopoTypeDef *cached)
+{
+    u8 b, addr, i, entry;
+
+    for(b=0; b<bus_count; b++)
+    {
+        for(addr=OPT3001_ADDR_MIN; addr<=OPT3001_ADDR_MAX; addr++)
+        {
+            entry = (u8)((b << 4) | (addr - OPT3001_ADDR_MIN));
+            for(i=0; i<cached->count && cached->entry[i] != entry; i++)
+                ;
+            if(i == cached->count && OPT3001_Bus_Probe(buses[b], addr) == 0)
+                return 1;
+        }
+    }
+    return 0;
+}
+
+u8 OPT3001_Topo_Discover(const OPT3001_BusTypeDef *const *buses, u8 bus_count,
+                         OPT3001_HandleTypeDef *sensors, u8 max_sensors)
+{
+    const OPT3001_TopoTypeDef *cached = (const OPT3001_TopoTypeDef *)OPT3001_TOPO_FLASH_ADDR;
+    OPT3001_TopoTypeDef topo;
+    u8 i, b, addr, bus_idx, count = 0;
+
+    if(max_sensors > OPT3001_MAX_SENSORS)
+        max_sensors = OPT3001_MAX_SENSORS;
+    topo_cache_hit = 0;
+
+    // 1. 快速路径：缓存有效时只核对缓存中的地址
+    if(cached->magic == OPT3001_TOPO_MAGIC && cached->count > 0 &&
+       cached->count <= max_sensors && cached->checksum == Topo_Checksum(cached))
+    {
+        for(i=0; i<cached->count; i++)
+        {
+            bus_idx = cached->entry[i] >> 4;
+            addr = OPT3001_ADDR_MIN + (cached->entry[i] & 0x0F);
+            if(bus_idx >= bus_count)
+                break;
+            Topo_Fill(&sensors[i], buses[bus_idx], addr, i);
+            if(OPT3001_Sensor_Identify(&sensors[i]) != 0)
+                break;
+        }
+        // 缓存中的器件都在：再对缓存外的候选地址只发地址字节，无应答才算命中；
+        // 新接入的传感器会应答，转入完整发现（每个候选地址只多一个字节的总线时间）
+        if(i == cached->count && Topo_ProbeUncached(buses, bus_count, cached) == 0)
+        {
+            topo_cache_hit = 1;
+            return i;
+        }
+    }
+
+    // 2. 缓存失效：每条总线只在4个候选地址上读ID
+    for(i=0; i<sizeof(topo); i++)
+        ((u8 *)&topo)[i] = 0xFF;
+    for(b=0; b<bus_count && count<max_sensors; b++)
+    {
+        for(addr=OPT3001_ADDR_MIN; addr<=OPT3001_ADDR_MAX && count<max_sensors; addr++)
+        {
+            Topo_Fill(&sensors[count], buses[b], addr, count);
+            if(OPT3001_Sensor_Identify(&sensors[count]) != 0)
+                continue;
+            topo.entry[count] = (u8)((b << 4) | (addr - OPT3001_ADDR_MIN));
+            count++;
+        }
+    }
+
+    // 3. 写回缓存（未发现传感器时不写，避免接线松动时覆盖有效记录）
+    if(count > 0)
+    {
+        topo.magic = OPT3001_TOPO_MAGIC;
+        topo.count = count;
+        topo.checksum = Topo_Checksum(&topo);
+        Topo_Save(&topo);
+    }
+    return count;
+}
+
+u8 OPT3001_Topo_CacheHit(void)
+{
+    return topo_cache_hit;
+}
+
+void OPT3001_Topo_Invalidate(void)
+{
+    Topo_FlashUnlock();
+    Topo_FlashErasePage(OPT3001_TOPO_FLASH_ADDR);
+    FLASH->CR |= FLASH_CR_LOCK;
+}
@@ -0,0 +1,30 @@
+#ifndef __OPT3001_TOPO_H
+#define __OPT3001_TOPO_H
+
+#include "opt3001.h"
+
+/********************* 拓扑缓存（Flash最后一页） *********************/
+#define OPT3001_TOPO_FLASH_ADDR  0x0800FC00  // STM32F103C8 64KB Flash的最后1KB页（工程IROM1只到0x0800FBFF，链接器不会把代码放进这一页）
+#define OPT3001_TOPO_MAGIC       0x4F505431  // "OPT1"
+
+// 缓存记录：entry高4位为总线序号，低4位为地址偏移（addr - 0x44）
+typedef struct {
+    u32 magic;
+    u8  count;
+    u8  entry[OPT3001_MAX_SENSORS];
+    u8  reserved[3];
+    u32 checksum;
+} OPT3001_TopoTypeDef;
+
+/********************* 函数声明 *********************/
+// 发现传感器并填充sensors（返回数量）：
+// 先按Flash缓存逐个核对ID，并确认缓存外的候选地址无应答（新接入的传感器），全部符合即结束；
+// 否则只在各总线的0x44~0x47读ID，结果写回缓存
+u8 OPT3001_Topo_Discover(const OPT3001_BusTypeDef *const *buses, u8 bus_count,
+                         OPT3001_HandleTypeDef *sensors, u8 max_sensors);
+// 本次发现是否直接命中缓存
+u8 OPT3001_Topo_CacheHit(void);
+// 清除Flash中的拓扑缓存（下次上电重新发现，串口命令topo）
+void OPT3001_Topo_Invalidate(void);
+
+#endif
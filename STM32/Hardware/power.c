@@ -0,0 +1,64 @@
+#include "power.h"
+#include "delay.h"
+
+static u32 window_start = 0;      // 当前窗口起始（us）
+static u32 window_idle = 0;       // 当前窗口累计睡眠（us）
+static Power_DutyTypeDef last_duty = {0, 0};
+
+// 窗口满1秒时滚动：总时长减去睡眠时间即为运行时间
+static void Power_Rollover(u32 now)
+{
+    u32 elapsed = now - window_start;
+
+    if(elapsed < 1000000)
+        return;
+    if(window_idle > elapsed)
+        window_idle = elapsed;
+    last_duty.idle_us = window_idle;
+    last_duty.busy_us = elapsed - window_idle;
+    window_start = now;
+    window_idle = 0;
+}
+
+void Power_Init(void)
+{
+    window_start = micros();
+    window_idle = 0;
+    last_duty.busy_us = 0;
+    last_duty.idle_us = 0;
+}
+
+// 关中断后再WFI：检查与睡眠之间到来的中断会保持挂起并立即唤醒内核，不会丢失；
+// 睡眠期间DWT周期计数器停止，因此睡眠时间用SysTick时间戳计量
+void Power_Idle(void)
+{
+#if POWER_SLEEP_ENABLE
+    u32 t0, t1;
+
+    __disable_irq();
+    t0 = micros();
+    __WFI();
+    t1 = micros();
+    __enable_irq();
+
+    window_idle += t1 - t0;
+    Power_Rollover(t1);
+#else
+    Power_Rollover(micros());
+#endif
+}
+
+void Power_GetDuty(Power_DutyTypeDef *duty)
+{
+    *duty = last_duty;
+}
+
+u16 Power_GetLoadPermille(void)
+{
+    u32 total = last_duty.busy_us + last_duty.idle_us;
+
+    if(total < 1000)
+        return 0;
+    // 窗口不短于1秒，total/1000不会为0，也不需要64位乘法
+    return (u16)(last_duty.busy_us / (total / 1000));
+}
@@ -0,0 +1,27 @@
+#ifndef __POWER_H
+#define __POWER_H
+
+#include "stm32f10x.h"
+
+/********************* 低功耗空闲参数 *********************/
+// 1：主循环无事可做时执行WFI进入睡眠模式，由SysTick/TIM2/I2C/EXTI等任意中断唤醒
+// 0：不睡眠，仅做占空比统计（用于对比）
+#define POWER_SLEEP_ENABLE  1
+
+// 占空比统计（以1秒为窗口，单位us）
+typedef struct {
+    u32 busy_us;   // 窗口内CPU运行时间
+    u32 idle_us;   // 窗口内睡眠时间
+} Power_DutyTypeDef;
+
+/********************* 函数声明 *********************/
+// 开始统计（需在SysTick_Init之后调用）
+void Power_Init(void);
+// 主循环空闲时调用：睡眠到下一个中断，并累计睡眠时间
+void Power_Idle(void);
+// 最近一个完整1秒窗口的统计结果
+void Power_GetDuty(Power_DutyTypeDef *duty);
+// 最近窗口的CPU占用率（千分比）
+u16 Power_GetLoadPermille(void);
+
+#endif
@@ -0,0 +1,64 @@
+#include "sample_ring.h"
+
+/********************* 缓冲区与下标 *********************/
+// head只由生产者写，tail只由消费者写，均为自由递增的32位计数（Cortex-M3上对齐的
+// 32位读写是原子的），两者之差即为记录数，回绕后仍然正确。
+// __DMB保证“先写记录、再发布下标”的顺序不被编译器/处理器重排
+static SampleRing_RecordTypeDef ring_buf[SAMPLE_RING_SIZE];
+static volatile u32 ring_head = 0;
+static volatile u32 ring_tail = 0;
+static volatile u32 ring_overflow = 0;   // 只由生产者写
+static u16 ring_seq = 0;                 // 只由生产者使用
+
+void SampleRing_Init(void)
+{
+    ring_head = ring_tail = 0;
+    ring_overflow = 0;
+    ring_seq = 0;
+}
+
+u8 SampleRing_Push(const SampleRing_RecordTypeDef *rec)
+{
+    u32 head = ring_head;
+    SampleRing_RecordTypeDef *slot;
+
+    // 序号对丢弃的记录同样递增，消费者看到的序号间隔即丢失条数
+    if(head - ring_tail >= SAMPLE_RING_SIZE)
+    {
+        ring_seq++;
+        ring_overflow++;
+        return 1;
+    }
+    slot = &ring_buf[head & SAMPLE_RING_MASK];
+    *slot = *rec;
+    slot->seq = ring_seq++;
+    __DMB();                        // 记录写完后才发布
+    ring_head = head + 1;
+    return 0;
+}
+
+u8 SampleRing_Drain(SampleRing_RecordTypeDef *out, u8 max)
+{
+    u32 tail = ring_tail;
+    u32 avail = ring_head - tail;
+    u8 n;
+
+    __DMB();                        // 读到下标之后才读记录
+    if(avail > max)
+        avail = max;
+    for(n=0; n<avail; n++)
+        out[n] = ring_buf[(tail + n) & SAMPLE_RING_MASK];
+    __DMB();                        // 记录读完后才释放槽位
+    ring_tail = tail + avail;
+    return n;
+}
+
+u8 SampleRing_Count(void)
+{
+    return (u8)(ring_head - ring_tail);
+}
+
+u32 SampleRing_GetOverflow(void)
+{
+    return ring_overflow;
+}
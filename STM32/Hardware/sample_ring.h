@@ -0,0 +1,35 @@
+#ifndef __SAMPLE_RING_H
+#define __SAMPLE_RING_H
+
+#include "stm32f10x.h"
+
+/********************* 样本环形缓冲参数 *********************/
+// 单生产者/单消费者：采集路径（中断或主循环）写入，串口输出路径批量取出，
+// 双方各自只写自己的下标，不需要关中断；满时丢弃新记录并计数，不阻塞采集
+#define SAMPLE_RING_SIZE   32     // 记录条数，必须为2的幂
+#define SAMPLE_RING_MASK   (SAMPLE_RING_SIZE - 1)
+
+// 定长样本记录（16字节）
+typedef struct {
+    u32 stamp_us;     // 转换完成时刻（micros()）
+    u32 clux;         // 滤波后光照（0.01lux）
+    u16 seq;          // 入队序号（由SampleRing_Push填写，消费者可据此发现丢失）
+    u16 raw;          // 结果寄存器原始值（通信失败时为0）
+    u8  sensor;       // 传感器编号
+    u8  status;       // OPT3001_StatusTypeDef
+    u8  jump;         // 本样本确认新等级时为确认次数，否则为0
+    u8  pending;      // 跳变候选已连续出现的次数
+} SampleRing_RecordTypeDef;
+
+/********************* 函数声明 *********************/
+void SampleRing_Init(void);
+// 生产者：写入一条记录（返回0：成功，1：已满，记录被丢弃）
+u8 SampleRing_Push(const SampleRing_RecordTypeDef *rec);
+// 消费者：最多取出max条记录到out（返回实际条数）
+u8 SampleRing_Drain(SampleRing_RecordTypeDef *out, u8 max);
+// 当前缓冲中的记录数
+u8 SampleRing_Count(void);
+// 上电以来因缓冲满而丢弃的记录数
+u32 SampleRing_GetOverflow(void);
+
+#endif
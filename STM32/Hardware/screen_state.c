@@ -0,0 +1,245 @@
+#include "screen_state.h"
+#include "filter_chain.h"
+
+typedef struct {
+    u8  state;
+    u8  cand;             // 候选状态（与state相同表示无候选）
+    u32 cand_since;
+    u32 since;
+    u32 last_clux;
+    u16 off_log;          // 熄屏基线（log2 Q8）
+    u16 on_log;           // 亮屏基线（log2 Q8）
+    u16 settle_log;       // 正在保持的光照等级（log2 Q8）
+    u32 settle_since;
+    u32 hist_start;       // 当前历史窗口起点
+    u16 hist_min[2];      // 当前/上一个窗口内稳定过的最低、最高等级（log2 Q8）
+    u16 hist_max[2];
+} Screen_CtxTypeDef;
+
+static Screen_CtxTypeDef screen[SCREEN_MAX_SENSORS];
+
+// 与opt3001.h中OPT3001_StatusTypeDef一致
+#define STATUS_NORMAL     0
+#define STATUS_JUMP_ERR   3
+
+/********************* 辅助函数 *********************/
+// log2 Q8逆运算（与FilterChain_Log2Q8的分段线性互逆），用于上报基线
+static u32 Screen_Exp2Q8(u16 lv)
+{
+    u8 e = lv >> 8;
+    u32 m = 0x100 | (lv & 0xFF);
+
+    return e >= 8 ? (m << (e - 8)) : (m >> (8 - e));
+}
+
+// 当前光照在两条基线之间的相对位置（Q8，可小于0或大于256）
+static s32 Screen_Position(const Screen_CtxTypeDef *c, u16 lv)
+{
+    s32 span = (s32)c->on_log - c->off_log;
+
+    if(span < SCREEN_MIN_SPAN_Q8)
+        span = SCREEN_MIN_SPAN_Q8;
+    return ((s32)lv - c->off_log) * 256 / span;
+}
+
+// 带回差分类：已处于熄屏/亮屏时用更宽的退出阈值
+static u8 Screen_Classify(u8 state, s32 pos)
+{
+    if(state == SCREEN_OFF && pos <= SCREEN_OFF_EXIT_Q8)
+        return SCREEN_OFF;
+    if(state == SCREEN_ON && pos >= SCREEN_ON_EXIT_Q8)
+        return SCREEN_ON;
+    if(pos < SCREEN_OFF_ENTER_Q8)
+        return SCREEN_OFF;
+    if(pos > SCREEN_ON_ENTER_Q8)
+        return SCREEN_ON;
+    return SCREEN_DIM;
+}
+
+// 基线向目标靠拢1/2^shift，两条基线保持最小间距
+static void Screen_Track(Screen_CtxTypeDef *c, u8 on, u16 lv, u8 shift)
+{
+    s32 v;
+
+    if(on)
+    {
+        v = c->on_log + (((s32)lv - c->on_log) >> shift);
+        if(v < c->off_log + SCREEN_MIN_SPAN_Q8)
+            v = c->off_log + SCREEN_MIN_SPAN_Q8;
+        c->on_log = (u16)v;
+    }
+    else
+    {
+        v = c->off_log + (((s32)lv - c->off_log) >> shift);
+        if(v > c->on_log - SCREEN_MIN_SPAN_Q8)
+            v = c->on_log - SCREEN_MIN_SPAN_Q8;
+        if(v < 0)
+            v = 0;
+        c->off_log = (u16)v;
+    }
+}
+
+// 记录稳定过的等级：短暂遮挡、亮灭过渡中的样本不计入
+static void Screen_History(Screen_CtxTypeDef *c, u16 lv, u32 stamp_ms)
+{
+    if((u32)(stamp_ms - c->hist_start) >= SCREEN_HIST_MS)
+    {
+        c->hist_min[1] = c->hist_min[0];
+        c->hist_max[1] = c->hist_max[0];
+        c->hist_min[0] = 0xFFFF;
+        c->hist_max[0] = 0;
+        c->hist_start = stamp_ms;
+    }
+    if(lv > c->settle_log + SCREEN_SETTLE_Q8 || lv + SCREEN_SETTLE_Q8 < c->settle_log)
+    {
+        c->settle_log = lv;
+        c->settle_since = stamp_ms;
+        return;
+    }
+    if((u32)(stamp_ms - c->settle_since) < SCREEN_DWELL_MS)
+        return;
+    if(lv < c->hist_min[0])
+        c->hist_min[0] = lv;
+    if(lv > c->hist_max[0])
+        c->hist_max[0] = lv;
+}
+
+// 包络学习：超出基线时快速外扩；确认亮屏/熄屏且明确处于该侧时对应基线跟踪当前值。
+// 最近1~2分钟内稳定过两个相差至少SCREEN_MIN_SPAN_Q8的等级时，两条基线分别跟踪最低与最高等级，
+// 熄屏光照高于初值的屏幕（强环境光）在几次亮灭内即可学到；亮屏/熄屏下落在回差带内的样本
+// 不拉动本侧基线，否则亮屏基线会被一路拖到熄屏水平。
+// 没有这样的历史时，低亮下两条基线向当前值收拢（较近的一条更快），使偏离初值的屏幕亮度/环境光
+// 最终归入亮屏或熄屏，代价是持续数分钟不变的低亮会被当作新的亮屏/熄屏水平
+static void Screen_Learn(Screen_CtxTypeDef *c, u16 lv, s32 pos)
+{
+    u16 lo = c->hist_min[0] < c->hist_min[1] ? c->hist_min[0] : c->hist_min[1];
+    u16 hi = c->hist_max[0] > c->hist_max[1] ? c->hist_max[0] : c->hist_max[1];
+    u8 near_on;
+
+    if(lv > c->on_log)
+        Screen_Track(c, 1, lv, SCREEN_ATTACK_SHIFT);
+    else if(lv < c->off_log)
+        Screen_Track(c, 0, lv, SCREEN_ATTACK_SHIFT);
+    else if(c->state == SCREEN_ON)
+    {
+        if(pos > SCREEN_ON_ENTER_Q8)
+            Screen_Track(c, 1, lv, SCREEN_LEARN_SHIFT);
+    }
+    else if(c->state == SCREEN_OFF)
+    {
+        if(pos < SCREEN_OFF_ENTER_Q8)
+            Screen_Track(c, 0, lv, SCREEN_LEARN_SHIFT);
+    }
+    else if(c->state == SCREEN_DIM && hi < lo + SCREEN_MIN_SPAN_Q8)
+    {
+        near_on = (c->on_log - lv) < (lv - c->off_log);
+        Screen_Track(c, 1, lv, near_on ? SCREEN_DRIFT_NEAR_SHIFT : SCREEN_DRIFT_FAR_SHIFT);
+        Screen_Track(c, 0, lv, near_on ? SCREEN_DRIFT_FAR_SHIFT : SCREEN_DRIFT_NEAR_SHIFT);
+    }
+
+    if(hi >= lo + SCREEN_MIN_SPAN_Q8)
+    {
+        Screen_Track(c, 1, hi, SCREEN_LEARN_SHIFT);
+        Screen_Track(c, 0, lo, SCREEN_LEARN_SHIFT);
+    }
+}
+
+/********************* 对外接口 *********************/
+void Screen_Init(void)
+{
+    u8 i;
+
+    for(i=0; i<SCREEN_MAX_SENSORS; i++)
+    {
+        screen[i].state = screen[i].cand = SCREEN_UNKNOWN;
+        screen[i].cand_since = screen[i].since = 0;
+        screen[i].last_clux = 0;
+        screen[i].off_log = FilterChain_Log2Q8(SCREEN_OFF_BASE_CLUX + SCREEN_LOG_FLOOR);
+        screen[i].on_log = FilterChain_Log2Q8(SCREEN_ON_BASE_CLUX + SCREEN_LOG_FLOOR);
+        screen[i].settle_log = 0;
+        screen[i].settle_since = screen[i].hist_start = 0;
+        screen[i].hist_min[0] = screen[i].hist_min[1] = 0xFFFF;
+        screen[i].hist_max[0] = screen[i].hist_max[1] = 0;
+    }
+}
+
+u8 Screen_Update(u8 sensor, u32 clux, u8 status, u32 stamp_ms, Screen_EventTypeDef *ev)
+{
+    Screen_CtxTypeDef *c;
+    u16 lv = 0;
+    s32 pos = 0;
+    u8 target;
+    u32 dwell;
+
+    if(sensor >= SCREEN_MAX_SENSORS)
+        return 0;
+    c = &screen[sensor];
+
+    if(status == STATUS_NORMAL || status == STATUS_JUMP_ERR)
+    {
+        lv = FilterChain_Log2Q8(clux + SCREEN_LOG_FLOOR);
+        pos = Screen_Position(c, lv);
+        target = Screen_Classify(c->state, pos);
+        c->last_clux = clux;
+        dwell = SCREEN_DWELL_MS;
+    }
+    else
+    {
+        target = SCREEN_FAULT;
+        dwell = SCREEN_FAULT_DWELL_MS;
+    }
+
+    if(status == STATUS_NORMAL)
+    {
+        Screen_History(c, lv, stamp_ms);
+        Screen_Learn(c, lv, pos);
+    }
+    if(target == c->state)
+    {
+        c->cand = c->state;         // 回到当前状态，放弃候选
+        return 0;
+    }
+    if(target != c->cand)
+    {
+        c->cand = target;
+        c->cand_since = stamp_ms;
+    }
+    if((u32)(stamp_ms - c->cand_since) < dwell)
+        return 0;
+
+    ev->sensor = sensor;
+    ev->from = c->state;
+    ev->to = target;
+    ev->stamp_ms = c->cand_since;
+    ev->confirm_ms = stamp_ms - c->cand_since;
+    ev->clux = c->last_clux;
+    c->state = target;
+    c->since = c->cand_since;
+    return 1;
+}
+
+void Screen_GetInfo(u8 sensor, Screen_InfoTypeDef *info)
+{
+    const Screen_CtxTypeDef *c;
+
+    if(sensor >= SCREEN_MAX_SENSORS)
+        return;
+    c = &screen[sensor];
+    info->state = c->state;
+    info->since_ms = c->since;
+    info->clux = c->last_clux;
+    info->off_base = Screen_Exp2Q8(c->off_log) - SCREEN_LOG_FLOOR;
+    info->on_base = Screen_Exp2Q8(c->on_log) - SCREEN_LOG_FLOOR;
+}
+
+const char *Screen_StateName(u8 state)
+{
+    switch(state)
+    {
+        case SCREEN_OFF:   return "熄屏";
+        case SCREEN_DIM:   return "低亮";
+        case SCREEN_ON:    return "亮屏";
+        case SCREEN_FAULT: return "传感器故障";
+        default:           return "未知";
+    }
+}
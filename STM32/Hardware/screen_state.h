@@ -0,0 +1,62 @@
+#ifndef __SCREEN_STATE_H
+#define __SCREEN_STATE_H
+
+#include "stm32f10x.h"
+
+/********************* 屏幕状态分类参数 *********************/
+// 在log2域把当前光照映射到“熄屏基线~亮屏基线”之间的相对位置（Q8，0=熄屏，256=亮屏），
+// 按带回差的阈值分类，候选状态持续SCREEN_DWELL_MS才确认；两条基线按包络方式学习，
+// 并参考最近1~2分钟内稳定过的最低/最高光照，适应不同屏幕亮度与环境光
+#define SCREEN_MAX_SENSORS      8
+#define SCREEN_OFF_ENTER_Q8     64        // 低于25%进入熄屏
+#define SCREEN_OFF_EXIT_Q8      96        // 熄屏状态下高于37.5%才离开
+#define SCREEN_ON_ENTER_Q8      192       // 高于75%进入亮屏
+#define SCREEN_ON_EXIT_Q8       160       // 亮屏状态下低于62.5%才离开
+#define SCREEN_DWELL_MS         300       // 状态确认时间
+#define SCREEN_FAULT_DWELL_MS   2000      // 连续通信/量程异常超过该时间判为传感器故障
+#define SCREEN_LEARN_SHIFT      6         // 确认亮屏/熄屏时对应基线的跟踪速率 1/2^SHIFT（每个样本）
+#define SCREEN_ATTACK_SHIFT     3         // 光照超出两条基线之外时基线快速外扩
+#define SCREEN_DRIFT_NEAR_SHIFT 7         // 低亮时较近的一条基线向当前值收拢
+#define SCREEN_DRIFT_FAR_SHIFT  10        // 低亮时较远的一条基线更慢地收拢
+#define SCREEN_MIN_SPAN_Q8      512       // 两条基线至少相差4倍
+#define SCREEN_HIST_MS          60000     // 历史窗口长度（保留当前与上一个窗口）
+#define SCREEN_SETTLE_Q8        64        // 光照在±1/4倍频程内保持SCREEN_DWELL_MS才计入历史
+#define SCREEN_OFF_BASE_CLUX    100       // 熄屏基线初值（1lux）
+#define SCREEN_ON_BASE_CLUX     20000     // 亮屏基线初值（200lux）
+#define SCREEN_LOG_FLOOR        100       // 取对数前加的底数（1lux），暗处噪声不被放大
+
+typedef enum {
+    SCREEN_UNKNOWN = 0,   // 上电后尚未确认
+    SCREEN_OFF,           // 熄屏/黑屏
+    SCREEN_DIM,           // 低亮度
+    SCREEN_ON,            // 正常亮屏
+    SCREEN_FAULT          // 传感器故障
+} Screen_StateTypeDef;
+
+// 状态变化事件
+typedef struct {
+    u8  sensor;
+    u8  from;
+    u8  to;
+    u32 stamp_ms;         // 候选状态首次出现的时刻（millis()时基）
+    u32 confirm_ms;       // 从首次出现到确认的用时
+    u32 clux;             // 确认时的光照（0.01lux）
+} Screen_EventTypeDef;
+
+// 当前状态（心跳上报）
+typedef struct {
+    u8  state;
+    u32 since_ms;         // 进入当前状态的时刻
+    u32 clux;             // 最近一次光照
+    u32 off_base;         // 熄屏基线（0.01lux）
+    u32 on_base;          // 亮屏基线（0.01lux）
+} Screen_InfoTypeDef;
+
+/********************* 函数声明 *********************/
+void Screen_Init(void);
+// 输入一个样本（status为OPT3001_StatusTypeDef，stamp_ms为转换时刻）；确认状态变化时返回1并填写ev
+u8 Screen_Update(u8 sensor, u32 clux, u8 status, u32 stamp_ms, Screen_EventTypeDef *ev);
+void Screen_GetInfo(u8 sensor, Screen_InfoTypeDef *info);
+const char *Screen_StateName(u8 state);
+
+#endif
@@ -0,0 +1,101 @@
+#include "soft_timer.h"
+
+#define WHEEL_MASK  (SOFT_TIMER_WHEEL_SIZE - 1)
+
+static SoftTimer_TypeDef *wheel_slot[SOFT_TIMER_WHEEL_SIZE];
+static u32 wheel_now = 0;
+
+/********************* 链表操作 *********************/
+static void SoftTimer_Link(SoftTimer_TypeDef *t, SoftTimer_TypeDef **head)
+{
+    t->next = *head;
+    if(t->next)
+        t->next->pprev = &t->next;
+    *head = t;
+    t->pprev = head;
+}
+
+static void SoftTimer_Unlink(SoftTimer_TypeDef *t)
+{
+    if(!t->pprev)
+        return;
+    *t->pprev = t->next;
+    if(t->next)
+        t->next->pprev = t->pprev;
+    t->next = 0;
+    t->pprev = 0;
+}
+
+/********************* 对外接口 *********************/
+void SoftTimer_Init(u32 now)
+{
+    u8 i;
+
+    for(i=0; i<SOFT_TIMER_WHEEL_SIZE; i++)
+        wheel_slot[i] = 0;
+    wheel_now = now;
+}
+
+void SoftTimer_Start(SoftTimer_TypeDef *t, u32 delay_ms, u32 period_ms, SoftTimer_Callback cb, void *ctx)
+{
+    SoftTimer_Unlink(t);
+    if(delay_ms == 0)
+        delay_ms = 1;   // 当前节拍的槽可能正在处理，最早下一节拍到期
+    t->expire = wheel_now + delay_ms;
+    t->period = period_ms;
+    t->cb = cb;
+    t->ctx = ctx;
+    SoftTimer_Link(t, &wheel_slot[t->expire & WHEEL_MASK]);
+}
+
+void SoftTimer_Stop(SoftTimer_TypeDef *t)
+{
+    SoftTimer_Unlink(t);
+}
+
+u8 SoftTimer_IsActive(const SoftTimer_TypeDef *t)
+{
+    return t->pprev != 0;
+}
+
+u32 SoftTimer_Now(void)
+{
+    return wheel_now;
+}
+
+// 逐毫秒推进：把当前槽整条链摘到局部链表上再处理，
+// 未到期的（超过一圈）放回原槽，回调中重启的定时器挂到别的时刻不会被本轮重复执行
+void SoftTimer_Advance(u32 now)
+{
+    SoftTimer_TypeDef *pending, *t;
+    u8 idx;
+
+    while((s32)(now - wheel_now) > 0)
+    {
+        wheel_now++;
+        idx = wheel_now & WHEEL_MASK;
+
+        pending = wheel_slot[idx];
+        if(!pending)
+            continue;
+        pending->pprev = &pending;
+        wheel_slot[idx] = 0;
+
+        while((t = pending) != 0)
+        {
+            SoftTimer_Unlink(t);
+            if((s32)(t->expire - wheel_now) > 0)
+            {
+                SoftTimer_Link(t, &wheel_slot[idx]);
+                continue;
+            }
+            if(t->period)
+            {
+                t->expire += t->period;
+                SoftTimer_Link(t, &wheel_slot[t->expire & WHEEL_MASK]);
+            }
+            if(t->cb)
+                t->cb(t->ctx);
+        }
+    }
+}
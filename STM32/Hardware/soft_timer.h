@@ -0,0 +1,35 @@
+#ifndef __SOFT_TIMER_H
+#define __SOFT_TIMER_H
+
+#include "stm32f10x.h"
+
+/********************* 软件定时器（哈希时间轮） *********************/
+// 按到期毫秒数对槽数取模挂链，推进一个节拍只检查一个槽；
+// 不访问任何外设，时间由调用者传入，可在主机上用模拟时钟驱动
+#define SOFT_TIMER_WHEEL_SIZE  32     // 槽数（2的幂）
+
+typedef void (*SoftTimer_Callback)(void *ctx);
+
+// 定时器节点由调用者分配（静态变量即可），启动后挂入时间轮
+typedef struct SoftTimer {
+    struct SoftTimer *next;
+    struct SoftTimer **pprev;   // 指向前一节点的next（或槽头），为空表示未启动
+    u32 expire;                 // 到期时刻（时间轮毫秒）
+    u32 period;                 // 周期（0：单次）
+    SoftTimer_Callback cb;
+    void *ctx;
+} SoftTimer_TypeDef;
+
+/********************* 函数声明 *********************/
+// 以当前时间初始化时间轮（清空所有槽）
+void SoftTimer_Init(u32 now);
+// 启动/重启定时器：delay_ms后到期（最小1ms），period_ms非0时周期触发
+void SoftTimer_Start(SoftTimer_TypeDef *t, u32 delay_ms, u32 period_ms, SoftTimer_Callback cb, void *ctx);
+void SoftTimer_Stop(SoftTimer_TypeDef *t);
+u8   SoftTimer_IsActive(const SoftTimer_TypeDef *t);
+// 推进时间轮到now，依次执行到期回调（主循环中调用，回调内可启动/停止定时器）
+void SoftTimer_Advance(u32 now);
+// 时间轮当前时间（最近一次推进到的毫秒）
+u32  SoftTimer_Now(void);
+
+#endif
@@ -0,0 +1,187 @@
+#include "stats_rollup.h"
+#include <string.h>
+
+static Stats_AccTypeDef acc[STATS_LEVELS][STATS_MAX_SENSORS];
+
+// 各分位数（Q16）与P²五个标记的期望增量（Q16）
+static const u32 p2_prob[STATS_QUANTILES] = {3277, 32768, 62259};   // 0.05/0.50/0.95
+
+/********************* P²分位数估计 *********************/
+static u32 Stats_P2Desired(u8 i, u32 p)
+{
+    switch(i)
+    {
+        case 0:  return 0;
+        case 1:  return p / 2;
+        case 2:  return p;
+        case 3:  return (65536 + p) / 2;
+        default: return 65536;
+    }
+}
+
+// 抛物线预测：两侧斜率各除一次再合并，乘积不超过2^48，Q8高度下也不会溢出
+static s32 Stats_P2Parabolic(const Stats_P2TypeDef *e, u8 i, s32 d)
+{
+    int64_t nl = e->n[i] - e->n[i - 1];
+    int64_t nr = e->n[i + 1] - e->n[i];
+    int64_t a = (nl + d) * ((int64_t)e->q[i + 1] - e->q[i]) / nr;
+    int64_t b = (nr - d) * ((int64_t)e->q[i] - e->q[i - 1]) / nl;
+
+    return e->q[i] + (s32)(d * (a + b) / (nl + nr));
+}
+
+static void Stats_P2Add(Stats_P2TypeDef *e, u32 count, u32 p, s32 x)
+{
+    u8 i, k;
+    s32 d;
+    int64_t want;
+
+    // 前5个样本：插入排序保存，分位数直接取
+    if(count <= 5)
+    {
+        for(i=count-1; i>0 && e->q[i-1]>x; i--)
+            e->q[i] = e->q[i-1];
+        e->q[i] = x;
+        e->n[count-1] = count;
+        return;
+    }
+    if(count > 0xFFFF)
+        return;                     // 位置按u16保存，超出后冻结估计
+
+    if(x < e->q[0])
+    {
+        e->q[0] = x;
+        k = 0;
+    }
+    else if(x >= e->q[4])
+    {
+        e->q[4] = x;
+        k = 3;
+    }
+    else
+    {
+        for(k=0; k<3 && x>=e->q[k+1]; k++);
+    }
+    for(i=k+1; i<5; i++)
+        e->n[i]++;
+
+    for(i=1; i<4; i++)
+    {
+        want = 65536 + (int64_t)(count - 1) * Stats_P2Desired(i, p) - ((int64_t)e->n[i] << 16);
+        if((want >= 65536 && e->n[i+1] - e->n[i] > 1) || (want <= -65536 && e->n[i-1] - e->n[i] < -1))
+        {
+            d = want > 0 ? 1 : -1;
+            x = Stats_P2Parabolic(e, i, d);
+            if(e->q[i-1] < x && x < e->q[i+1])
+                e->q[i] = x;
+            else
+                e->q[i] += (s32)(d * ((int64_t)e->q[i+d] - e->q[i]) / (e->n[i+d] - e->n[i]));
+            e->n[i] += d;
+        }
+    }
+}
+
+static u32 Stats_P2Get(const Stats_P2TypeDef *e, u32 count, u32 p)
+{
+    if(count == 0)
+        return 0;
+    if(count < 5)
+        return (u32)e->q[((count - 1) * p + 32768) >> 16] >> STATS_P2_FRAC;   // 最近秩
+    return (u32)(e->q[2] + (1 << (STATS_P2_FRAC - 1))) >> STATS_P2_FRAC;
+}
+
+/********************* 辅助函数 *********************/
+static u32 Stats_Isqrt(uint64_t v)
+{
+    uint64_t res = 0, bit = (uint64_t)1 << 62;
+
+    while(bit > v)
+        bit >>= 2;
+    while(bit)
+    {
+        if(v >= res + bit)
+        {
+            v -= res + bit;
+            res = (res >> 1) + bit;
+        }
+        else
+        {
+            res >>= 1;
+        }
+        bit >>= 2;
+    }
+    return (u32)res;
+}
+
+/********************* 对外接口 *********************/
+void Stats_Init(void)
+{
+    memset(acc, 0, sizeof(acc));
+}
+
+void Stats_Add(u8 sensor, u32 clux, u8 status)
+{
+    Stats_AccTypeDef *a;
+    s32 d, q;
+    u8 l, j;
+
+    if(sensor >= STATS_MAX_SENSORS)
+        return;
+    for(l=0; l<STATS_LEVELS; l++)
+    {
+        a = &acc[l][sensor];
+        if(status < STATS_STATUS_COUNT && a->status[status] < 0xFFFF)
+            a->status[status]++;
+        if(status != 0)
+            continue;
+
+        if(a->count == 0)
+        {
+            a->offset = a->min = a->max = clux;
+        }
+        else
+        {
+            if(clux < a->min)
+                a->min = clux;
+            if(clux > a->max)
+                a->max = clux;
+        }
+        a->count++;
+        d = (s32)(clux - a->offset);
+        a->sum += d;
+        a->sumsq += (uint64_t)((int64_t)d * d);
+        q = (s32)((clux > STATS_P2_MAX ? STATS_P2_MAX : clux) << STATS_P2_FRAC);
+        for(j=0; j<STATS_QUANTILES; j++)
+            Stats_P2Add(&a->p2[j], a->count, p2_prob[j], q);
+    }
+}
+
+// 方差 = (Σd² - Σd·mean_d)/(n-1)，mean_d按整数截断，误差不超过|Σd|/(n-1)
+void Stats_Close(u8 level, u8 sensor, Stats_RollupTypeDef *out)
+{
+    Stats_AccTypeDef *a;
+    int64_t mean_d;
+    uint64_t var = 0;
+    u8 j;
+
+    if(level >= STATS_LEVELS || sensor >= STATS_MAX_SENSORS)
+        return;
+    a = &acc[level][sensor];
+
+    out->sensor = sensor;
+    out->level = level;
+    out->count = a->count > 0xFFFF ? 0xFFFF : (u16)a->count;
+    out->min = a->min;
+    out->max = a->max;
+    mean_d = a->count ? a->sum / (int64_t)a->count : 0;
+    out->mean = (u32)((int64_t)a->offset + mean_d);
+    if(a->count > 1)
+        var = (a->sumsq - (uint64_t)(a->sum * mean_d)) / (a->count - 1);
+    out->stddev = Stats_Isqrt(var);
+    for(j=0; j<STATS_QUANTILES; j++)
+        out->quantile[j] = Stats_P2Get(&a->p2[j], a->count, p2_prob[j]);
+    for(j=0; j<STATS_STATUS_COUNT; j++)
+        out->status[j] = a->status[j];
+
+    memset(a, 0, sizeof(*a));
+}
@@ -0,0 +1,64 @@
+#ifndef __STATS_ROLLUP_H
+#define __STATS_ROLLUP_H
+
+#include "stm32f10x.h"
+
+/********************* 统计汇总参数 *********************/
+// 每个传感器、每个统计周期一组增量累加器，周期结束时输出一条汇总记录，
+// 主机端流量与CPU随显示屏数量而不是采样率增长
+#define STATS_LEVELS           2
+#define STATS_SHORT_MS         1000      // 短周期（level 0）
+#define STATS_LONG_MS          60000     // 长周期（level 1），须为短周期的整数倍
+#define STATS_MAX_SENSORS      8         // 与OPT3001_MAX_SENSORS一致
+#define STATS_STATUS_COUNT     4         // OPT3001_StatusTypeDef取值个数
+#define STATS_QUANTILES        3         // p5/p50/p95
+
+#if (STATS_LONG_MS % STATS_SHORT_MS) != 0
+#error "STATS_LONG_MS 须为 STATS_SHORT_MS 的整数倍"
+#endif
+
+// P²分位数估计（Jain & Chlamtac），整数实现：5个标记的高度与实际位置，
+// 期望位置由样本数直接算出，不单独保存。标记每次只移动相邻间距/位置差，样本密集时不足0.01lux，
+// 高度带STATS_P2_FRAC位小数保存，否则截断为0后标记停住
+#define STATS_P2_FRAC          8
+#define STATS_P2_MAX           (0x7FFFFFFF >> STATS_P2_FRAC)     // 可表示的最大光照（0.01lux），高于OPT3001满量程
+
+typedef struct {
+    s32 q[5];         // 标记高度（0.01lux，Q8）
+    u16 n[5];         // 标记实际位置（1起）
+} Stats_P2TypeDef;
+
+// 单个周期的累加器：以周期内第一个样本为偏移累加差值及差值平方（整数精确），
+// 避免大均值下平方和溢出与相消误差
+typedef struct {
+    u32 count;                          // 参与数值统计的样本数（状态正常）
+    u32 min;
+    u32 max;
+    u32 offset;                         // 第一个样本
+    int64_t sum;                            // Σ(x - offset)
+    uint64_t sumsq;                          // Σ(x - offset)^2
+    u16 status[STATS_STATUS_COUNT];     // 各状态样本数（含异常样本）
+    Stats_P2TypeDef p2[STATS_QUANTILES];
+} Stats_AccTypeDef;
+
+// 周期汇总结果（光照单位0.01lux）
+typedef struct {
+    u8  sensor;
+    u8  level;
+    u16 count;
+    u32 min;
+    u32 max;
+    u32 mean;
+    u32 stddev;                         // 样本标准差（方差 = stddev^2）
+    u32 quantile[STATS_QUANTILES];      // p5/p50/p95
+    u16 status[STATS_STATUS_COUNT];
+} Stats_RollupTypeDef;
+
+/********************* 函数声明 *********************/
+void Stats_Init(void);
+// 加入一个样本（主循环上下文）；status非0的样本只计入状态计数
+void Stats_Add(u8 sensor, u32 clux, u8 status);
+// 结束一个周期：输出汇总并清空该累加器
+void Stats_Close(u8 level, u8 sensor, Stats_RollupTypeDef *out);
+
+#endif
@@ -0,0 +1,204 @@
+#include "telemetry.h"
+#include "usart1_dma.h"
+
+static u32 tele_samples = 0;
+static u32 tele_bytes = 0;
+static u8 tele_binary = TELEMETRY_BINARY;
+static u8 tele_output = TELEMETRY_OUTPUT;
+static volatile u8 tele_need_lead = 1;   // 1：上一帧之后输出过文本（或尚未发过帧）
+
+/********************* CRC16-CCITT（半字节查表，32字节表） *********************/
+static const u16 crc16_nibble[16] = {
+    0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
+    0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF
+};
+
+u16 Telemetry_Crc16(const u8 *data, u8 len)
+{
+    u16 crc = 0xFFFF;
+    u8 i;
+
+    for(i=0; i<len; i++)
+    {
+        crc = (crc << 4) ^ crc16_nibble[(crc >> 12) ^ (data[i] >> 4)];
+        crc = (crc << 4) ^ crc16_nibble[(crc >> 12) ^ (data[i] & 0x0F)];
+    }
+    return crc;
+}
+
+/********************* COBS编码 *********************/
+// 每个0x00替换为到下一个0x00（或帧尾）的距离，帧长远小于254，不需要分段
+u8 Telemetry_CobsEncode(const u8 *in, u8 len, u8 *out)
+{
+    u8 code_pos = 0, code = 1, o = 1, i;
+
+    for(i=0; i<len; i++)
+    {
+        if(in[i] == 0)
+        {
+            out[code_pos] = code;
+            code_pos = o++;
+            code = 1;
+        }
+        else
+        {
+            out[o++] = in[i];
+            code++;
+        }
+    }
+    out[code_pos] = code;
+    return o;
+}
+
+/********************* 串口输出 *********************/
+// 追加CRC、COBS编码并整帧写入发送缓冲；其间输出过调试文本时先补一个分隔符把文本与本帧隔开
+static u8 Telemetry_SendFrame(u8 *frame, u8 payload_len)
+{
+    u8 wire[TELEMETRY_ROLLUP_FRAME_LEN + 3];
+    u16 crc = Telemetry_Crc16(frame, payload_len);
+    u8 sent = 0;
+
+    frame[payload_len] = crc & 0xFF;
+    frame[payload_len + 1] = crc >> 8;
+    if(tele_need_lead)
+    {
+        wire[sent++] = 0x00;
+        tele_need_lead = 0;
+    }
+    sent += Telemetry_CobsEncode(frame, payload_len + 2, &wire[sent]);
+    wire[sent++] = 0x00;
+    USART1_DMA_Write(wire, sent);
+    return sent;
+}
+
+static void Telemetry_Put24(u8 *p, u32 v)
+{
+    if(v > TELEMETRY_CLUX_MAX)
+        v = TELEMETRY_CLUX_MAX;
+    p[0] = v & 0xFF;
+    p[1] = (v >> 8) & 0xFF;
+    p[2] = v >> 16;
+}
+
+static void Telemetry_Put32(u8 *p, u32 v)
+{
+    p[0] = v & 0xFF;
+    p[1] = (v >> 8) & 0xFF;
+    p[2] = (v >> 16) & 0xFF;
+    p[3] = v >> 24;
+}
+
+u8 Telemetry_SendSample(const SampleRing_RecordTypeDef *rec)
+{
+    u8 frame[TELEMETRY_FRAME_LEN];
+    u8 sent;
+
+    frame[0] = rec->seq & 0xFF;
+    frame[1] = rec->seq >> 8;
+    Telemetry_Put32(&frame[2], rec->stamp_us);
+    Telemetry_Put24(&frame[6], rec->clux);
+    frame[9] = (TELEMETRY_TYPE_SAMPLE << 6) | ((rec->status & 0x07) << 3) | (rec->sensor & 0x07);
+    sent = Telemetry_SendFrame(frame, TELEMETRY_PAYLOAD_LEN);
+    Telemetry_Account(sent);
+    return sent;
+}
+
+u8 Telemetry_SendRollup(const Stats_RollupTypeDef *r, u32 stamp_ms)
+{
+    u8 frame[TELEMETRY_ROLLUP_FRAME_LEN];
+    u8 i;
+
+    frame[0] = (TELEMETRY_TYPE_ROLLUP << 6) | ((r->level & 0x07) << 3) | (r->sensor & 0x07);
+    Telemetry_Put32(&frame[1], stamp_ms);
+    frame[5] = r->count & 0xFF;
+    frame[6] = r->count >> 8;
+    Telemetry_Put24(&frame[7], r->min);
+    Telemetry_Put24(&frame[10], r->max);
+    Telemetry_Put24(&frame[13], r->mean);
+    Telemetry_Put24(&frame[16], r->stddev);
+    for(i=0; i<STATS_QUANTILES; i++)
+        Telemetry_Put24(&frame[19 + i * 3], r->quantile[i]);
+    for(i=0; i<STATS_STATUS_COUNT; i++)
+    {
+        frame[28 + i * 2] = r->status[i] & 0xFF;
+        frame[29 + i * 2] = r->status[i] >> 8;
+    }
+    return Telemetry_SendFrame(frame, TELEMETRY_ROLLUP_PAYLOAD_LEN);
+}
+
+// 状态帧公共部分：光照与两条基线
+static void Telemetry_PutState(u8 *frame, u8 type, u8 sensor, u32 stamp_ms, u32 dur_ms,
+                               const Screen_InfoTypeDef *info)
+{
+    frame[0] = (type << 6) | (sensor & 0x07);
+    Telemetry_Put32(&frame[1], stamp_ms);
+    Telemetry_Put32(&frame[6], dur_ms);
+    Telemetry_Put24(&frame[10], info->clux);
+    Telemetry_Put24(&frame[13], info->off_base);
+    Telemetry_Put24(&frame[16], info->on_base);
+}
+
+u8 Telemetry_SendEvent(const Screen_EventTypeDef *ev, const Screen_InfoTypeDef *info)
+{
+    u8 frame[TELEMETRY_STATE_FRAME_LEN];
+
+    Telemetry_PutState(frame, TELEMETRY_TYPE_EVENT, ev->sensor, ev->stamp_ms, ev->confirm_ms, info);
+    Telemetry_Put24(&frame[10], ev->clux);
+    frame[5] = (ev->from << 4) | (ev->to & 0x0F);
+    return Telemetry_SendFrame(frame, TELEMETRY_STATE_PAYLOAD_LEN);
+}
+
+u8 Telemetry_SendHeartbeat(u8 sensor, const Screen_InfoTypeDef *info, u32 stamp_ms)
+{
+    u8 frame[TELEMETRY_STATE_FRAME_LEN];
+
+    Telemetry_PutState(frame, TELEMETRY_TYPE_HEARTBEAT, sensor, stamp_ms, stamp_ms - info->since_ms, info);
+    frame[5] = (info->state << 4) | (info->state & 0x0F);
+    return Telemetry_SendFrame(frame, TELEMETRY_STATE_PAYLOAD_LEN);
+}
+
+u8 Telemetry_SetOutput(u8 output)
+{
+    if(output > TELEMETRY_OUT_EVENT)
+        return 1;
+    tele_output = output;
+    return 0;
+}
+
+u8 Telemetry_GetOutput(void)
+{
+    return tele_output;
+}
+
+void Telemetry_SetBinary(u8 binary)
+{
+    tele_binary = binary ? 1 : 0;
+    tele_need_lead = 1;
+}
+
+u8 Telemetry_IsBinary(void)
+{
+    return tele_binary;
+}
+
+void Telemetry_NoteText(void)
+{
+    tele_need_lead = 1;
+}
+
+/********************* 统计 *********************/
+void Telemetry_Account(u32 bytes)
+{
+    tele_samples++;
+    tele_bytes += bytes;
+}
+
+u32 Telemetry_GetSamples(void)
+{
+    return tele_samples;
+}
+
+u32 Telemetry_GetBytes(void)
+{
+    return tele_bytes;
+}
@@ -0,0 +1,78 @@
+#ifndef __TELEMETRY_H
+#define __TELEMETRY_H
+
+#include "stm32f10x.h"
+#include "sample_ring.h"
+#include "stats_rollup.h"
+#include "screen_state.h"
+
+/********************* 二进制遥测帧定义 *********************/
+// 上电默认输出模式（1：样本以COBS二进制帧发送；0：原文本输出，调试模式），运行时可切换
+#define TELEMETRY_BINARY        1
+// 输出粒度：逐样本 / 每个统计周期一条汇总 / 只输出屏幕状态变化事件与周期心跳，运行时可切换
+// 状态变化事件在各粒度下都输出（稀少且是最终关心的结果）
+#define TELEMETRY_OUT_SAMPLE    0
+#define TELEMETRY_OUT_ROLLUP    1
+#define TELEMETRY_OUT_EVENT     2
+#define TELEMETRY_OUTPUT        TELEMETRY_OUT_EVENT   // 上电默认粒度
+
+// 帧类型由帧长区分（主机端先按长度再校验CRC）
+// 样本帧内容（小端）：
+//   [0..1] 序号  [2..5] 时间戳us  [6..8] 光照0.01lux（24位）
+//   [9]    类型[7:6] | 状态[5:3] | 传感器编号[2:0]
+//   [10..11] CRC16-CCITT（多项式0x1021，初值0xFFFF，覆盖[0..9]）
+// COBS编码后帧内不含0x00，帧前后各发一个0x00分隔符，
+// 夹在帧之间的调试文本（不含0x00）在主机端被当作文本段分离出来
+#define TELEMETRY_PAYLOAD_LEN   10
+#define TELEMETRY_FRAME_LEN     (TELEMETRY_PAYLOAD_LEN + 2)
+#define TELEMETRY_WIRE_LEN      (TELEMETRY_FRAME_LEN + 1 + 1)   // COBS开销1字节 + 分隔符（连续帧共用）
+#define TELEMETRY_TYPE_SAMPLE   0
+#define TELEMETRY_TYPE_ROLLUP   1
+#define TELEMETRY_TYPE_EVENT    2
+#define TELEMETRY_TYPE_HEARTBEAT 3
+#define TELEMETRY_CLUX_MAX      0xFFFFFF
+
+// 汇总帧内容（小端，光照均为0.01lux、24位饱和）：
+//   [0]      类型[7:6] | 周期级别[5:3] | 传感器编号[2:0]
+//   [1..4]   周期结束时刻ms  [5..6] 数值样本数
+//   [7..9]   最小  [10..12] 最大  [13..15] 均值  [16..18] 标准差
+//   [19..27] p5/p50/p95   [28..35] 各状态样本数（4×u16）
+//   [36..37] CRC16
+#define TELEMETRY_ROLLUP_PAYLOAD_LEN  36
+#define TELEMETRY_ROLLUP_FRAME_LEN    (TELEMETRY_ROLLUP_PAYLOAD_LEN + 2)
+
+// 屏幕状态帧（事件与心跳同一格式，小端）：
+//   [0]      类型[7:6] | 传感器编号[2:0]
+//   [1..4]   时刻ms（事件：新状态首次出现；心跳：发送时刻）
+//   [5]      原状态[7:4] | 新状态[3:0]（心跳两者相同）
+//   [6..9]   事件：确认用时ms；心跳：已处于当前状态的时长ms
+//   [10..12] 光照  [13..15] 熄屏基线  [16..18] 亮屏基线（0.01lux，24位饱和）
+//   [19..20] CRC16
+#define TELEMETRY_STATE_PAYLOAD_LEN   19
+#define TELEMETRY_STATE_FRAME_LEN     (TELEMETRY_STATE_PAYLOAD_LEN + 2)
+
+/********************* 函数声明 *********************/
+u16 Telemetry_Crc16(const u8 *data, u8 len);
+// COBS编码（out至少len+1字节，返回编码后长度，不含分隔符）
+u8 Telemetry_CobsEncode(const u8 *in, u8 len, u8 *out);
+// 编码一条样本帧并写入串口发送缓冲（返回帧占用的线上字节数）
+u8 Telemetry_SendSample(const SampleRing_RecordTypeDef *rec);
+// 编码一条汇总帧并写入串口发送缓冲（返回线上字节数）
+u8 Telemetry_SendRollup(const Stats_RollupTypeDef *r, u32 stamp_ms);
+// 编码一条屏幕状态变化事件 / 状态心跳帧（返回线上字节数）
+u8 Telemetry_SendEvent(const Screen_EventTypeDef *ev, const Screen_InfoTypeDef *info);
+u8 Telemetry_SendHeartbeat(u8 sensor, const Screen_InfoTypeDef *info, u32 stamp_ms);
+// 运行时切换/查询输出粒度（TELEMETRY_OUT_xxx，非法值返回1）
+u8 Telemetry_SetOutput(u8 output);
+u8 Telemetry_GetOutput(void);
+// 运行时切换/查询输出模式（1：二进制，0：文本）
+void Telemetry_SetBinary(u8 binary);
+u8 Telemetry_IsBinary(void);
+// 调试文本输出时调用（fputc内）：下一帧前补分隔符，避免文本并入帧
+void Telemetry_NoteText(void);
+// 累计输出的样本数与字节数（用于统计每样本线上字节数）
+void Telemetry_Account(u32 bytes);
+u32 Telemetry_GetSamples(void);
+u32 Telemetry_GetBytes(void);
+
+#endif
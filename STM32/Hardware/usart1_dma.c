@@ -0,0 +1,113 @@
+#include "usart1_dma.h"
+#include "delay.h"
+#include <string.h>
+
+/********************* 双缓冲状态 *********************/
+// tx_fill指向应用正在填充的缓冲，另一块（tx_busy时）正由DMA发送；
+// 填充与交换都在关中断下进行，发送完成中断只在填充缓冲非空时交换
+static u8 tx_buf[2][USART1_DMA_BUF_SIZE];
+static u8 tx_fill = 0;
+static volatile u16 tx_fill_len = 0;
+static volatile u8  tx_busy = 0;
+static volatile u32 tx_dropped = 0;
+
+// 启动填充缓冲的发送并交换（调用时中断已关闭或在发送完成中断内）
+static void USART1_DMA_Kick(void)
+{
+    DMA1_Channel4->CCR   = 0;
+    DMA1_Channel4->CMAR  = (u32)tx_buf[tx_fill];
+    DMA1_Channel4->CNDTR = tx_fill_len;
+    DMA1_Channel4->CCR   = DMA_CCR1_DIR | DMA_CCR1_MINC | DMA_CCR1_TCIE | DMA_CCR1_TEIE;
+    DMA1_Channel4->CCR  |= DMA_CCR1_EN;
+    tx_fill ^= 1;
+    tx_fill_len = 0;
+    tx_busy = 1;
+}
+
+void USART1_DMA_Init(void)
+{
+    NVIC_InitTypeDef NVIC_InitStruct;
+
+    RCC_AHBPeriphClockCmd(RCC_AHBPeriph_DMA1, ENABLE);
+
+    // DMA1通道4（USART1_TX）外设地址固定为DR
+    DMA1_Channel4->CCR  = 0;
+    DMA1_Channel4->CPAR = (u32)&USART1->DR;
+    DMA1->IFCR = DMA_IFCR_CGIF4;
+    USART1->CR3 |= USART_CR3_DMAT;
+
+    // 低于总线中断的抢占优先级，串口收尾不影响I2C时序
+    NVIC_InitStruct.NVIC_IRQChannel = DMA1_Channel4_IRQn;
+    NVIC_InitStruct.NVIC_IRQChannelPreemptionPriority = 2;
+    NVIC_InitStruct.NVIC_IRQChannelSubPriority = 0;
+    NVIC_InitStruct.NVIC_IRQChannelCmd = ENABLE;
+    NVIC_Init(&NVIC_InitStruct);
+
+    tx_fill = 0;
+    tx_fill_len = 0;
+    tx_busy = 0;
+}
+
+u16 USART1_DMA_Write(const u8 *data, u16 len)
+{
+    u16 done = 0, n;
+    u32 deadline = micros() + USART1_DMA_WAIT_US;
+
+    while(done < len)
+    {
+        __disable_irq();
+        n = USART1_DMA_BUF_SIZE - tx_fill_len;
+        if(n > len - done)
+            n = len - done;
+        memcpy(&tx_buf[tx_fill][tx_fill_len], data + done, n);
+        tx_fill_len += n;
+        done += n;
+        if(!tx_busy && tx_fill_len > 0)
+            USART1_DMA_Kick();
+        __enable_irq();
+
+        // 两块都满：等发送完成中断腾出填充缓冲，超过等待上限则丢弃剩余部分
+        if(done < len)
+        {
+            if(TIME_REACHED(micros(), deadline))
+            {
+                tx_dropped += len - done;
+                break;
+            }
+        }
+    }
+    return done;
+}
+
+u8 USART1_DMA_Flush(u32 timeout_us)
+{
+    u32 deadline = micros() + timeout_us;
+
+    while(tx_busy || tx_fill_len > 0 || USART_GetFlagStatus(USART1, USART_FLAG_TC) == RESET)
+    {
+        if(TIME_REACHED(micros(), deadline))
+            return 1;
+    }
+    return 0;
+}
+
+u16 USART1_DMA_Pending(void)
+{
+    return tx_fill_len + (tx_busy ? (u16)DMA1_Channel4->CNDTR : 0);
+}
+
+u32 USART1_DMA_GetDropped(void)
+{
+    return tx_dropped;
+}
+
+/********************* 中断服务函数 *********************/
+// DMA1通道4（USART1_TX）：一块发完，填充缓冲有数据则接着发送
+void DMA1_Channel4_IRQHandler(void)
+{
+    DMA1->IFCR = DMA_IFCR_CGIF4;
+    DMA1_Channel4->CCR = 0;
+    tx_busy = 0;
+    if(tx_fill_len > 0)
+        USART1_DMA_Kick();
+}
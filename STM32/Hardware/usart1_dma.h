@@ -0,0 +1,24 @@
+#ifndef __USART1_DMA_H
+#define __USART1_DMA_H
+
+#include "stm32f10x.h"
+
+/********************* USART1 DMA发送参数 *********************/
+// 双缓冲：应用写入填充缓冲，另一块由DMA1通道4发送；发送完成中断交换两块缓冲，
+// 主循环写串口不再逐字节等待TXE
+#define USART1_DMA_BUF_SIZE    128      // 单块缓冲字节数
+#define USART1_DMA_WAIT_US     150000   // 两块缓冲都满时最多等待（9600bps下约一整块），超时丢弃并计数
+
+/********************* 函数声明 *********************/
+// 在USART1_Init之后调用：配置DMA1通道4并打开USART1的DMA发送请求
+void USART1_DMA_Init(void);
+// 写入发送缓冲，DMA空闲时立即启动发送（返回实际写入的字节数，其余因背压丢弃）
+u16 USART1_DMA_Write(const u8 *data, u16 len);
+// 等待已写入的数据全部移出移位寄存器（返回0：完成，1：超时）
+u8 USART1_DMA_Flush(u32 timeout_us);
+// 发送缓冲中尚未发出的字节数
+u16 USART1_DMA_Pending(void);
+// 上电以来因背压丢弃的字节数
+u32 USART1_DMA_GetDropped(void);
+
+#endif
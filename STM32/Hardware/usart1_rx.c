@@ -0,0 +1,72 @@
+#include "usart1_rx.h"
+
+/********************* 接收缓冲 *********************/
+static u8 rx_buf[USART1_RX_BUF_SIZE];
+static volatile u32 rx_head = 0;      // 只由中断写
+static volatile u32 rx_tail = 0;      // 只由主循环写
+static volatile u32 rx_dropped = 0;
+static volatile u32 rx_overrun = 0;
+
+void USART1_RX_Init(void)
+{
+    NVIC_InitTypeDef NVIC_InitStruct;
+
+    rx_head = rx_tail = 0;
+
+    // 与串口DMA发送同一抢占优先级，低于总线中断
+    NVIC_InitStruct.NVIC_IRQChannel = USART1_IRQn;
+    NVIC_InitStruct.NVIC_IRQChannelPreemptionPriority = 2;
+    NVIC_InitStruct.NVIC_IRQChannelSubPriority = 1;
+    NVIC_InitStruct.NVIC_IRQChannelCmd = ENABLE;
+    NVIC_Init(&NVIC_InitStruct);
+
+    USART1->CR1 |= USART_CR1_RXNEIE;
+}
+
+u8 USART1_RX_Read(u8 *ch)
+{
+    u32 tail = rx_tail;
+
+    if(tail == rx_head)
+        return 0;
+    __DMB();                        // 读到下标之后才读数据
+    *ch = rx_buf[tail & USART1_RX_MASK];
+    __DMB();
+    rx_tail = tail + 1;
+    return 1;
+}
+
+u32 USART1_RX_GetDropped(void)
+{
+    return rx_dropped;
+}
+
+u32 USART1_RX_GetOverrun(void)
+{
+    return rx_overrun;
+}
+
+/********************* 中断服务函数 *********************/
+// 读SR再读DR同时清除RXNE与ORE
+void USART1_IRQHandler(void)
+{
+    u16 sr = USART1->SR;
+    u8 ch;
+    u32 head;
+
+    if(!(sr & (USART_SR_RXNE | USART_SR_ORE)))
+        return;
+    ch = (u8)USART1->DR;
+    if(sr & USART_SR_ORE)
+        rx_overrun++;
+
+    head = rx_head;
+    if(head - rx_tail >= USART1_RX_BUF_SIZE)
+    {
+        rx_dropped++;
+        return;
+    }
+    rx_buf[head & USART1_RX_MASK] = ch;
+    __DMB();                        // 数据写完后才发布
+    rx_head = head + 1;
+}
@@ -0,0 +1,21 @@
+#ifndef __USART1_RX_H
+#define __USART1_RX_H
+
+#include "stm32f10x.h"
+
+/********************* USART1中断接收参数 *********************/
+// RXNE中断把字节写入环形缓冲（中断写head，主循环读tail，不需要关中断），
+// 主循环空闲时逐字节取出交给命令解析
+#define USART1_RX_BUF_SIZE   64     // 必须为2的幂
+#define USART1_RX_MASK       (USART1_RX_BUF_SIZE - 1)
+
+/********************* 函数声明 *********************/
+// 在USART1_Init之后调用：打开RXNE中断
+void USART1_RX_Init(void);
+// 取出一个字节（返回1：有数据，0：缓冲空）
+u8 USART1_RX_Read(u8 *ch);
+// 上电以来因缓冲满丢弃的字节数 / 硬件溢出（ORE）次数
+u32 USART1_RX_GetDropped(void);
+u32 USART1_RX_GetOverrun(void);
+
+#endif
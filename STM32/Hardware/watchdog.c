@@ -0,0 +1,40 @@
+#include "watchdog.h"
+
+static u8 watchdog_reset = 0;
+
+// 预分频32：计数时钟约1.25kHz，12位重装值最大约3.2s
+#define IWDG_PR_DIV32    0x03
+#define IWDG_KEY_UNLOCK  0x5555
+#define IWDG_KEY_RELOAD  0xAAAA
+#define IWDG_KEY_START   0xCCCC
+
+void Watchdog_Init(u32 timeout_ms)
+{
+    u32 reload = timeout_ms * (WATCHDOG_LSI_HZ / 32) / 1000;
+
+    watchdog_reset = (RCC->CSR & RCC_CSR_IWDGRSTF) ? 1 : 0;
+    RCC->CSR |= RCC_CSR_RMVF;        // 清除复位标志，下次复位原因才能区分
+
+    if(reload == 0)
+        reload = 1;
+    if(reload > 0x0FFF)
+        reload = 0x0FFF;
+
+    DBGMCU->CR |= DBGMCU_CR_DBG_IWDG_STOP;
+    IWDG->KR = IWDG_KEY_UNLOCK;
+    IWDG->PR = IWDG_PR_DIV32;
+    IWDG->RLR = reload;
+    while(IWDG->SR != 0);            // 等待PR/RLR写入LSI时钟域
+    IWDG->KR = IWDG_KEY_RELOAD;
+    IWDG->KR = IWDG_KEY_START;
+}
+
+void Watchdog_Kick(void)
+{
+    IWDG->KR = IWDG_KEY_RELOAD;
+}
+
+u8 Watchdog_WasReset(void)
+{
+    return watchdog_reset;
+}
@@ -0,0 +1,20 @@
+#ifndef __WATCHDOG_H
+#define __WATCHDOG_H
+
+#include "stm32f10x.h"
+
+/********************* 独立看门狗参数 *********************/
+// IWDG由LSI（约40kHz，实际30~60kHz）驱动，一旦启动无法关闭；
+// 只在主循环确认采集仍在推进时喂狗，主循环卡死或一轮读取长期不结束都会导致复位
+#define WATCHDOG_ENABLE      1
+#define WATCHDOG_TIMEOUT_MS  2000      // 标称超时（LSI偏差下实际约1.3~2.7s，上限约3.2s）
+#define WATCHDOG_LSI_HZ      40000
+
+/********************* 函数声明 *********************/
+// 记录并清除复位原因，启动IWDG（调试暂停时看门狗同时暂停）
+void Watchdog_Init(u32 timeout_ms);
+void Watchdog_Kick(void);
+// 上一次复位是否由IWDG引起（Watchdog_Init中读取）
+u8 Watchdog_WasReset(void);
+
+#endif
@@ -1,17 +1,37 @@
 #include "stm32f10x.h"
 #include "opt3001.h"
+#include "opt3001_sched.h"
+#include "opt3001_adapt.h"
+#include "opt3001_health.h"
+#include "sample_ring.h"
+#include "telemetry.h"
+#include "screen_state.h"
+#include "usart1_dma.h"
+#include "usart1_rx.h"
+#include "cmd_parser.h"
+#include "opt3001_topo.h"
+#include "opt3001_lanes.h"
+#include "soft_timer.h"
+#include "power.h"
+#include "watchdog.h"
+#include "metrics.h"
 #include "delay.h"   
 #include "stdio.h"
 
+#define USART1_BAUD  9600
+
 // 声明USART1初始化函数
 void USART1_Init(u32 baudrate);
 
 // 重定向printf到串口（屏蔽未使用参数，消除警告）
+// 字符写入DMA双缓冲后立即返回，不再逐字节等待TXE
 int fputc(int ch, FILE *f)
 {
+    u8 c = (u8)ch;
+
     (void)f; // 屏蔽未使用的f参数
-    USART_SendData(USART1, (u8)ch);
-    while(USART_GetFlagStatus(USART1, USART_FLAG_TXE) == RESET);
+    Telemetry_NoteText();
+    USART1_DMA_Write(&c, 1);
     return ch;
 }
 
@@ -49,65 +69,1028 @@ void USART1_Init(u32 baudrate)
 }
 
 
+// 传感器总线列表：每条总线按ADDR引脚可接0x44~0x47，再定义软件IIC总线可扩展到8个
+static const OPT3001_BusTypeDef *const buses[] = {
+    &OPT3001_DefaultBus,
+};
+#define BUS_COUNT  (sizeof(buses) / sizeof(buses[0]))
+
+// 传感器表由上电发现流程填充
+static OPT3001_HandleTypeDef sensors[OPT3001_MAX_SENSORS];
+static u8 sensor_count = 0;
+
+// 1：阈值窗口事件模式（光照稳定时无总线流量、无串口输出，仅越限时上报）
+#define SENSOR_EVENT_MODE  0
+
+// 软件定时器：采样轮间隔、全地址扫描步进、流量统计
+// 接INT时采集由中断触发，定时查询只作兜底（INT未接或丢沿）；事件模式下兜底间隔放长
+#if OPT3001_INT_ENABLE && SENSOR_EVENT_MODE
+#define CYCLE_INTERVAL_MS  60000
+#elif OPT3001_INT_ENABLE
+#define CYCLE_INTERVAL_MS  1000
+#else
+#define CYCLE_INTERVAL_MS  100
+#endif
+#define SCAN_STEP_MS       2
+static u32 cycle_interval_ms = CYCLE_INTERVAL_MS;   // 运行时可由set period修改
+#define STATS_INTERVAL_MS  60000
+static SoftTimer_TypeDef cycle_timer;
+static SoftTimer_TypeDef scan_timer;
+static SoftTimer_TypeDef stats_timer;
+static u8 scan_requested = 0;
+static u8 scan_addr = 0;
+
+static void Cycle_Start(void *ctx);
+
+// 总线上仍有事务：调度器一轮读取未结束，或异步队列里还有健康恢复/自适应重配置等其它来源的事务
+static u8 Bus_InUse(void)
+{
+    return OPT3001_Sched_IsBusy() || OPT3001_Async_Pending() != 0;
+}
+
+// 扫描步进：每2ms探测一个地址，不阻塞主循环；探测是同步总线操作，
+// 每一步都重新确认异步队列已空（扫描期间仍可能有事务被提交），否则本步跳过
+static void I2C_Scan_Step(void *ctx)
+{
+    (void)ctx;
+    if(Bus_InUse())
+        return;
+    if(OPT3001_Probe(scan_addr) == 0)     // 如果返回 0 说明有真实应答
+    {
+        printf("成功找到设备！真实地址为: 0x%02X\r\n", scan_addr);
+    }
+    if(++scan_addr < 128)
+        return;
+
+    SoftTimer_Stop(&scan_timer);
+    printf("--- 扫描结束 ---\r\n");
+    OPT3001_Sched_Pause(0);
+    SoftTimer_Start(&cycle_timer, cycle_interval_ms, 0, Cycle_Start, 0);
+}
+
+// 全地址扫描仅用于排查接线，不在上电流程中执行（串口发送's'触发）
 void I2C_Scan_Test(void)
 {
-    u8 addr;
     printf("\r\n--- 启动 I2C 总线扫描 ---\r\n");
-    for(addr = 1; addr < 128; addr++)
+    scan_addr = 1;
+    SoftTimer_Start(&scan_timer, SCAN_STEP_MS, SCAN_STEP_MS, I2C_Scan_Step, 0);
+}
+
+// 采样轮到期：有扫描请求时等本轮读取结束、异步队列排空后独占总线扫描，否则发起新一轮CRF查询
+static void Cycle_Start(void *ctx)
+{
+    (void)ctx;
+    if(scan_requested)
     {
-        OPT3001_IIC_Start();
-        OPT3001_IIC_SendByte(addr << 1); // 发送写地址
-        if(OPT3001_IIC_WaitAck() == 0)   // 如果返回 0 说明有真实应答
+        if(Bus_InUse())
         {
-            printf("成功找到设备！真实地址为: 0x%02X\r\n", addr);
+            SoftTimer_Start(&cycle_timer, 1, 0, Cycle_Start, 0);
+            return;
         }
-        OPT3001_IIC_Stop();
-        Delay_ms(2);
+        scan_requested = 0;
+        OPT3001_Sched_Pause(1);
+        I2C_Scan_Test();
+        return;
     }
-    printf("--- 扫描结束 ---\r\n");
+    // 未发现传感器或上一轮未结束时稍后再试，保证扫描请求总能得到执行
+    if(OPT3001_Sched_StartCycle() != 0)
+        SoftTimer_Start(&cycle_timer, cycle_interval_ms, 0, Cycle_Start, 0);
+}
+
+// 每分钟报告总线事务数、样本数和滤波链各级耗时，用于对比事件模式与连续采集的流量
+static u32 sample_total = 0;
+static u32 drain_cycles = 0;   // 输出路径累计占用的CPU周期（Telemetry_Drain内）
+static u32 baud_current = USART1_BAUD;
+// 当前统计周期的起点（上次定时报告时的累计值），只由Traffic_Reset推进
+static u32 last_xfers = 0, last_samples = 0, last_tele = 0, last_bytes = 0, last_report_ms = 0;
+#if OPT3001_IIC_STATS
+static u32 last_skipped = 0;
+#endif
+
+// 打印当前统计周期的流量与耗时，不改动周期起点：stats命令随时查看，不打断定时报告的统计窗口
+static void Traffic_Print(u8 periodic)
+{
+    u32 xfers = OPT3001_Async_GetXferCount();
+    u32 tele = Telemetry_GetSamples() - last_tele;
+    u32 bytes = Telemetry_GetBytes() - last_bytes;   // 本周期样本输出的字节数
+    Filter_StageStatsTypeDef fs;
+#if OPT3001_HEALTH_ENABLE
+    static const char *const fault_names[OPT3001_FAULT_TYPES] = {"总线卡死", "无应答"};
+    OPT3001_RecoveryStatsTypeDef rs;
+#endif
+#if OPT3001_ADAPT_ENABLE
+    OPT3001_AdaptStatsTypeDef as;
+#endif
+#if OPT3001_IIC_STATS
+    OPT3001_IIC_StatsTypeDef iic;
+    u32 samples = sample_total - last_samples;
+#endif
+    u8 i;
+
+    if(periodic)
+        printf("近1分钟：");
+    else
+        printf("本周期（%lu 秒）：", (unsigned long)((millis() - last_report_ms) / 1000));
+    printf("总线事务 %lu 次，上报样本 %lu 个（缓冲溢出累计 %lu 条）\r\n",
+           (unsigned long)(xfers - last_xfers), (unsigned long)(sample_total - last_samples),
+           (unsigned long)SampleRing_GetOverflow());
+#if OPT3001_IIC_STATS
+    // 软件IIC每样本的总线开销（含配置查询、指针写入与重试），总线时间按SCL脉冲数×位周期估算
+    OPT3001_IIC_GetStats(&iic);
+    if(samples > 0)
+        printf("  IIC总线：%lu 字节/样本，%lu START/样本，约 %lu us/样本，跳过未到期查询 %lu 次\r\n",
+               (unsigned long)(iic.bytes / samples), (unsigned long)(iic.starts / samples),
+               (unsigned long)(iic.scl_pulses * 1000000ULL / OPT3001_IIC_SPEED / samples),
+               (unsigned long)(OPT3001_Sched_GetSkipped() - last_skipped));
+#endif
+    // 主循环每样本的输出耗时，对比逐字节等待TXE时的耗时（字节数×10位/当前波特率）
+    if(tele > 0)
+    {
+        printf("  %s输出：平均 %lu 字节/样本，主循环 %lu 周期/样本（阻塞发送约 %lu 周期），背压丢弃 %lu 字节\r\n",
+               Telemetry_IsBinary() ? "二进制" : "文本",
+               (unsigned long)(bytes / tele),
+               (unsigned long)(drain_cycles / tele),
+               (unsigned long)((uint64_t)bytes * 10 * SystemCoreClock / baud_current / tele),
+               (unsigned long)USART1_DMA_GetDropped());
+    }
+    // 滤波链各级耗时（按链顺序），用于按部署权衡延迟与噪声
+    for(i=0; i<FilterChain_Length(); i++)
+    {
+        FilterChain_GetStats(FilterChain_StageAt(i), &fs);
+        if(fs.calls == 0)
+            continue;
+        printf("  滤波级%d %s：平均 %lu 周期，最大 %lu 周期\r\n", i, fs.name,
+               (unsigned long)(fs.cycles / fs.calls), (unsigned long)fs.max);
+    }
+
+#if OPT3001_HEALTH_ENABLE
+    // 各类故障的恢复耗时（首次失败到恢复后第一个有效读数）
+    for(i=0; i<OPT3001_FAULT_TYPES; i++)
+    {
+        OPT3001_Health_GetStats((OPT3001_FaultTypeDef)i, &rs);
+        if(rs.faults == 0)
+            continue;
+        printf("  %s：故障 %lu 次，已恢复 %lu 次（尝试 %lu 次），恢复耗时 平均 %lu ms，最近 %lu ms，最大 %lu ms\r\n",
+               fault_names[i], (unsigned long)rs.faults, (unsigned long)rs.recovered, (unsigned long)rs.attempts,
+               (unsigned long)(rs.recovered ? rs.total_ms / rs.recovered : 0),
+               (unsigned long)rs.last_ms, (unsigned long)rs.max_ms);
+    }
+    if(OPT3001_Health_GetBusRecoveries() > 0)
+        printf("  总线恢复序列累计 %lu 次\r\n", (unsigned long)OPT3001_Health_GetBusRecoveries());
+#endif
+
+#if OPT3001_ADAPT_ENABLE
+    // 当前转换时间/量程与累计重配置次数
+    for(i=0; i<sensor_count; i++)
+    {
+        OPT3001_Adapt_GetStats(i, &as);
+        printf("  传感器%d：转换%s，", i, (as.config & OPT3001_CFG_CT) ? "800ms" : "100ms");
+        if((as.config >> 12) == OPT3001_CFG_RN_AUTO)
+            printf("自动量程");
+        else
+            printf("固定量程RN=%d", as.config >> 12);
+        printf("，重配置 %lu 次，丢弃样本 %lu 个\r\n",
+               (unsigned long)as.switches, (unsigned long)as.discarded);
+    }
+#endif
+}
+
+// 开始新的统计周期：推进各计数的起点，清零本周期的输出耗时、软件IIC与滤波级统计
+static void Traffic_Reset(void)
+{
+    last_xfers = OPT3001_Async_GetXferCount();
+    last_samples = sample_total;
+    last_tele = Telemetry_GetSamples();
+    last_bytes = Telemetry_GetBytes();
+    last_report_ms = millis();
+    drain_cycles = 0;
+#if OPT3001_IIC_STATS
+    OPT3001_IIC_ResetStats();
+    last_skipped = OPT3001_Sched_GetSkipped();
+#endif
+    FilterChain_ResetStats();
+}
+
+static void Traffic_Report(void *ctx)
+{
+    (void)ctx;
+    Traffic_Print(1);
+    Traffic_Reset();
+}
+
+#if OPT3001_IIC_STATS
+// 启动时的驱动基准：连续读取结果寄存器，报告每次OPT3001_ReadLux的
+// SCL脉冲数、总线字节数、总线耗时与CPU周期（软件IIC下CPU全程参与）；
+// 分别测指针缓存命中（只发addr+R）和每次都写指针两种情况
+#define BENCH_READS  16
+// 1：同时测浮点接口的单样本开销（会把软件浮点库链接进来，只在对比时打开）
+#define BENCH_FLOAT  0
+static void OPT3001_Bench_Reads(OPT3001_HandleTypeDef *h, u8 cached)
+{
+    OPT3001_IIC_StatsTypeDef stats;
+    u32 start, cycles;
+    u8 i;
+
+    OPT3001_Sensor_ReadCentiLux(h);     // 先把指针指向结果寄存器
+    OPT3001_IIC_ResetStats();
+    start = DWT->CYCCNT;
+    for(i=0; i<BENCH_READS; i++)
+    {
+        if(!cached)
+            h->reg_ptr = OPT3001_PTR_UNKNOWN;
+        OPT3001_Sensor_ReadCentiLux(h);
+    }
+    cycles = (DWT->CYCCNT - start) / BENCH_READS;
+    OPT3001_IIC_GetStats(&stats);
+
+    printf("ReadLux基准（%s）：SCL脉冲 %lu，字节 %lu，START %lu，耗时 %lu us，CPU %lu 周期/次\r\n",
+           cached ? "指针缓存" : "写指针",
+           (unsigned long)(stats.scl_pulses / BENCH_READS), (unsigned long)(stats.bytes / BENCH_READS),
+           (unsigned long)(stats.starts / BENCH_READS),
+           (unsigned long)(cycles / (SystemCoreClock / 1000000)), (unsigned long)cycles);
+}
+
+static void OPT3001_Benchmark(OPT3001_HandleTypeDef *h)
+{
+    // 副本含中值窗口（MEDIAN_WINDOW_MAX=63时约0.5KB），放静态区以免占用1KB主栈
+    static OPT3001_HandleTypeDef scratch;
+    u32 start, int_cycles;
+    u8 i;
+
+    OPT3001_Bench_Reads(h, 0);
+    OPT3001_Bench_Reads(h, 1);
+
+    // 单样本处理（换算+量程/跳变/中值），用副本避免污染传感器状态
+    scratch = *h;
+    start = DWT->CYCCNT;
+    for(i=0; i<BENCH_READS; i++)
+        OPT3001_Sensor_FilterCentiLux(&scratch, OPT3001_RawToCentiLux(0x5000 | (i * 37)));
+    int_cycles = (DWT->CYCCNT - start) / BENCH_READS;
+    printf("样本处理：整数 %lu 周期/样本\r\n", (unsigned long)int_cycles);
+
+    // 流式中值单独计时：窗口填满后再测，反映稳态下每个样本的更新开销
+    Median_Init(&scratch.filter.median);
+    for(i=0; i<MEDIAN_WINDOW_SIZE; i++)
+        Median_Update(&scratch.filter.median, (u32)i * 7919 % 1000);
+    start = DWT->CYCCNT;
+    for(i=0; i<BENCH_READS; i++)
+        Median_Update(&scratch.filter.median, (u32)i * 104729 % 1000);
+    printf("中值滤波（窗口%d）：%lu 周期/样本\r\n", MEDIAN_WINDOW_SIZE,
+           (unsigned long)((DWT->CYCCNT - start) / BENCH_READS));
+    FilterChain_ResetStats();
+
+#if BENCH_FLOAT
+    scratch = *h;
+    start = DWT->CYCCNT;
+    for(i=0; i<BENCH_READS; i++)
+        OPT3001_Sensor_FilterLux(&scratch, OPT3001_RawToLux(0x5000 | (i * 37)));
+    printf("样本处理：浮点接口 %lu 周期/样本\r\n",
+           (unsigned long)((DWT->CYCCNT - start) / BENCH_READS));
+#endif
+}
+#endif
+
+#if OPT3001_LANES_ENABLE
+// 多通道锁步总线：初始化同地址传感器阵列，并对比并行读取与单通道读取的耗时
+static void Lanes_Boot(void)
+{
+    u16 data[OPT3001_LANES_MAX];
+    u32 start, all_cycles, one_cycles;
+    u8 all = (u8)((1 << OPT3001_DefaultLanes.count) - 1);
+    u8 lanes_online;
+
+    OPT3001_Lanes_Init(&OPT3001_DefaultLanes);
+    lanes_online = OPT3001_Lanes_SensorInit(&OPT3001_DefaultLanes, OPT3001_ADDR, all);
+    printf("多通道总线：%d个通道，在线位图 0x%02X\r\n", OPT3001_DefaultLanes.count, lanes_online);
+    if(lanes_online == 0)
+        return;
+
+    start = DWT->CYCCNT;
+    OPT3001_Lanes_ReadReg(&OPT3001_DefaultLanes, OPT3001_ADDR, OPT3001_RESULT_REG, lanes_online, data);
+    all_cycles = DWT->CYCCNT - start;
+    start = DWT->CYCCNT;
+    OPT3001_Lanes_ReadReg(&OPT3001_DefaultLanes, OPT3001_ADDR, OPT3001_RESULT_REG,
+                          lanes_online & -lanes_online, data);
+    one_cycles = DWT->CYCCNT - start;
+    printf("  并行读结果寄存器：%lu us（单通道 %lu us）\r\n",
+           (unsigned long)(all_cycles / (SystemCoreClock / 1000000)),
+           (unsigned long)(one_cycles / (SystemCoreClock / 1000000)));
+}
+#endif
+
+// 单个传感器样本处理完成（主循环上下文）：只写入样本环形缓冲，不在采集路径上等串口
+static void Sensor_Report(OPT3001_HandleTypeDef *h, u16 raw, u32 clux, u32 stamp_us)
+{
+    SampleRing_RecordTypeDef rec;
+
+    rec.stamp_us = stamp_us;
+    rec.clux = clux;
+    rec.raw = raw;
+    rec.sensor = h->id;
+    rec.status = (u8)h->status;
+    rec.jump = h->filter.jump.accepted;
+    rec.pending = h->filter.jump.pending;
+    SampleRing_Push(&rec);
+}
+
+// 文本调试输出：结果+状态+与上一样本的间隔（可选，用于故障排查），返回输出字节数
+// 每次转换只输出一次，常规配置下间隔应稳定在约800ms
+static int Telemetry_PrintText(const SampleRing_RecordTypeDef *r, u32 interval_ms)
+{
+    const char *state;
+
+    switch(r->status)
+    {
+        case OPT3001_STATUS_COMM_ERR:  state = "通信异常"; break;
+        case OPT3001_STATUS_RANGE_ERR: state = "量程异常"; break;
+        case OPT3001_STATUS_JUMP_ERR:  state = "跳变待确认"; break;
+        default:                       state = "正常";     break;
+    }
+    return printf("传感器%d 当前光照强度：%lu.%02lu lux（%s，间隔%lu ms）\r\n", r->sensor,
+                  (unsigned long)(r->clux / 100), (unsigned long)(r->clux % 100), state,
+                  (unsigned long)interval_ms);
+}
+
+// 串口输出路径：每次最多取出一批记录，按当前输出模式发送二进制帧或打印文本
+// 序号不连续说明缓冲满丢了记录（二进制模式由主机端按序号发现）
+// 跳变确认时报告从候选等级首次出现到被接受的延迟（上限为FILTER_JUMP_CONFIRM次转换）
+#define TELEMETRY_BATCH  8
+static u32 last_stamp[OPT3001_MAX_SENSORS];
+static u32 jump_since[OPT3001_MAX_SENSORS];
+
+// 屏幕状态变化：事件时刻换算到millis()时基，便于与主机日志/心跳对齐
+static void Screen_Report(const Screen_EventTypeDef *ev)
+{
+    Screen_InfoTypeDef info;
+
+    Screen_GetInfo(ev->sensor, &info);
+    if(Telemetry_IsBinary())
+    {
+        Telemetry_SendEvent(ev, &info);
+        return;
+    }
+    printf("传感器%d 屏幕状态：%s -> %s（光照 %lu.%02lu lux，确认用时 %lu ms）\r\n", ev->sensor,
+           Screen_StateName(ev->from), Screen_StateName(ev->to),
+           (unsigned long)(ev->clux / 100), (unsigned long)(ev->clux % 100), (unsigned long)ev->confirm_ms);
+}
+
+static void Telemetry_Drain(void)
+{
+    SampleRing_RecordTypeDef batch[TELEMETRY_BATCH];
+    const SampleRing_RecordTypeDef *r;
+    Screen_EventTypeDef ev;
+    u32 start = DWT->CYCCNT;
+    u32 now_ms = millis(), now_us = micros();
+    static u16 next_seq = 0;
+    u8 n, k;
+
+    n = SampleRing_Drain(batch, TELEMETRY_BATCH);
+    for(k=0; k<n; k++)
+    {
+        r = &batch[k];
+        sample_total++;
+        Stats_Add(r->sensor, r->clux, r->status);
+        if(r->status == OPT3001_STATUS_JUMP_ERR && r->pending == 1)
+            jump_since[r->sensor] = r->stamp_us;
+        // 跳变待确认期间滤波输出仍保持旧等级，状态分类改用原始值，由驻留时间过滤瞬态
+        if(Screen_Update(r->sensor,
+                         r->status == OPT3001_STATUS_JUMP_ERR ? OPT3001_RawToCentiLux(r->raw) : r->clux,
+                         r->status, now_ms - (now_us - r->stamp_us) / 1000, &ev))
+            Screen_Report(&ev);
+        // 汇总/事件模式下样本不逐个输出
+        if(Telemetry_GetOutput() != TELEMETRY_OUT_SAMPLE)
+            ;
+        else if(Telemetry_IsBinary())
+        {
+            Telemetry_SendSample(r);
+        }
+        else
+        {
+            if(r->seq != next_seq)
+                printf("样本缓冲溢出，丢失 %u 条\r\n", (unsigned)(u16)(r->seq - next_seq));
+            if(r->jump)
+                printf("传感器%d 新光照等级已确认：%d次转换，延迟 %lu ms\r\n", r->sensor, r->jump,
+                       (unsigned long)(r->jump > 1 ? (r->stamp_us - jump_since[r->sensor]) / 1000 : 0));
+            Telemetry_Account(Telemetry_PrintText(r, (r->stamp_us - last_stamp[r->sensor]) / 1000));
+        }
+        next_seq = r->seq + 1;
+        last_stamp[r->sensor] = r->stamp_us;
+    }
+    if(n > 0)
+        drain_cycles += DWT->CYCCNT - start;
+}
+
+// 统计周期到期：每个传感器输出一条汇总（逐样本模式下只清空累加器）
+static SoftTimer_TypeDef rollup_timer;
+
+static void Rollup_Emit(u8 level)
+{
+    Stats_RollupTypeDef r;
+    u8 i;
+
+    for(i=0; i<sensor_count; i++)
+    {
+        Stats_Close(level, i, &r);
+        if(Telemetry_GetOutput() != TELEMETRY_OUT_ROLLUP)
+            continue;
+        if(Telemetry_IsBinary())
+        {
+            Telemetry_SendRollup(&r, millis());
+            continue;
+        }
+        printf("传感器%d %s汇总：%u个样本，最小 %lu.%02lu，最大 %lu.%02lu，均值 %lu.%02lu，标准差 %lu.%02lu，"
+               "p5/p50/p95 %lu.%02lu/%lu.%02lu/%lu.%02lu lux，状态 %u/%u/%u/%u\r\n",
+               i, level ? "1min" : "1s", r.count,
+               (unsigned long)(r.min / 100), (unsigned long)(r.min % 100),
+               (unsigned long)(r.max / 100), (unsigned long)(r.max % 100),
+               (unsigned long)(r.mean / 100), (unsigned long)(r.mean % 100),
+               (unsigned long)(r.stddev / 100), (unsigned long)(r.stddev % 100),
+               (unsigned long)(r.quantile[0] / 100), (unsigned long)(r.quantile[0] % 100),
+               (unsigned long)(r.quantile[1] / 100), (unsigned long)(r.quantile[1] % 100),
+               (unsigned long)(r.quantile[2] / 100), (unsigned long)(r.quantile[2] % 100),
+               r.status[0], r.status[1], r.status[2], r.status[3]);
+    }
+}
+
+// 事件模式下定期上报各传感器当前状态，主机据此确认链路正常、状态未漏报
+#define HEARTBEAT_MS  10000
+static SoftTimer_TypeDef heartbeat_timer;
+
+static void Heartbeat_Tick(void *ctx)
+{
+    Screen_InfoTypeDef info;
+    u32 now = millis();
+    u8 i;
+
+    (void)ctx;
+    if(Telemetry_GetOutput() != TELEMETRY_OUT_EVENT)
+        return;
+    for(i=0; i<sensor_count; i++)
+    {
+        Screen_GetInfo(i, &info);
+        if(Telemetry_IsBinary())
+        {
+            Telemetry_SendHeartbeat(i, &info, now);
+            continue;
+        }
+        printf("传感器%d 心跳：%s %lu s，光照 %lu.%02lu lux，基线 %lu.%02lu/%lu.%02lu lux\r\n", i,
+               Screen_StateName(info.state), (unsigned long)((now - info.since_ms) / 1000),
+               (unsigned long)(info.clux / 100), (unsigned long)(info.clux % 100),
+               (unsigned long)(info.off_base / 100), (unsigned long)(info.off_base % 100),
+               (unsigned long)(info.on_base / 100), (unsigned long)(info.on_base % 100));
+    }
+}
+
+static void Rollup_Tick(void *ctx)
+{
+    static u16 ticks = 0;
+
+    (void)ctx;
+    Rollup_Emit(0);
+    if(++ticks >= STATS_LONG_MS / STATS_SHORT_MS)
+    {
+        ticks = 0;
+        Rollup_Emit(1);
+    }
+}
+
+// 两种输出模式每样本的线上字节数及各波特率下可持续的样本率（8N1每字节10位）
+// 文本长度按典型一行（5位整数光照、正常、间隔800ms）计算
+static void Telemetry_ReportThroughput(void)
+{
+    static const u32 bauds[] = {9600, 19200, 57600, 115200};
+    SampleRing_RecordTypeDef r;
+    char line[96];
+    int text_len;
+    u8 i;
+
+    r.sensor = 0;
+    r.clux = 1234567;
+    r.status = OPT3001_STATUS_NORMAL;
+    text_len = snprintf(line, sizeof(line), "传感器%d 当前光照强度：%lu.%02lu lux（%s，间隔%lu ms）\r\n",
+                        r.sensor, (unsigned long)(r.clux / 100), (unsigned long)(r.clux % 100),
+                        "正常", 800UL);
+    printf("每样本线上字节：二进制 %d，文本 %d\r\n", TELEMETRY_WIRE_LEN, text_len);
+    for(i=0; i<sizeof(bauds)/sizeof(bauds[0]); i++)
+        printf("  %lu bps：二进制 %lu 样本/s，文本 %lu 样本/s\r\n", (unsigned long)bauds[i],
+               (unsigned long)(bauds[i] / 10 / TELEMETRY_WIRE_LEN), (unsigned long)(bauds[i] / 10 / text_len));
+}
+
+// 上电快速启动：先用100ms转换时间拿到首个样本，再切回常规的800ms配置
+// 等待转换完成挂在软件定时器上（每2ms查询一次CRF，150ms截止），主循环照常运行；
+// 全部传感器拿到首个样本或超时后调用Boot_Finish，之后才开始按周期采集
+#define FASTBOOT_POLL_MS     2
+#define FASTBOOT_TIMEOUT_MS  150
+static SoftTimer_TypeDef fastboot_timer;
+static u32 fastboot_init_ms;        // 上电到发起首次转换的初始化耗时
+static u32 fastboot_start_ms;
+static u8  fastboot_pending = 0;    // 位图：尚未拿到首个样本的传感器
+static u8  fastboot_first = 1;
+
+static void Boot_Finish(void);
+
+static void Sensor_FastBoot_Step(void *ctx)
+{
+    u8 i, r;
+    u32 clux;
+
+    (void)ctx;
+    for(i=0; i<sensor_count; i++)
+    {
+        if(!(fastboot_pending & (1 << i)))
+            continue;
+        r = OPT3001_Sensor_PollReady(&sensors[i]);
+        if(r == 1 && millis() - fastboot_start_ms < FASTBOOT_TIMEOUT_MS)
+            continue;
+        fastboot_pending &= (u8)~(1 << i);
+        if(r != 0)
+        {
+            printf("OPT3001[%d] 0x%02X 首个样本%s！\r\n", sensors[i].id, sensors[i].addr,
+                   r == 1 ? "超时" : "读取失败");
+            OPT3001_Sensor_Configure(&sensors[i], OPT3001_CONFIG_DEFAULT);
+            continue;
+        }
+        clux = OPT3001_Sensor_ReadCentiLux(&sensors[i]);
+        if(fastboot_first)
+        {
+            fastboot_first = 0;
+            printf("上电到首个样本：%lu ms\r\n",
+                   (unsigned long)(fastboot_init_ms + millis() - fastboot_start_ms));
+        }
+        printf("OPT3001[%d] 0x%02X 初始化成功，首个样本：%lu.%02lu lux\r\n",
+               sensors[i].id, sensors[i].addr, (unsigned long)(clux / 100), (unsigned long)(clux % 100));
+        OPT3001_Sensor_Configure(&sensors[i], OPT3001_CONFIG_DEFAULT);
+    }
+    if(fastboot_pending != 0)
+        return;
+    SoftTimer_Stop(&fastboot_timer);
+    Boot_Finish();
+}
+
+static void Sensor_FastBoot(u32 boot_cycles)
+{
+    u8 i;
+
+    // 初始化阶段没有睡眠，用DWT周期计；之后主循环会WFI睡眠（DWT停止计数），等待转换的时间用SysTick计
+    fastboot_init_ms = (DWT->CYCCNT - boot_cycles) / (SystemCoreClock / 1000);
+    fastboot_start_ms = millis();
+    fastboot_pending = 0;
+    // 快速启动与Boot_Finish都是同步总线访问：首次转换完成拉低INT时不能让调度器发起异步读取，
+    // 否则TIM2中断会插进同一总线上的事务中间，暂停到Boot_Finish结束（期间的INT事件随后处理）
+    OPT3001_Sched_Pause(1);
+    for(i=0; i<sensor_count; i++)
+    {
+        if(OPT3001_Sensor_Configure(&sensors[i], OPT3001_CONFIG_FASTBOOT) != 0 ||
+           OPT3001_Sensor_EnableEoc(&sensors[i]) != 0)
+            printf("OPT3001[%d] 0x%02X 初始化失败！\r\n", sensors[i].id, sensors[i].addr);
+        else
+            fastboot_pending |= (u8)(1 << i);
+    }
+    if(fastboot_pending == 0)
+    {
+        Boot_Finish();
+        return;
+    }
+    SoftTimer_Start(&fastboot_timer, FASTBOOT_POLL_MS, FASTBOOT_POLL_MS, Sensor_FastBoot_Step, 0);
+}
+
+/********************* 串口命令 *********************/
+// 运行时调参/排查，无需重新烧录：
+//   get [名称]          查看参数          set <名称> <值>   修改参数（滤波参数修改后各传感器滤波状态复位）
+//   mode bin|text       输出格式          mode sample|rollup|event 逐样本/周期汇总/仅状态事件
+//   scan                全地址扫描（与旧的's'相同）
+//   stats               立即输出统计      baud <速率>       切换波特率，须在新波特率下5秒内发送confirm，否则恢复
+//   metrics             导出计数器与耗时直方图
+//   topo                清除拓扑缓存（上电时缓存外的候选地址有应答也会自动重新发现）
+#define BAUD_CONFIRM_MS  5000
+static Cmd_ParserTypeDef cmd_parser;
+static SoftTimer_TypeDef baud_timer;
+static u32 baud_previous = USART1_BAUD;
+
+typedef enum {
+    PARAM_JUMP = 0, PARAM_FLOOR, PARAM_CONFIRM, PARAM_EMA, PARAM_MEDIAN, PARAM_DECIM,
+    PARAM_HAMPEL, PARAM_KQ, PARAM_KR, PARAM_PERIOD, PARAM_COUNT
+} ParamIdTypeDef;
+
+static const char *const param_names[PARAM_COUNT] = {
+    "jump", "floor", "confirm", "ema", "median", "decim", "hampel", "kq", "kr", "period"
+};
+
+static u32 Param_Get(u8 id)
+{
+    Filter_ParamsTypeDef fp;
+
+    FilterChain_GetParams(&fp);
+    switch(id)
+    {
+        case PARAM_JUMP:    return fp.jump_log_q8;
+        case PARAM_FLOOR:   return fp.jump_floor;
+        case PARAM_CONFIRM: return fp.jump_confirm;
+        case PARAM_EMA:     return fp.ema_shift;
+        case PARAM_MEDIAN:  return fp.median_window;
+        case PARAM_DECIM:   return fp.decim_factor;
+        case PARAM_HAMPEL:  return fp.hampel_k_q8;
+        case PARAM_KQ:      return fp.kalman_q;
+        case PARAM_KR:      return fp.kalman_r;
+        case PARAM_PERIOD:  return cycle_interval_ms;
+        default:            return 0;
+    }
+}
+
+// 滤波参数按字段宽度检查后整体校验，失败时不做任何修改
+static u8 Param_Set(u8 id, u32 v)
+{
+    Filter_ParamsTypeDef fp;
+    u8 i;
+
+    if(id == PARAM_PERIOD)
+    {
+        if(v < 10 || v > 3600000)
+            return 1;
+        cycle_interval_ms = v;
+        return 0;
+    }
+    if(v > 0xFFFF || ((id == PARAM_CONFIRM || id == PARAM_EMA || id == PARAM_MEDIAN || id == PARAM_DECIM) && v > 0xFF))
+        return 1;
+
+    FilterChain_GetParams(&fp);
+    switch(id)
+    {
+        case PARAM_JUMP:    fp.jump_log_q8 = (u16)v;  break;
+        case PARAM_FLOOR:   fp.jump_floor = (u16)v;   break;
+        case PARAM_CONFIRM: fp.jump_confirm = (u8)v;  break;
+        case PARAM_EMA:     fp.ema_shift = (u8)v;     break;
+        case PARAM_MEDIAN:  fp.median_window = (u8)v; break;
+        case PARAM_DECIM:   fp.decim_factor = (u8)v;  break;
+        case PARAM_HAMPEL:  fp.hampel_k_q8 = (u16)v;  break;
+        case PARAM_KQ:      fp.kalman_q = (u16)v;     break;
+        case PARAM_KR:      fp.kalman_r = (u16)v;     break;
+        default:            return 1;
+    }
+    if(FilterChain_SetParams(&fp) != 0)
+        return 1;
+    for(i=0; i<sensor_count; i++)
+        FilterChain_Reset(&sensors[i].filter);
+    return 0;
+}
+
+static u8 Param_Find(const char *name)
+{
+    u8 i;
+
+    for(i=0; i<PARAM_COUNT; i++)
+    {
+        if(Cmd_StrEq(name, param_names[i]))
+            return i;
+    }
+    return PARAM_COUNT;
+}
+
+static u8 Cmd_Get(u8 argc, char **argv)
+{
+    u8 i;
+
+    if(argc == 2)
+    {
+        i = Param_Find(argv[1]);
+        if(i >= PARAM_COUNT)
+            return 1;
+        printf("%s=%lu\r\n", param_names[i], (unsigned long)Param_Get(i));
+        return 0;
+    }
+    for(i=0; i<PARAM_COUNT; i++)
+        printf("%s=%lu%s", param_names[i], (unsigned long)Param_Get(i), i + 1 < PARAM_COUNT ? " " : "\r\n");
+    return 0;
+}
+
+static u8 Cmd_Set(u8 argc, char **argv)
+{
+    u8 id = Param_Find(argv[1]);
+    u32 v;
+
+    (void)argc;
+    if(id >= PARAM_COUNT || Cmd_ParseU32(argv[2], &v) != 0)
+        return 1;
+    if(Param_Set(id, v) != 0)
+    {
+        // 中值窗口上限由编译选项决定，超出时说明当前上限，避免误以为参数格式不对
+        if(id == PARAM_MEDIAN)
+            printf("median须为3~%d的奇数（编译选项MEDIAN_WINDOW_MAX）\r\n", MEDIAN_WINDOW_MAX);
+        return 1;
+    }
+    printf("OK %s=%lu\r\n", param_names[id], (unsigned long)Param_Get(id));
+    return 0;
+}
+
+static u8 Cmd_Mode(u8 argc, char **argv)
+{
+    (void)argc;
+    if(Cmd_StrEq(argv[1], "bin"))
+        Telemetry_SetBinary(1);
+    else if(Cmd_StrEq(argv[1], "text"))
+        Telemetry_SetBinary(0);
+    else if(Cmd_StrEq(argv[1], "sample"))
+        Telemetry_SetOutput(TELEMETRY_OUT_SAMPLE);
+    else if(Cmd_StrEq(argv[1], "rollup"))
+        Telemetry_SetOutput(TELEMETRY_OUT_ROLLUP);
+    else if(Cmd_StrEq(argv[1], "event"))
+        Telemetry_SetOutput(TELEMETRY_OUT_EVENT);
+    else
+        return 1;
+    printf("OK mode %s\r\n", argv[1]);
+    return 0;
+}
+
+// 扫描请求在两轮读取之间执行（快速启动尚未结束时拒绝，周期采集由Boot_Finish启动）
+static u8 Cmd_Scan(u8 argc, char **argv)
+{
+    (void)argc;
+    (void)argv;
+    if(SoftTimer_IsActive(&fastboot_timer))
+        return 1;
+    scan_requested = 1;
+    SoftTimer_Start(&cycle_timer, 1, 0, Cycle_Start, 0);
+    return 0;
+}
+
+static u8 Cmd_Stats(u8 argc, char **argv)
+{
+    (void)argc;
+    (void)argv;
+    Traffic_Print(0);
+    printf("  串口接收：缓冲丢弃 %lu 字节，硬件溢出 %lu 次\r\n",
+           (unsigned long)USART1_RX_GetDropped(), (unsigned long)USART1_RX_GetOverrun());
+    return 0;
+}
+
+// 计数器与直方图导出（紧凑文本，每行一个块，直方图只列非零桶“桶号:次数”）：
+//   M c nack_aw=0 nack_reg=0 ...
+//   M h i2c 17:1520 18:3
+static u8 Cmd_Metrics(u8 argc, char **argv)
+{
+    u8 i, k;
+
+    (void)argc;
+    (void)argv;
+    Metrics_Set(METRIC_RING_OVERRUN, SampleRing_GetOverflow());
+    Metrics_Set(METRIC_UART_TX_DROP, USART1_DMA_GetDropped());
+    Metrics_Set(METRIC_UART_RX_DROP, USART1_RX_GetDropped());
+    Metrics_Set(METRIC_UART_RX_OVERRUN, USART1_RX_GetOverrun());
+#if OPT3001_HEALTH_ENABLE
+    Metrics_Set(METRIC_BUS_RECOVERY, OPT3001_Health_GetBusRecoveries());
+#endif
+    printf("M c");
+    for(i=0; i<METRIC_COUNTERS; i++)
+        printf(" %s=%lu", Metrics_CounterName((Metrics_CounterTypeDef)i),
+               (unsigned long)Metrics_Registry.counter[i]);
+    printf("\r\n");
+    for(k=0; k<METRIC_HISTS; k++)
+    {
+        printf("M h %s", Metrics_HistName((Metrics_HistTypeDef)k));
+        for(i=0; i<METRICS_BUCKETS; i++)
+        {
+            if(Metrics_Registry.hist[k][i] != 0)
+                printf(" %u:%lu", i, (unsigned long)Metrics_Registry.hist[k][i]);
+        }
+        printf("\r\n");
+    }
+    return 0;
+}
+
+#if OPT3001_LANES_ENABLE
+// 一次并行读取全部通道的结果寄存器：L <通道> <0.01lux>，无应答的通道输出 L <通道> -
+static u8 Cmd_Lanes(u8 argc, char **argv)
+{
+    u16 data[OPT3001_LANES_MAX];
+    u8 ok, i;
+
+    (void)argc;
+    (void)argv;
+    ok = OPT3001_Lanes_ReadReg(&OPT3001_DefaultLanes, OPT3001_ADDR, OPT3001_RESULT_REG,
+                               (u8)((1 << OPT3001_DefaultLanes.count) - 1), data);
+    for(i=0; i<OPT3001_DefaultLanes.count; i++)
+    {
+        if(ok & (1 << i))
+            printf("L %d %lu\r\n", i, (unsigned long)OPT3001_RawToCentiLux(data[i]));
+        else
+            printf("L %d -\r\n", i);
+    }
+    return 0;
+}
+#endif
+
+// 切换前先发完应答；新波特率下未在限时内收到confirm则自动恢复，避免失联
+static void USART1_SetBaud(u32 baud)
+{
+    USART1_DMA_Flush(USART1_DMA_WAIT_US);
+    USART1_Init(baud);
+    baud_current = baud;
+}
+
+static void Baud_Revert(void *ctx)
+{
+    (void)ctx;
+    USART1_SetBaud(baud_previous);
+    printf("波特率未确认，已恢复 %lu bps\r\n", (unsigned long)baud_current);
+}
+
+static u8 Cmd_Baud(u8 argc, char **argv)
+{
+    u32 baud;
+
+    (void)argc;
+    if(Cmd_ParseU32(argv[1], &baud) != 0 ||
+       (baud != 9600 && baud != 19200 && baud != 38400 && baud != 57600 && baud != 115200))
+        return 1;
+    if(SoftTimer_IsActive(&baud_timer))
+        return 1;                       // 上一次切换尚未确认
+    printf("OK baud %lu，请在%d秒内以新波特率发送confirm\r\n", (unsigned long)baud, BAUD_CONFIRM_MS / 1000);
+    baud_previous = baud_current;
+    USART1_SetBaud(baud);
+    SoftTimer_Start(&baud_timer, BAUD_CONFIRM_MS, 0, Baud_Revert, 0);
+    return 0;
+}
+
+static u8 Cmd_Confirm(u8 argc, char **argv)
+{
+    (void)argc;
+    (void)argv;
+    if(!SoftTimer_IsActive(&baud_timer))
+        return 1;
+    SoftTimer_Stop(&baud_timer);
+    printf("OK baud %lu\r\n", (unsigned long)baud_current);
+    return 0;
+}
+
+// 清除Flash拓扑缓存：传感器表在上电时建立，下次上电按候选地址完整发现一次
+static u8 Cmd_Topo(u8 argc, char **argv)
+{
+    (void)argc;
+    (void)argv;
+    OPT3001_Topo_Invalidate();
+    printf("OK 拓扑缓存已清除，下次上电重新发现\r\n");
+    return 0;
+}
+
+static u8 Cmd_Help(u8 argc, char **argv);
+
+static const Cmd_EntryTypeDef cmd_table[] = {
+    {"help",    0, 0, Cmd_Help,    "命令列表"},
+    {"get",     0, 1, Cmd_Get,     "get [名称]：查看参数"},
+    {"set",     2, 2, Cmd_Set,     "set <名称> <值>：修改参数"},
+    {"mode",    1, 1, Cmd_Mode,    "mode bin|text|sample|rollup|event：输出格式/粒度"},
+    {"scan",    0, 0, Cmd_Scan,    "scan：全地址扫描"},
+    {"s",       0, 0, Cmd_Scan,    "s：同scan"},
+    {"stats",   0, 0, Cmd_Stats,   "stats：输出统计"},
+    {"metrics", 0, 0, Cmd_Metrics, "metrics：导出驱动计数器/耗时直方图"},
+#if OPT3001_LANES_ENABLE
+    {"lanes",   0, 0, Cmd_Lanes,   "lanes：并行读取多通道总线上的全部传感器"},
+#endif
+    {"baud",    1, 1, Cmd_Baud,    "baud <速率>：切换波特率"},
+    {"confirm", 0, 0, Cmd_Confirm, "confirm：确认新波特率"},
+    {"topo",    0, 0, Cmd_Topo,    "topo：清除拓扑缓存，下次上电重新发现传感器"},
+};
+#define CMD_COUNT  (sizeof(cmd_table) / sizeof(cmd_table[0]))
+
+static u8 Cmd_Help(u8 argc, char **argv)
+{
+    u8 i;
+
+    (void)argc;
+    (void)argv;
+    for(i=0; i<CMD_COUNT; i++)
+        printf("  %s\r\n", cmd_table[i].help);
+    return 0;
+}
+
+// 主循环调用：取出已接收的字节逐个解析（每次最多一个接收缓冲的量）
+static void Cmd_Poll(void)
+{
+    static const char *const err_text[] = {
+        "", "", "ERR 未知命令", "ERR 参数个数", "ERR 参数值", "ERR 行过长"
+    };
+    Cmd_ResultTypeDef res;
+    u8 ch, n = 0;
+
+    while(n++ < USART1_RX_BUF_SIZE && USART1_RX_Read(&ch))
+    {
+        res = Cmd_Feed(&cmd_parser, ch);
+        if(res > CMD_OK)
+            printf("%s\r\n", err_text[res]);
+    }
+}
+
+// 快速启动结束：线上吞吐估算、启动基准、多通道自检，再进入按周期采集
+// （吞吐估算有数百字节，9600bps下会占满两块DMA缓冲，放在首个样本之后输出）
+static void Boot_Finish(void)
+{
+    Telemetry_ReportThroughput();
+#if OPT3001_IIC_STATS
+    if(sensor_count > 0 && !sensors[0].bus->hw)
+        OPT3001_Benchmark(&sensors[0]);
+#endif
+#if OPT3001_LANES_ENABLE
+    Lanes_Boot();
+#endif
+#if SENSOR_EVENT_MODE
+    if(OPT3001_Sched_SetEventMode(1) != 0)
+        printf("事件模式设置失败！\r\n");
+#endif
+    OPT3001_Sched_Pause(0);
+    SoftTimer_Start(&cycle_timer, 1, 0, Cycle_Start, 0);
 }
 
-float lux;
 int main(void)
 {
-    OPT3001_StatusTypeDef sensor_status;
+    u8 i;
+    u8 cycle_cnt = 0;
+    u32 boot_cycles, loop_start;
+    Power_DutyTypeDef duty;
+
+    // 上电计时从这里开始（DWT周期计数器，不依赖SysTick）
+    DWT_Init();
+    boot_cycles = DWT->CYCCNT;
 
+    NVIC_PriorityGroupConfig(NVIC_PriorityGroup_2);
     SysTick_Init();
-    USART1_Init(9600);
+    USART1_Init(USART1_BAUD);
+    USART1_DMA_Init();
+    USART1_RX_Init();
+    Cmd_Init(&cmd_parser, cmd_table, CMD_COUNT);
 
-    if(OPT3001_Init() == 0)
-        printf("OPT3001初始化成功！\r\n");
-    else
-        printf("OPT3001初始化失败！\r\n");
+    // 各总线初始化一次，再按缓存/候选地址发现传感器
+    for(i=0; i<BUS_COUNT; i++)
+        OPT3001_Bus_Init(buses[i]);
+    sensor_count = OPT3001_Topo_Discover(buses, BUS_COUNT, sensors, OPT3001_MAX_SENSORS);
+    printf("发现%d个OPT3001（%s）\r\n", sensor_count, OPT3001_Topo_CacheHit() ? "缓存命中" : "重新发现");
+
+    SampleRing_Init();
+    Stats_Init();
+    Screen_Init();
+    OPT3001_Async_Init();
+    OPT3001_Sched_Init(sensors, sensor_count, Sensor_Report);
+#if OPT3001_HEALTH_ENABLE
+    OPT3001_Health_Init(sensors, sensor_count);
+#endif
+#if OPT3001_ADAPT_ENABLE
+    OPT3001_Adapt_Init(sensors, sensor_count);
+#endif
+    SoftTimer_Init(millis());
+    // 首个样本在主循环中由软件定时器取得，完成后Boot_Finish启动周期采集
+    Sensor_FastBoot(boot_cycles);
+    SoftTimer_Start(&stats_timer, STATS_INTERVAL_MS, STATS_INTERVAL_MS, Traffic_Report, 0);
+    SoftTimer_Start(&rollup_timer, STATS_SHORT_MS, STATS_SHORT_MS, Rollup_Tick, 0);
+    SoftTimer_Start(&heartbeat_timer, HEARTBEAT_MS, HEARTBEAT_MS, Heartbeat_Tick, 0);
+    Power_Init();
+#if WATCHDOG_ENABLE
+    // 上电初始化中没有阻塞等待（快速启动在主循环中按定时器推进），只有Boot_Finish中的基准短暂占用主循环
+    Watchdog_Init(WATCHDOG_TIMEOUT_MS);
+    if(Watchdog_WasReset())
+        printf("上次复位由看门狗触发\r\n");
+#endif
 
-		I2C_Scan_Test();
-		
     while(1)
     {
-        // 调用带异常处理的读取函数
-        lux = OPT3001_ReadLux_WithFilter();
-        // 获取传感器状态，便于调试
-        sensor_status = OPT3001_GetStatus();
+        // 所有等待都以截止时间挂在时间轮上，主循环不再忙等
+        loop_start = DWT->CYCCNT;
+        SoftTimer_Advance(millis());
+
+        // 串口命令由接收中断缓存，这里逐字节解析
+        Cmd_Poll();
 
-			
-			
-        // 打印结果+状态（可选，用于故障排查）
-        switch(sensor_status)
+        // 总线事务由TIM2/I2C中断推进，一轮读取进行中主循环可处理其它任务
+        if(OPT3001_Sched_Poll())
         {
-            case OPT3001_STATUS_NORMAL:
-                printf("当前光照强度：%.2f lux（正常）\r\n", (double)lux);
-                break;
-            case OPT3001_STATUS_COMM_ERR:
-                printf("当前光照强度：%.2f lux（通信异常）\r\n", (double)lux);
-                break;
-            case OPT3001_STATUS_RANGE_ERR:
-                printf("当前光照强度：%.2f lux（量程异常）\r\n", (double)lux);
-                break;
-            case OPT3001_STATUS_JUMP_ERR:
-                printf("当前光照强度：%.2f lux（跳变异常）\r\n", (double)lux);
-                break;
+            // 每50轮报告一次整轮读取耗时及CPU占空比，用于评估传感器数量和睡眠模式的影响
+            if(++cycle_cnt >= 50)
+            {
+                cycle_cnt = 0;
+                Power_GetDuty(&duty);
+                printf("%d个传感器单轮读取耗时：%lu us，CPU运行 %lu us/s，睡眠 %lu us/s（占用%u‰）\r\n",
+                       (int)sensor_count, (unsigned long)OPT3001_Sched_GetCycleTime(),
+                       (unsigned long)duty.busy_us, (unsigned long)duty.idle_us, Power_GetLoadPermille());
+            }
+            SoftTimer_Start(&cycle_timer, cycle_interval_ms, 0, Cycle_Start, 0);
         }
-        
-        Delay_ms(100);
+
+#if OPT3001_HEALTH_ENABLE
+        // 离线传感器按退避间隔尝试恢复（只在两轮读取之间进行）
+        OPT3001_Health_Poll();
+#endif
+
+        // 样本打印与采集解耦：串口慢时记录在缓冲中排队，溢出只计数
+        Telemetry_Drain();
+
+#if WATCHDOG_ENABLE
+        // 主循环在运行且当前一轮读取没有停滞才喂狗；总线卡死由健康监测处理，不会让读取停滞
+        if(OPT3001_Sched_GetBusyMs() < OPT3001_HEALTH_STALL_MS)
+            Watchdog_Kick();
+#endif
+
+        // 单次迭代的运行时间（睡眠期间DWT停止，不计入）
+        METRIC_HIST(METRIC_HIST_LOOP, DWT->CYCCNT - loop_start);
+
+        // 本轮无事可做：睡眠到下一个中断（SysTick每1ms唤醒一次，串口命令字节由接收中断缓存）
+        Power_Idle();
     }
 }